@@ -1377,9 +1377,9 @@ void AIEngine::threadloop(void)
 	if (queued_element == end)
 	{
 	  // Nothing to do. Wait till something is added to the queue again.
-	  engine_state_w->waiting = true;
+	  ++engine_state_w->waiting;
 	  engine_state_w.wait();
-	  engine_state_w->waiting = false;
+	  --engine_state_w->waiting;
 	  return;
 	}
   }
@@ -1402,12 +1402,47 @@ void AIEngine::threadloop(void)
   while (queued_element != end);
 }
 
+// State Machine Thread pool main loop.
+//
+// Unlike threadloop(), this doesn't walk the queue while it isn't locked:
+// each call takes the front element off the queue, runs it and puts it back
+// at the end if it's still active, so that any number of threads can run
+// state machines from the same engine. A state machine is still only run
+// by one thread at a time; that is guaranteed by AIStateMachine::multiplex.
+void AIEngine::poolloop(void)
+{
+  QueueElement queued_element(NULL);
+  {
+	engine_state_type_wat engine_state_w(mEngineState);
+	if (engine_state_w->list.empty())
+	{
+	  // Nothing to do. Wait till something is added to the queue again.
+	  ++engine_state_w->waiting;
+	  engine_state_w.wait();
+	  --engine_state_w->waiting;
+	  return;
+	}
+	queued_element = engine_state_w->list.front();
+	engine_state_w->list.pop_front();
+  }
+  AIStateMachine& state_machine(queued_element.statemachine());
+  state_machine.multiplex(AIStateMachine::normal_run);
+  bool active = state_machine.active(this);		// This locks mState shortly, so it must be called before locking mEngineState because add() locks mEngineState while holding mState.
+  if (!active)
+  {
+	Dout(dc::statemachine(state_machine.mSMDebug), "Erasing state machine [" << (void*)&state_machine << "] from " << mName);
+	return;
+  }
+  engine_state_type_wat engine_state_w(mEngineState);
+  engine_state_w->list.push_back(queued_element);
+}
+
 void AIEngine::wake_up(void)
 {
   engine_state_type_wat engine_state_w(mEngineState);
   if (engine_state_w->waiting)
   {
-	engine_state_w.signal();
+	engine_state_w.broadcast();
   }
 }
 
@@ -1417,22 +1452,25 @@ void AIEngine::wake_up(void)
 class AIEngineThread : public LLThread
 {
   public:
-	static AIEngineThread* sInstance;
+	static std::vector<AIEngineThread*> sInstances;
 	bool volatile mRunning;
 
   public:
     // MAIN-THREAD
-    AIEngineThread(void);
+    AIEngineThread(bool pool);
     virtual ~AIEngineThread();
 
   protected:
 	virtual void run(void);
+
+  private:
+	bool mPool;		// Use AIEngine::poolloop instead of AIEngine::threadloop.
 };
 
 //static
-AIEngineThread* AIEngineThread::sInstance;
+std::vector<AIEngineThread*> AIEngineThread::sInstances;
 
-AIEngineThread::AIEngineThread(void) : LLThread("AIEngineThread"), mRunning(true)
+AIEngineThread::AIEngineThread(bool pool) : LLThread("AIEngineThread"), mRunning(true), mPool(pool)
 {
 }
 
@@ -1444,25 +1482,48 @@ void AIEngineThread::run(void)
 {
   while(mRunning)
   {
-	gStateMachineThreadEngine.threadloop();
+	if (mPool)
+	  gStateMachineThreadEngine.poolloop();
+	else
+	  gStateMachineThreadEngine.threadloop();
+  }
+}
+
+// Start number_of_threads threads to run gStateMachineThreadEngine.
+// With more than one thread, they share the queue (see AIEngine::poolloop).
+void startEngineThread(U32 number_of_threads)
+{
+  number_of_threads = llmax(number_of_threads, 1U);
+  for (U32 i = 0; i < number_of_threads; ++i)
+  {
+	AIEngineThread::sInstances.push_back(new AIEngineThread(number_of_threads > 1));
+	AIEngineThread::sInstances.back()->start();
   }
 }
 
-void startEngineThread(void)
+static bool engine_threads_stopped(void)
 {
-  AIEngineThread::sInstance = new AIEngineThread;
-  AIEngineThread::sInstance->start();
+  for (std::vector<AIEngineThread*>::iterator iter = AIEngineThread::sInstances.begin(); iter != AIEngineThread::sInstances.end(); ++iter)
+  {
+	if (!(*iter)->isStopped())
+	{
+	  return false;
+	}
+  }
+  return true;
 }
 
 void stopEngineThread(void)
 {
-  AIEngineThread::sInstance->mRunning = false;
+  for (std::vector<AIEngineThread*>::iterator iter = AIEngineThread::sInstances.begin(); iter != AIEngineThread::sInstances.end(); ++iter)
+  {
+	(*iter)->mRunning = false;
+  }
   gStateMachineThreadEngine.wake_up();
   int count = 401;
-  while(--count && !AIEngineThread::sInstance->isStopped())
+  while(--count && !engine_threads_stopped())
   {
 	ms_sleep(10);
   }
-  LL_INFOS() << "State machine thread" << (!AIEngineThread::sInstance->isStopped() ? " not" : "") << " stopped after " << ((400 - count) * 10) << "ms." << LL_ENDL;
+  LL_INFOS() << "State machine thread" << (AIEngineThread::sInstances.size() > 1 ? "s" : "") << (!engine_threads_stopped() ? " not" : "") << " stopped after " << ((400 - count) * 10) << "ms." << LL_ENDL;
 }
-
@@ -68,8 +68,8 @@ class AIEngine
 	typedef std::list<QueueElement> queued_type;
 	struct engine_state_type {
 	  queued_type list;
-	  bool waiting;
-	  engine_state_type(void) : waiting(false) { }
+	  int waiting;							// The number of threads waiting for state machines to be added.
+	  engine_state_type(void) : waiting(0) { }
 	};
 
   private:
@@ -88,6 +88,9 @@ class AIEngine
 
 	void mainloop(void);
 	void threadloop(void);
+	// Like threadloop, but any number of threads may call this at the same time;
+	// each call runs the state machine at the front of the queue once.
+	void poolloop(void);
 	void wake_up(void);
 	void flush(void);
 
@@ -30,6 +30,7 @@
 #include "llavatarappearance.h"
 #include "llavatarappearancedefines.h"
 #include "llavatarjointmesh.h"
+#include "llavatarsnapshot.h"
 #include "llstl.h"
 #include "imageids.h"
 #include "lldir.h"
@@ -346,10 +347,15 @@ void LLAvatarAppearance::initClass(const std::string& avatar_file_name_arg, cons
     {
         avatar_file_name = gDirUtilp->getExpandedFilename(LL_PATH_CHARACTER,AVATAR_DEFAULT_CHAR + "_lad.xml");
     }
-	BOOL success = sXMLTree.parseFile( avatar_file_name, FALSE );
+	BOOL success = LLAvatarSnapshot::instance().loadXmlTree(avatar_file_name, sXMLTree);
 	if (!success)
 	{
-		LL_ERRS() << "Problem reading avatar configuration file:" << avatar_file_name << LL_ENDL;
+		success = sXMLTree.parseFile( avatar_file_name, FALSE );
+		if (!success)
+		{
+			LL_ERRS() << "Problem reading avatar configuration file:" << avatar_file_name << LL_ENDL;
+		}
+		LLAvatarSnapshot::instance().storeXmlTree(avatar_file_name, sXMLTree);
 	}
 
 	// now sanity check xml file
@@ -450,6 +456,7 @@ void LLAvatarAppearance::initClass(const std::string& avatar_file_name_arg, cons
 
 void LLAvatarAppearance::cleanupClass()
 {
+	LLAvatarSnapshot::instance().save();
 	delete_and_clear(sAvatarXmlInfo);
 	delete_and_clear(sAvatarSkeletonInfo);
 	sSkeletonXMLTree.cleanup();
@@ -580,12 +587,17 @@ BOOL LLAvatarAppearance::parseSkeletonFile(const std::string& filename)
 	//-------------------------------------------------------------------------
 	// parse the file
 	//-------------------------------------------------------------------------
-	BOOL parsesuccess = sSkeletonXMLTree.parseFile( filename, FALSE );
-
+	BOOL parsesuccess = LLAvatarSnapshot::instance().loadXmlTree(filename, sSkeletonXMLTree);
 	if (!parsesuccess)
 	{
-		LL_ERRS() << "Can't parse skeleton file: " << filename << LL_ENDL;
-		return FALSE;
+		parsesuccess = sSkeletonXMLTree.parseFile( filename, FALSE );
+
+		if (!parsesuccess)
+		{
+			LL_ERRS() << "Can't parse skeleton file: " << filename << LL_ENDL;
+			return FALSE;
+		}
+		LLAvatarSnapshot::instance().storeXmlTree(filename, sSkeletonXMLTree);
 	}
 
 	// now sanity check xml file
@@ -948,6 +960,8 @@ BOOL LLAvatarAppearance::loadAvatar()
 		LL_WARNS() << "avatar file: loadNodeMesh() failed" << LL_ENDL;
 		return FALSE;
 	}
+	// Only writes anything the first time, or after the files changed.
+	LLAvatarSnapshot::instance().save();
 	
 	// avatar_lad.xml : <global_color>
 	if( sAvatarXmlInfo->mTexSkinColorInfo )
@@ -1430,6 +1444,44 @@ LLPolyMesh* LLAvatarAppearance::getMesh( LLPolyMeshSharedData *shared_data )
 	return NULL;
 }
 
+//-----------------------------------------------------------------------------
+// updateVisualParams()
+//-----------------------------------------------------------------------------
+void LLAvatarAppearance::updateVisualParams()
+{
+	beginMorphBatch();
+	LLCharacter::updateVisualParams();
+	endMorphBatch();
+}
+
+void LLAvatarAppearance::beginMorphBatch()
+{
+	for (polymesh_map_t::iterator i = mPolyMeshes.begin(); i != mPolyMeshes.end(); ++i)
+	{
+		// LOD meshes share the vertices of their reference mesh.
+		if (!i->second->isLOD())
+		{
+			i->second->beginMorphBatch();
+		}
+	}
+}
+
+void LLAvatarAppearance::endMorphBatch()
+{
+	std::vector<LLPolyMesh*> meshes;
+	for (polymesh_map_t::iterator i = mPolyMeshes.begin(); i != mPolyMeshes.end(); ++i)
+	{
+		if (i->second->inMorphBatch())
+		{
+			meshes.push_back(i->second);
+		}
+	}
+	// Renormalizing runs in parallel, so each mesh must be listed once.
+	std::sort(meshes.begin(), meshes.end());
+	meshes.erase(std::unique(meshes.begin(), meshes.end()), meshes.end());
+	LLPolyMesh::endMorphBatches(meshes);
+}
+
 // static
 void LLAvatarAppearance::getMeshInfo (mesh_info_t* mesh_info)
 {
@@ -264,6 +264,14 @@ public:
 protected:
 	virtual void	dirtyMesh(S32 priority) = 0; // Dirty the avatar mesh, with priority
 
+public:
+	// Applies the changed visual params inside a morph batch.
+	/*virtual*/ void	updateVisualParams();
+	// Morph targets applied in between only derive the normals of the
+	// vertices they touched once, at the end (see LLPolyMesh).
+	void			beginMorphBatch();
+	void			endMorphBatch();
+
 protected:
 	friend class WavefrontSaver;
 	typedef std::multimap<std::string, LLPolyMesh*> polymesh_map_t;
@@ -0,0 +1,408 @@
+/** 
+ * @file llavatarsnapshot.cpp
+ * @brief Memory mapped snapshot of the parsed avatar definition and mesh files
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llavatarsnapshot.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "lldir.h"
+#include "llfasttimer.h"
+#include "llfile.h"
+#include "llxmltree.h"
+
+static const U32 SNAPSHOT_MAGIC = 0x50534e41;	// "ANSP", also tells byte order apart.
+static const U32 SNAPSHOT_VERSION = 2;	// 2: sanitized morph binormals.
+static const char SNAPSHOT_FILENAME[] = "avatar_snapshot.bin";
+static const U32 SNAPSHOT_MAX_SECTIONS = 4096;
+
+static LLTrace::BlockTimerStatHandle FTM_AVATAR_SNAPSHOT_HASH("Avatar Snapshot Hash");
+static LLTrace::BlockTimerStatHandle FTM_AVATAR_SNAPSHOT_WRITE("Avatar Snapshot Write");
+
+namespace
+{
+
+size_t align16(size_t size)
+{
+	return (size + 15) & ~(size_t)15;
+}
+
+// Mixes in 8 bytes at a time; good enough to notice an edited file.
+class ContentHash
+{
+public:
+	ContentHash() : mHash(0x9e3779b97f4a7c15ULL), mLength(0) { }
+
+	void update(const U8* data, size_t size)
+	{
+		mLength += size;
+		for (; size >= 8; data += 8, size -= 8)
+		{
+			U64 word;
+			memcpy(&word, data, 8);
+			mix(word);
+		}
+		if (size)
+		{
+			U64 word = 0;
+			memcpy(&word, data, size);
+			mix(word);
+		}
+	}
+
+	U64 digest() const
+	{
+		U64 hash = mHash ^ mLength;
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+private:
+	void mix(U64 word)
+	{
+		mHash = (mHash ^ word) * 0x100000001b3ULL;
+		mHash ^= mHash >> 29;
+	}
+
+	U64 mHash;
+	U64 mLength;
+};
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+// LLSnapshotWriter / LLSnapshotReader
+//-----------------------------------------------------------------------------
+void LLSnapshotWriter::putString(const std::string& value)
+{
+	put((U32)value.size());
+	mOutput.append(value);
+}
+
+void LLSnapshotWriter::putArray(const void* data, size_t size)
+{
+	mOutput.resize(align16(mOutput.size()), '\0');
+	mOutput.append((const char*)data, size);
+}
+
+bool LLSnapshotReader::getString(std::string& value)
+{
+	U32 size;
+	if (!get(size) || (size_t)(mEnd - mCur) < size)
+	{
+		mCur = mEnd;
+		return false;
+	}
+	value.assign((const char*)mCur, size);
+	mCur += size;
+	return true;
+}
+
+bool LLSnapshotReader::align()
+{
+	size_t offset = align16(mCur - mStart);
+	if ((size_t)(mEnd - mStart) < offset)
+	{
+		mCur = mEnd;
+		return false;
+	}
+	mCur = mStart + offset;
+	return true;
+}
+
+bool LLSnapshotReader::getArray(void* data, size_t size)
+{
+	if (!align() || (size_t)(mEnd - mCur) < size)
+	{
+		mCur = mEnd;
+		return false;
+	}
+	memcpy(data, mCur, size);
+	mCur += size;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// LLAvatarSnapshot
+//-----------------------------------------------------------------------------
+bool LLAvatarSnapshot::sEnabled = true;
+
+LLAvatarSnapshot::LLAvatarSnapshot()
+:	mRegion(NULL),
+	mMapped(false),
+	mDirty(false),
+	mHits(0),
+	mMisses(0)
+{
+}
+
+LLAvatarSnapshot::~LLAvatarSnapshot()
+{
+	unmap();
+}
+
+// static
+std::string LLAvatarSnapshot::getFilename()
+{
+	std::string cache_dir = gDirUtilp->getCacheDir();
+	if (cache_dir.empty())
+	{
+		// Too early during startup.
+		return std::string();
+	}
+	return gDirUtilp->add(cache_dir, SNAPSHOT_FILENAME);
+}
+
+bool LLAvatarSnapshot::getFileHash(const std::string& filename, U64& hash)
+{
+	std::map<std::string, U64>::iterator iter = mFileHashes.find(filename);
+	if (iter != mFileHashes.end())
+	{
+		hash = iter->second;
+		return true;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_AVATAR_SNAPSHOT_HASH);
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if (!fp)
+	{
+		return false;
+	}
+	ContentHash content_hash;
+	U8 buffer[65536];
+	size_t nread;
+	while ((nread = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+	{
+		content_hash.update(buffer, nread);
+	}
+	fclose(fp);
+
+	hash = content_hash.digest();
+	mFileHashes[filename] = hash;
+	return true;
+}
+
+// File layout: magic, version, number of sections, then per section the key,
+// hash, offset and size, then the section data at 16 byte aligned offsets.
+void LLAvatarSnapshot::map()
+{
+	std::string filename = getFilename();
+	if (filename.empty())
+	{
+		return;
+	}
+	mMapped = true;
+	if (!LLFile::isfile(filename))
+	{
+		return;
+	}
+
+	try
+	{
+		boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_only);
+		mRegion = new boost::interprocess::mapped_region(file, boost::interprocess::read_only);
+	}
+	catch (boost::interprocess::interprocess_exception& e)
+	{
+		LL_WARNS() << "Can't map " << filename << ": " << e.what() << LL_ENDL;
+		return;
+	}
+
+	const U8* data = (const U8*)mRegion->get_address();
+	U64 size = (U64)mRegion->get_size();
+	LLSnapshotReader reader(data, (size_t)size);
+	U32 magic, version, count;
+	if (!reader.get(magic) || magic != SNAPSHOT_MAGIC ||
+		!reader.get(version) || version != SNAPSHOT_VERSION ||
+		!reader.get(count) || count > SNAPSHOT_MAX_SECTIONS)
+	{
+		// Older format; it gets replaced by the next save().
+		unmap();
+		return;
+	}
+	for (U32 i = 0; i < count; ++i)
+	{
+		std::string key;
+		Section section;
+		if (!reader.getString(key) || !reader.get(section.mHash) ||
+			!reader.get(section.mOffset) || !reader.get(section.mSize) ||
+			section.mOffset > size || section.mSize > size - section.mOffset)
+		{
+			LL_WARNS() << "Discarding corrupt avatar snapshot " << filename << LL_ENDL;
+			mSections.clear();
+			unmap();
+			return;
+		}
+		mSections[key] = section;
+	}
+}
+
+void LLAvatarSnapshot::unmap()
+{
+	delete mRegion;
+	mRegion = NULL;
+}
+
+bool LLAvatarSnapshot::find(const std::string& filename, const U8*& data, U32& size)
+{
+	if (!sEnabled)
+	{
+		return false;
+	}
+	if (!mMapped)
+	{
+		map();
+	}
+
+	sections_t::iterator iter = mSections.find(filename);
+	U64 hash;
+	if (iter == mSections.end() || !getFileHash(filename, hash) || iter->second.mHash != hash)
+	{
+		++mMisses;
+		return false;
+	}
+
+	const Section& section = iter->second;
+	if (!section.mData.empty())
+	{
+		data = (const U8*)section.mData.data();
+	}
+	else if (mRegion)
+	{
+		data = (const U8*)mRegion->get_address() + section.mOffset;
+	}
+	else
+	{
+		++mMisses;
+		return false;
+	}
+	size = (U32)section.mSize;
+	++mHits;
+	return true;
+}
+
+void LLAvatarSnapshot::store(const std::string& filename, const std::string& data)
+{
+	U64 hash;
+	if (!sEnabled || data.empty() || !getFileHash(filename, hash))
+	{
+		return;
+	}
+	Section& section = mSections[filename];
+	section.mHash = hash;
+	section.mOffset = 0;
+	section.mSize = data.size();
+	section.mData = data;
+	mDirty = true;
+}
+
+bool LLAvatarSnapshot::loadXmlTree(const std::string& filename, LLXmlTree& tree)
+{
+	const U8* data;
+	U32 size;
+	return find(filename, data, size) && tree.parseBinary(data, size);
+}
+
+void LLAvatarSnapshot::storeXmlTree(const std::string& filename, const LLXmlTree& tree)
+{
+	if (sEnabled)
+	{
+		std::string data;
+		tree.writeBinary(data);
+		store(filename, data);
+	}
+}
+
+void LLAvatarSnapshot::save()
+{
+	std::string filename = getFilename();
+	if (!mDirty || filename.empty())
+	{
+		return;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_AVATAR_SNAPSHOT_WRITE);
+	std::string header;
+	LLSnapshotWriter writer(header);
+	writer.put(SNAPSHOT_MAGIC);
+	writer.put(SNAPSHOT_VERSION);
+	writer.put((U32)mSections.size());
+	size_t table_size = header.size();
+	for (sections_t::const_iterator iter = mSections.begin(); iter != mSections.end(); ++iter)
+	{
+		table_size += sizeof(U32) + iter->first.size() + 3 * sizeof(U64);
+	}
+	U64 offset = align16(table_size);
+	for (sections_t::const_iterator iter = mSections.begin(); iter != mSections.end(); ++iter)
+	{
+		writer.putString(iter->first);
+		writer.put(iter->second.mHash);
+		writer.put(offset);
+		writer.put(iter->second.mSize);
+		offset = align16(offset + iter->second.mSize);
+	}
+	header.resize(align16(header.size()), '\0');
+
+	// Write to a temporary file first so that a crash never leaves a truncated snapshot behind.
+	std::string tmp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(tmp_filename, "wb");
+	if (!fp)
+	{
+		return;
+	}
+	static const char padding[16] = { 0 };
+	bool ok = fwrite(header.data(), 1, header.size(), fp) == header.size();
+	for (sections_t::const_iterator iter = mSections.begin(); ok && iter != mSections.end(); ++iter)
+	{
+		const Section& section = iter->second;
+		const char* data = section.mData.empty() ? (const char*)mRegion->get_address() + section.mOffset : section.mData.data();
+		size_t pad = align16(section.mSize) - section.mSize;
+		ok = fwrite(data, 1, section.mSize, fp) == section.mSize &&
+			 fwrite(padding, 1, pad, fp) == pad;
+	}
+	fclose(fp);
+
+	// The old file can't be replaced while it is mapped on Windows; forget
+	// about it and map the new one the next time a section is looked up.
+	unmap();
+	mSections.clear();
+	mMapped = false;
+	mDirty = false;
+	if (ok)
+	{
+		// rename() doesn't replace existing files on Windows.
+		LLFile::remove_nowarn(filename);
+	}
+	if (!ok || LLFile::rename_nowarn(tmp_filename, filename) != 0)
+	{
+		LL_WARNS() << "Failed to write avatar snapshot " << filename << LL_ENDL;
+		LLFile::remove_nowarn(tmp_filename);
+	}
+}
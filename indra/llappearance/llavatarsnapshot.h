@@ -0,0 +1,159 @@
+/** 
+ * @file llavatarsnapshot.h
+ * @brief Memory mapped snapshot of the parsed avatar definition and mesh files
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLAVATARSNAPSHOT_H
+#define LL_LLAVATARSNAPSHOT_H
+
+#include <map>
+#include <string>
+
+#include "llsingleton.h"
+
+class LLXmlTree;
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+//
+// Native endian serialization of a snapshot section. Arrays start on 16 byte
+// boundaries of the section, and sections start on 16 byte boundaries of the
+// snapshot file, so that LLVector4a data can be used in place.
+//
+class LLSnapshotWriter
+{
+public:
+	LLSnapshotWriter(std::string& output) : mOutput(output) { }
+
+	template<typename T>
+	void put(const T& value)
+	{
+		mOutput.append((const char*)&value, sizeof(T));
+	}
+
+	void putString(const std::string& value);
+	void putArray(const void* data, size_t size);
+
+private:
+	std::string& mOutput;
+};
+
+class LLSnapshotReader
+{
+public:
+	LLSnapshotReader(const U8* data, size_t size) : mStart(data), mCur(data), mEnd(data + size) { }
+
+	// All getters return false, and leave the reader at the end, on overrun.
+	template<typename T>
+	bool get(T& value)
+	{
+		if ((size_t)(mEnd - mCur) < sizeof(T))
+		{
+			mCur = mEnd;
+			return false;
+		}
+		memcpy(&value, mCur, sizeof(T));
+		mCur += sizeof(T);
+		return true;
+	}
+
+	bool getString(std::string& value);
+	bool getArray(void* data, size_t size);
+
+	bool atEnd() const { return mCur == mEnd; }
+
+private:
+	bool align();
+
+	const U8* mStart;
+	const U8* mCur;
+	const U8* mEnd;
+};
+
+//
+// LLAvatarSnapshot keeps the parsed form of the avatar definition files
+// (avatar_lad.xml, the skeleton) and of the base .llm meshes in a single
+// versioned file in the cache directory, which is memory mapped on startup.
+// Each section is keyed on the path of its source file and carries a hash of
+// that file's contents; a section is only used while the hash still matches.
+// New sections are collected in memory and written out by save().
+//
+class LLAvatarSnapshot : public LLSingleton<LLAvatarSnapshot>
+{
+	friend class LLSingleton<LLAvatarSnapshot>;
+	LLAvatarSnapshot();
+	~LLAvatarSnapshot();
+
+public:
+	// Returns the section stored for filename, or false when there is none
+	// or the file changed since. The data is valid until the next save().
+	bool find(const std::string& filename, const U8*& data, U32& size);
+
+	// Replaces the section for filename. Only call this right after reading
+	// the file, so that the stored hash describes the parsed contents.
+	void store(const std::string& filename, const std::string& data);
+
+	bool loadXmlTree(const std::string& filename, LLXmlTree& tree);
+	void storeXmlTree(const std::string& filename, const LLXmlTree& tree);
+
+	// Writes the snapshot file if any sections were stored.
+	void save();
+
+	static void setEnabled(bool enabled) { sEnabled = enabled; }
+	static bool enabled() { return sEnabled; }
+
+	U32 getHits() const { return mHits; }
+	U32 getMisses() const { return mMisses; }
+
+private:
+	struct Section
+	{
+		Section() : mHash(0), mOffset(0), mSize(0) { }
+		U64 mHash;
+		U64 mOffset;				// Offset in the mapped file, unless pending.
+		U64 mSize;
+		std::string mData;			// Pending data, not yet saved.
+	};
+	typedef std::map<std::string, Section> sections_t;
+
+	static std::string getFilename();
+
+	// Hash of the current contents of filename, cached for the session.
+	bool getFileHash(const std::string& filename, U64& hash);
+
+	void map();
+	void unmap();
+
+	boost::interprocess::mapped_region* mRegion;
+	bool mMapped;					// Whether we tried to map the file yet.
+	bool mDirty;
+	sections_t mSections;
+	std::map<std::string, U64> mFileHashes;
+	U32 mHits;
+	U32 mMisses;
+
+	static bool sEnabled;
+};
+
+#endif // LL_LLAVATARSNAPSHOT_H
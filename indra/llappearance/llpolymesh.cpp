@@ -29,12 +29,15 @@
 //-----------------------------------------------------------------------------
 #include "linden_common.h"
 #include "llpolymesh.h"
+#include "boost/bind.hpp"
 #include "llfasttimer.h"
+#include "lljobsystem.h"
 #include "llmemory.h"
 
 //#include "llviewercontrol.h"
 #include "llxmltree.h"
 #include "llavatarappearance.h"
+#include "llavatarsnapshot.h"
 //#include "llwearable.h"
 #include "lldir.h"
 #include "llvolume.h"
@@ -267,6 +270,171 @@ BOOL LLPolyMeshSharedData::allocateJointNames( U32 numJointNames )
 	return TRUE;
 }
 
+//--------------------------------------------------------------------
+// LLPolyMeshSharedData::writeSnapshot()
+//--------------------------------------------------------------------
+void LLPolyMeshSharedData::writeSnapshot(std::string& output)
+{
+	LLSnapshotWriter writer(output);
+	writer.put((U8)isLOD());
+	writer.put(mHasWeights);
+	writer.put(mHasDetailTexCoords);
+	writer.put(mPosition);
+	writer.put(mRotation);
+	writer.put(mScale);
+	writer.put(mNumVertices);
+	if (!isLOD())
+	{
+		writer.putArray(mBaseCoords, mNumVertices * sizeof(LLVector4a));
+		writer.putArray(mBaseNormals, mNumVertices * sizeof(LLVector4a));
+		writer.putArray(mBaseBinormals, mNumVertices * sizeof(LLVector4a));
+		writer.putArray(mTexCoords, mNumVertices * sizeof(LLVector2));
+		if (mHasDetailTexCoords)
+		{
+			writer.putArray(mDetailTexCoords, mNumVertices * sizeof(LLVector2));
+		}
+		if (mHasWeights)
+		{
+			writer.putArray(mWeights, mNumVertices * sizeof(F32));
+		}
+	}
+
+	writer.put(mNumFaces);
+	writer.putArray(mFaces, mNumFaces * sizeof(LLPolyFace));
+
+	writer.put(mNumJointNames);
+	for (U32 i = 0; i < mNumJointNames; i++)
+	{
+		writer.putString(mJointNames[i]);
+	}
+
+	// Including the morphs cloned from the ones in the file.
+	writer.put((U32)mMorphData.size());
+	for (morphdata_list_t::const_iterator iter = mMorphData.begin(); iter != mMorphData.end(); ++iter)
+	{
+		(*iter)->writeSnapshot(writer);
+	}
+
+	writer.put((U32)mSharedVerts.size());
+	for (std::map<S32, S32>::const_iterator iter = mSharedVerts.begin(); iter != mSharedVerts.end(); ++iter)
+	{
+		writer.put(iter->first);
+		writer.put(iter->second);
+	}
+}
+
+//--------------------------------------------------------------------
+// LLPolyMeshSharedData::readSnapshot()
+//--------------------------------------------------------------------
+BOOL LLPolyMeshSharedData::readSnapshot(const U8* data, U32 size)
+{
+	LLSnapshotReader reader(data, size);
+	U8 lod;
+	if (!reader.get(lod) || (lod != 0) != (isLOD() != FALSE))
+	{
+		return FALSE;
+	}
+
+	BOOL has_weights, has_detail_tex_coords;
+	LLVector3 position, scale;
+	LLQuaternion rotation;
+	S32 num_vertices;
+	if (!reader.get(has_weights) || !reader.get(has_detail_tex_coords) ||
+		!reader.get(position) || !reader.get(rotation) || !reader.get(scale) ||
+		!reader.get(num_vertices) || num_vertices < 0 || num_vertices > 65535)
+	{
+		return FALSE;
+	}
+	setPosition(position);
+	setRotation(rotation);
+	setScale(scale);
+
+	freeMeshData();
+
+	bool ok = true;
+	if (!isLOD())
+	{
+		mHasWeights = has_weights;
+		mHasDetailTexCoords = has_detail_tex_coords;
+		allocateVertexData(num_vertices);
+		ok = reader.getArray(mBaseCoords, num_vertices * sizeof(LLVector4a)) &&
+			 reader.getArray(mBaseNormals, num_vertices * sizeof(LLVector4a)) &&
+			 reader.getArray(mBaseBinormals, num_vertices * sizeof(LLVector4a)) &&
+			 reader.getArray(mTexCoords, num_vertices * sizeof(LLVector2)) &&
+			 (!mHasDetailTexCoords || reader.getArray(mDetailTexCoords, num_vertices * sizeof(LLVector2))) &&
+			 (!mHasWeights || reader.getArray(mWeights, num_vertices * sizeof(F32)));
+	}
+	mNumVertices = num_vertices;
+
+	S32 num_faces;
+	ok = ok && reader.get(num_faces) && num_faces >= 0 && num_faces <= 65535;
+	if (ok)
+	{
+		allocateFaceData(num_faces);
+		ok = reader.getArray(mFaces, num_faces * sizeof(LLPolyFace));
+	}
+
+	U32 num_joint_names;
+	ok = ok && reader.get(num_joint_names) && num_joint_names <= 65535;
+	if (ok && num_joint_names)
+	{
+		allocateJointNames(num_joint_names);
+		for (U32 i = 0; ok && i < num_joint_names; i++)
+		{
+			ok = reader.getString(mJointNames[i]);
+		}
+	}
+
+	U32 num_morphs;
+	ok = ok && reader.get(num_morphs);
+	for (U32 i = 0; ok && i < num_morphs; i++)
+	{
+		std::string name;
+		ok = reader.getString(name);
+		if (ok)
+		{
+			LLPolyMorphData* morph_data = new LLPolyMorphData(name);
+			ok = morph_data->readSnapshot(reader, this);
+			if (ok)
+			{
+				mMorphData.insert(morph_data);
+			}
+			else
+			{
+				delete morph_data;
+			}
+		}
+	}
+
+	U32 num_remaps;
+	ok = ok && reader.get(num_remaps);
+	for (U32 i = 0; ok && i < num_remaps; i++)
+	{
+		S32 remap_src, remap_dst;
+		ok = reader.get(remap_src) && reader.get(remap_dst);
+		if (ok)
+		{
+			mSharedVerts[remap_src] = remap_dst;
+		}
+	}
+
+	if (!ok || !reader.atEnd())
+	{
+		LL_WARNS() << "Discarding corrupt mesh snapshot" << LL_ENDL;
+		freeMeshData();
+		for_each(mMorphData.begin(), mMorphData.end(), DeletePointer());
+		mMorphData.clear();
+		mSharedVerts.clear();
+		return FALSE;
+	}
+
+	if (0 == mNumJointNames)
+	{
+		allocateJointNames(1);
+	}
+	return TRUE;
+}
+
 //--------------------------------------------------------------------
 // LLPolyMeshSharedData::loadMesh()
 //--------------------------------------------------------------------
@@ -280,6 +448,15 @@ BOOL LLPolyMeshSharedData::loadMesh( const std::string& fileName )
                 LL_ERRS() << "Filename is Empty!" << LL_ENDL;
 		return FALSE;
 	}
+
+	const U8* snapshot_data;
+	U32 snapshot_size;
+	if (LLAvatarSnapshot::instance().find(fileName, snapshot_data, snapshot_size) &&
+		readSnapshot(snapshot_data, snapshot_size))
+	{
+		return TRUE;
+	}
+
 	LLFILE* fp = LLFile::fopen(fileName, "rb");			/*Flawfinder: ignore*/
 	if (!fp)
 	{
@@ -715,6 +892,13 @@ BOOL LLPolyMeshSharedData::loadMesh( const std::string& fileName )
 
 	fclose( fp );
 
+	if (status && LLAvatarSnapshot::enabled())
+	{
+		std::string snapshot;
+		writeSnapshot(snapshot);
+		LLAvatarSnapshot::instance().store(fileName, snapshot);
+	}
+
 	return status;
 }
 
@@ -758,6 +942,7 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
 	mFaceIndexOffset = 0;
 	mFaceVertexCount = 0;
 	mFaceVertexOffset = 0;
+	mMorphBatch = false;
 
 	if (shared_data->isLOD() && reference_mesh)
 	{
@@ -796,6 +981,7 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
 		mBinormals			=   (LLVector4a*)(mVertexData + offset); offset += 4*nverts;
 		mScaledBinormals	=   (LLVector4a*)(mVertexData + offset); offset += 4*nverts; 
 		initializeForMorph();
+		mMorphedFlags.resize(mSharedData->mNumVertices, 0);
 	}
 }
 
@@ -1732,6 +1918,95 @@ void LLPolyMesh::initializeForMorph()
 }
 
 
+//-----------------------------------------------------------------------------
+// Morph batches
+//-----------------------------------------------------------------------------
+static LLTrace::BlockTimerStatHandle FTM_END_MORPH_BATCH("End Morph Batch");
+
+// Below this many morphed vertices renormalizing isn't worth waking workers for.
+static const U32 MIN_PARALLEL_MORPHED_VERTICES = 8192;
+static const U32 MORPHED_VERTICES_PER_CHUNK = 2048;
+
+namespace
+{
+	struct MorphedChunk
+	{
+		LLPolyMesh* mMesh;
+		U32 mBegin;
+		U32 mEnd;
+	};
+
+	void renormalize_chunk(const std::vector<MorphedChunk>* chunks, S32 index)
+	{
+		const MorphedChunk& chunk = (*chunks)[index];
+		LLPolyMesh::renormalizeMorphedVertices(chunk.mMesh, chunk.mBegin, chunk.mEnd);
+	}
+}
+
+// static
+void LLPolyMesh::renormalizeMorphedVertices(LLPolyMesh* mesh, U32 begin, U32 end)
+{
+	for (U32 i = begin; i < end; ++i)
+	{
+		mesh->renormalizeVertex(mesh->mMorphedVertices[i]);
+	}
+}
+
+void LLPolyMesh::clearMorphedVertices()
+{
+	for (std::vector<U32>::const_iterator iter = mMorphedVertices.begin(); iter != mMorphedVertices.end(); ++iter)
+	{
+		mMorphedFlags[*iter] = 0;
+	}
+	mMorphedVertices.clear();
+	mMorphBatch = false;
+}
+
+// static
+void LLPolyMesh::endMorphBatches(const std::vector<LLPolyMesh*>& meshes)
+{
+	LL_RECORD_BLOCK_TIME(FTM_END_MORPH_BATCH);
+
+	U32 total = 0;
+	for (std::vector<LLPolyMesh*>::const_iterator iter = meshes.begin(); iter != meshes.end(); ++iter)
+	{
+		total += (*iter)->mMorphedVertices.size();
+	}
+
+	LLJobSystem& jobs = LLJobSystem::instance();
+	if (total < MIN_PARALLEL_MORPHED_VERTICES || !jobs.getWorkerCount())
+	{
+		for (std::vector<LLPolyMesh*>::const_iterator iter = meshes.begin(); iter != meshes.end(); ++iter)
+		{
+			renormalizeMorphedVertices(*iter, 0, (*iter)->mMorphedVertices.size());
+		}
+	}
+	else
+	{
+		std::vector<MorphedChunk> chunks;
+		for (std::vector<LLPolyMesh*>::const_iterator iter = meshes.begin(); iter != meshes.end(); ++iter)
+		{
+			U32 count = (*iter)->mMorphedVertices.size();
+			for (U32 begin = 0; begin < count; begin += MORPHED_VERTICES_PER_CHUNK)
+			{
+				MorphedChunk chunk = { *iter, begin, llmin(begin + MORPHED_VERTICES_PER_CHUNK, count) };
+				chunks.push_back(chunk);
+			}
+		}
+		jobs.parallelFor(chunks.size(), boost::bind(&renormalize_chunk, &chunks, _1));
+	}
+
+	for (std::vector<LLPolyMesh*>::const_iterator iter = meshes.begin(); iter != meshes.end(); ++iter)
+	{
+		(*iter)->clearMorphedVertices();
+	}
+}
+
+void LLPolyMesh::endMorphBatch()
+{
+	endMorphBatches(std::vector<LLPolyMesh*>(1, this));
+}
+
 //-----------------------------------------------------------------------------
 // getMorphList()
 //-----------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include "llstl.h"
 
 #include "v3math.h"
@@ -128,10 +129,14 @@ private:
 	// Retrieve the number of KB of memory used by this instance
 	U32 getNumKB();
 
-	// Load mesh data from file
-	BOOL loadMesh( const std::string& fileName );
+	// Everything loadMesh() reads, for the avatar startup snapshot.
+	void writeSnapshot(std::string& output);
+	BOOL readSnapshot(const U8* data, U32 size);
 
 public:
+	// Load mesh data from file, or from the avatar startup snapshot
+	BOOL loadMesh( const std::string& fileName );
+
 	void genIndices(S32 offset);
 
 	const LLVector2 &getUVs(U32 index);
@@ -353,8 +358,48 @@ public:
 	// Dumps diagnostic information about the global mesh table
 	static void dumpDiagInfo(void*);
 
+	//--------------------------------------------------------------------
+	// Morph batches
+	//--------------------------------------------------------------------
+	// While a batch is open, applied morphs only accumulate their deltas;
+	// the normals and binormals of the vertices they touched are derived
+	// once, when the batch ends.
+	void beginMorphBatch() { mMorphBatch = true; }
+	bool inMorphBatch() const { return mMorphBatch; }
+	void addMorphedVertex(U32 index)
+	{
+		if (!mMorphedFlags[index])
+		{
+			mMorphedFlags[index] = 1;
+			mMorphedVertices.push_back(index);
+		}
+	}
+
+	// Ends the batches of all meshes, renormalizing on the LLJobSystem
+	// workers as well when there are enough vertices to share.
+	static void endMorphBatches(const std::vector<LLPolyMesh*>& meshes);
+	void endMorphBatch();
+	// Renormalizes the entries [begin, end) of the batch of mesh; thread safe
+	// for disjoint ranges.
+	static void renormalizeMorphedVertices(LLPolyMesh* mesh, U32 begin, U32 end);
+
+	// Derives the output normal and binormal of a morphed vertex.
+	void renormalizeVertex(U32 index)
+	{
+		LLVector4a norm = mScaledNormals[index];
+		norm.normalize3fast();
+		mNormals[index] = norm;
+
+		LLVector4a tangent;
+		tangent.setCross3(mScaledBinormals[index], norm);
+		LLVector4a& normalized_binormal = mBinormals[index];
+		normalized_binormal.setCross3(norm, tangent);
+		normalized_binormal.normalize3fast();
+	}
+
 private:
 	void initializeForMorph();
+	void clearMorphedVertices();
 
 protected:
 	// mesh data shared across all instances of a given mesh
@@ -384,6 +429,11 @@ protected:
 
 	// Backlink only; don't make this an LLPointer.
 	LLAvatarAppearance* mAvatarp;
+
+	bool					mMorphBatch;
+	// Vertices touched by the open morph batch, and a flag per vertex.
+	std::vector<U32>		mMorphedVertices;
+	std::vector<U8>			mMorphedFlags;
 };
 
 #endif // LL_LLPOLYMESHINTERFACE_H
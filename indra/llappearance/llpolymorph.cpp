@@ -32,6 +32,7 @@
 #include "llpolymorph.h"
 #include "llavatarappearance.h"
 #include "llavatarjoint.h"
+#include "llavatarsnapshot.h"
 //#include "llwearable.h"
 #include "llxmltree.h"
 #include "llendianswizzle.h"
@@ -213,9 +214,134 @@ BOOL LLPolyMorphData::loadBinary(LLFILE *fp, LLPolyMeshSharedData *mesh)
 	mAvgDistortion.mul(1.f/(F32)mNumIndices);
 	mAvgDistortion.normalize3fast();
 
+	sanitizeBinormals();
+
 	return TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// sanitizeBinormals()
+//-----------------------------------------------------------------------------
+void LLPolyMorphData::sanitizeBinormals()
+{
+	for (U32 v = 0; v < mNumIndices; v++)
+	{
+		LLVector4a& binorm = mBinormals[v];
+		if (!binorm.isFinite3() || (binorm.dot3(binorm).getF32() <= F_APPROXIMATELY_ZERO))
+		{
+			binorm.set(1,0,0,1);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// applyTo()
+//-----------------------------------------------------------------------------
+void LLPolyMorphData::applyTo(LLPolyMesh* mesh, F32 delta_weight, const F32* mask_weights, bool clothing) const
+{
+	LLVector4a* coords = mesh->getWritableCoords();
+	LLVector4a* scaled_normals = mesh->getScaledNormals();
+	LLVector4a* scaled_binormals = mesh->getScaledBinormals();
+	LLVector4a* clothing_weights = clothing ? mesh->getWritableClothingWeights() : NULL;
+	LLVector2* tex_coords = mesh->getWritableTexCoords();
+	const bool batch = mesh->inMorphBatch();
+
+	LLVector4a weight;
+	weight.splat(delta_weight);
+	LLVector4a normal_weight;
+	normal_weight.splat(delta_weight * NORMAL_SOFTEN_FACTOR);
+	F32 mask_weight = 1.f;
+
+	for (U32 v = 0; v < mNumIndices; v++)
+	{
+		const U32 vert_index_mesh = mVertexIndices[v];
+
+		if (mask_weights)
+		{
+			mask_weight = mask_weights[v];
+			weight.splat(delta_weight * mask_weight);
+			normal_weight.splat(delta_weight * mask_weight * NORMAL_SOFTEN_FACTOR);
+		}
+
+		LLVector4a pos;
+		pos.setMul(mCoords[v], weight);
+		coords[vert_index_mesh].add(pos);
+
+		if (clothing_weights)
+		{
+			LLVector4a& clothing_weight = clothing_weights[vert_index_mesh];
+			clothing_weight.add(pos);
+			clothing_weight.getF32ptr()[VW] = mask_weight;
+		}
+
+		LLVector4a delta;
+		delta.setMul(mNormals[v], normal_weight);
+		scaled_normals[vert_index_mesh].add(delta);
+		delta.setMul(mBinormals[v], normal_weight);
+		scaled_binormals[vert_index_mesh].add(delta);
+
+		tex_coords[vert_index_mesh] += mTexCoords[v] * (delta_weight * mask_weight);
+
+		if (batch)
+		{
+			mesh->addMorphedVertex(vert_index_mesh);
+		}
+		else
+		{
+			mesh->renormalizeVertex(vert_index_mesh);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// writeSnapshot()
+//-----------------------------------------------------------------------------
+void LLPolyMorphData::writeSnapshot(LLSnapshotWriter& writer) const
+{
+	writer.putString(mName);
+	writer.put(mNumIndices);
+	writer.put(mTotalDistortion);
+	writer.put(mMaxDistortion);
+	writer.put(mAvgDistortion);
+	writer.putArray(mVertexIndices, mNumIndices * sizeof(U32));
+	writer.putArray(mCoords, mNumIndices * sizeof(LLVector4a));
+	writer.putArray(mNormals, mNumIndices * sizeof(LLVector4a));
+	writer.putArray(mBinormals, mNumIndices * sizeof(LLVector4a));
+	writer.putArray(mTexCoords, mNumIndices * sizeof(LLVector2));
+}
+
+//-----------------------------------------------------------------------------
+// readSnapshot()
+// The name was read by the caller.
+//-----------------------------------------------------------------------------
+BOOL LLPolyMorphData::readSnapshot(LLSnapshotReader& reader, LLPolyMeshSharedData *mesh)
+{
+	freeData();
+
+	U32 num_indices;
+	if (!reader.get(num_indices) || num_indices > 10000 ||
+		!reader.get(mTotalDistortion) || !reader.get(mMaxDistortion) || !reader.get(mAvgDistortion))
+	{
+		return FALSE;
+	}
+
+	U32 size = sizeof(LLVector4a) * num_indices;
+	mCoords = static_cast<LLVector4a*>(ll_aligned_malloc_16(size));
+	mNormals = static_cast<LLVector4a*>(ll_aligned_malloc_16(size));
+	mBinormals = static_cast<LLVector4a*>(ll_aligned_malloc_16(size));
+	mTexCoords = new LLVector2[num_indices];
+	mVertexIndices = new U32[num_indices];
+	mNumIndices = num_indices;
+	mCurrentIndex = 0;
+	mMesh = mesh;
+
+	return reader.getArray(mVertexIndices, num_indices * sizeof(U32)) &&
+		   reader.getArray(mCoords, size) &&
+		   reader.getArray(mNormals, size) &&
+		   reader.getArray(mBinormals, size) &&
+		   reader.getArray(mTexCoords, num_indices * sizeof(LLVector2));
+}
+
 //-----------------------------------------------------------------------------
 // freeData()
 //-----------------------------------------------------------------------------
@@ -544,6 +670,8 @@ BOOL LLPolyMorphData::setMorphFromMesh(LLPolyMesh *morph)
 	mTexCoords     = new_tex_coords;
 	mNumIndices    = nindices;
 
+	sanitizeBinormals();
+
 	return TRUE;
 }
 
@@ -866,86 +994,10 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
 	if (delta_weight != 0.f)
 	{
 		llassert(!mMesh->isLOD());
-		LLVector4a *coords = mMesh->getWritableCoords();
-
-		LLVector4a *scaled_normals = mMesh->getScaledNormals();
-		LLVector4a *normals = mMesh->getWritableNormals();
-
-		LLVector4a *scaled_binormals = mMesh->getScaledBinormals();
-		LLVector4a *binormals = mMesh->getWritableBinormals();
-
-		LLVector4a *clothing_weights = mMesh->getWritableClothingWeights();
-		LLVector2 *tex_coords = mMesh->getWritableTexCoords();
-
 		F32 *maskWeightArray = (mVertMask) ? mVertMask->getMorphMaskWeights() : NULL;
+		mMorphData->applyTo(mMesh, delta_weight, maskWeightArray, getInfo()->mIsClothingMorph);
 
-		for(U32 vert_index_morph = 0; vert_index_morph < mMorphData->mNumIndices; vert_index_morph++)
-		{
-			S32 vert_index_mesh = mMorphData->mVertexIndices[vert_index_morph];
-
-			F32 maskWeight = 1.f;
-			if (maskWeightArray)
-			{
-				maskWeight = maskWeightArray[vert_index_morph];
-			}
-
-
-			LLVector4a pos = mMorphData->mCoords[vert_index_morph];
-			pos.mul(delta_weight*maskWeight);
-			coords[vert_index_mesh].add(pos);
-
-			if (getInfo()->mIsClothingMorph && clothing_weights)
-			{
-				LLVector4a clothing_offset = mMorphData->mCoords[vert_index_morph];
-				clothing_offset.mul(delta_weight * maskWeight);
-				LLVector4a* clothing_weight = &clothing_weights[vert_index_mesh];
-				clothing_weight->add(clothing_offset);
-				clothing_weight->getF32ptr()[VW] = maskWeight;
-			}
-
-			// calculate new normals based on half angles
-			LLVector4a norm = mMorphData->mNormals[vert_index_morph];
-			norm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-			scaled_normals[vert_index_mesh].add(norm);
-			norm = scaled_normals[vert_index_mesh];
-
-			// guard against degenerate input data before we create NaNs below!
-			//
-			norm.normalize3fast();
-			normals[vert_index_mesh] = norm;
-
-			// calculate new binormals
-			LLVector4a binorm = mMorphData->mBinormals[vert_index_morph];
-
-			// guard against degenerate input data before we create NaNs below!
-			//
-			if (!binorm.isFinite3() || (binorm.dot3(binorm).getF32() <= F_APPROXIMATELY_ZERO))
-			{
-				binorm.set(1,0,0,1);
-			}
-
-			binorm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-			scaled_binormals[vert_index_mesh].add(binorm);
-			LLVector4a tangent;
-			tangent.setCross3(scaled_binormals[vert_index_mesh], norm);
-			LLVector4a& normalized_binormal = binormals[vert_index_mesh];
-
-			normalized_binormal.setCross3(norm, tangent); 			
-			normalized_binormal.normalize3fast();
-			
-			tex_coords[vert_index_mesh] += mMorphData->mTexCoords[vert_index_morph] * delta_weight * maskWeight;
-		}
-
-		// now apply volume changes
-		for( volume_list_t::iterator iter = mVolumeMorphs.begin(); iter != mVolumeMorphs.end(); ++iter )
-		{
-			LLPolyVolumeMorph* volume_morph = &(*iter);
-			LLVector3 scale_delta = volume_morph->mScale * delta_weight;
-			LLVector3 pos_delta = volume_morph->mPos * delta_weight;
-			
-			volume_morph->mVolume->setScale(volume_morph->mVolume->getScale() + scale_delta);
-			volume_morph->mVolume->setPosition(volume_morph->mVolume->getPosition() + pos_delta);
-		}
+		applyVolumeChanges(delta_weight);
 	}
 
 	if (mNext)
@@ -34,6 +34,8 @@
 
 class LLAvatarJointCollisionVolume;
 class LLPolyMeshSharedData;
+class LLSnapshotReader;
+class LLSnapshotWriter;
 class LLVector2;
 class LLAvatarJointCollisionVolume;
 class LLWearable;
@@ -60,12 +62,19 @@ public:
 	}
 
 	BOOL			loadBinary(LLFILE* fp, LLPolyMeshSharedData *mesh);
+	void			writeSnapshot(LLSnapshotWriter& writer) const;
+	BOOL			readSnapshot(LLSnapshotReader& reader, LLPolyMeshSharedData *mesh);
 	const std::string& getName() { return mName; }
 
 	BOOL			saveLLM(LLFILE *fp);
 	BOOL			saveOBJ(LLFILE *fp);
 	BOOL			setMorphFromMesh(LLPolyMesh *morph);
 
+	// Adds delta_weight times this morph to mesh, scaled per vertex by
+	// mask_weights if not NULL, and to its clothing weights with clothing.
+	// Inside a morph batch of mesh the normals are derived when it ends.
+	void			applyTo(LLPolyMesh* mesh, F32 delta_weight, const F32* mask_weights, bool clothing) const;
+
 public:
 	std::string			mName;
 
@@ -85,6 +94,8 @@ public:
 
 private:
 	void freeData();
+	// Replaces degenerate binormals, so that applying doesn't create NaNs.
+	void sanitizeBinormals();
 } LL_ALIGN_POSTFIX(16);
 
 
@@ -34,6 +34,9 @@
  *
  *   26/01/2013
  *   Added support for LLCondition to AIThreadSafeSimple.
+ *
+ *   19/10/2026
+ *   Added AIThreadSafeRCU, AIRCUReadAccess and AIRCUWriteAccess.
  */
 
 // This file defines wrapper template classes for arbitrary types T
@@ -45,8 +48,8 @@
 // the access object obtains the lock, while destructing it releases
 // the lock.
 //
-// There are three types of wrapper classes:
-// AIThreadSafe, AIThreadSafeSimple and AIThreadSafeSingleThread.
+// There are four types of wrapper classes:
+// AIThreadSafe, AIThreadSafeSimple, AIThreadSafeSingleThread and AIThreadSafeRCU.
 //
 // AIThreadSafe is for use with the access classes:
 // AIReadAccessConst, AIReadAccess and AIWriteAccess.
@@ -67,10 +70,15 @@
 // AISTAccessConst provides read access to a const AIThreadSafeSingleThread.
 // AISTAccess provides read/write access to a non-const AIThreadSafeSingleThread.
 //
+// AIRCUReadAccess provides read access to an AIThreadSafeRCU.
+// AIRCUWriteAccess replaces the object of an AIThreadSafeRCU with a changed copy.
+//
 // Thus, AIThreadSafe is to protect objects with a read/write lock,
 // AIThreadSafeSimple is to protect objects with a single mutex,
-// and AIThreadSafeSingleThread doesn't do any locking but makes sure
-// (in Debug mode) that the wrapped object is only accessed by one thread.
+// AIThreadSafeSingleThread doesn't do any locking but makes sure
+// (in Debug mode) that the wrapped object is only accessed by one thread,
+// and AIThreadSafeRCU is for objects that are read a lot more often than
+// they are changed: readers never wait, not even for a writer.
 //
 // Each wrapper class allows its wrapped object to be constructed
 // with arbitrary parameters by using operator new with placement;
@@ -103,6 +111,8 @@ template<typename T, typename MUTEX> struct AIAccessConst;
 template<typename T, typename MUTEX> struct AIAccess;
 template<typename T> struct AISTAccessConst;
 template<typename T> struct AISTAccess;
+template<typename T> struct AIRCUReadAccess;
+template<typename T> struct AIRCUWriteAccess;
 
 // This helper class is needed because offsetof is only allowed on POD types.
 template<typename T>
@@ -590,6 +600,8 @@ struct AIAccessConst
 	void wait() { this->mWrapper.mMutex.wait(); }
 	// If MUTEX is a LLCondition then this can be used to wake up the waiting thread.
 	void signal() { this->mWrapper.mMutex.signal(); }
+	// If MUTEX is a LLCondition then this can be used to wake up all waiting threads.
+	void broadcast() { this->mWrapper.mMutex.broadcast(); }
 
 protected:
 	AIThreadSafeSimple<T, MUTEX>& mWrapper;		//!< Reference to the object that we provide access to.
@@ -806,4 +818,123 @@ struct AISTAccess : public AISTAccessConst<T>
 	T& operator*() const { return *this->mWrapper.ptr(); }
 };
 
+/**
+ * @brief A wrapper class for objects that are read by more than one thread a lot more often than they are changed.
+ *
+ * Use AIRCUReadAccess to read the object, and AIRCUWriteAccess to change it.
+ *
+ * For example,
+ *
+ * <code>
+ * AIThreadSafeRCU<Foo> foo;					// Default constructed Foo.
+ * AIThreadSafeRCU<Foo> bar(new Foo(2, 3));	// Takes ownership of the Foo.
+ *
+ * AIRCUReadAccess<Foo> foo_r(foo);
+ * // Use foo_r-> for read access.
+ *
+ * AIRCUWriteAccess<Foo> foo_w(foo);
+ * // Use foo_w-> for read and write access.
+ * </code>
+ *
+ * This is read-copy-update: an AIRCUWriteAccess changes a copy of the object,
+ * that replaces the object when the AIRCUWriteAccess is destructed. Readers
+ * therefore never wait, and each AIRCUReadAccess sees the same version of
+ * the object for as long as it exists, even when it was replaced meanwhile.
+ *
+ * Writers wait for each other, and the destruction of an AIRCUWriteAccess
+ * waits until all AIRCUReadAccess objects that might be using the old
+ * version are destructed, before deleting it. Hence keep read accesses
+ * short, and never create an AIRCUWriteAccess in a thread that has an
+ * AIRCUReadAccess to the same object: it would wait for itself.
+ *
+ * T must be copy constructible.
+ */
+template<typename T>
+class AIThreadSafeRCU
+{
+protected:
+	// Only these may access the object.
+	friend struct AIRCUReadAccess<T>;
+	friend struct AIRCUWriteAccess<T>;
+
+	boost::atomic<T*> mObject;			// The current version.
+	mutable AIRCULock mRCULock;
+
+public:
+	// Construct a wrapper around a default constructed object.
+	AIThreadSafeRCU(void) : mObject(new T) { }
+	// Construct a wrapper around object, which must have been allocated with new.
+	explicit AIThreadSafeRCU(T* object) : mObject(object) { }
+
+	~AIThreadSafeRCU() { delete mObject.load(); }
+
+private:
+	// Disallow copying or assignments.
+	AIThreadSafeRCU(AIThreadSafeRCU const&);
+	void operator=(AIThreadSafeRCU const&);
+};
+
+/**
+ * @brief Provide read access to the current version of an AIThreadSafeRCU object, without waiting.
+ */
+template<typename T>
+struct AIRCUReadAccess
+{
+	//! Construct a AIRCUReadAccess from a AIThreadSafeRCU.
+	AIRCUReadAccess(AIThreadSafeRCU<T> const& wrapper) :
+		mWrapper(wrapper), mToken(wrapper.mRCULock.rdlock()), mObject(wrapper.mObject.load()) { }
+
+	~AIRCUReadAccess() { mWrapper.mRCULock.rdunlock(mToken); }
+
+	//! Access the underlaying object for read access.
+	T const* operator->() const { return mObject; }
+
+	//! Access the underlaying object for read access.
+	T const& operator*() const { return *mObject; }
+
+private:
+	AIThreadSafeRCU<T> const& mWrapper;	//!< Reference to the object that we provide access to.
+	U32 const mToken;					//!< Where we registered as reader.
+	T const* const mObject;				//!< The version that we see.
+
+	// Disallow copy constructing directly.
+	AIRCUReadAccess(AIRCUReadAccess const&);
+};
+
+/**
+ * @brief Provide read/write access to a copy of an AIThreadSafeRCU object, that replaces it upon destruction.
+ */
+template<typename T>
+struct AIRCUWriteAccess
+{
+	//! Construct a AIRCUWriteAccess from a AIThreadSafeRCU.
+	AIRCUWriteAccess(AIThreadSafeRCU<T>& wrapper) : mWrapper(wrapper)
+	{
+		mWrapper.mRCULock.wrlock();
+		mCopy = new T(*mWrapper.mObject.load());
+	}
+
+	//! Publish the copy, and delete the old version once no reader can see it anymore.
+	~AIRCUWriteAccess()
+	{
+		T* old_object = mWrapper.mObject.exchange(mCopy);
+		mWrapper.mRCULock.synchronize();
+		mWrapper.mRCULock.wrunlock();
+		delete old_object;
+	}
+
+	//! Access the copy for (read and) write access.
+	T* operator->() const { return mCopy; }
+
+	//! Access the copy for (read and) write access.
+	T& operator*() const { return *mCopy; }
+
+private:
+	AIThreadSafeRCU<T>& mWrapper;		//!< Reference to the object that we provide access to.
+	T* mCopy;							//!< The new version.
+
+	// Disallow copy constructing directly.
+	AIRCUWriteAccess(AIRCUWriteAccess const&);
+};
+
 #endif
@@ -41,6 +41,8 @@
 #endif // !LL_WINDOWS
 #include <vector>
 
+#include "boost/atomic.hpp"
+
 #include "llapp.h"
 #include "llapr.h"
 #include "llfile.h"
@@ -297,6 +299,22 @@ namespace
 #endif
 	}
 
+	// The name that function levels are set for: with the class, if known.
+	std::string qualifiedFunctionName(const LLError::CallSite& site)
+	{
+		std::string function_name = functionName(site.mFunction);
+#if LL_LINUX
+		// gross, but typeid comparison seems to always fail here with gcc4.1
+		if (0 != strcmp(site.mClassInfo.name(), typeid(LLError::NoClassInfo).name()))
+#else
+		if (site.mClassInfo != typeid(LLError::NoClassInfo))
+#endif // LL_LINUX
+		{
+			function_name = className(site.mClassInfo) + "::" + function_name;
+		}
+		return function_name;
+	}
+
 
 	class LogControlFile : public LLLiveFile
 	{
@@ -361,7 +379,17 @@ namespace
 
 	typedef std::map<std::string, LLError::ELevel> LevelMap;
 	typedef std::vector<LLError::RecorderPtr> Recorders;
-	typedef std::vector<LLError::CallSite*> CallSiteVector;
+
+	// The message stream of Globals, which can be compared against without
+	// locking Globals.
+	std::ostringstream const* gSharedMessageStream;
+
+	// Makes every call site evaluate its level again the next time it is
+	// reached. Call this after changing the settings.
+	void invalidateCallSites()
+	{
+		LLError::Log::sGeneration++;
+	}
 
 	class Globals
 	{
@@ -370,15 +398,10 @@ namespace
 		std::ostringstream messageStream;
 		bool messageStreamInUse;
 
-		void addCallSite(LLError::CallSite&);
-		void invalidateCallSites();
-
 		static AIThreadSafeSimple<Globals>& get();
 			// return the one instance of the globals
 
 	private:
-		CallSiteVector callSites;
-		
 		friend class AIThreadSafeSimpleDC<Globals>;		// Calls constructor.
 		friend class AIThreadSafeSimple<Globals>;		// Calls destructor.
 		
@@ -387,28 +410,11 @@ namespace
 
 	Globals::Globals()
 		: messageStream(),
-		messageStreamInUse(false),
-		callSites()
+		messageStreamInUse(false)
 	{
+		gSharedMessageStream = &messageStream;
 	}
 
-	void Globals::addCallSite(LLError::CallSite& site)
-	{
-		callSites.push_back(&site);
-	}
-	
-	void Globals::invalidateCallSites()
-	{
-		for (CallSiteVector::const_iterator i = callSites.begin();
-			 i != callSites.end();
-			 ++i)
-		{
-			(*i)->invalidate();
-		}
-		
-		callSites.clear();
-	}
-	
 	AIThreadSafeSimple<Globals>& Globals::get()
 	{
 		/* This pattern, of returning a reference to a static function
@@ -518,8 +524,8 @@ namespace LLError
 	
 	void Settings::reset()
 	{
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		mSettingsConfig = new SettingsConfig();
+		invalidateCallSites();
 	}
 	
 	SettingsStoragePtr Settings::saveAndReset()
@@ -531,14 +537,17 @@ namespace LLError
 	
 	void Settings::restore(SettingsStoragePtr pSettingsStorage)
 	{
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		SettingsConfigPtr newSettingsConfig(dynamic_cast<SettingsConfig *>(pSettingsStorage.get()));
 		mSettingsConfig = newSettingsConfig;
+		invalidateCallSites();
 	}
 }
 
 namespace LLError
 {
+	// Zero would match a call site that was never evaluated.
+	boost::atomic<U32> Log::sGeneration(1);
+
 	CallSite::CallSite(ELevel level,
 		const char* file,
 		int line,
@@ -552,8 +561,7 @@ namespace LLError
 		mLine(line),
 		mClassInfo(class_info),
 		mFunction(function),
-		mCached(false),
-		mShouldLog(false),
+		mCachedShouldLog(0),
 		mPrintOnce(printOnce),
 		mTags(new const char*[tag_count]),
 		mTagCount(tag_count)
@@ -603,7 +611,7 @@ namespace LLError
 
 	void CallSite::invalidate()
 	{
-		mCached = false; 
+		mCachedShouldLog.store(0, boost::memory_order_relaxed);
 	}
 }
 
@@ -717,8 +725,8 @@ namespace LLError
 
 	void setDefaultLevel(AIAccess<Settings> const& settings_w, ELevel level)
 	{
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		settings_w->getSettingsConfig()->mDefaultLevel = level;
+		invalidateCallSites();
 	}
 
 	void setDefaultLevel(ELevel level)
@@ -728,26 +736,26 @@ namespace LLError
 
 	void setFunctionLevel(const std::string& function_name, ELevel level)
 	{
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		AIAccess<Settings>(Settings::get())->getSettingsConfig()->mFunctionLevelMap[function_name] = level;
+		invalidateCallSites();
 	}
 
 	void setClassLevel(const std::string& class_name, ELevel level)
 	{
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		AIAccess<Settings>(Settings::get())->getSettingsConfig()->mClassLevelMap[class_name] = level;
+		invalidateCallSites();
 	}
 
 	void setFileLevel(const std::string& file_name, ELevel level)
 	{
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		AIAccess<Settings>(Settings::get())->getSettingsConfig()->mFileLevelMap[file_name] = level;
+		invalidateCallSites();
 	}
 
 	void setTagLevel(const std::string& tag_name, ELevel level)
 	{
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		AIAccess<Settings>(Settings::get())->getSettingsConfig()->mTagLevelMap[tag_name] = level;
+		invalidateCallSites();
 	}
 
 	LLError::ELevel decodeLevel(std::string name)
@@ -792,7 +800,6 @@ namespace LLError
 	void configure(const LLSD& config)
 	{
 		AIAccess<Settings> settings_w(Settings::get());
-		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		SettingsConfigPtr s = settings_w->getSettingsConfig();
 
 		s->mFunctionLevelMap.clear();
@@ -817,6 +824,7 @@ namespace LLError
 			setLevels(s->mFileLevelMap,		entry["files"],		level);
 			setLevels(s->mTagLevelMap,		entry["tags"],		level);
 		}
+		invalidateCallSites();
 	}
 }
 
@@ -1094,12 +1102,332 @@ namespace {
 			gLogMutex.unlock();
 		}
 	}
+
+	// Writes one message the way Log::flush always did: handles print-once
+	// messages, formats the message for each recorder and, for errors,
+	// calls the fatal function.
+	void writeMessage(AIAccess<LLError::Settings>& settings_w, const LLError::CallSite& site, const std::string& message)
+	{
+		LLError::SettingsConfigPtr s = settings_w->getSettingsConfig();
+		
+		if (site.mLevel == LLError::LEVEL_ERROR)
+		{
+			writeToRecorders(settings_w, site, "error", true, true, true, false, false);
+		}
+		
+		std::ostringstream message_stream;
+
+		bool need_function = site.mFunction;
+		if (need_function && !site.mTagString.empty())
+		{
+#if LL_DEBUG
+			// Suppress printing mFunction if mBroadTag is set, starts with
+			// "Plugin " and ends with "child": a debug message from a plugin.
+			size_t taglen = site.mTagString.length();
+			if (taglen >= 12 && strncmp(site.mTagString.c_str(), "Plugin ", 7) == 0 &&
+				strcmp(site.mTagString.c_str() + taglen - 5, "child") == 0)
+			{
+				need_function = false;
+			}
+#endif
+		}
+
+		if (site.mPrintOnce)
+		{
+			std::map<std::string, unsigned int>::iterator messageIter = s->mUniqueLogMessages.find(message);
+			if (messageIter != s->mUniqueLogMessages.end())
+			{
+				messageIter->second++;
+				unsigned int num_messages = messageIter->second;
+				if (num_messages == 10 || num_messages == 50 || (num_messages % 100) == 0)
+				{
+					message_stream << "ONCE (" << num_messages << "th time seen): ";
+				} 
+				else
+				{
+					return;
+				}
+			}
+			else 
+			{
+				message_stream << "ONCE: ";
+				s->mUniqueLogMessages[message] = 1;
+			}
+		}
+		
+		message_stream << message;
+		
+		writeToRecorders(settings_w, site, message_stream.str(), true, true, true, true, need_function);
+		
+		if (site.mLevel == LLError::LEVEL_ERROR  &&  s->mCrashFunction)
+		{
+			s->mCrashFunction(message_stream.str());
+		}
+	}
+
+	//------------------------------------------------------------------------
+	// Asynchronous logging.
+	//
+	// While enabled, Log::flush only queues the message and returns; the
+	// LogWriter thread takes the log lock and does the print-once bookkeeping,
+	// the formatting and the actual writing. Note that therefore the time
+	// printed is the time the message was written, which normally is within
+	// a millisecond of when it was logged.
+	// Errors are still written synchronously, after everything queued before
+	// them, because the fatal function does not return.
+
+	// Dmitry Vyukov's bounded queue: every cell carries a sequence number that
+	// tells a producer whether the cell is free and the consumer whether it
+	// was filled, so that pushing is lock-free and never blocks.
+	// Only one thread at a time may pop (see gLogDrainMutex).
+	class LogQueue
+	{
+	public:
+		enum { CAPACITY = 4096 };	// Must be a power of two.
+
+		LogQueue();
+
+		// ANY THREAD. Takes over message (leaving it empty), unless the queue is full
+		// and false is returned.
+		bool push(const LLError::CallSite& site, std::string& message);
+
+		// CONSUMER. Returns false if the queue is empty.
+		bool pop(const LLError::CallSite*& site, std::string& message);
+
+		// ANY THREAD. Might return false when the queue just became empty.
+		bool empty() const;
+
+	private:
+		struct Cell
+		{
+			boost::atomic<U32> mSequence;
+			const LLError::CallSite* mSite;
+			std::string mMessage;
+		};
+
+		Cell mCells[CAPACITY];
+		boost::atomic<U32> mEnqueuePos;
+		char mPad[64];					// Keep the consumer position out of the cache line that the producers fight over.
+		boost::atomic<U32> mDequeuePos;
+	};
+
+	LogQueue::LogQueue() : mEnqueuePos(0), mDequeuePos(0)
+	{
+		for (U32 i = 0; i < CAPACITY; ++i)
+		{
+			mCells[i].mSequence.store(i, boost::memory_order_relaxed);
+			mCells[i].mSite = NULL;
+		}
+	}
+
+	bool LogQueue::push(const LLError::CallSite& site, std::string& message)
+	{
+		U32 pos = mEnqueuePos.load(boost::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = mCells[pos & (CAPACITY - 1)];
+			S32 diff = (S32)(cell.mSequence.load(boost::memory_order_acquire) - pos);
+			if (diff == 0)
+			{
+				// The cell is free; claim it.
+				if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+				{
+					cell.mSite = &site;
+					cell.mMessage.swap(message);
+					cell.mSequence.store(pos + 1, boost::memory_order_release);
+					return true;
+				}
+				// pos was updated by compare_exchange_weak.
+			}
+			else if (diff < 0)
+			{
+				// The cell still holds a message from CAPACITY pushes ago: full.
+				return false;
+			}
+			else
+			{
+				// Another producer claimed it first.
+				pos = mEnqueuePos.load(boost::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool LogQueue::pop(const LLError::CallSite*& site, std::string& message)
+	{
+		U32 pos = mDequeuePos.load(boost::memory_order_relaxed);
+		Cell& cell = mCells[pos & (CAPACITY - 1)];
+		if ((S32)(cell.mSequence.load(boost::memory_order_acquire) - (pos + 1)) < 0)
+		{
+			return false;
+		}
+		site = cell.mSite;
+		// Swap rather than copy, so that the string buffers are recycled.
+		message.swap(cell.mMessage);
+		cell.mMessage.clear();
+		cell.mSequence.store(pos + CAPACITY, boost::memory_order_release);
+		mDequeuePos.store(pos + 1, boost::memory_order_relaxed);
+		return true;
+	}
+
+	bool LogQueue::empty() const
+	{
+		U32 pos = mDequeuePos.load(boost::memory_order_relaxed);
+		return (S32)(mCells[pos & (CAPACITY - 1)].mSequence.load(boost::memory_order_acquire) - (pos + 1)) < 0;
+	}
+
+	LogQueue* gLogQueue;
+	boost::atomic<bool> gAsyncLogging(false);
+	boost::atomic<U32> gDroppedLogMessages(0);
+	// Serializes the consumers of gLogQueue: the writer thread and a thread logging an error.
+	LLGlobalMutex gLogDrainMutex;
+
+	// Writes everything that is queued. Returns false if there was nothing.
+	bool drainLogQueue()
+	{
+		if (!gLogQueue)
+		{
+			return false;
+		}
+
+		LLMutexLock drain_lock(gLogDrainMutex);
+		if (gLogQueue->empty() && !gDroppedLogMessages.load(boost::memory_order_relaxed))
+		{
+			return false;
+		}
+
+		// Release the log lock every now and then; Log::shouldLog only tries
+		// for a few milliseconds to get it.
+		const int MAX_BATCH = 64;
+		const LLError::CallSite* site;
+		std::string message;
+		bool more = true;
+		while (more)
+		{
+			LogLock lock;
+			if (!lock.ok())
+			{
+				break;
+			}
+			AIAccess<LLError::Settings> settings_w(LLError::Settings::get());
+
+			U32 dropped = gDroppedLogMessages.exchange(0);
+			if (dropped)
+			{
+				static const char* tags[] = { "Logging" };
+				static LLError::CallSite dropped_site(LLError::LEVEL_WARN, __FILE__, __LINE__, typeid(LLError::NoClassInfo), NULL, false, tags, 1);
+				std::ostringstream dropped_message;
+				dropped_message << dropped << " log messages dropped: the log writer could not keep up.";
+				writeToRecorders(settings_w, dropped_site, dropped_message.str());
+			}
+
+			for (int count = 0; count < MAX_BATCH; ++count)
+			{
+				if (!(more = gLogQueue->pop(site, message)))
+				{
+					break;
+				}
+				writeMessage(settings_w, *site, message);
+			}
+		}
+		return true;
+	}
+
+	class LogWriter : public LLThread
+	{
+	public:
+		LogWriter() : LLThread("Log writer"), mSleeping(false) { }
+
+		// ANY THREAD. Call after queuing a message.
+		void wakeUpIfSleeping()
+		{
+			// Pairs with the fence in run(): either we see mSleeping, or the
+			// writer sees the message we just queued.
+			boost::atomic_thread_fence(boost::memory_order_seq_cst);
+			if (mSleeping.load(boost::memory_order_relaxed))
+			{
+				wake();
+			}
+		}
+
+	private:
+		/*virtual*/ bool runCondition() { return !gLogQueue->empty(); }
+		/*virtual*/ void run();
+
+		boost::atomic<bool> mSleeping;
+	};
+
+	void LogWriter::run()
+	{
+		while (!isQuitting())
+		{
+			if (drainLogQueue())
+			{
+				continue;
+			}
+			mRunCondition->lock();
+			mSleeping.store(true, boost::memory_order_relaxed);
+			boost::atomic_thread_fence(boost::memory_order_seq_cst);
+			while (shouldSleep())
+			{
+				mRunCondition->wait();
+			}
+			mSleeping.store(false, boost::memory_order_relaxed);
+			mRunCondition->unlock();
+		}
+		drainLogQueue();
+	}
+
+	// Created the first time asynchronous logging is enabled, and never
+	// destroyed: threads that are logging might still be using it.
+	LogWriter* gLogWriter;
+}
+
+namespace LLError
+{
+	void setAsyncLogging(bool async)
+	{
+		if (async == gAsyncLogging.load())
+		{
+			return;
+		}
+		if (async)
+		{
+			if (!gLogWriter)
+			{
+				gLogQueue = new LogQueue;
+				gLogWriter = new LogWriter;
+			}
+			gLogWriter->start();
+			gAsyncLogging = !gLogWriter->isStopped();
+		}
+		else
+		{
+			gAsyncLogging = false;
+			gLogWriter->setQuitting();
+			while (!gLogWriter->isStopped())
+			{
+				ms_sleep(1);
+			}
+			// Messages that were queued while the writer was finishing.
+			drainLogQueue();
+		}
+	}
+
+	void flushAsyncLog()
+	{
+		drainLogQueue();
+	}
 }
 
 namespace LLError
 {
 	bool Log::shouldLog(CallSite& site)
 	{
+		// Read the generation before the settings: if they change while we
+		// evaluate, the result is stored for a generation that already passed
+		// and the call site is evaluated again.
+		U32 generation = sGeneration.load(boost::memory_order_acquire);
+
 		LogLock lock;
 		if (!lock.ok())
 		{
@@ -1111,43 +1439,38 @@ namespace LLError
 		
 		s->mShouldLogCallCounter++;
 		
-		const std::string& class_name = className(site.mClassInfo);
-		std::string function_name;
-		if (site.mFunction)
-		{
-			function_name = functionName(site.mFunction);
-#if LL_LINUX
-			// gross, but typeid comparison seems to always fail here with gcc4.1
-			if (0 != strcmp(site.mClassInfo.name(), typeid(NoClassInfo).name()))
-#else
-			if (site.mClassInfo != typeid(NoClassInfo))
-#endif // LL_LINUX
-			{
-				function_name = class_name + "::" + function_name;
-			}
-		}
-
 		ELevel compareLevel = s->mDefaultLevel;
 
 		// The most specific match found will be used as the log level,
 		// since the computation short circuits.
 		// So, in increasing order of importance:
 		// Default < Tags < File < Class < Function
-		checkLevelMap(s->mFunctionLevelMap, function_name, compareLevel)
-		|| checkLevelMap(s->mClassLevelMap, class_name, compareLevel)
-		|| checkLevelMap(s->mFileLevelMap, abbreviateFile(site.mFile), compareLevel)
+		// The names are only worked out (demangled and all) for the maps
+		// that have entries; usually most of them are empty.
+		(site.mFunction && !s->mFunctionLevelMap.empty()
+			&& checkLevelMap(s->mFunctionLevelMap, qualifiedFunctionName(site), compareLevel))
+		|| (!s->mClassLevelMap.empty()
+			&& checkLevelMap(s->mClassLevelMap, className(site.mClassInfo), compareLevel))
+		|| (!s->mFileLevelMap.empty()
+			&& checkLevelMap(s->mFileLevelMap, abbreviateFile(site.mFile), compareLevel))
 		|| (site.mTagCount > 0
 			? checkLevelMap(s->mTagLevelMap, site.mTags, site.mTagCount, compareLevel) 
 			: false);
 
-		site.mCached = true;
-		AIAccess<Globals>(Globals::get())->addCallSite(site);
-		return site.mShouldLog = site.mLevel >= compareLevel;
+		bool should_log = site.mLevel >= compareLevel;
+		site.mCachedShouldLog.store((generation << 1) | should_log, boost::memory_order_relaxed);
+		return should_log;
 	}
 
 
 	std::ostringstream* Log::out()
 	{
+		if (gAsyncLogging.load(boost::memory_order_relaxed))
+		{
+			// Don't wait for the log lock; that is the whole point.
+			return new std::ostringstream;
+		}
+
 		LogLock lock;
 		if (lock.ok())
 		{
@@ -1197,6 +1520,27 @@ namespace LLError
 
 	void Log::flush(std::ostringstream* out, const CallSite& site)
 	{
+		if (out != gSharedMessageStream && gAsyncLogging.load(boost::memory_order_relaxed))
+		{
+			if (site.mLevel != LEVEL_ERROR)
+			{
+				std::string message = out->str();
+				delete out;
+				if (gLogQueue->push(site, message))
+				{
+					gLogWriter->wakeUpIfSleeping();
+				}
+				else
+				{
+					// Rather lose a message than block the caller.
+					gDroppedLogMessages++;
+				}
+				return;
+			}
+			// Write everything that was logged before the error first.
+			drainLogQueue();
+		}
+
 		LogLock lock;
 		if (!lock.ok())
 		{
@@ -1219,61 +1563,7 @@ namespace LLError
 		}
 
 		AIAccess<Settings> settings_w(Settings::get());
-		SettingsConfigPtr s = settings_w->getSettingsConfig();
-		
-		if (site.mLevel == LEVEL_ERROR)
-		{
-			writeToRecorders(settings_w, site, "error", true, true, true, false, false);
-		}
-		
-		std::ostringstream message_stream;
-
-		bool need_function = site.mFunction;
-		if (need_function && !site.mTagString.empty())
-		{
-#if LL_DEBUG
-			// Suppress printing mFunction if mBroadTag is set, starts with
-			// "Plugin " and ends with "child": a debug message from a plugin.
-			size_t taglen = site.mTagString.length();
-			if (taglen >= 12 && strncmp(site.mTagString.c_str(), "Plugin ", 7) == 0 &&
-				strcmp(site.mTagString.c_str() + taglen - 5, "child") == 0)
-			{
-				need_function = false;
-			}
-#endif
-		}
-
-		if (site.mPrintOnce)
-		{
-			std::map<std::string, unsigned int>::iterator messageIter = s->mUniqueLogMessages.find(message);
-			if (messageIter != s->mUniqueLogMessages.end())
-			{
-				messageIter->second++;
-				unsigned int num_messages = messageIter->second;
-				if (num_messages == 10 || num_messages == 50 || (num_messages % 100) == 0)
-				{
-					message_stream << "ONCE (" << num_messages << "th time seen): ";
-				} 
-				else
-				{
-					return;
-				}
-			}
-			else 
-			{
-				message_stream << "ONCE: ";
-				s->mUniqueLogMessages[message] = 1;
-			}
-		}
-		
-		message_stream << message;
-		
-		writeToRecorders(settings_w, site, message_stream.str(), true, true, true, true, need_function);
-		
-		if (site.mLevel == LEVEL_ERROR  &&  s->mCrashFunction)
-		{
-			s->mCrashFunction(message_stream.str());
-		}
+		writeMessage(settings_w, site, message);
 	}
 }
 
@@ -35,6 +35,7 @@
 
 #include "llpreprocessor.h"
 #include <boost/static_assert.hpp>
+#include <boost/atomic.hpp>
 
 const int LL_ERR_NOERR = 0;
 
@@ -194,6 +195,12 @@ namespace LLError
 		static std::ostringstream* out();
 		static void flush(std::ostringstream* out, char* message);
 		static void flush(std::ostringstream*, const CallSite&);
+
+		// Changes whenever the settings change. Call sites cache whether they
+		// should log together with the generation they found that for, so
+		// checking needs no lock, and a settings change doesn't need to visit
+		// every call site: each evaluates again when it is next reached.
+		static boost::atomic<U32> sGeneration;
 	};
 	
 	struct LL_COMMON_API CallSite
@@ -217,8 +224,9 @@ namespace LLError
 #else // LL_LIBRARY_INCLUDE
 		bool shouldLog()
 		{ 
-			return mCached 
-					? mShouldLog 
+			U32 cached = mCachedShouldLog.load(boost::memory_order_relaxed);
+			return (cached >> 1) == Log::sGeneration.load(boost::memory_order_relaxed)
+					? (cached & 1)
 					: Log::shouldLog(*this); 
 		}
 			// this member function needs to be in-line for efficiency
@@ -239,8 +247,7 @@ namespace LLError
 		std::string				mLocationString,
 								mFunctionString,
 								mTagString;
-		bool					mCached,
-								mShouldLog;
+		boost::atomic<U32>		mCachedShouldLog;	// The generation shifted left by one, plus whether to log.
 		
 		friend class Log;
 	};
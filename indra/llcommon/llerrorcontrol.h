@@ -178,6 +178,15 @@ namespace LLError
 	LL_COMMON_API std::string logFileName();
 		// returns name of current logging file, empty string if none
 
+	LL_COMMON_API void setAsyncLogging(bool);
+		// When enabled, logging a message only queues it, and a separate
+		// thread writes it to the recorders; errors are still written
+		// immediately, after everything that was queued before them.
+		// Messages are dropped (and counted) rather than blocking the caller
+		// when the writer can't keep up. Disabling it writes what is queued.
+	LL_COMMON_API void flushAsyncLog();
+		// Writes all queued messages now, e.g. before crashing.
+
 
 	/*
 		Utilities for use by the unit tests of LLError itself.
@@ -0,0 +1,473 @@
+/** 
+ * @file lljobsystem.cpp
+ * @brief Shared work-stealing job scheduler.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lljobsystem.h"
+
+#include "boost/thread/thread.hpp"
+
+#include "lltimer.h"
+
+// Index of the worker running on this thread, -1 if this isn't a worker thread.
+static LL_THREAD_LOCAL S32 sCurrentWorker = -1;
+
+//============================================================================
+
+LLJob::LLJob(EPriority priority, bool finish_on_main_thread)
+:	mPriority(priority),
+	mFinishOnMainThread(finish_on_main_thread),
+	mWaitCount(1),
+	mDone(false)
+{
+}
+
+LLJob::~LLJob()
+{
+}
+
+void LLJob::addDependency(LLJob* prerequisite)
+{
+	LLJobSystem& system = LLJobSystem::instance();
+	LLMutexLock lock(system.mDependencyMutex);
+	if (!prerequisite->mDone)
+	{
+		mWaitCount++;
+		prerequisite->mDependents.push_back(this);
+	}
+}
+
+LLFunctionJob::LLFunctionJob(const function_t& work, EPriority priority, const function_t& finish)
+:	LLJob(priority, !finish.empty()),
+	mWork(work),
+	mFinish(finish)
+{
+}
+
+//virtual
+void LLFunctionJob::run()
+{
+	mWork();
+}
+
+//virtual
+void LLFunctionJob::finish()
+{
+	mFinish();
+}
+
+//============================================================================
+
+namespace
+{
+	// The items of a parallelFor(), claimed by the calling thread and the
+	// helper jobs alike.
+	class ParallelForItems : public LLThreadSafeRefCount
+	{
+	public:
+		ParallelForItems(S32 count, const LLJobSystem::for_function_t& work)
+		:	mCount(count),
+			mWork(work),
+			mNext(0),
+			mDone(0)
+		{
+		}
+
+		// Returns false when there are no items left to claim.
+		bool runItem()
+		{
+			S32 index = mNext++;
+			if (index >= mCount)
+			{
+				return false;
+			}
+			mWork(index);
+			if (mDone++ == mCount - 1)
+			{
+				mDoneCondition.lock();
+				mDoneCondition.broadcast();
+				mDoneCondition.unlock();
+			}
+			return true;
+		}
+
+		// Blocks until every item returned, including those others claimed.
+		void waitDone()
+		{
+			mDoneCondition.lock();
+			while (mDone < mCount)
+			{
+				mDoneCondition.wait();
+			}
+			mDoneCondition.unlock();
+		}
+
+	private:
+		const S32 mCount;
+		const LLJobSystem::for_function_t mWork;
+		LLAtomicS32 mNext;
+		LLAtomicS32 mDone;
+		LLCondition mDoneCondition;
+	};
+
+	class ParallelForJob : public LLJob
+	{
+	public:
+		ParallelForJob(ParallelForItems* items) : LLJob(PRIORITY_HIGH), mItems(items) { }
+
+	protected:
+		/*virtual*/ void run()
+		{
+			while (mItems->runItem())
+			{
+			}
+		}
+
+	private:
+		LLPointer<ParallelForItems> mItems;
+	};
+}
+
+//============================================================================
+
+class LLJobSystem::Worker : public LLThread
+{
+public:
+	Worker(LLJobSystem& system, S32 index)
+	:	LLThread(llformat("Job worker %d", index)),
+		mSystem(system),
+		mIndex(index)
+	{
+	}
+
+	// Protected by mMutex.
+	LLMutex mMutex;
+	std::deque<LLPointer<LLJob> > mJobs[LLJob::NUM_PRIORITIES];
+
+protected:
+	/*virtual*/ void run();
+
+private:
+	LLJobSystem& mSystem;
+	const S32 mIndex;
+};
+
+//virtual
+void LLJobSystem::Worker::run()
+{
+	sCurrentWorker = mIndex;
+	while (true)
+	{
+		LLPointer<LLJob> job = mSystem.getJob(mIndex);
+		if (job)
+		{
+			mSystem.runJob(job);
+			continue;
+		}
+
+		mSystem.mWorkCondition.lock();
+		while (!mSystem.mQueuedCount && !mSystem.mQuitting)
+		{
+			mSystem.mWorkCondition.wait();
+		}
+		bool done = mSystem.mQuitting && !mSystem.mQueuedCount;
+		mSystem.mWorkCondition.unlock();
+		if (done)
+		{
+			break;
+		}
+	}
+	sCurrentWorker = -1;
+}
+
+//============================================================================
+
+LLJobSystem::LLJobSystem()
+:	mWorkerCount(0),
+	mNextWorker(0),
+	mQueuedCount(0),
+	mQuitting(false)
+{
+}
+
+LLJobSystem::~LLJobSystem()
+{
+	stop();
+}
+
+//static
+void LLJobSystem::cleanupClass()
+{
+	if (instanceExists())
+	{
+		deleteSingleton();
+	}
+}
+
+//static
+S32 LLJobSystem::getCurrentWorker()
+{
+	return sCurrentWorker;
+}
+
+void LLJobSystem::start(S32 worker_count)
+{
+	if (!mWorkers.empty())
+	{
+		return;
+	}
+	if (worker_count <= 0)
+	{
+		// Leave a core for the main thread.
+		worker_count = llmax((S32)boost::thread::hardware_concurrency() - 1, 1);
+	}
+	LL_INFOS() << "Starting " << worker_count << " job workers." << LL_ENDL;
+
+	mQuitting = false;
+	for (S32 i = 0; i < worker_count; ++i)
+	{
+		mWorkers.push_back(new Worker(*this, i));
+	}
+	// Only start them once mWorkers is complete: workers look at each other's queues.
+	for (S32 i = 0; i < worker_count; ++i)
+	{
+		mWorkers[i]->start();
+	}
+	mWorkerCount = worker_count;
+}
+
+void LLJobSystem::stop()
+{
+	if (mWorkers.empty())
+	{
+		return;
+	}
+
+	mWorkCondition.lock();
+	mQuitting = true;
+	mWorkCondition.broadcast();
+	mWorkCondition.unlock();
+
+	for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+	{
+		while (!(*iter)->isStopped())
+		{
+			ms_sleep(1);
+		}
+	}
+
+	// From here on enqueue() runs jobs synchronously.
+	std::vector<Worker*> workers;
+	mWorkersLock.wrlock();
+	workers.swap(mWorkers);
+	mWorkerCount = 0;
+	mWorkersLock.wrunlock();
+
+	// Run what other threads queued after the workers made their last check.
+	for (std::vector<Worker*>::iterator iter = workers.begin(); iter != workers.end(); ++iter)
+	{
+		for (S32 priority = 0; priority < LLJob::NUM_PRIORITIES; ++priority)
+		{
+			std::deque<LLPointer<LLJob> > jobs;
+			{
+				LLMutexLock lock((*iter)->mMutex);
+				jobs.swap((*iter)->mJobs[priority]);
+			}
+			for (std::deque<LLPointer<LLJob> >::iterator job = jobs.begin(); job != jobs.end(); ++job)
+			{
+				--mQueuedCount;
+				runJob(*job);
+			}
+		}
+	}
+	for_each(workers.begin(), workers.end(), DeletePointer());
+}
+
+void LLJobSystem::submit(LLJob* job)
+{
+	// Drop the reference held on behalf of submit(); the job runs once the prerequisites did.
+	if (!--job->mWaitCount)
+	{
+		enqueue(job);
+	}
+}
+
+void LLJobSystem::post(const LLFunctionJob::function_t& work, LLJob::EPriority priority, const LLFunctionJob::function_t& finish)
+{
+	submit(new LLFunctionJob(work, priority, finish));
+}
+
+void LLJobSystem::parallelFor(S32 count, const for_function_t& work)
+{
+	LLPointer<ParallelForItems> items = new ParallelForItems(count, work);
+	S32 helpers = llmin((S32)mWorkerCount, count - 1);
+	for (S32 i = 0; i < helpers; ++i)
+	{
+		submit(new ParallelForJob(items));
+	}
+	while (items->runItem())
+	{
+	}
+	// Wait for the items the workers already claimed.
+	items->waitDone();
+}
+
+void LLJobSystem::enqueue(LLJob* job)
+{
+	mWorkersLock.rdlock();
+	if (mWorkers.empty())
+	{
+		mWorkersLock.rdunlock();
+		runJob(job);
+		return;
+	}
+
+	// Jobs created by a job stay with its worker, the others are spread.
+	S32 worker = sCurrentWorker;
+	if (worker < 0)
+	{
+		worker = mNextWorker++ % mWorkers.size();
+	}
+
+	// Count the job before it can be taken, so that mQueuedCount never drops below zero.
+	mQueuedCount++;
+	{
+		Worker* queue = mWorkers[worker];
+		LLMutexLock lock(queue->mMutex);
+		queue->mJobs[job->mPriority].push_back(job);
+	}
+	mWorkersLock.rdunlock();
+
+	mWorkCondition.lock();
+	mWorkCondition.signal();
+	mWorkCondition.unlock();
+}
+
+// A worker runs its own jobs oldest first. When it has none left of a priority,
+// it steals the newest job of that priority from another worker: the one its
+// owner would get to last.
+LLPointer<LLJob> LLJobSystem::getJob(S32 worker)
+{
+	LLPointer<LLJob> job;
+	if (!mQueuedCount)
+	{
+		return job;
+	}
+
+	const S32 worker_count = mWorkers.size();
+	for (S32 priority = 0; priority < LLJob::NUM_PRIORITIES; ++priority)
+	{
+		{
+			Worker* own = mWorkers[worker];
+			LLMutexLock lock(own->mMutex);
+			std::deque<LLPointer<LLJob> >& jobs = own->mJobs[priority];
+			if (!jobs.empty())
+			{
+				job = jobs.front();
+				jobs.pop_front();
+			}
+		}
+		for (S32 i = 1; !job && i < worker_count; ++i)
+		{
+			Worker* victim = mWorkers[(worker + i) % worker_count];
+			LLMutexLock lock(victim->mMutex);
+			std::deque<LLPointer<LLJob> >& jobs = victim->mJobs[priority];
+			if (!jobs.empty())
+			{
+				job = jobs.back();
+				jobs.pop_back();
+			}
+		}
+		if (job)
+		{
+			--mQueuedCount;
+			break;
+		}
+	}
+	return job;
+}
+
+void LLJobSystem::runJob(LLJob* job)
+{
+	// Keep the job alive until the end of this function.
+	LLPointer<LLJob> job_ptr = job;
+
+	job->run();
+
+	// Release the jobs that were waiting for this one.
+	std::vector<LLPointer<LLJob> > dependents;
+	{
+		LLMutexLock lock(mDependencyMutex);
+		job->mDone = true;
+		dependents.swap(job->mDependents);
+	}
+	for (std::vector<LLPointer<LLJob> >::iterator iter = dependents.begin(); iter != dependents.end(); ++iter)
+	{
+		if (!--(*iter)->mWaitCount)
+		{
+			enqueue(*iter);
+		}
+	}
+
+	if (job->mFinishOnMainThread)
+	{
+		LLMutexLock lock(mFinishedMutex);
+		mFinished.push_back(job);
+	}
+}
+
+S32 LLJobSystem::updateMainThread(F32 max_time_ms)
+{
+	LLTimer timer;
+	while (true)
+	{
+		LLPointer<LLJob> job;
+		mFinishedMutex.lock();
+		if (!mFinished.empty())
+		{
+			job = mFinished.front();
+			mFinished.pop_front();
+		}
+		mFinishedMutex.unlock();
+		if (!job)
+		{
+			return 0;
+		}
+
+		job->finish();
+
+		if (max_time_ms > 0.f && timer.getElapsedTimeF32() * 1000.f > max_time_ms)
+		{
+			break;
+		}
+	}
+	LLMutexLock lock(mFinishedMutex);
+	return mFinished.size();
+}
@@ -0,0 +1,186 @@
+/** 
+ * @file lljobsystem.h
+ * @brief Shared work-stealing job scheduler.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLJOBSYSTEM_H
+#define LL_LLJOBSYSTEM_H
+
+#include <deque>
+#include <vector>
+
+#include "boost/function.hpp"
+
+#include "llsingleton.h"
+#include "llthread.h"
+
+class LLJobSystem;
+
+//============================================================================
+// A unit of work for LLJobSystem.
+//
+// run() is called on one of the worker threads once all jobs this one depends
+// on have finished their run(). If the job was created with
+// finish_on_main_thread, finish() is called afterwards from
+// LLJobSystem::updateMainThread().
+
+class LL_COMMON_API LLJob : public LLThreadSafeRefCount
+{
+	friend class LLJobSystem;
+
+public:
+	enum EPriority
+	{
+		PRIORITY_HIGH = 0,
+		PRIORITY_NORMAL,
+		PRIORITY_LOW,
+		NUM_PRIORITIES
+	};
+
+	LLJob(EPriority priority = PRIORITY_NORMAL, bool finish_on_main_thread = false);
+
+	// Makes this job wait for prerequisite to have run. Must be called before
+	// this job is submitted; prerequisite may be submitted or even done already.
+	void addDependency(LLJob* prerequisite);
+
+	EPriority getPriority() const { return mPriority; }
+
+protected:
+	virtual ~LLJob();
+
+	// WORKER THREAD
+	virtual void run() = 0;
+	// MAIN THREAD
+	virtual void finish() { }
+
+private:
+	const EPriority mPriority;
+	const bool mFinishOnMainThread;
+	// One more than the number of unfinished prerequisites until the job is submitted.
+	LLAtomicS32 mWaitCount;
+	// Protected by LLJobSystem::mDependencyMutex.
+	bool mDone;
+	std::vector<LLPointer<LLJob> > mDependents;
+};
+
+// Convenience job running a function object.
+class LL_COMMON_API LLFunctionJob : public LLJob
+{
+public:
+	typedef boost::function<void()> function_t;
+
+	LLFunctionJob(const function_t& work, EPriority priority = PRIORITY_NORMAL, const function_t& finish = function_t());
+
+protected:
+	/*virtual*/ void run();
+	/*virtual*/ void finish();
+
+private:
+	function_t mWork;
+	function_t mFinish;
+};
+
+//============================================================================
+// A pool of worker threads shared by subsystems that have work to do in the
+// background, instead of each owning a thread.
+//
+// Every worker has a deque per priority. Jobs submitted by a worker (e.g. from
+// a run()) go to the back of its own deques, other jobs are spread over the
+// workers round robin. A worker takes its oldest job of the highest priority
+// available and, when it has none, steals the newest one of that priority
+// from another worker; so no core idles while another has jobs queued.
+
+class LL_COMMON_API LLJobSystem : public LLSingleton<LLJobSystem>
+{
+	friend class LLSingleton<LLJobSystem>;
+	friend class LLJob;
+
+public:
+	// Starts worker_count workers; 0 means one less than the number of cores.
+	// Must be called before the first job is submitted.
+	void start(S32 worker_count = 0);
+	// Runs the jobs still queued and stops the workers. Jobs submitted after
+	// this are run synchronously, jobs submitted concurrently with it run on
+	// either side of it.
+	void stop();
+
+	// ANY THREAD
+	void submit(LLJob* job);
+	// Submits an LLFunctionJob.
+	void post(const LLFunctionJob::function_t& work, LLJob::EPriority priority = LLJob::PRIORITY_NORMAL,
+			  const LLFunctionJob::function_t& finish = LLFunctionJob::function_t());
+
+	// Calls work(i) for every i in [0, count) and returns once all calls
+	// returned. The calling thread takes items too, so it only ever waits for
+	// items that a worker already started; no worker being free is fine.
+	typedef boost::function<void(S32)> for_function_t;
+	void parallelFor(S32 count, const for_function_t& work);
+
+	// MAIN THREAD
+	// Calls finish() of jobs that are done, until max_time_ms elapsed (0 means no limit).
+	// Returns the number of jobs still waiting to be finished.
+	S32 updateMainThread(F32 max_time_ms);
+
+	S32 getWorkerCount() const { return mWorkerCount; }
+	// Jobs submitted that didn't start running yet (not counting those waiting for dependencies).
+	S32 getQueuedCount() const { return mQueuedCount; }
+
+	// Returns the index of the worker running the calling thread, or -1.
+	static S32 getCurrentWorker();
+
+	static void cleanupClass();
+
+private:
+	LLJobSystem();
+	~LLJobSystem();
+
+	class Worker;
+
+	void enqueue(LLJob* job);
+	LLPointer<LLJob> getJob(S32 worker);
+	void runJob(LLJob* job);
+
+	// Submitters read-lock mWorkersLock; stop() write-locks it to take the
+	// workers away. The workers themselves only exist while it holds them.
+	std::vector<Worker*> mWorkers;
+	AIRWLock mWorkersLock;
+	LLAtomicS32 mWorkerCount;
+	LLAtomicU32 mNextWorker;
+	LLAtomicS32 mQueuedCount;
+
+	// Idle workers wait on this.
+	LLCondition mWorkCondition;
+	bool mQuitting;
+
+	LLMutex mDependencyMutex;
+
+	LLMutex mFinishedMutex;
+	std::deque<LLPointer<LLJob> > mFinished;
+};
+
+#endif // LL_LLJOBSYSTEM_H
@@ -27,15 +27,18 @@
 #include "llqueuedthread.h"
 
 #include "llstl.h"
+#include "lljobsystem.h"
 #include "lltimer.h"	// ms_sleep()
 
 //============================================================================
 
 // MAIN THREAD
-LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded, bool should_pause) :
+LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded, bool should_pause, S32 max_jobs) :
 	LLThread(name),
 	mThreaded(threaded),
 	mIdleThread(true),
+	mMaxJobs(threaded ? max_jobs : 0),
+	mActiveJobs(0),
 	mNextHandle(0),
 	mStarted(FALSE)
 {
@@ -46,7 +49,17 @@ LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded, bool shou
 			pause() ; //call this before start the thread.
 		}
 
-		start();
+		if (mMaxJobs)
+		{
+			// We have no thread of our own, but behave as if it were running
+			// so that pausing and quitting work as usual.
+			mStatus = RUNNING;
+			mStarted = TRUE;
+		}
+		else
+		{
+			start();
+		}
 	}
 }
 
@@ -66,7 +79,28 @@ void LLQueuedThread::shutdown()
 	setQuitting();
 
 	unpause(); // MAIN THREAD
-	if (mThreaded)
+	if (mMaxJobs)
+	{
+		// Jobs stop processing requests once we're quitting; wait for them to return.
+		S32 timeout = 10000;
+		for ( ; timeout>0; timeout--)
+		{
+			lockData();
+			bool done = !mActiveJobs;
+			unlockData();
+			if (done)
+			{
+				break;
+			}
+			ms_sleep(1);
+		}
+		if (timeout == 0)
+		{
+			LL_WARNS() << "~LLQueuedThread (" << mName << ") timed out waiting for jobs!" << LL_ENDL;
+		}
+		mStatus = STOPPED;
+	}
+	else if (mThreaded)
 	{
 		S32 timeout = 100;
 		for ( ; timeout>0; timeout--)
@@ -88,10 +122,15 @@ void LLQueuedThread::shutdown()
 		mStatus = STOPPED;
 	}
 
-	QueuedRequest* req;
+	std::vector<QueuedRequest*> requests;
+	lockData();
+	mRequestHash.getRequests(requests);
+	mRequestHash.clear();
+	unlockData();
 	S32 active_count = 0;
-	while ( (req = (QueuedRequest*)mRequestHash.pop_element()) )
+	for (std::vector<QueuedRequest*>::iterator iter = requests.begin(); iter != requests.end(); ++iter)
 	{
+		QueuedRequest* req = *iter;
 		if (req->getStatus() == STATUS_QUEUED || req->getStatus() == STATUS_INPROGRESS)
 		{
 			++active_count;
@@ -135,6 +174,10 @@ S32 LLQueuedThread::updateQueue(F32 max_time_ms)
 		if(pending > 0)
 		{
 			unpause();
+			if (mMaxJobs)
+			{
+				scheduleJobs();
+			}
 		}
 	}
 	else
@@ -154,7 +197,11 @@ void LLQueuedThread::incQueue()
 	// Something has been added to the queue
 	if (!isPaused())
 	{
-		if (mThreaded)
+		if (mMaxJobs)
+		{
+			scheduleJobs();
+		}
+		else if (mThreaded)
 		{
 			wake(); // Wake the thread up if necessary.
 		}
@@ -165,11 +212,8 @@ void LLQueuedThread::incQueue()
 // May be called from any thread
 S32 LLQueuedThread::getPending()
 {
-	S32 res;
-	lockData();
-	res = mRequestQueue.size();
-	unlockData();
-	return res;
+	// The queue keeps its size in an atomic; no need for the data lock.
+	return mRequestQueue.size();
 }
 
 // MAIN thread
@@ -197,7 +241,7 @@ void LLQueuedThread::printQueueStats()
 	lockData();
 	if (!mRequestQueue.empty())
 	{
-		QueuedRequest *req = *mRequestQueue.begin();
+		QueuedRequest *req = mRequestQueue.front();
 		LL_INFOS() << llformat("Pending Requests:%d Current status:%d", mRequestQueue.size(), req->getStatus()) << LL_ENDL;
 	}
 	else
@@ -211,7 +255,7 @@ void LLQueuedThread::printQueueStats()
 LLQueuedThread::handle_t LLQueuedThread::generateHandle()
 {
 	lockData();
-	while ((mNextHandle == nullHandle()) || (mRequestHash.find(mNextHandle)))
+	while ((mNextHandle == nullHandle()) || !mRequestHash.isFree(mNextHandle))
 	{
 		mNextHandle++;
 	}
@@ -253,7 +297,7 @@ bool LLQueuedThread::waitForResult(LLQueuedThread::handle_t handle, bool auto_co
 	{
 		update(0); // unpauses
 		lockData();
-		QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+		QueuedRequest* req = mRequestHash.find(handle);
 		if (!req)
 		{
 			done = true; // request does not exist
@@ -291,7 +335,7 @@ LLQueuedThread::QueuedRequest* LLQueuedThread::getRequest(handle_t handle)
 		return 0;
 	}
 	lockData();
-	QueuedRequest* res = (QueuedRequest*)mRequestHash.find(handle);
+	QueuedRequest* res = mRequestHash.find(handle);
 	unlockData();
 	return res;
 }
@@ -300,7 +344,7 @@ LLQueuedThread::status_t LLQueuedThread::getRequestStatus(handle_t handle)
 {
 	status_t res = STATUS_EXPIRED;
 	lockData();
-	QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+	QueuedRequest* req = mRequestHash.find(handle);
 	if (req)
 	{
 		res = req->getStatus();
@@ -312,7 +356,7 @@ LLQueuedThread::status_t LLQueuedThread::getRequestStatus(handle_t handle)
 void LLQueuedThread::abortRequest(handle_t handle, bool autocomplete)
 {
 	lockData();
-	QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+	QueuedRequest* req = mRequestHash.find(handle);
 	if (req)
 	{
 		req->setFlags(FLAG_ABORT | (autocomplete ? FLAG_AUTO_COMPLETE : 0));
@@ -324,7 +368,7 @@ void LLQueuedThread::abortRequest(handle_t handle, bool autocomplete)
 void LLQueuedThread::setFlags(handle_t handle, U32 flags)
 {
 	lockData();
-	QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+	QueuedRequest* req = mRequestHash.find(handle);
 	if (req)
 	{
 		req->setFlags(flags);
@@ -335,7 +379,7 @@ void LLQueuedThread::setFlags(handle_t handle, U32 flags)
 void LLQueuedThread::setPriority(handle_t handle, U32 priority)
 {
 	lockData();
-	QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+	QueuedRequest* req = mRequestHash.find(handle);
 	if (req)
 	{
 		if(req->getStatus() == STATUS_INPROGRESS)
@@ -345,10 +389,7 @@ void LLQueuedThread::setPriority(handle_t handle, U32 priority)
 		}
 		else if(req->getStatus() == STATUS_QUEUED)
 		{
-			// remove from list then re-insert
-			llverify(mRequestQueue.erase(req) == 1);
-			req->setPriority(priority);
-			mRequestQueue.insert(req);
+			mRequestQueue.setPriority(req, priority);
 		}
 	}
 	unlockData();
@@ -358,7 +399,7 @@ bool LLQueuedThread::completeRequest(handle_t handle)
 {
 	bool res = false;
 	lockData();
-	QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+	QueuedRequest* req = mRequestHash.find(handle);
 	if (req)
 	{
 		llassert_always(req->getStatus() != STATUS_QUEUED);
@@ -385,22 +426,19 @@ bool LLQueuedThread::completeRequest(handle_t handle)
 
 bool LLQueuedThread::check()
 {
-#if 0 // not a reliable check once mNextHandle wraps, just for quick and dirty debugging
-	for (int i=0; i<REQUEST_HASH_SIZE; i++)
+	// Every queued request must be findable by its handle.
+	bool res = true;
+	lockData();
+	for (QueuedRequest* req = mRequestQueue.front(); req; req = mRequestQueue.next(req))
 	{
-		LLSimpleHashEntry<handle_t>* entry = mRequestHash.get_element_at_index(i);
-		while (entry)
+		if (mRequestHash.find(req->getHandle()) != req)
 		{
-			if (entry->getHashKey() > mNextHandle)
-			{
-				LL_ERRS() << "Hash Error" << LL_ENDL;
-				return false;
-			}
-			entry = entry->getNextEntry();
+			LL_WARNS() << "Queued request " << req->getHandle() << " is not in the request table" << LL_ENDL;
+			res = false;
 		}
 	}
-#endif
-	return true;
+	unlockData();
+	return res;
 }		
 	
 //============================================================================
@@ -418,8 +456,8 @@ S32 LLQueuedThread::processNextRequest()
 		{
 			break;
 		}
-		req = *mRequestQueue.begin();
-		mRequestQueue.erase(mRequestQueue.begin());
+		req = mRequestQueue.front();
+		mRequestQueue.erase(req);
 		if ((req->getFlags() & FLAG_ABORT) || (mStatus == QUITTING))
 		{
 			req->setStatus(STATUS_ABORTED);
@@ -511,7 +549,7 @@ S32 LLQueuedThread::processNextRequest()
 			req->setStatus(STATUS_QUEUED);
 			mRequestQueue.insert(req);
 			unlockData();
-			if (mThreaded && start_priority < PRIORITY_NORMAL)
+			if (mThreaded && !mMaxJobs && start_priority < PRIORITY_NORMAL)
 			{
 				ms_sleep(1); // sleep the thread a little
 			}
@@ -568,6 +606,75 @@ void LLQueuedThread::run()
 	LL_INFOS() << "LLQueuedThread " << mName << " EXITING." << LL_ENDL;
 }
 
+//============================================================================
+// Processing requests with jobs instead of our own thread
+
+class LLQueuedThread::ProcessJob : public LLJob
+{
+public:
+	ProcessJob(LLQueuedThread* thread) : mThread(thread) { }
+
+protected:
+	/*virtual*/ void run() { mThread->processJob(); }
+
+private:
+	LLQueuedThread* const mThread;
+};
+
+// Submits jobs until there is one per queued request, or mMaxJobs.
+void LLQueuedThread::scheduleJobs()
+{
+	S32 new_jobs = 0;
+	lockData();
+	if (!isPaused() && !isQuitting())
+	{
+		new_jobs = llmin((S32)mRequestQueue.size(), mMaxJobs) - mActiveJobs;
+		if (new_jobs > 0)
+		{
+			mActiveJobs += new_jobs;
+			mIdleThread = false;
+		}
+	}
+	unlockData();
+
+	for ( ; new_jobs > 0; --new_jobs)
+	{
+		LLJobSystem::instance().submit(new ProcessJob(this));
+	}
+}
+
+// Runs on a job worker. Processes requests until there are none left, and
+// every few milliseconds hands the worker to other jobs by resubmitting itself.
+void LLQueuedThread::processJob()
+{
+	const F64 JOB_TIME_SLICE = 0.005;
+	LLTimer timer;
+	while (1)
+	{
+		lockData();
+		if (mRequestQueue.empty() || isPaused() || isQuitting())
+		{
+			if (!--mActiveJobs)
+			{
+				mIdleThread = true;
+			}
+			unlockData();
+			return;
+		}
+		unlockData();
+
+		processNextRequest();
+
+		if (timer.getElapsedTimeF64() > JOB_TIME_SLICE)
+		{
+			LLJobSystem::instance().submit(new ProcessJob(this));
+			return;
+		}
+	}
+}
+
+//============================================================================
+
 // virtual
 void LLQueuedThread::startThread()
 {
@@ -586,10 +693,13 @@ void LLQueuedThread::threadedUpdate()
 //============================================================================
 
 LLQueuedThread::QueuedRequest::QueuedRequest(LLQueuedThread::handle_t handle, U32 priority, U32 flags) :
-	LLSimpleHashEntry<LLQueuedThread::handle_t>(handle),
+	mHandle(handle),
 	mStatus(STATUS_UNKNOWN),
 	mPriority(priority),
-	mFlags(flags)
+	mFlags(flags),
+	mQueuePrev(NULL),
+	mQueueNext(NULL),
+	mQueueBucket(-1)
 {
 }
 
@@ -610,3 +720,293 @@ void LLQueuedThread::QueuedRequest::deleteRequest()
 	setStatus(STATUS_DELETE);
 	delete this;
 }
+
+//============================================================================
+
+LLQueuedThread::RequestQueue::RequestQueue() :
+	mSize(0)
+{
+	memset(mBuckets, 0, sizeof(mBuckets));
+	memset(mWords, 0, sizeof(mWords));
+	memset(mSummary, 0, sizeof(mSummary));
+}
+
+// Index of the highest bit set in a non-zero word.
+static S32 highest_bit(U32 word)
+{
+#if defined(__GNUC__)
+	return 31 - __builtin_clz(word);
+#else
+	S32 bit = 0;
+	if (word & 0xFFFF0000) { word >>= 16; bit += 16; }
+	if (word & 0xFF00) { word >>= 8; bit += 8; }
+	if (word & 0xF0) { word >>= 4; bit += 4; }
+	if (word & 0xC) { word >>= 2; bit += 2; }
+	if (word & 0x2) { bit += 1; }
+	return bit;
+#endif
+}
+
+void LLQueuedThread::RequestQueue::insert(QueuedRequest* req)
+{
+	llassert(req->mQueueBucket < 0);
+	S32 bucket = getBucket(req->getPriority());
+	QueuedRequest*& head = mBuckets[bucket];
+	if (head)
+	{
+		// Append at the tail, which is the head's previous.
+		req->mQueueNext = head;
+		req->mQueuePrev = head->mQueuePrev;
+		head->mQueuePrev->mQueueNext = req;
+		head->mQueuePrev = req;
+	}
+	else
+	{
+		req->mQueueNext = req->mQueuePrev = req;
+		head = req;
+		mWords[bucket >> 5] |= 1U << (bucket & 31);
+		mSummary[bucket >> 10] |= 1U << ((bucket >> 5) & 31);
+	}
+	req->mQueueBucket = bucket;
+	mSize.fetch_add(1, boost::memory_order_relaxed);
+}
+
+void LLQueuedThread::RequestQueue::erase(QueuedRequest* req)
+{
+	S32 bucket = req->mQueueBucket;
+	llassert_always(bucket >= 0);
+	QueuedRequest*& head = mBuckets[bucket];
+	if (req->mQueueNext == req)
+	{
+		head = NULL;
+		if (!(mWords[bucket >> 5] &= ~(1U << (bucket & 31))))
+		{
+			mSummary[bucket >> 10] &= ~(1U << ((bucket >> 5) & 31));
+		}
+	}
+	else
+	{
+		req->mQueuePrev->mQueueNext = req->mQueueNext;
+		req->mQueueNext->mQueuePrev = req->mQueuePrev;
+		if (head == req)
+		{
+			head = req->mQueueNext;
+		}
+	}
+	req->mQueueNext = req->mQueuePrev = NULL;
+	req->mQueueBucket = -1;
+	mSize.fetch_sub(1, boost::memory_order_relaxed);
+}
+
+void LLQueuedThread::RequestQueue::setPriority(QueuedRequest* req, U32 priority)
+{
+	if (getBucket(priority) == req->mQueueBucket)
+	{
+		// Most updates are small nudges that stay within the bucket.
+		req->setPriority(priority);
+	}
+	else
+	{
+		erase(req);
+		req->setPriority(priority);
+		insert(req);
+	}
+}
+
+S32 LLQueuedThread::RequestQueue::findBucketBelow(S32 bucket) const
+{
+	// Remaining buckets in the same word first.
+	S32 word = bucket >> 5;
+	U32 bits = mWords[word] & ((1U << (bucket & 31)) - 1);
+	if (bits)
+	{
+		return (word << 5) + highest_bit(bits);
+	}
+	// Then the remaining words of the same summary word, then the others.
+	S32 summary = word >> 5;
+	bits = mSummary[summary] & ((1U << (word & 31)) - 1);
+	while (!bits)
+	{
+		if (--summary < 0)
+		{
+			return -1;
+		}
+		bits = mSummary[summary];
+	}
+	word = (summary << 5) + highest_bit(bits);
+	return (word << 5) + highest_bit(mWords[word]);
+}
+
+LLQueuedThread::QueuedRequest* LLQueuedThread::RequestQueue::front() const
+{
+	if (mBuckets[NUM_BUCKETS - 1])
+	{
+		return mBuckets[NUM_BUCKETS - 1];
+	}
+	S32 bucket = findBucketBelow(NUM_BUCKETS - 1);
+	return bucket < 0 ? NULL : mBuckets[bucket];
+}
+
+LLQueuedThread::QueuedRequest* LLQueuedThread::RequestQueue::next(const QueuedRequest* req) const
+{
+	S32 bucket = req->mQueueBucket;
+	if (req->mQueueNext != mBuckets[bucket])
+	{
+		return req->mQueueNext;
+	}
+	bucket = findBucketBelow(bucket);
+	return bucket < 0 ? NULL : mBuckets[bucket];
+}
+
+//============================================================================
+
+struct LLQueuedThread::RequestTable::Slots
+{
+	Slots(U32 size) :
+		mMask(size - 1),
+		mRequests(new boost::atomic<QueuedRequest*>[size]),
+		mHandles(new boost::atomic<handle_t>[size])
+	{
+		for (U32 i = 0; i < size; ++i)
+		{
+			mRequests[i].store(NULL, boost::memory_order_relaxed);
+			mHandles[i].store(nullHandle(), boost::memory_order_relaxed);
+		}
+	}
+	~Slots()
+	{
+		delete [] mRequests;
+		delete [] mHandles;
+	}
+
+	void store(QueuedRequest* req)
+	{
+		U32 slot = req->getHandle() & mMask;
+		mHandles[slot].store(req->getHandle(), boost::memory_order_relaxed);
+		mRequests[slot].store(req, boost::memory_order_release);
+	}
+	void clear(U32 slot)
+	{
+		mRequests[slot].store(NULL, boost::memory_order_relaxed);
+		mHandles[slot].store(nullHandle(), boost::memory_order_release);
+	}
+
+	const U32 mMask;
+	boost::atomic<QueuedRequest*>* const mRequests;
+	boost::atomic<handle_t>* const mHandles;
+};
+
+LLQueuedThread::RequestTable::RequestTable() :
+	mSlots(new Slots(256)),
+	mCount(0)
+{
+}
+
+LLQueuedThread::RequestTable::~RequestTable()
+{
+	delete mSlots.load(boost::memory_order_relaxed);
+	for_each(mRetiredSlots.begin(), mRetiredSlots.end(), DeletePointer());
+}
+
+LLQueuedThread::QueuedRequest* LLQueuedThread::RequestTable::find(handle_t handle) const
+{
+	const Slots* slots = mSlots.load(boost::memory_order_acquire);
+	U32 slot = handle & slots->mMask;
+	QueuedRequest* req = slots->mRequests[slot].load(boost::memory_order_acquire);
+	if (req && slots->mHandles[slot].load(boost::memory_order_relaxed) == handle)
+	{
+		return req;
+	}
+	return NULL;
+}
+
+bool LLQueuedThread::RequestTable::isFree(handle_t handle) const
+{
+	const Slots* slots = mSlots.load(boost::memory_order_relaxed);
+	return !slots->mRequests[handle & slots->mMask].load(boost::memory_order_relaxed);
+}
+
+void LLQueuedThread::RequestTable::insert(QueuedRequest* req)
+{
+	// Handles are handed out before their request is added, so another
+	// request may have taken the slot in the meantime; keep doubling the
+	// table until the handles differ in the masked bits.
+	while (mCount >= (mSlots.load(boost::memory_order_relaxed)->mMask + 1) / 2 ||
+		   !isFree(req->getHandle()))
+	{
+		grow();
+	}
+	mSlots.load(boost::memory_order_relaxed)->store(req);
+	++mCount;
+}
+
+bool LLQueuedThread::RequestTable::erase(handle_t handle)
+{
+	Slots* slots = mSlots.load(boost::memory_order_relaxed);
+	U32 slot = handle & slots->mMask;
+	if (!slots->mRequests[slot].load(boost::memory_order_relaxed) ||
+		slots->mHandles[slot].load(boost::memory_order_relaxed) != handle)
+	{
+		return false;
+	}
+	slots->clear(slot);
+	// Lookups that are still probing an old table must not find it either.
+	for (std::vector<Slots*>::iterator iter = mRetiredSlots.begin(); iter != mRetiredSlots.end(); ++iter)
+	{
+		Slots* retired = *iter;
+		U32 retired_slot = handle & retired->mMask;
+		if (retired->mHandles[retired_slot].load(boost::memory_order_relaxed) == handle)
+		{
+			retired->clear(retired_slot);
+		}
+	}
+	--mCount;
+	return true;
+}
+
+void LLQueuedThread::RequestTable::grow()
+{
+	Slots* slots = mSlots.load(boost::memory_order_relaxed);
+	Slots* new_slots = new Slots((slots->mMask + 1) * 2);
+	// Handles in distinct slots remain distinct with more bits, so this can't collide.
+	for (U32 i = 0; i <= slots->mMask; ++i)
+	{
+		QueuedRequest* req = slots->mRequests[i].load(boost::memory_order_relaxed);
+		if (req)
+		{
+			new_slots->store(req);
+		}
+	}
+	mSlots.store(new_slots, boost::memory_order_release);
+	mRetiredSlots.push_back(slots);
+}
+
+void LLQueuedThread::RequestTable::getRequests(std::vector<QueuedRequest*>& requests) const
+{
+	const Slots* slots = mSlots.load(boost::memory_order_relaxed);
+	for (U32 i = 0; i <= slots->mMask; ++i)
+	{
+		QueuedRequest* req = slots->mRequests[i].load(boost::memory_order_relaxed);
+		if (req)
+		{
+			requests.push_back(req);
+		}
+	}
+}
+
+void LLQueuedThread::RequestTable::clear()
+{
+	Slots* slots = mSlots.load(boost::memory_order_relaxed);
+	for (U32 i = 0; i <= slots->mMask; ++i)
+	{
+		slots->clear(i);
+	}
+	for (std::vector<Slots*>::iterator iter = mRetiredSlots.begin(); iter != mRetiredSlots.end(); ++iter)
+	{
+		for (U32 i = 0; i <= (*iter)->mMask; ++i)
+		{
+			(*iter)->clear(i);
+		}
+	}
+	mCount = 0;
+}
@@ -31,9 +31,11 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
+
+#include "boost/atomic.hpp"
 
 #include "llthread.h"
-#include "llsimplehash.h"
 
 //============================================================================
 // Note: ~LLQueuedThread is O(N) N=# of queued threads, assumed to be small
@@ -73,7 +75,7 @@ public:
 	//------------------------------------------------------------------------
 public:
 
-	class LL_COMMON_API QueuedRequest : public LLSimpleHashEntry<handle_t>
+	class LL_COMMON_API QueuedRequest
 	{
 		friend class LLQueuedThread;
 		
@@ -83,6 +85,10 @@ public:
 	public:
 		QueuedRequest(handle_t handle, U32 priority, U32 flags = 0);
 
+		handle_t getHandle() const
+		{
+			return mHandle;
+		}
 		status_t getStatus()
 		{
 			return mStatus;
@@ -98,7 +104,7 @@ public:
 		bool higherPriority(const QueuedRequest& second) const
 		{
 			if ( mPriority == second.mPriority)
-				return mHashKey < second.mHashKey;
+				return mHandle < second.mHandle;
 			else
 				return mPriority > second.mPriority;
 		}
@@ -132,18 +138,97 @@ public:
 		};
 		
 	protected:
+		const handle_t mHandle;
 		LLAtomic32<status_t> mStatus;
 		U32 mPriority;
 		U32 mFlags;
+
+	private:
+		// Links in the RequestQueue bucket, while queued.
+		QueuedRequest* mQueuePrev;
+		QueuedRequest* mQueueNext;
+		S32 mQueueBucket;
 	};
 
-protected:
-	struct queued_request_less
+	//------------------------------------------------------------------------
+	// Queued requests, bucketed by priority: queuing, removing and changing
+	// the priority of a request are O(1), which matters because the texture
+	// fetcher reprioritizes thousands of requests per second. Requests in the
+	// same bucket (1/4096th of the priority range) are served in the order
+	// they were queued.
+	// The data lock must be held for everything but empty() and size().
+
+	class LL_COMMON_API RequestQueue
 	{
-		bool operator()(const QueuedRequest* lhs, const QueuedRequest* rhs) const
+	public:
+		RequestQueue();
+
+		// ANY THREAD
+		bool empty() const { return !size(); }
+		S32 size() const { return mSize.load(boost::memory_order_relaxed); }
+
+		void insert(QueuedRequest* req);
+		void erase(QueuedRequest* req);
+		// Changes the priority of a queued request.
+		void setPriority(QueuedRequest* req, U32 priority);
+
+		// Returns the queued request with the highest priority, or NULL.
+		QueuedRequest* front() const;
+		// Returns the request after req in priority order, or NULL.
+		QueuedRequest* next(const QueuedRequest* req) const;
+
+	private:
+		enum
 		{
-			return lhs->higherPriority(*rhs); // higher priority in front of queue (set)
-		}
+			BUCKET_SHIFT = 19,						// Priorities are 31 bits.
+			NUM_BUCKETS = 1 << (31 - BUCKET_SHIFT),
+			NUM_WORDS = NUM_BUCKETS / 32,
+			NUM_SUMMARY_WORDS = NUM_WORDS / 32
+		};
+
+		static S32 getBucket(U32 priority) { return llmin(priority, (U32)PRIORITY_IMMEDIATE) >> BUCKET_SHIFT; }
+		// Returns the highest non-empty bucket below bucket, or -1.
+		S32 findBucketBelow(S32 bucket) const;
+
+		// Circular lists, head first.
+		QueuedRequest* mBuckets[NUM_BUCKETS];
+		// Bit per non-empty bucket, and bit per non-zero word of that.
+		U32 mWords[NUM_WORDS];
+		U32 mSummary[NUM_SUMMARY_WORDS];
+		boost::atomic<S32> mSize;
+	};
+
+	//------------------------------------------------------------------------
+	// Requests by handle, direct-mapped: the table grows until every request
+	// has a slot of its own, so finding one is a single probe. Lookups are
+	// lock-free, but a request found without holding the data lock may be
+	// deleted at any moment and must not be dereferenced.
+	// Everything else needs the data lock.
+
+	class LL_COMMON_API RequestTable
+	{
+	public:
+		RequestTable();
+		~RequestTable();
+
+		// ANY THREAD
+		QueuedRequest* find(handle_t handle) const;
+
+		bool isFree(handle_t handle) const;
+		void insert(QueuedRequest* req);
+		bool erase(handle_t handle);
+		bool erase(QueuedRequest* req) { return erase(req->getHandle()); }
+		void getRequests(std::vector<QueuedRequest*>& requests) const;
+		void clear();
+
+	private:
+		struct Slots;
+		void grow();
+
+		boost::atomic<Slots*> mSlots;
+		// Replaced slot arrays, still probed by lookups that started before.
+		std::vector<Slots*> mRetiredSlots;
+		U32 mCount;
 	};
 
 
@@ -153,7 +238,10 @@ public:
 	static handle_t nullHandle() { return handle_t(0); }
 	
 public:
-	LLQueuedThread(const std::string& name, bool threaded = true, bool should_pause = false);
+	// When max_jobs is not zero and threaded is true, requests are processed by
+	// up to max_jobs jobs on the shared LLJobSystem instead of by our own thread.
+	// Only use this if requests can be processed concurrently.
+	LLQueuedThread(const std::string& name, bool threaded = true, bool should_pause = false, S32 max_jobs = 0);
 	virtual ~LLQueuedThread();	
 	virtual void shutdown();
 	
@@ -168,6 +256,10 @@ private:
 	virtual void endThread(void);
 	virtual void threadedUpdate(void);
 
+	class ProcessJob;
+	void scheduleJobs();
+	void processJob();
+
 protected:
 	handle_t generateHandle();
 	bool addRequest(QueuedRequest* req);
@@ -203,12 +295,13 @@ protected:
 	BOOL mThreaded;  // if false, run on main thread and do updates during update()
 	BOOL mStarted;  // required when mThreaded is false to call startThread() from update()
 	LLAtomic32<bool> mIdleThread; // request queue is empty (or we are quitting) and the thread is idle
+	const S32 mMaxJobs;  // if not zero, requests are processed by this many jobs at most instead of by our thread
+	S32 mActiveJobs;     // number of jobs submitted to process requests, protected by the data lock
 	
-	typedef std::set<QueuedRequest*, queued_request_less> request_queue_t;
+	typedef RequestQueue request_queue_t;
 	request_queue_t mRequestQueue;
 
-	enum { REQUEST_HASH_SIZE = 512 }; // must be power of 2
-	typedef LLSimpleHash<handle_t, REQUEST_HASH_SIZE> request_hash_t;
+	typedef RequestTable request_hash_t;
 	request_hash_t mRequestHash;
 
 	handle_t mNextHandle;
@@ -302,6 +302,27 @@ public:
 	 */
 	LLSDXMLParser(bool emit_errors=true);
 
+	/** 
+	 * @brief Parse a document that arrives in pieces, as it arrives.
+	 *
+	 * Pass consecutive chunks of one XML document to parsePartial(),
+	 * then call finishParse() to get the result. The parser must be
+	 * reset before it is used for another document.
+	 * @param buf The next chunk of the document.
+	 * @param len The size of the chunk.
+	 * @return Returns false if the document is not valid XML so far.
+	 */
+	bool parsePartial(const char* buf, int len);
+
+	/** 
+	 * @brief Finish the document passed to parsePartial().
+	 *
+	 * @param data[out] The newly parsed structured data.
+	 * @return Returns the number of LLSD objects parsed into
+	 * data. Returns PARSE_FAILURE (-1) on parse failure.
+	 */
+	S32 finishParse(LLSD& data);
+
 protected:
 	/** 
 	 * @brief Call this method to parse a stream for LLSD.
@@ -246,6 +246,9 @@ public:
 	S32 parseLines(std::istream& input, LLSD& data);
 
 	void parsePart(const char *buf, int len);
+
+	bool parsePartial(const char* buf, int len);
+	S32 finishParse(LLSD& data);
 	
 	void reset();
 
@@ -540,6 +543,32 @@ void LLSDXMLParser::Impl::parsePart(const char* buf, int len)
 	}
 }
 
+bool LLSDXMLParser::Impl::parsePartial(const char* buf, int len)
+{
+	// Anything after the closing </llsd> is ignored, as by parse().
+	if (mGracefullStop || len <= 0)
+	{
+		return true;
+	}
+	return XML_Parse(mParser, buf, len, false) != XML_STATUS_ERROR || mGracefullStop;
+}
+
+S32 LLSDXMLParser::Impl::finishParse(LLSD& data)
+{
+	XML_Status status = mGracefullStop ? XML_STATUS_OK : XML_Parse(mParser, NULL, 0, true);
+	if (status == XML_STATUS_ERROR && !mGracefullStop)
+	{
+		if (mEmitErrors)
+		{
+			LL_INFOS() << "LLSDXMLParser::Impl::finishParse: XML_STATUS_ERROR: " << XML_ErrorString(XML_GetErrorCode(mParser)) << LL_ENDL;
+		}
+		data = LLSD();
+		return LLSDParser::PARSE_FAILURE;
+	}
+	data = mResult;
+	return mParseCount;
+}
+
 // Performance testing code
 //#define	XML_PARSER_PERFORMANCE_TESTS
 
@@ -905,6 +934,16 @@ void LLSDXMLParser::parsePart(const char *buf, int len)
 	impl.parsePart(buf, len);
 }
 
+bool LLSDXMLParser::parsePartial(const char* buf, int len)
+{
+	return impl.parsePartial(buf, len);
+}
+
+S32 LLSDXMLParser::finishParse(LLSD& data)
+{
+	return impl.finishParse(data);
+}
+
 // virtual
 S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data) const
 {
@@ -35,330 +35,260 @@
 
 #include "llstringtable.h"
 #include "llstl.h"
+#include "llthread.h"
+
+#include "boost/atomic.hpp"
 
 LLStringTable gStringTable(32768);
 
-LLStringTableEntry::LLStringTableEntry(const char *str)
-: mString(NULL), mCount(1)
+// Must be a power of 2.
+static const U32 NUM_SHARDS = 16;
+static const U32 SHARD_SHIFT = 28;		// 32 - log2(NUM_SHARDS): shards are selected by the top bits of the hash.
+static const U32 MIN_SHARD_SLOTS = 16;
+static const U32 ENTRIES_PER_CHUNK = 64;
+
+// FNV-1a.
+static U32 hash_string(const char* str, size_t length)
 {
-	// Copy string
-	U32 length = (U32)strlen(str) + 1;	 /*Flawfinder: ignore*/
-	length = llmin(length, MAX_STRINGS_LENGTH);
-	mString = new char[length];
-	strncpy(mString, str, length);	 /*Flawfinder: ignore*/
-	mString[length - 1] = 0;
+	U32 hash = 2166136261U;
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash = (hash ^ (U8)str[i]) * 16777619U;
+	}
+	return hash;
 }
 
-LLStringTableEntry::~LLStringTableEntry()
+LLStringTableEntry::LLStringTableEntry(const char* str, size_t length, U32 hash)
+:	mStdString(str, length),
+	mString(const_cast<char*>(mStdString.c_str())),
+	mCount(1),
+	mHash(hash)
 {
-	delete [] mString;
-	mCount = 0;
 }
 
-LLStringTable::LLStringTable(int tablesize)
-: mUniqueEntries(0)
+struct LLStringTable::Shard
 {
-	S32 i;
-	if (!tablesize)
-		tablesize = 4096; // some arbitrary default
-	// Make sure tablesize is power of 2
-	for (i = 31; i>0; i--)
+	// Open addressing table with linear probing. Slots are only ever filled,
+	// never cleared, so readers can stop probing at the first empty slot.
+	struct Slots
 	{
-		if (tablesize & (1<<i))
+		Slots(U32 size) : mMask(size - 1), mEntries(new boost::atomic<LLStringTableEntry*>[size])
 		{
-			if (tablesize >= (3<<(i-1)))
-				tablesize = (1<<(i+1));
-			else
-				tablesize = (1<<i);
-			break;
+			for (U32 i = 0; i < size; ++i)
+			{
+				mEntries[i].store(NULL, boost::memory_order_relaxed);
+			}
 		}
-	}
-	mMaxEntries = tablesize;
+		~Slots() { delete [] mEntries; }
+
+		void insert(LLStringTableEntry* entry)
+		{
+			U32 i = entry->mHash & mMask;
+			while (mEntries[i].load(boost::memory_order_relaxed))
+			{
+				i = (i + 1) & mMask;
+			}
+			mEntries[i].store(entry, boost::memory_order_release);
+		}
+
+		const U32 mMask;
+		boost::atomic<LLStringTableEntry*>* const mEntries;
+	};
+
+	Shard() : mSlots(NULL), mCount(0), mChunkUsed(ENTRIES_PER_CHUNK) { }
+
+	boost::atomic<Slots*> mSlots;
+
+	// Everything below is only accessed by writers, with mMutex locked.
+	LLMutex mMutex;
+	U32 mCount;
+	std::vector<Slots*> mRetiredSlots;
+	std::vector<LLStringTableEntry*> mChunks;
+	U32 mChunkUsed;
+};
 
-#if !STRING_TABLE_HASH_MAP
-	// ALlocate strings
-	mStringList = new string_list_ptr_t[mMaxEntries];
-	// Clear strings
-	for (i = 0; i < mMaxEntries; i++)
+LLStringTable::LLStringTable(int tablesize)
+:	mShards(new Shard[NUM_SHARDS]),
+	mShardSlots(MIN_SHARD_SLOTS),
+	mUniqueEntries(0)
+{
+	while (mShardSlots < (U32)llmax(tablesize, 0) / NUM_SHARDS)
 	{
-		mStringList[i] = NULL;
+		mShardSlots <<= 1;
+	}
+	for (U32 i = 0; i < NUM_SHARDS; ++i)
+	{
+		mShards[i].mSlots.store(new Shard::Slots(mShardSlots), boost::memory_order_release);
 	}
-#endif
 }
 
 LLStringTable::~LLStringTable()
 {
-#if !STRING_TABLE_HASH_MAP
-	if (mStringList)
+	freeEntries();
+	delete [] mShards;
+}
+
+void LLStringTable::clear()
+{
+	freeEntries();
+	for (U32 i = 0; i < NUM_SHARDS; ++i)
 	{
-		for (S32 i = 0; i < mMaxEntries; i++)
+		Shard& shard = mShards[i];
+		shard.mSlots.store(new Shard::Slots(mShardSlots), boost::memory_order_release);
+		shard.mRetiredSlots.clear();
+		shard.mChunks.clear();
+		shard.mChunkUsed = ENTRIES_PER_CHUNK;
+		shard.mCount = 0;
+	}
+	mUniqueEntries = 0;
+}
+
+void LLStringTable::freeEntries()
+{
+	for (U32 i = 0; i < NUM_SHARDS; ++i)
+	{
+		Shard& shard = mShards[i];
+		delete shard.mSlots.load(boost::memory_order_relaxed);
+		for_each(shard.mRetiredSlots.begin(), shard.mRetiredSlots.end(), DeletePointer());
+		for (U32 chunk = 0; chunk < shard.mChunks.size(); ++chunk)
 		{
-			if (mStringList[i])
+			U32 used = chunk + 1 == shard.mChunks.size() ? shard.mChunkUsed : ENTRIES_PER_CHUNK;
+			for (U32 j = 0; j < used; ++j)
 			{
-				string_list_t::iterator iter;
-				for (iter = mStringList[i]->begin(); iter != mStringList[i]->end(); iter++)
-					delete *iter; // *iter = (LLStringTableEntry*)
+				shard.mChunks[chunk][j].~LLStringTableEntry();
 			}
-			delete mStringList[i];
+			::operator delete(shard.mChunks[chunk]);
 		}
-		delete [] mStringList;
-		mStringList = NULL;
 	}
-#else
-	// Need to clean up the string hash
-	for_each(mStringHash.begin(), mStringHash.end(), DeletePairedPointer());
-	mStringHash.clear();
-#endif
 }
 
+LLStringTableEntry* LLStringTable::find(const char* str, size_t length, U32 hash) const
+{
+	const Shard::Slots* slots = mShards[hash >> SHARD_SHIFT].mSlots.load(boost::memory_order_acquire);
+	for (U32 i = hash & slots->mMask; ; i = (i + 1) & slots->mMask)
+	{
+		LLStringTableEntry* entry = slots->mEntries[i].load(boost::memory_order_acquire);
+		if (!entry)
+		{
+			return NULL;
+		}
+		if (entry->mHash == hash && entry->mStdString.size() == length && !memcmp(entry->mString, str, length))
+		{
+			return entry;
+		}
+	}
+}
 
-static U32 hash_my_string(const char *str, int max_entries)
+LLStringTableEntry* LLStringTable::add(const char* str, size_t length)
 {
-	U32 retval = 0;
-#if 0
-	while (*str)
+	U32 hash = hash_string(str, length);
+	LLStringTableEntry* entry = find(str, length, hash);
+	if (entry)
+	{
+		entry->incCount();
+		return entry;
+	}
+
+	Shard& shard = mShards[hash >> SHARD_SHIFT];
+	LLMutexLock lock(shard.mMutex);
+
+	// Another thread might have added it in the meantime.
+	entry = find(str, length, hash);
+	if (entry)
+	{
+		entry->incCount();
+		return entry;
+	}
+
+	if (shard.mChunkUsed == ENTRIES_PER_CHUNK)
 	{
-		retval <<= 1;
-		retval += *str++;
+		shard.mChunks.push_back(static_cast<LLStringTableEntry*>(::operator new(sizeof(LLStringTableEntry) * ENTRIES_PER_CHUNK)));
+		shard.mChunkUsed = 0;
 	}
-#else
-	while (*str)
+	entry = new (shard.mChunks.back() + shard.mChunkUsed) LLStringTableEntry(str, length, hash);
+	++shard.mChunkUsed;
+
+	Shard::Slots* slots = shard.mSlots.load(boost::memory_order_relaxed);
+	if ((shard.mCount + 1) * 4 > (slots->mMask + 1) * 3)
 	{
-		retval = (retval<<4) + *str;
-		U32 x = (retval & 0xf0000000);
-		if (x) retval = retval ^ (x>>24);
-		retval = retval & (~x);
-		str++;
+		Shard::Slots* old_slots = slots;
+		slots = new Shard::Slots((old_slots->mMask + 1) * 2);
+		for (U32 i = 0; i <= old_slots->mMask; ++i)
+		{
+			LLStringTableEntry* old_entry = old_slots->mEntries[i].load(boost::memory_order_relaxed);
+			if (old_entry)
+			{
+				slots->insert(old_entry);
+			}
+		}
+		shard.mSlots.store(slots, boost::memory_order_release);
+		shard.mRetiredSlots.push_back(old_slots);
 	}
-#endif
-	return (retval & (max_entries-1)); // max_entries is gauranteed to be power of 2
+	slots->insert(entry);
+	++shard.mCount;
+	mUniqueEntries++;
+
+	return entry;
 }
 
 char* LLStringTable::checkString(const std::string& str)
 {
-	return checkString(str.c_str());
+	LLStringTableEntry* entry = checkStringEntry(str);
+	return entry ? entry->mString : NULL;
 }
 
 char* LLStringTable::checkString(const char *str)
 {
-    LLStringTableEntry* entry = checkStringEntry(str);
-    if (entry)
-    {
-	return entry->mString;
-    }
-    else
-    {
-	return NULL;
-    }
+	LLStringTableEntry* entry = checkStringEntry(str);
+	return entry ? entry->mString : NULL;
 }
 
 LLStringTableEntry* LLStringTable::checkStringEntry(const std::string& str)
 {
-    return checkStringEntry(str.c_str());
+	return find(str.c_str(), str.size(), hash_string(str.c_str(), str.size()));
 }
 
 LLStringTableEntry* LLStringTable::checkStringEntry(const char *str)
 {
-	if (str)
+	if (!str)
 	{
-		char *ret_val;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-			{
-				return entry;
-			}
-		}
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-		if (strlist)
-		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); iter++)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					return entry;
-				}
-			}
-		}
-#endif
+		return NULL;
 	}
-	return NULL;
+	size_t length = strlen(str);	 /*Flawfinder: ignore*/
+	return find(str, length, hash_string(str, length));
 }
 
 char* LLStringTable::addString(const std::string& str)
 {
-	//RN: safe to use temporary c_str since string is copied
-	return addString(str.c_str());
+	return add(str.c_str(), str.size())->mString;
 }
 
 char* LLStringTable::addString(const char *str)
 {
-
-    LLStringTableEntry* entry = addStringEntry(str);
-    if (entry)
-    {
-	return entry->mString;
-    }
-    else
-    {
-	return NULL;
-    }
+	LLStringTableEntry* entry = addStringEntry(str);
+	return entry ? entry->mString : NULL;
 }
 
 LLStringTableEntry* LLStringTable::addStringEntry(const std::string& str)
 {
-    return addStringEntry(str.c_str());
+	return add(str.c_str(), str.size());
 }
 
 LLStringTableEntry* LLStringTable::addStringEntry(const char *str)
 {
-	if (str)
-	{
-		char *ret_val = NULL;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-			{
-				entry->incCount();
-				return entry;
-			}
-		}
-
-		// not found, so add!
-		LLStringTableEntry* newentry = new LLStringTableEntry(str);
-		ret_val = newentry->mString;
-		mStringHash.insert(string_hash_t::value_type(hash_value, newentry));
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-
-		if (strlist)
-		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); ++iter)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					entry->incCount();
-					return entry;
-				}
-			}
-		}
-		else
-		{
-			mStringList[hash_value] = new string_list_t;
-			strlist = mStringList[hash_value];
-		}
-
-		// not found, so add!
-		LLStringTableEntry *newentry = new LLStringTableEntry(str);
-		//ret_val = newentry->mString;
-		strlist->push_front(newentry);
-#endif
-		mUniqueEntries++;
-		return newentry;
-	}
-	else
-	{
-		return NULL;
-	}
+	return str ? add(str, strlen(str)) : NULL;	 /*Flawfinder: ignore*/
 }
 
 void LLStringTable::removeString(const char *str)
 {
-	if (str)
+	LLStringTableEntry* entry = checkStringEntry(str);
+	if (entry)
 	{
-		char *ret_val;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-		{
-#if 1 // Microsoft
-			string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-			string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-			std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-			string_hash_t::iterator lower = P.first;
-			string_hash_t::iterator upper = P.second;
-#endif
-			for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-			{
-				entry = iter->second;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					if (!entry->decCount())
-					{
-						mUniqueEntries--;
-						if (mUniqueEntries < 0)
-						{
-							LL_ERRS() << "LLStringTable:removeString trying to remove too many strings!" << LL_ENDL;
-						}
-						delete iter->second;
-						mStringHash.erase(iter);
-					}
-					return;
-				}
-			}
-		}
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-
-		if (strlist)
+		// Unused entries are kept, the count only serves to catch unbalanced removals.
+		entry->decCount();
+		if (entry->mCount < 0)
 		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); ++iter)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					if (!entry->decCount())
-					{
-						mUniqueEntries--;
-						if (mUniqueEntries < 0)
-						{
-							LL_ERRS() << "LLStringTable:removeString trying to remove too many strings!" << LL_ENDL;
-						}
-						strlist->remove(entry);
-						delete entry;
-					}
-					return;
-				}
-			}
+			LL_WARNS() << "LLStringTable::removeString trying to remove \"" << str << "\" too many times!" << LL_ENDL;
 		}
-#endif
 	}
 }
-
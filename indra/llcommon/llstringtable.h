@@ -35,45 +35,44 @@
 #define LL_STRING_TABLE_H
 
 #include "lldefs.h"
+#include "llatomic.h"
 #include "llformat.h"
 #include "llstl.h"
-#include <list>
-#include <set>
-
-#if LL_WINDOWS
-# if (_MSC_VER >= 1300 && _MSC_VER < 1400)
-#  define STRING_TABLE_HASH_MAP 1
-# endif
-#else
-//# define STRING_TABLE_HASH_MAP 1
-#endif
-
-#if STRING_TABLE_HASH_MAP
-# if LL_WINDOWS
-#  include <hash_map>
-# else
-#  include <ext/hash_map>
-# endif
-#endif
-
-const U32 MAX_STRINGS_LENGTH = 256;
+#include <string>
 
+// An interned string. Entries are allocated in chunks owned by their table and
+// are never moved or freed before the table itself is destroyed, so the address
+// of an entry (or of its strings) can be used as a handle for the string.
 class LL_COMMON_API LLStringTableEntry
 {
-public:
-	LLStringTableEntry(const char *str);
-	~LLStringTableEntry();
+	friend class LLStringTable;
+
+	LLStringTableEntry(const char* str, size_t length, U32 hash);
 
+public:
 	void incCount()		{ mCount++; }
 	BOOL decCount()		{ return --mCount; }
 
-	char *mString;
-	S32  mCount;
+	const std::string mStdString;
+	char* const mString;			// mStdString.c_str()
+	LLAtomicS32 mCount;
+	const U32 mHash;
 };
 
+// Concurrent string interning table.
+//
+// Lookups are lock-free and may be done from any thread, as may insertions;
+// those lock one of NUM_SHARDS shards, selected by hash. Each shard is an open
+// addressing table of entry pointers that is replaced by one twice its size
+// when it gets 3/4 full; replaced tables are kept until the LLStringTable is
+// destroyed because other threads may still be probing them.
+//
+// Strings are never removed: removeString() only decrements the reference
+// count of the entry.
 class LL_COMMON_API LLStringTable
 {
 public:
+	// tablesize is the expected number of strings.
 	LLStringTable(int tablesize);
 	~LLStringTable();
 
@@ -88,21 +87,21 @@ public:
 	LLStringTableEntry *addStringEntry(const std::string& str);
 	void  removeString(const char *str);
 
-	S32 mMaxEntries;
-	S32 mUniqueEntries;
-	
-#if STRING_TABLE_HASH_MAP
-#if LL_WINDOWS
-	typedef std::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#else
-	typedef __gnu_cxx::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#endif
-	string_hash_t mStringHash;
-#else
-	typedef std::list<LLStringTableEntry *> string_list_t;
-	typedef string_list_t * string_list_ptr_t;
-	string_list_ptr_t	*mStringList;
-#endif	
+	S32 getUniqueEntries() const { return mUniqueEntries; }
+
+	// Frees all strings. Not thread-safe: nothing may use the table or any of
+	// its entries while (and, for entries, after) this is called.
+	void clear();
+
+private:
+	void freeEntries();
+	LLStringTableEntry* find(const char* str, size_t length, U32 hash) const;
+	LLStringTableEntry* add(const char* str, size_t length);
+
+	struct Shard;
+	Shard* mShards;
+	U32 mShardSlots;
+	LLAtomicS32 mUniqueEntries;
 };
 
 extern LL_COMMON_API LLStringTable gStringTable;
@@ -119,104 +118,44 @@ class LL_COMMON_API LLStdStringTable
 {
 public:
 	LLStdStringTable(S32 tablesize = 0)
+	:	mTable(tablesize ? tablesize : 256)
 	{
-		if (tablesize == 0)
-		{
-			tablesize = 256; // default
-		}
-		// Make sure tablesize is power of 2
-		for (S32 i = 31; i>0; i--)
-		{
-			if (tablesize & (1<<i))
-			{
-				if (tablesize >= (3<<(i-1)))
-					tablesize = (1<<(i+1));
-				else
-					tablesize = (1<<i);
-				break;
-			}
-		}
-		mTableSize = tablesize;
-		mStringList = new string_set_t[tablesize];
-	}
-	~LLStdStringTable()
-	{
-		cleanup();
-		delete[] mStringList;
-	}
-	void cleanup()
-	{
-		// remove strings
-		for (S32 i = 0; i<mTableSize; i++)
-		{
-			string_set_t& stringset = mStringList[i];
-			for (string_set_t::iterator iter = stringset.begin(); iter != stringset.end(); ++iter)
-			{
-				delete *iter;
-			}
-			stringset.clear();
-		}
 	}
 
 	LLStdStringHandle lookup(const std::string& s)
 	{
-		U32 hashval = makehash(s);
-		return lookup(hashval, s);
+		return getHandle(mTable.checkStringEntry(s));
 	}
-	
+
 	LLStdStringHandle checkString(const std::string& s)
 	{
-		U32 hashval = makehash(s);
-		return lookup(hashval, s);
+		return getHandle(mTable.checkStringEntry(s));
 	}
 
 	LLStdStringHandle insert(const std::string& s)
 	{
-		U32 hashval = makehash(s);
-		LLStdStringHandle result = lookup(hashval, s);
-		if (result == NULL)
-		{
-			result = new std::string(s);
-			mStringList[hashval].insert(result);
-		}
-		return result;
+		// Only go through addStringEntry() (and bump the reference count) for new strings.
+		LLStringTableEntry* entry = mTable.checkStringEntry(s);
+		return getHandle(entry ? entry : mTable.addStringEntry(s));
 	}
 	LLStdStringHandle addString(const std::string& s)
 	{
 		return insert(s);
 	}
-	
-private:
-	U32 makehash(const std::string& s)
+
+	void cleanup()
 	{
-		S32 len = (S32)s.size();
-		const char* c = s.c_str();
-		U32 hashval = 0;
-		for (S32 i=0; i<len; i++)
-		{
-			hashval = ((hashval<<5) + hashval) + *c++;
-		}
-		return hashval & (mTableSize-1);
+		mTable.clear();
 	}
-	LLStdStringHandle lookup(U32 hashval, const std::string& s)
+
+private:
+	static LLStdStringHandle getHandle(const LLStringTableEntry* entry)
 	{
-		string_set_t& stringset = mStringList[hashval];
-		LLStdStringHandle handle = &s;
-		string_set_t::iterator iter = stringset.find(handle); // compares actual strings
-		if (iter != stringset.end())
-		{
-			return *iter;
-		}
-		else
-		{
-			return NULL;
-		}
+		return entry ? &entry->mStdString : NULL;
 	}
-	
+
 private:
-	S32 mTableSize;
-	typedef std::set<LLStdStringHandle, compare_pointer_contents<std::string> > string_set_t;
-	string_set_t* mStringList; // [mTableSize]
+	LLStringTable mTable;
 };
 
 
@@ -41,6 +41,22 @@
 #include <sched.h>
 #endif
 
+#if LL_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#endif
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define LL_CPU_RELAX() _mm_pause()
+#else
+#define LL_CPU_RELAX()
+#endif
+
 //----------------------------------------------------------------------------
 // Usage:
 // void run_func(LLThread* thread)
@@ -364,6 +380,106 @@ LLThreadLocalData& LLThreadLocalData::tldata(void)
 
 //============================================================================
 
+BOOST_STATIC_ASSERT(sizeof(boost::atomic<U32>) == sizeof(U32));
+
+#if LL_LINUX
+void ll_futex_wait(boost::atomic<U32>& word, U32 expected)
+{
+	syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+void ll_futex_wake(boost::atomic<U32>& word, int count)
+{
+	syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+#else
+namespace
+{
+	// Without futexes, sleeping threads wait on one of a fixed number of
+	// condition variables, picked by the address they wait for. That costs
+	// nothing per word, and is only used when a thread has to sleep.
+	struct ParkingBucket
+	{
+		boost::mutex mMutex;
+		boost::condition_variable mCondition;
+	};
+
+	ParkingBucket& parking_bucket(void const* address)
+	{
+		static ParkingBucket buckets[64];
+		return buckets[((size_t)address / sizeof(U32)) % LL_ARRAY_SIZE(buckets)];
+	}
+}
+
+void ll_futex_wait(boost::atomic<U32>& word, U32 expected)
+{
+	ParkingBucket& bucket = parking_bucket(&word);
+	boost::unique_lock<boost::mutex> lock(bucket.mMutex);
+	if (word.load() == expected)
+	{
+		bucket.mCondition.wait(lock);
+	}
+}
+
+void ll_futex_wake(boost::atomic<U32>& word, int count)
+{
+	// The bucket might be shared with other words, so wake everyone.
+	ParkingBucket& bucket = parking_bucket(&word);
+	boost::lock_guard<boost::mutex> lock(bucket.mMutex);
+	bucket.mCondition.notify_all();
+}
+#endif
+
+#if USE_NATIVE_MUTEX
+void LLMutexImpl::lock_contended()
+{
+	// Most locks are held very briefly; spinning a little avoids going to
+	// sleep only to be woken right away.
+	const int SPIN_COUNT = 100;
+	for (int i = 0; i < SPIN_COUNT; ++i)
+	{
+		LL_CPU_RELAX();
+		U32 expected = UNLOCKED;
+		if (mState.load(boost::memory_order_relaxed) == UNLOCKED &&
+			mState.compare_exchange_weak(expected, LOCKED, boost::memory_order_acquire))
+		{
+			return;
+		}
+	}
+	// Mark the mutex as having sleepers, so that unlock() wakes us up. When
+	// we get it this way we can't tell whether others are still sleeping, so
+	// it stays marked; that costs at most one unnecessary wake up.
+	while (mState.exchange(LOCKED_WITH_SLEEPERS, boost::memory_order_acquire) != UNLOCKED)
+	{
+		ll_futex_wait(mState, LOCKED_WITH_SLEEPERS);
+	}
+}
+
+void LLMutexImpl::unlock_contended()
+{
+	ll_futex_wake(mState, 1);
+}
+
+void LLConditionVariableImpl::notify(bool all)
+{
+	mSequence++;
+	ll_futex_wake(mSequence, all ? INT_MAX : 1);
+}
+
+void LLConditionVariableImpl::wait(LLMutex& lock)
+{
+	LLMutex::ImplAdoptMutex impl_adopted_mutex(lock);
+	// Anyone that notifies after we release the mutex changes the sequence
+	// number first, so we either don't go to sleep, or are woken up.
+	U32 sequence = mSequence.load();
+	mWaiters++;
+	lock.LLMutexImpl::unlock();
+	ll_futex_wait(mSequence, sequence);
+	lock.LLMutexImpl::lock();
+	mWaiters--;
+}
+#endif
+
 #if defined(NEEDS_MUTEX_IMPL)
 #if defined(USE_WIN32_THREAD)
 LLMutexImpl::LLMutexImpl()
@@ -493,4 +609,50 @@ void LLMutexLock::lock()
 	}
 }
 
+//============================================================================
+
+AIRCULock::AIRCULock() : mEpoch(0)
+{
+	for (S32 i = 0; i < NUM_SHARDS; ++i)
+	{
+		mShards[i].mReaders[0] = 0;
+		mShards[i].mReaders[1] = 0;
+	}
+}
+
+static LL_THREAD_LOCAL S32 sRCUReaderShard = -1;
+static boost::atomic<U32> sRCUNextReaderShard(0);
+
+//static
+U32 AIRCULock::readerShard()
+{
+	if (sRCUReaderShard < 0)
+	{
+		sRCUReaderShard = sRCUNextReaderShard++ % NUM_SHARDS;
+	}
+	return sRCUReaderShard;
+}
+
+void AIRCULock::synchronize()
+{
+	U32 const epoch = mEpoch.load();
+	mEpoch.store(epoch + 1);
+	// New readers count in the other parity now; wait for the old ones.
+	for (S32 i = 0; i < NUM_SHARDS; ++i)
+	{
+		boost::atomic<S32>& readers(mShards[i].mReaders[epoch & 1]);
+		for (S32 spin = 0; readers.load() != 0; ++spin)
+		{
+			if (spin < 100)
+			{
+				LL_CPU_RELAX();
+			}
+			else
+			{
+				LLThread::yield();
+			}
+		}
+	}
+}
+
 //----------------------------------------------------------------------------
\ No newline at end of file
@@ -27,6 +27,7 @@
 #ifndef LL_LLTHREAD_H
 #define LL_LLTHREAD_H
 
+#define USE_NATIVE_MUTEX 1
 #if !defined(_MSC_VER) || _MSC_VER >= 1700
 #define USE_BOOST_MUTEX 1
 #endif
@@ -45,11 +46,18 @@
 #include "llatomic.h"
 #include "llmemory.h"
 #include "aithreadid.h"
+#include "boost/atomic.hpp"
 
 class LLThread;
 class LLMutex;
 class LLCondition;
 
+// Sleeps until woken by ll_futex_wake, unless word no longer equals expected.
+// Can return spuriously.
+LL_COMMON_API void ll_futex_wait(boost::atomic<U32>& word, U32 expected);
+// Wakes up to count threads sleeping in ll_futex_wait on word.
+LL_COMMON_API void ll_futex_wake(boost::atomic<U32>& word, int count);
+
 class LL_COMMON_API LLThreadLocalDataMember
 {
 public:
@@ -190,9 +198,73 @@ protected:
 #define NEEDS_MUTEX_RECURSION do_not_define_manually_thanks
 #undef NEEDS_MUTEX_RECURSION
 
-//Prefer boost over stl over windows over apr.
+//Prefer native over boost over stl over windows over apr.
+
+#if USE_NATIVE_MUTEX
+// Not recursive by themselves; LLMutex keeps track of the lock depth.
+#define NEEDS_MUTEX_RECURSION
+
+class LLMutex;
+
+// A mutex that is a single word: locking and unlocking it without contention
+// is one atomic instruction, without a system call or any allocation, and
+// constructing one costs nothing. A thread that finds it locked spins for a
+// little while, and then sleeps in the kernel until it is unlocked (see
+// ll_futex_wait).
+class LL_COMMON_API LLMutexImpl : private boost::noncopyable
+{
+public:
+	LLMutexImpl() : mState(UNLOCKED) { }
+
+	void lock()
+	{
+		U32 expected = UNLOCKED;
+		if (!mState.compare_exchange_strong(expected, LOCKED, boost::memory_order_acquire))
+		{
+			lock_contended();
+		}
+	}
+	void unlock()
+	{
+		if (mState.exchange(UNLOCKED, boost::memory_order_release) == LOCKED_WITH_SLEEPERS)
+		{
+			unlock_contended();
+		}
+	}
+	bool try_lock()
+	{
+		U32 expected = UNLOCKED;
+		return mState.compare_exchange_strong(expected, LOCKED, boost::memory_order_acquire);
+	}
+
+private:
+	void lock_contended();
+	void unlock_contended();
+
+	enum { UNLOCKED, LOCKED, LOCKED_WITH_SLEEPERS };
+	boost::atomic<U32> mState;
+};
+
+// A condition variable that is two words. Like any condition variable,
+// wait() can return spuriously.
+class LL_COMMON_API LLConditionVariableImpl : private boost::noncopyable
+{
+public:
+	LLConditionVariableImpl() : mSequence(0), mWaiters(0) { }
+
+	// Cheap when there are no waiters, which is the usual case for LLThread::wake().
+	void notify_one() { if (mWaiters.load()) notify(false); }
+	void notify_all() { if (mWaiters.load()) notify(true); }
+	void wait(LLMutex& lock);
+
+private:
+	void notify(bool all);
+
+	boost::atomic<U32> mSequence;		// Incremented by every notify.
+	boost::atomic<U32> mWaiters;
+};
 
-#if USE_BOOST_MUTEX && (BOOST_VERSION >= 103400)	//condition_variable_any was added in boost 1.34
+#elif USE_BOOST_MUTEX && (BOOST_VERSION >= 103400)	//condition_variable_any was added in boost 1.34
 //Define BOOST_SYSTEM_NO_DEPRECATED to avoid system_category() and generic_category() dependencies, as those won't be exported.
 #define BOOST_SYSTEM_NO_DEPRECATED
 #include <boost/thread/mutex.hpp>
@@ -256,7 +328,7 @@ private:
 
 class LL_COMMON_API LLMutex : public LLMutexImpl
 {
-#ifdef NEEDS_MUTEX_IMPL
+#ifdef NEEDS_MUTEX_RECURSION
 	friend class LLConditionVariableImpl;
 #endif
 public:
@@ -346,7 +418,7 @@ public:
 #endif
 	}
 
-#ifdef NEEDS_MUTEX_IMPL
+#ifdef NEEDS_MUTEX_RECURSION
 	//This is important for libraries that we cannot pass LLMutex into.
 	//For example, apr wait. apr wait unlocks and re-locks the thread, however
 	// it has no knowledge of LLMutex::mLockingThread and LLMutex::mLockDepth,
@@ -591,6 +663,61 @@ public:
 #endif
 };
 
+// Keeps track of the readers of an object that is replaced rather than
+// changed (read-copy-update): a writer that replaced it can wait until no
+// reader can still see the previous version (a grace period), after which
+// that can be deleted. Used by AIThreadSafeRCU.
+//
+// Readers never block. They register in one of two epochs; a writer starts
+// a new epoch and waits for the readers of the old one. The reader counts
+// are spread over cache lines, by thread, so that readers on different
+// cores don't fight over one.
+class LL_COMMON_API AIRCULock
+{
+public:
+	AIRCULock();
+
+	// Returns the token to pass to rdunlock().
+	U32 rdlock()
+	{
+		U32 const shard = readerShard();
+		for (;;)
+		{
+			U32 const epoch = mEpoch.load();
+			boost::atomic<S32>& readers(mShards[shard].mReaders[epoch & 1]);
+			++readers;
+			// If a writer started a new epoch meanwhile, it might not be waiting for us.
+			if (mEpoch.load() == epoch)
+			{
+				return (shard << 1) | (epoch & 1);
+			}
+			--readers;
+		}
+	}
+	void rdunlock(U32 token) { mShards[token >> 1].mReaders[token & 1].fetch_sub(1, boost::memory_order_release); }
+
+	// Serializes the writers.
+	void wrlock() { mWriterMutex.lock(); }
+	void wrunlock() { mWriterMutex.unlock(); }
+
+	// Waits until every reader that started before this call finished.
+	// Call with wrlock() held.
+	void synchronize();
+
+private:
+	static U32 readerShard();
+
+	enum { NUM_SHARDS = 16 };
+	struct Shard
+	{
+		boost::atomic<S32> mReaders[2];		// Per epoch parity.
+		char mPad[64 - 2 * sizeof(boost::atomic<S32>)];
+	};
+	Shard mShards[NUM_SHARDS];
+	boost::atomic<U32> mEpoch;
+	LLMutex mWriterMutex;
+};
+
 #if LL_DEBUG
 class AINRLock
 {
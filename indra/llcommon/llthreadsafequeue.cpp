@@ -24,8 +24,6 @@
  */
 
 #include "linden_common.h"
-#include <apr_pools.h>
-#include <apr_queue.h>
 #include "llthreadsafequeue.h"
 
 
@@ -34,67 +32,57 @@
 //-----------------------------------------------------------------------------
 
 
-LLThreadSafeQueueImplementation::LLThreadSafeQueueImplementation(unsigned int capacity):
-	mQueue(0)
+LLThreadSafeQueueImplementation::LLThreadSafeQueueImplementation(void):
+	mInterrupted(false)
 {
-	mPool.create();
-	apr_status_t status = apr_queue_create(&mQueue, capacity, mPool());
-	if(status != APR_SUCCESS) throw LLThreadSafeQueueError("failed to allocate queue");
+	; // No op.
 }
 
 
-LLThreadSafeQueueImplementation::~LLThreadSafeQueueImplementation()
+// static
+size_t LLThreadSafeQueueImplementation::slotCount(unsigned int capacity)
 {
-	if(mQueue != 0) {
-		if(apr_queue_size(mQueue) != 0) LL_WARNS() << 
-			"terminating queue which still contains " << apr_queue_size(mQueue) <<
-			" elements;" << "memory will be leaked" << LL_ENDL;
-		apr_queue_term(mQueue);
-	}
+	size_t count = 2;
+	while(count < capacity) count <<= 1;
+	return count;
 }
 
 
-void LLThreadSafeQueueImplementation::pushFront(void * element)
+void LLThreadSafeQueueImplementation::interrupt(void)
 {
-	apr_status_t status = apr_queue_push(mQueue, element);
-	
-	if(status == APR_EINTR) {
-		throw LLThreadSafeQueueInterrupt();
-	} else if(status != APR_SUCCESS) {
-		throw LLThreadSafeQueueError("push failed");
-	} else {
-		; // Success.
+	mInterrupted = true;
+	// Bump the counts, so that threads that didn't go to sleep yet won't.
+	mPushed.mCount++;
+	mPopped.mCount++;
+	ll_futex_wake(mPushed.mCount, INT_MAX);
+	ll_futex_wake(mPopped.mCount, INT_MAX);
+	while(mPushed.mWaiters.load() || mPopped.mWaiters.load()) {
+		LLThread::yield();
 	}
 }
 
 
-bool LLThreadSafeQueueImplementation::tryPushFront(void * element){
-	return apr_queue_trypush(mQueue, element) == APR_SUCCESS;
-}
-
-
-void * LLThreadSafeQueueImplementation::popBack(void)
+LLThreadSafeQueueImplementation::Waiter::Waiter(LLThreadSafeQueueImplementation& implementation, Event& event):
+	mImplementation(implementation),
+	mEvent(event)
 {
-	void * element;
-	apr_status_t status = apr_queue_pop(mQueue, &element);
-
-	if(status == APR_EINTR) {
-		throw LLThreadSafeQueueInterrupt();
-	} else if(status != APR_SUCCESS) {
-		throw LLThreadSafeQueueError("pop failed");
-	} else {
-		return element;
-	}
+	// Whoever signals after we read the count changes it first, and then
+	// sees that we are waiting.
+	mEvent.mWaiters++;
+	mCount = mEvent.mCount.load();
 }
 
 
-bool LLThreadSafeQueueImplementation::tryPopBack(void *& element)
+LLThreadSafeQueueImplementation::Waiter::~Waiter()
 {
-	return apr_queue_trypop(mQueue, &element) == APR_SUCCESS;
+	mEvent.mWaiters--;
 }
 
 
-size_t LLThreadSafeQueueImplementation::size()
+void LLThreadSafeQueueImplementation::Waiter::wait(void)
 {
-	return apr_queue_size(mQueue);
+	if(!mImplementation.mInterrupted.load()) {
+		ll_futex_wait(mEvent.mCount, mCount);
+	}
+	if(mImplementation.mInterrupted.load()) throw LLThreadSafeQueueInterrupt();
 }
@@ -30,7 +30,9 @@
 
 #include <string>
 #include <stdexcept>
-#include "llaprpool.h"
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include "llthread.h"
 
 
 class LLThreadSafeQueueImplementation; // See below.
@@ -66,31 +68,76 @@ public:
 };
 
 
-struct apr_queue_t; // From apr_queue.h
-
-
 //
-// Implementation details. 
+// Implementation details: putting threads to sleep while the queue is full
+// or empty, and waking them up again. The queue itself doesn't lock.
 //
 class LL_COMMON_API LLThreadSafeQueueImplementation
 {
 public:
-	LLThreadSafeQueueImplementation(unsigned int capacity);
-	~LLThreadSafeQueueImplementation();
-	void pushFront(void * element);
-	bool tryPushFront(void * element);
-	void * popBack(void);
-	bool tryPopBack(void *& element);
-	size_t size();
-	
+	// Something that threads wait for: an element being pushed or popped.
+	class Event
+	{
+	public:
+		Event(void) : mCount(0), mWaiters(0) { }
+
+		// Wakes up a thread waiting for this event, if any.
+		void signal(void)
+		{
+			mCount.fetch_add(1);
+			if (mWaiters.load())
+			{
+				ll_futex_wake(mCount, 1);
+			}
+		}
+
+	private:
+		friend class LLThreadSafeQueueImplementation;
+		boost::atomic<U32> mCount;
+		boost::atomic<U32> mWaiters;
+	};
+
+	// Registers the current thread as waiting for event while it exists.
+	// The caller must check the queue again after creating one, and only
+	// then call wait(), or it might sleep through the event.
+	class Waiter
+	{
+	public:
+		Waiter(LLThreadSafeQueueImplementation& implementation, Event& event);
+		~Waiter();
+
+		// Sleeps until the event is signalled after this waiter was created.
+		// Throws LLThreadSafeQueueInterrupt if the queue is being destroyed.
+		void wait(void);
+
+	private:
+		LLThreadSafeQueueImplementation& mImplementation;
+		Event& mEvent;
+		U32 mCount;
+	};
+
+	LLThreadSafeQueueImplementation(void);
+
+	// Returns the number of slots to use for a queue of the given capacity.
+	static size_t slotCount(unsigned int capacity);
+
+	// Wakes up all blocked threads with an LLThreadSafeQueueInterrupt, and
+	// returns once they have left.
+	void interrupt(void);
+
+	Event mPushed;
+	Event mPopped;
+
 private:
-	LLAPRPool mPool;			// The pool used for mQueue.
-	apr_queue_t * mQueue;
+	boost::atomic<bool> mInterrupted;
 };
 
 
 //
-// Implements a thread safe FIFO.
+// Implements a thread safe FIFO: a bounded ring buffer that any number of
+// threads can push to and pop from at the same time without locking.
+// Elements are stored by value. Threads only sleep (in the kernel) when they
+// use a blocking call on a full or empty queue.
 //
 template<typename ElementT>
 class LLThreadSafeQueue
@@ -98,8 +145,12 @@ class LLThreadSafeQueue
 public:
 	typedef ElementT value_type;
 	
-	// Constructor.
+	// Constructor. The capacity is rounded up to a power of two.
 	LLThreadSafeQueue(unsigned int capacity = 1024);
+
+	// Destructor. Threads still blocked in pushFront() or popBack() get an
+	// LLThreadSafeQueueInterrupt.
+	~LLThreadSafeQueue();
 	
 	// Add an element to the front of queue (will block if the queue has
 	// reached capacity).
@@ -123,11 +174,41 @@ public:
 	// Returns true only if an element was popped.
 	bool tryPopBack(ElementT & element);
 	
-	// Returns the size of the queue.
+	// Returns the size of the queue (a snapshot while other threads use it).
 	size_t size();
 
 private:
+	// No copy constructor or copy assignment.
+	LLThreadSafeQueue(LLThreadSafeQueue const &);
+	LLThreadSafeQueue & operator=(LLThreadSafeQueue const &);
+
+	// A slot is free for the push at position mSequence, and holds the
+	// element for the pop at position mSequence - 1.
+	struct Slot
+	{
+		boost::atomic<size_t> mSequence;
+		typename boost::aligned_storage<sizeof(ElementT), boost::alignment_of<ElementT>::value>::type mStorage;
+
+		ElementT * element(void) { return reinterpret_cast<ElementT *>(&mStorage); }
+	};
+
+	// Returns the slot reserved for the element to push, or NULL if full.
+	Slot * reservePush(void);
+	// Returns the slot of the element to pop, or NULL if empty.
+	Slot * reservePop(size_t & position);
+	// Frees the slot of a popped element.
+	void releasePop(Slot * slot, size_t position);
+
 	LLThreadSafeQueueImplementation mImplementation;
+	Slot * mSlots;
+	size_t const mMask;
+	// Pushes and pops on separate cache lines, so that producers and
+	// consumers don't slow each other down.
+	char mPad0[64];
+	boost::atomic<size_t> mPushPosition;
+	char mPad1[64];
+	boost::atomic<size_t> mPopPosition;
+	char mPad2[64];
 };
 
 
@@ -138,21 +219,78 @@ private:
 
 template<typename ElementT>
 LLThreadSafeQueue<ElementT>::LLThreadSafeQueue(unsigned int capacity) :
-	mImplementation(capacity)
+	mMask(LLThreadSafeQueueImplementation::slotCount(capacity) - 1),
+	mPushPosition(0),
+	mPopPosition(0)
+{
+	mSlots = new Slot[mMask + 1];
+	for(size_t i = 0; i <= mMask; ++i) {
+		mSlots[i].mSequence.store(i, boost::memory_order_relaxed);
+	}
+}
+
+
+template<typename ElementT>
+LLThreadSafeQueue<ElementT>::~LLThreadSafeQueue()
+{
+	mImplementation.interrupt();
+	size_t position;
+	while(Slot * slot = reservePop(position)) {
+		slot->element()->~ElementT();
+	}
+	delete [] mSlots;
+}
+
+
+template<typename ElementT>
+typename LLThreadSafeQueue<ElementT>::Slot * LLThreadSafeQueue<ElementT>::reservePush(void)
+{
+	size_t position = mPushPosition.load(boost::memory_order_relaxed);
+	for(;;) {
+		Slot * slot = &mSlots[position & mMask];
+		size_t sequence = slot->mSequence.load(boost::memory_order_acquire);
+		std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+		if(difference == 0) {
+			if(mPushPosition.compare_exchange_weak(position, position + 1, boost::memory_order_relaxed)) {
+				return slot;
+			}
+		} else if(difference < 0) {
+			return NULL; // Full.
+		} else {
+			position = mPushPosition.load(boost::memory_order_relaxed);
+		}
+	}
+}
+
+
+template<typename ElementT>
+typename LLThreadSafeQueue<ElementT>::Slot * LLThreadSafeQueue<ElementT>::reservePop(size_t & position)
 {
-	; // No op.
+	position = mPopPosition.load(boost::memory_order_relaxed);
+	for(;;) {
+		Slot * slot = &mSlots[position & mMask];
+		size_t sequence = slot->mSequence.load(boost::memory_order_acquire);
+		std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+		if(difference == 0) {
+			if(mPopPosition.compare_exchange_weak(position, position + 1, boost::memory_order_relaxed)) {
+				return slot;
+			}
+		} else if(difference < 0) {
+			return NULL; // Empty.
+		} else {
+			position = mPopPosition.load(boost::memory_order_relaxed);
+		}
+	}
 }
 
 
 template<typename ElementT>
 void LLThreadSafeQueue<ElementT>::pushFront(ElementT const & element)
 {
-	ElementT * elementCopy = new ElementT(element);
-	try {
-		mImplementation.pushFront(elementCopy);
-	} catch (LLThreadSafeQueueInterrupt) {
-		delete elementCopy;
-		throw;
+	while(!tryPushFront(element)) {
+		LLThreadSafeQueueImplementation::Waiter waiter(mImplementation, mImplementation.mPopped);
+		if(tryPushFront(element)) break;
+		waiter.wait();
 	}
 }
 
@@ -160,19 +298,37 @@ void LLThreadSafeQueue<ElementT>::pushFront(ElementT const & element)
 template<typename ElementT>
 bool LLThreadSafeQueue<ElementT>::tryPushFront(ElementT const & element)
 {
-	ElementT * elementCopy = new ElementT(element);
-	bool result = mImplementation.tryPushFront(elementCopy);
-	if(!result) delete elementCopy;
-	return result;
+	Slot * slot = reservePush();
+	if(!slot) return false;
+	size_t position = slot->mSequence.load(boost::memory_order_relaxed);
+	new (slot->element()) ElementT(element);
+	slot->mSequence.store(position + 1, boost::memory_order_release);
+	mImplementation.mPushed.signal();
+	return true;
+}
+
+
+template<typename ElementT>
+void LLThreadSafeQueue<ElementT>::releasePop(Slot * slot, size_t position)
+{
+	slot->element()->~ElementT();
+	slot->mSequence.store(position + mMask + 1, boost::memory_order_release);
+	mImplementation.mPopped.signal();
 }
 
 
 template<typename ElementT>
 ElementT LLThreadSafeQueue<ElementT>::popBack(void)
 {
-	ElementT * element = reinterpret_cast<ElementT *> (mImplementation.popBack());
-	ElementT result(*element);
-	delete element;
+	size_t position;
+	Slot * slot = reservePop(position);
+	while(!slot) {
+		LLThreadSafeQueueImplementation::Waiter waiter(mImplementation, mImplementation.mPushed);
+		slot = reservePop(position);
+		if(!slot) waiter.wait();
+	}
+	ElementT result(*slot->element());
+	releasePop(slot, position);
 	return result;
 }
 
@@ -180,23 +336,21 @@ ElementT LLThreadSafeQueue<ElementT>::popBack(void)
 template<typename ElementT>
 bool LLThreadSafeQueue<ElementT>::tryPopBack(ElementT & element)
 {
-	void * storedElement;
-	bool result = mImplementation.tryPopBack(storedElement);
-	if(result) {
-		ElementT * elementPtr = reinterpret_cast<ElementT *>(storedElement); 
-		element = *elementPtr;
-		delete elementPtr;
-	} else {
-		; // No op.
-	}
-	return result;
+	size_t position;
+	Slot * slot = reservePop(position);
+	if(!slot) return false;
+	element = *slot->element();
+	releasePop(slot, position);
+	return true;
 }
 
 
 template<typename ElementT>
 size_t LLThreadSafeQueue<ElementT>::size(void)
 {
-	return mImplementation.size();
+	size_t pops = mPopPosition.load(boost::memory_order_relaxed);
+	size_t pushes = mPushPosition.load(boost::memory_order_relaxed);
+	return pushes > pops ? pushes - pops : 0;
 }
 
 
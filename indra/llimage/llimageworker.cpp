@@ -32,8 +32,8 @@
 //----------------------------------------------------------------------------
 
 // MAIN THREAD
-LLImageDecodeThread::LLImageDecodeThread(bool threaded)
-	: LLQueuedThread("imagedecode", threaded)
+LLImageDecodeThread::LLImageDecodeThread(bool threaded, S32 max_jobs)
+	: LLQueuedThread("imagedecode", threaded, false, max_jobs)
 {
 	mCreationMutex = new LLMutex();
 }
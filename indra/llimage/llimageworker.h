@@ -72,7 +72,8 @@ public:
 	};
 	
 public:
-	LLImageDecodeThread(bool threaded = true);
+	// With max_jobs, images are decoded concurrently on the shared LLJobSystem workers.
+	LLImageDecodeThread(bool threaded = true, S32 max_jobs = 0);
 	virtual ~LLImageDecodeThread();
 
 	handle_t decodeImage(LLImageFormatted* image,
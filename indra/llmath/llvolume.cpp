@@ -680,7 +680,8 @@ LLProfile::Face* LLProfile::addHole(const LLProfileParams& params, BOOL flat, F3
 
 	Face *face = addFace(mTotalOut, mTotal-mTotalOut,0,LL_FACE_INNER_SIDE, flat);
 
-	static LLAlignedArray<LLVector4a,64> pt;
+	// scratch is per thread so profiles can be generated off the main thread
+	static thread_local LLAlignedArray<LLVector4a,64> pt;
 	pt.resize(mTotal) ;
 
 	for (S32 i=mTotalOut;i<mTotal;i++)
@@ -2030,7 +2031,7 @@ void LLPathParams::copyParams(const LLPathParams &params)
 	setSkew(params.getSkew());
 }
 
-S32 profile_delete_lock = 1 ; 
+static thread_local S32 profile_delete_lock = 1 ; 
 LLProfile::~LLProfile()
 {
 	if(profile_delete_lock)
@@ -2040,7 +2041,7 @@ LLProfile::~LLProfile()
 }
 
 
-S32 LLVolume::sNumMeshPoints = 0;
+LLAtomicS32 LLVolume::sNumMeshPoints(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -2098,7 +2099,7 @@ void LLVolume::genTangents(S32 face)
 
 LLVolume::~LLVolume()
 {
-	sNumMeshPoints -= mMesh.size();
+	sNumMeshPoints -= (S32)mMesh.size();
 	delete mPathp;
 
 	profile_delete_lock = 0 ;
@@ -2164,9 +2165,9 @@ BOOL LLVolume::generate()
 		S32 sizeS = mPathp->mPath.size();
 		S32 sizeT = mProfilep->mProfile.size();
 
-		sNumMeshPoints -= mMesh.size();
+		sNumMeshPoints -= (S32)mMesh.size();
 		mMesh.resize(sizeT * sizeS);
-		sNumMeshPoints += mMesh.size();		
+		sNumMeshPoints += (S32)mMesh.size();		
 
 		//generate vertex positions
 
@@ -2987,80 +2988,106 @@ void LLVolume::sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8
 
 	S32 sizeS = mPathp->mPath.size();
 	S32 sizeT = mProfilep->mProfile.size();
-	
-	S32 line = 0;
-	for (S32 s = 0; s < sizeS; s++)
+
+	// The map column only depends on t and the map row only on s, so resolve
+	// both (including the stitching rules) once rather than per vertex.
+	static thread_local std::vector<U32> col_x;
+	col_x.resize(sizeT);
+
+	for (S32 t = 0; t < sizeT; t++)
 	{
-		// Run along the profile.
-		for (S32 t = 0; t < sizeT; t++)
+		S32 reversed_t = t;
+
+		if (reverse_horizontal)
 		{
-			S32 i = t + line;
-			LLVector4a& pt = mMesh[i];
+			reversed_t = sizeT - t - 1;
+		}
 
-			S32 reversed_t = t;
+		U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
 
-			if (reverse_horizontal)
+		if (x == sculpt_width)   // side stitching
+		{
+			// wrap?
+			if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
 			{
-				reversed_t = sizeT - t - 1;
+				x = 0;
 			}
-			
-			U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
-			U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
-
-			
-			if (y == 0)  // top row stitching
+			else
 			{
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
+				x = sculpt_width - 1;
 			}
+		}
 
-			if (y == sculpt_height)  // bottom row stitching
-			{
-				// wrap?
-				if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
-				{
-					y = 0;
-				}
-				else
-				{
-					y = sculpt_height - 1;
-				}
+		col_x[t] = x;
+	}
 
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
-			}
+	LLVector4a mirror_scale(-1.f,1,1,1);
 
-			if (x == sculpt_width)   // side stitching
+	S32 line = 0;
+	for (S32 s = 0; s < sizeS; s++)
+	{
+		U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
+		bool pinch = false;
+
+		if (y == 0)  // top row stitching
+		{
+			// pinch?
+			pinch = (sculpt_stitching == LL_SCULPT_TYPE_SPHERE);
+		}
+
+		if (y == sculpt_height)  // bottom row stitching
+		{
+			// wrap?
+			if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
 			{
-				// wrap?
-				if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
-				{
-					x = 0;
-				}
-					
-				else
-				{
-					x = sculpt_width - 1;
-				}
+				y = 0;
+			}
+			else
+			{
+				y = sculpt_height - 1;
 			}
 
-			pt = sculpt_xy_to_vector(x, y, sculpt_width, sculpt_height, sculpt_components, sculpt_data);
+			// pinch?
+			pinch = (sculpt_stitching == LL_SCULPT_TYPE_SPHERE);
+		}
+
+		LLVector4a* row = mMesh.mArray + line;
+
+		if (pinch)
+		{ // the whole row collapses to the center of the map row
+			LLVector4a pt = sculpt_xy_to_vector(sculpt_width / 2, y, sculpt_width, sculpt_height, sculpt_components, sculpt_data);
 
 			if (sculpt_mirror)
 			{
-				LLVector4a scale(-1.f,1,1,1);
-				pt.mul(scale);
+				pt.mul(mirror_scale);
 			}
 
 			llassert(pt.isFinite3());
+
+			for (S32 t = 0; t < sizeT; t++)
+			{
+				row[t] = pt;
+			}
+		}
+		else
+		{
+			const U8* row_data = sculpt_data + sculpt_xy_to_index(0, y, sculpt_width, sculpt_height, sculpt_components);
+
+			for (S32 t = 0; t < sizeT; t++)
+			{
+				LLVector4a& pt = row[t];
+
+				pt = sculpt_index_to_vector(col_x[t] * sculpt_components, row_data);
+
+				if (sculpt_mirror)
+				{
+					pt.mul(mirror_scale);
+				}
+
+				llassert(pt.isFinite3());
+			}
 		}
 		
 		line += sizeT;
@@ -3202,9 +3229,9 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
 		LL_WARNS() << "sculpt bad mesh size " << sizeS << " " << sizeT << LL_ENDL;
 	}
 	
-	sNumMeshPoints -= mMesh.size();
+	sNumMeshPoints -= (S32)mMesh.size();
 	mMesh.resize(sizeS * sizeT);
-	sNumMeshPoints += mMesh.size();
+	sNumMeshPoints += (S32)mMesh.size();
 
 	//generate vertex positions
 	if (!data_is_empty)
@@ -6426,51 +6453,72 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 	S32 end_t = mBeginT+mNumT;
 	bool test = (mTypeMask & INNER_MASK) && (mTypeMask & FLAT_MASK) && mNumS > 2;
 
-	// Copy the vertices into the array
-	for (t = mBeginT; t < end_t; t++)
+	// Everything but the row offset and the t tex-coord depends only on s, so
+	// resolve the per-column mesh offset and s tex-coord once up front and
+	// keep the copy loop below free of type mask branches.
+	static thread_local std::vector<S32> col_offset;
+	static thread_local std::vector<F32> col_s;
+	col_offset.resize(num_s);
+	col_s.resize(num_s);
+
+	for (s = 0; s < num_s; s++)
 	{
-		tt = path_data[t].mTexT;
-		for (s = 0; s < num_s; s++)
+		if (mTypeMask & END_MASK)
 		{
-			if (mTypeMask & END_MASK)
+			if (s)
 			{
-				if (s)
-				{
-					ss = 1.f;
-				}
-				else
-				{
-					ss = 0.f;
-				}
+				ss = 1.f;
 			}
 			else
 			{
-				// Get s value for tex-coord.
-				if (!flat)
-				{
-					ss = profile[mBeginS + s][2];
-				}
-				else
-				{
-					ss = profile[mBeginS + s][2] - begin_stex;
-				}
-			}
-
-			if (sculpt_reverse_horizontal)
-			{
-				ss = 1.f - ss;
+				ss = 0.f;
 			}
-			
-			// Check to see if this triangle wraps around the array.
-			if (mBeginS + s >= max_s)
+		}
+		else
+		{
+			// Get s value for tex-coord.
+			if (!flat)
 			{
-				// We're wrapping
-				i = mBeginS + s + max_s*(t-1);
+				ss = profile[mBeginS + s][2];
 			}
 			else
 			{
-				i = mBeginS + s + max_s*t;
+				ss = profile[mBeginS + s][2] - begin_stex;
 			}
+		}
+
+		if (sculpt_reverse_horizontal)
+		{
+			ss = 1.f - ss;
+		}
+
+		col_s[s] = ss;
+
+		// Check to see if this triangle wraps around the array.
+		if (mBeginS + s >= max_s)
+		{
+			// We're wrapping
+			col_offset[s] = mBeginS + s - max_s;
+		}
+		else
+		{
+			col_offset[s] = mBeginS + s;
+		}
+	}
+
+	S32 inner_s = (mTypeMask & OPEN_MASK) ? num_s-1 : 0;
+	F32 inner_ss = test ? profile[mBeginS + inner_s][2] - begin_stex : 0.f;
+
+	// Copy the vertices into the array
+	for (t = mBeginT; t < end_t; t++)
+	{
+		tt = path_data[t].mTexT;
+		S32 row = max_s*t;
+
+		for (s = 0; s < num_s; s++)
+		{
+			i = col_offset[s] + row;
+			ss = col_s[s];
 
 			mesh[i].store4a((F32*)(pos+cur_vertex));
 			tc[cur_vertex].set(ss,tt);
@@ -6485,22 +6533,12 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 			}
 		}
 		
-		if ((mTypeMask & INNER_MASK) && (mTypeMask & FLAT_MASK) && mNumS > 2)
+		if (test)
 		{
-			if (mTypeMask & OPEN_MASK)
-			{
-				s = num_s-1;
-			}
-			else
-			{
-				s = 0;
-			}
-
-			i = mBeginS + s + max_s*t;
-			ss = profile[mBeginS + s][2] - begin_stex;
+			i = mBeginS + inner_s + row;
 
 			mesh[i].store4a((F32*)(pos+cur_vertex));
-			tc[cur_vertex].set(ss,tt);
+			tc[cur_vertex].set(inner_ss,tt);
 			
 			cur_vertex++;
 		}
@@ -6634,7 +6672,7 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 
 	LLVector4a* norm = mNormals;
 
-	static LLAlignedArray<LLVector4a, 64> triangle_normals;
+	static thread_local LLAlignedArray<LLVector4a, 64> triangle_normals;
 	triangle_normals.resize(count);
 	LLVector4a* output = triangle_normals.mArray;
 	LLVector4a* end_output = output+count;
@@ -6884,16 +6922,11 @@ void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVe
         const LLVector2& w2 = texcoord[i2];
         const LLVector2& w3 = texcoord[i3];
         
-		const F32* v1ptr = v1.getF32ptr();
-		const F32* v2ptr = v2.getF32ptr();
-		const F32* v3ptr = v3.getF32ptr();
-		
-        float x1 = v2ptr[0] - v1ptr[0];
-        float x2 = v3ptr[0] - v1ptr[0];
-        float y1 = v2ptr[1] - v1ptr[1];
-        float y2 = v3ptr[1] - v1ptr[1];
-        float z1 = v2ptr[2] - v1ptr[2];
-        float z2 = v3ptr[2] - v1ptr[2];
+		// triangle edges, all three axes at once
+		LLVector4a e1;
+		LLVector4a e2;
+		e1.setSub(v2, v1);
+		e2.setSub(v3, v1);
         
         float s1 = w2.mV[0] - w1.mV[0];
         float s2 = w3.mV[0] - w1.mV[0];
@@ -6908,10 +6941,22 @@ void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVe
 		llassert(std::isfinite(r));
 		llassert(!std::isnan(r));
 
-		LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-				(t2 * z1 - t1 * z2) * r);
-		LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-				(s1 * z2 - s2 * z1) * r);
+		// sdir = (e1*t2 - e2*t1)*r, tdir = (e2*s1 - e1*s2)*r -- same operation
+		// order as the per-axis form so the result is bit identical; the w
+		// lane is ignored below (dot3/cross3) and overwritten with handedness
+		LLVector4a sdir;
+		LLVector4a tdir;
+		LLVector4a tmp;
+
+		sdir.setMul(e1, LLVector4a(t2));
+		tmp.setMul(e2, LLVector4a(t1));
+		sdir.sub(tmp);
+		sdir.mul(r);
+
+		tdir.setMul(e2, LLVector4a(s1));
+		tmp.setMul(e1, LLVector4a(s2));
+		tdir.sub(tmp);
+		tdir.mul(r);
         
 		tan1[i1].add(sdir);
 		tan1[i2].add(sdir);
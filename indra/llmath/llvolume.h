@@ -61,6 +61,7 @@ class LLVolumeTriangle;
 #include "llfile.h"
 #include "llalignedarray.h"
 #include "llrigginginfo.h"
+#include "llatomic.h"
 
 //============================================================================
 
@@ -668,6 +669,23 @@ public:
 			return (*first < *second);
 		}
 	};
+
+	// Consistent with operator==(); e.g. for hashed containers.
+	size_t getHash() const { return absl::Hash<LLVolumeParams>()(*this); }
+
+	template <typename H>
+	friend H AbslHashValue(H h, const LLVolumeParams& params)
+	{
+		const LLProfileParams& profile = params.mProfileParams;
+		const LLPathParams& path = params.mPathParams;
+		return H::combine(std::move(h),
+						  profile.getCurveType(), profile.getBegin(), profile.getEnd(), profile.getHollow(),
+						  path.getCurveType(), path.getBegin(), path.getEnd(),
+						  path.getScaleX(), path.getScaleY(), path.getShearX(), path.getShearY(),
+						  path.getTwistBegin(), path.getTwistEnd(), path.getRadiusOffset(),
+						  path.getTaperX(), path.getTaperY(), path.getRevolutions(), path.getSkew(),
+						  params.mSculptID, params.mSculptType);
+	}
 	
 	friend std::ostream& operator<<(std::ostream &s, const LLVolumeParams &volume_params);
 
@@ -1049,7 +1067,7 @@ public:
 	LLFaceID generateFaceMask();
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
-	static S32 sNumMeshPoints;
+	static LLAtomicS32 sNumMeshPoints;
 
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);		// HACK to bypass Windoze confusion over 
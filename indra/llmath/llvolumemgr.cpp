@@ -45,43 +45,41 @@ F32 LLVolumeLODGroup::mDetailScales[NUM_LODS] = {1.f, 1.5f, 2.5f, 4.f};
 //============================================================================
 
 LLVolumeMgr::LLVolumeMgr()
-:	mDataMutex(NULL)
 {
 	// the LLMutex magic interferes with easy unit testing,
 	// so you now must manually call useMutex() to use it
-	//mDataMutex = new LLMutex;
 }
 
 LLVolumeMgr::~LLVolumeMgr()
 {
 	cleanup();
 
-	delete mDataMutex;
-	mDataMutex = NULL;
+	for (S32 i = 0; i < NUM_SHARDS; i++)
+	{
+		delete mShards[i].mMutex;
+		mShards[i].mMutex = NULL;
+	}
 }
 
 BOOL LLVolumeMgr::cleanup()
 {
 	BOOL no_refs = TRUE;
-	if (mDataMutex)
+	for (S32 i = 0; i < NUM_SHARDS; i++)
 	{
-		mDataMutex->lock();
-	}
-	for (volume_lod_group_map_t::iterator iter = mVolumeLODGroups.begin(),
-			 end = mVolumeLODGroups.end();
-		 iter != end; iter++)
-	{
-		LLVolumeLODGroup *volgroupp = iter->second;
-		if (volgroupp->cleanupRefs() == false)
+		Shard& shard = mShards[i];
+		LLMutexLock lock(shard.mMutex);
+		for (volume_lod_group_map_t::iterator iter = shard.mGroups.begin(),
+				 end = shard.mGroups.end();
+			 iter != end; iter++)
 		{
-			no_refs = FALSE;
+			LLVolumeLODGroup *volgroupp = iter->second;
+			if (volgroupp->cleanupRefs() == false)
+			{
+				no_refs = FALSE;
+			}
+			delete volgroupp;
 		}
- 		delete volgroupp;
-	}
-	mVolumeLODGroups.clear();
-	if (mDataMutex)
-	{
-		mDataMutex->unlock();
+		shard.mGroups.clear();
 	}
 	return no_refs;
 }
@@ -92,45 +90,49 @@ BOOL LLVolumeMgr::cleanup()
 //  anything holding the volume and the LODGroup are destroyed
 LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32 detail)
 {
+	return refVolume(volume_params, detail, NULL);
+}
+
+LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32 detail, LLVolume* prebuilt)
+{
+	GroupKey key = { volume_params.getHash(), &volume_params };
+	Shard& shard = getShard(key.mHash);
 	LLVolumeLODGroup* volgroupp;
-	if (mDataMutex)
-	{
-		mDataMutex->lock();
-	}
-	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
-	if( iter == mVolumeLODGroups.end() )
-	{
-		volgroupp = createNewGroup(volume_params);
-	}
-	else
+	LLVolume* volumep;
 	{
-		volgroupp = iter->second;
+		LLMutexLock lock(shard.mMutex);
+		volume_lod_group_map_t::iterator iter = shard.mGroups.find(key);
+		if (iter == shard.mGroups.end())
+		{
+			volgroupp = createNewGroup(volume_params);
+		}
+		else
+		{
+			volgroupp = iter->second;
+		}
+		// The reference keeps the group alive while the volume is generated.
+		volumep = volgroupp->addLODRef(detail, prebuilt);
 	}
-	if (mDataMutex)
+
+	if (!volumep)
 	{
-		mDataMutex->unlock();
+		// Generate without the lock, so that other threads can look up
+		// shapes in this shard meanwhile.
+		LLPointer<LLVolume> new_volume = new LLVolume(volume_params, LLVolumeLODGroup::getVolumeScaleFromDetail(detail));
+		LLMutexLock lock(shard.mMutex);
+		volumep = volgroupp->setLOD(detail, new_volume);
 	}
-	return volgroupp->refLOD(detail);
+	return volumep;
 }
 
 // virtual
 LLVolumeLODGroup* LLVolumeMgr::getGroup( const LLVolumeParams& volume_params ) const
 {
-	LLVolumeLODGroup* volgroupp = NULL;
-	if (mDataMutex)
-	{
-		mDataMutex->lock();
-	}
-	volume_lod_group_map_t::const_iterator iter = mVolumeLODGroups.find(&volume_params);
-	if( iter != mVolumeLODGroups.end() )
-	{
-		volgroupp = iter->second;
-	}
-	if (mDataMutex)
-	{
-		mDataMutex->unlock();
-	}
-	return volgroupp;
+	GroupKey key = { volume_params.getHash(), &volume_params };
+	const Shard& shard = getShard(key.mHash);
+	LLMutexLock lock(shard.mMutex);
+	volume_lod_group_map_t::const_iterator iter = shard.mGroups.find(key);
+	return iter != shard.mGroups.end() ? iter->second : NULL;
 }
 
 void LLVolumeMgr::unrefVolume(LLVolume *volumep)
@@ -141,18 +143,13 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
 		return;
 	}
 	const LLVolumeParams* params = &(volumep->getParams());
-	if (mDataMutex)
-	{
-		mDataMutex->lock();
-	}
-	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(params);
-	if( iter == mVolumeLODGroups.end() )
+	GroupKey key = { params->getHash(), params };
+	Shard& shard = getShard(key.mHash);
+	LLMutexLock lock(shard.mMutex);
+	volume_lod_group_map_t::iterator iter = shard.mGroups.find(key);
+	if( iter == shard.mGroups.end() )
 	{
 		LL_ERRS() << "Warning! Tried to cleanup unknown volume type! " << *params << LL_ENDL;
-		if (mDataMutex)
-		{
-			mDataMutex->unlock();
-		}
 		return;
 	}
 	else
@@ -162,21 +159,17 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
 		volgroupp->derefLOD(volumep);
 		if (volgroupp->getNumRefs() == 0)
 		{
-			mVolumeLODGroups.erase(params);
+			shard.mGroups.erase(iter);
 			delete volgroupp;
 		}
 	}
-	if (mDataMutex)
-	{
-		mDataMutex->unlock();
-	}
-
 }
 
 // protected
 void LLVolumeMgr::insertGroup(LLVolumeLODGroup* volgroup)
 {
-	mVolumeLODGroups[volgroup->getVolumeParams()] = volgroup;
+	GroupKey key = { volgroup->getParamsHash(), volgroup->getVolumeParams() };
+	getShard(key.mHash).mGroups[key] = volgroup;
 }
 
 // protected
@@ -191,55 +184,62 @@ LLVolumeLODGroup* LLVolumeMgr::createNewGroup(const LLVolumeParams& volume_param
 void LLVolumeMgr::dump()
 {
 	F32 avg = 0.f;
-	if (mDataMutex)
-	{
-		mDataMutex->lock();
-	}
-	for (volume_lod_group_map_t::iterator iter = mVolumeLODGroups.begin(),
-			 end = mVolumeLODGroups.end();
-		 iter != end; iter++)
-	{
-		LLVolumeLODGroup *volgroupp = iter->second;
-		avg += volgroupp->dump();
+	S32 count = 0;
+	for (S32 i = 0; i < NUM_SHARDS; i++)
+	{
+		Shard& shard = mShards[i];
+		LLMutexLock lock(shard.mMutex);
+		for (volume_lod_group_map_t::iterator iter = shard.mGroups.begin(),
+				 end = shard.mGroups.end();
+			 iter != end; iter++)
+		{
+			LLVolumeLODGroup *volgroupp = iter->second;
+			avg += volgroupp->dump();
+		}
+		count += (S32)shard.mGroups.size();
 	}
-	int count = (int)mVolumeLODGroups.size();
 	avg = count ? avg / (F32)count : 0.0f;
-	if (mDataMutex)
+	LL_INFOS() << "Average usage of LODs " << avg << LL_ENDL;
+}
+
+S32 LLVolumeMgr::getNumGroups() const
+{
+	S32 count = 0;
+	for (S32 i = 0; i < NUM_SHARDS; i++)
 	{
-		mDataMutex->unlock();
+		LLMutexLock lock(mShards[i].mMutex);
+		count += (S32)mShards[i].mGroups.size();
 	}
-	LL_INFOS() << "Average usage of LODs " << avg << LL_ENDL;
+	return count;
 }
 
 void LLVolumeMgr::useMutex()
 { 
-	if (!mDataMutex)
+	for (S32 i = 0; i < NUM_SHARDS; i++)
 	{
-		mDataMutex = new LLMutex();
+		if (!mShards[i].mMutex)
+		{
+			mShards[i].mMutex = new LLMutex();
+		}
 	}
 }
 
 std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 {
-	s << "{ numLODgroups=" << volume_mgr.mVolumeLODGroups.size() << ", ";
+	s << "{ numLODgroups=" << volume_mgr.getNumGroups() << ", ";
 
 	S32 total_refs = 0;
-	if (volume_mgr.mDataMutex)
-	{
-		volume_mgr.mDataMutex->lock();
-	}
-
-	for (LLVolumeMgr::volume_lod_group_map_t::const_iterator iter = volume_mgr.mVolumeLODGroups.begin();
-		 iter != volume_mgr.mVolumeLODGroups.end(); ++iter)
-	{
-		LLVolumeLODGroup *volgroupp = iter->second;
-		total_refs += volgroupp->getNumRefs();
-		s << ", " << (*volgroupp);
-	}
-
-	if (volume_mgr.mDataMutex)
+	for (S32 i = 0; i < LLVolumeMgr::NUM_SHARDS; i++)
 	{
-		volume_mgr.mDataMutex->unlock();
+		const LLVolumeMgr::Shard& shard = volume_mgr.mShards[i];
+		LLMutexLock lock(shard.mMutex);
+		for (LLVolumeMgr::volume_lod_group_map_t::const_iterator iter = shard.mGroups.begin();
+			 iter != shard.mGroups.end(); ++iter)
+		{
+			LLVolumeLODGroup *volgroupp = iter->second;
+			total_refs += volgroupp->getNumRefs();
+			s << ", " << (*volgroupp);
+		}
 	}
 
 	s << ", total_refs=" << total_refs << " }";
@@ -248,6 +248,7 @@ std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 
 LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
 	: mVolumeParams(params),
+	  mParamsHash(params.getHash()),
 	  mRefs(0)
 {
 	for (S32 i = 0; i < NUM_LODS; i++)
@@ -288,17 +289,37 @@ bool LLVolumeLODGroup::cleanupRefs()
 	return res;
 }
 
-LLVolume* LLVolumeLODGroup::refLOD(const S32 detail)
+LLVolume* LLVolumeLODGroup::refLOD(const S32 detail, LLVolume* prebuilt)
+{
+	LLVolume* volumep = addLODRef(detail, prebuilt);
+	if (!volumep)
+	{
+		volumep = setLOD(detail, new LLVolume(mVolumeParams, mDetailScales[detail]));
+	}
+	return volumep;
+}
+
+LLVolume* LLVolumeLODGroup::addLODRef(const S32 detail, LLVolume* prebuilt)
 {
 	llassert(detail >=0 && detail < NUM_LODS);
 	mAccessCount[detail]++;
 	
 	mRefs++;
+	mLODRefs[detail]++;
+	if (mVolumeLODs[detail].isNull() && prebuilt)
+	{
+		llassert(prebuilt->getDetail() == mDetailScales[detail]);
+		mVolumeLODs[detail] = prebuilt;
+	}
+	return mVolumeLODs[detail];
+}
+
+LLVolume* LLVolumeLODGroup::setLOD(const S32 detail, LLVolume* volumep)
+{
 	if (mVolumeLODs[detail].isNull())
 	{
-		mVolumeLODs[detail] = new LLVolume(mVolumeParams, mDetailScales[detail]);
+		mVolumeLODs[detail] = volumep;
 	}
-	mLODRefs[detail]++;
 	return mVolumeLODs[detail];
 }
 
@@ -27,7 +27,7 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
-#include <map>
+#include <absl/container/flat_hash_map.h>
 
 #include "llvolume.h"
 #include "llpointer.h"
@@ -54,17 +54,28 @@ public:
 	static F32 getVolumeScaleFromDetail(const S32 detail);
 	static S32 getVolumeDetailFromScale(F32 scale);
 
-	LLVolume* refLOD(const S32 detail);
+	// Uses prebuilt, generated for this group's parameters at detail, when
+	// the group has no volume for that detail yet.
+	LLVolume* refLOD(const S32 detail, LLVolume* prebuilt = NULL);
+	// refLOD() in two steps, so that the volume can be generated without
+	// holding the lock of the manager: addLODRef() takes the reference and
+	// returns the volume, or NULL if there is none yet. In that case the
+	// caller generates one and passes it to setLOD(), which keeps it unless
+	// another thread was first and returns the one to use.
+	LLVolume* addLODRef(const S32 detail, LLVolume* prebuilt = NULL);
+	LLVolume* setLOD(const S32 detail, LLVolume* volumep);
 	BOOL derefLOD(LLVolume *volumep);
 	S32 getNumRefs() const { return mRefs; }
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
+	size_t getParamsHash() const { return mParamsHash; }
 
 	F32	dump();
 	friend std::ostream& operator<<(std::ostream& s, const LLVolumeLODGroup& volgroup);
 
 protected:
 	LLVolumeParams mVolumeParams;
+	const size_t mParamsHash;
 
 	S32 mRefs;
 	S32 mLODRefs[NUM_LODS];
@@ -87,9 +98,14 @@ public:
 	// cannot keep references for long since it may be deleted
 	// later.  For best results hold it in an LLPointer<LLVolume>.
 	virtual LLVolume *refVolume(const LLVolumeParams &volume_params, const S32 detail);
+	// Same as above, but takes a volume already generated for these parameters
+	// and detail (e.g. on another thread) instead of generating one, unless
+	// the manager already has it.
+	LLVolume *refVolume(const LLVolumeParams &volume_params, const S32 detail, LLVolume* prebuilt);
 	virtual void unrefVolume(LLVolume *volumep);
 
 	void dump();
+	S32 getNumGroups() const;
 
 	// manually call this for mutex magic
 	void useMutex();
@@ -102,10 +118,43 @@ protected:
 	virtual LLVolumeLODGroup* createNewGroup(const LLVolumeParams& volume_params);
 
 protected:
-	typedef std::map<const LLVolumeParams*, LLVolumeLODGroup*, LLVolumeParams::compare> volume_lod_group_map_t;
-	volume_lod_group_map_t mVolumeLODGroups;
+	// Groups are keyed on the hash of their parameters, computed once, so
+	// that probing and rehashing only compare full parameters on a match.
+	struct GroupKey
+	{
+		size_t mHash;
+		const LLVolumeParams* mParams;
+	};
+	struct GroupKeyHash
+	{
+		size_t operator()(const GroupKey& key) const { return key.mHash; }
+	};
+	struct GroupKeyEq
+	{
+		bool operator()(const GroupKey& a, const GroupKey& b) const
+		{
+			return a.mHash == b.mHash && *a.mParams == *b.mParams;
+		}
+	};
+	typedef absl::flat_hash_map<GroupKey, LLVolumeLODGroup*, GroupKeyHash, GroupKeyEq> volume_lod_group_map_t;
+
+	// The table is split in shards, each with its own lock, so that threads
+	// referencing different shapes don't wait for each other.
+	enum
+	{
+		SHARD_BITS = 4,
+		NUM_SHARDS = 1 << SHARD_BITS
+	};
+	struct Shard
+	{
+		Shard() : mMutex(NULL) { }
+		volume_lod_group_map_t mGroups;
+		LLMutex* mMutex;
+	};
+	Shard& getShard(size_t hash) { return mShards[hash >> (sizeof(size_t) * 8 - SHARD_BITS)]; }
+	const Shard& getShard(size_t hash) const { return mShards[hash >> (sizeof(size_t) * 8 - SHARD_BITS)]; }
 
-	LLMutex* mDataMutex;
+	Shard mShards[NUM_SHARDS];
 };
 
 #endif // LL_LLVOLUMEMGR_H
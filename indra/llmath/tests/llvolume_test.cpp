@@ -0,0 +1,321 @@
+/** 
+ * @file llvolume_test.cpp
+ * @brief LLVolume unit test: golden checksums of the generated meshes
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include <cmath>
+#include <vector>
+
+#include "../llvolume.h"
+
+#include "../test/lltut.h"
+
+// Defined by the viewer, referenced by llvolume.cpp and lloctree.h
+BOOL gDebugGL = FALSE;
+U32 gOctreeMaxCapacity = 128;
+float gOctreeMinSize = 0.01f;
+U32 gOctreeReserveCapacity = 0;
+
+namespace
+{
+	// Any non null id marks the params as a sculpt; the map is supplied directly.
+	const LLUUID SCULPT_ID("5a5a5a5a-5a5a-5a5a-5a5a-5a5a5a5a5a5a");
+
+	// Sum of all components, each weighted by a pseudo random factor from its
+	// position in the stream, so that values landing in the wrong place change
+	// the sum about as much as wrong values do. Normals and tangents are
+	// renormalized first: normalize3fast() depends on the CPU's _mm_rsqrt_ps().
+	struct WeightedSum
+	{
+		WeightedSum() : mSum(0.0), mScale(0.0), mCount(0) { }
+
+		void add(F64 value)
+		{
+			F64 weight = 1.0 + ((mCount++ * 2654435761u) >> 22) / 1024.0;
+			mSum += weight * value;
+			mScale += weight * fabs(value);
+		}
+
+		void add(const F32* v, S32 components, bool normalize)
+		{
+			F64 length = 1.0;
+			if (normalize)
+			{
+				length = sqrt((F64)v[0] * v[0] + (F64)v[1] * v[1] + (F64)v[2] * v[2]);
+			}
+			for (S32 i = 0; i < components; ++i)
+			{
+				// Degenerate vectors come out as NaN; count them as zero.
+				add(std::isfinite(length) && length > 0.0 ? v[i] / length : 0.0);
+			}
+		}
+
+		F64 mSum;
+		F64 mScale;
+		U32 mCount;
+	};
+
+	enum { POSITIONS, NORMALS, TEXCOORDS, TANGENTS, HANDEDNESS, NUM_STREAMS };
+
+	// Triangles without area, in space or in texture space, leave the normals or
+	// the tangent handedness of their corners up to rounding; that's the case at
+	// the poles of spheres and along collapsed rows of cut and hollowed prims.
+	bool degenerate(const LLVector4a& p1, const LLVector4a& p2, const LLVector4a& p3,
+					const LLVector2& w1, const LLVector2& w2, const LLVector2& w3)
+	{
+		F64 e1[3], e2[3];
+		for (S32 i = 0; i < 3; ++i)
+		{
+			e1[i] = (F64)p2[i] - p1[i];
+			e2[i] = (F64)p3[i] - p1[i];
+		}
+		F64 cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		F64 area = cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2];
+		F64 size = llmax(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2], e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]);
+
+		F64 s1 = (F64)w2.mV[0] - w1.mV[0];
+		F64 s2 = (F64)w3.mV[0] - w1.mV[0];
+		F64 t1 = (F64)w2.mV[1] - w1.mV[1];
+		F64 t2 = (F64)w3.mV[1] - w1.mV[1];
+		F64 uv_area = s1 * t2 - s2 * t1;
+		F64 uv_size = llmax(s1 * s1 + t1 * t1, s2 * s2 + t2 * t2);
+
+		return area <= 1e-10 * size * size || uv_area * uv_area <= 1e-10 * uv_size * uv_size;
+	}
+
+	void checksum_volume(LLVolume* volume, WeightedSum sums[NUM_STREAMS])
+	{
+		std::vector<bool> unstable;
+		for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+		{
+			volume->genTangents(f);
+			const LLVolumeFace& face = volume->getVolumeFace(f);
+
+			unstable.assign(face.mNumVertices, false);
+			for (S32 i = 0; i + 2 < face.mNumIndices; i += 3)
+			{
+				const U16* idx = face.mIndices + i;
+				if (degenerate(face.mPositions[idx[0]], face.mPositions[idx[1]], face.mPositions[idx[2]],
+							   face.mTexCoords[idx[0]], face.mTexCoords[idx[1]], face.mTexCoords[idx[2]]))
+				{
+					unstable[idx[0]] = unstable[idx[1]] = unstable[idx[2]] = true;
+				}
+			}
+
+			for (S32 i = 0; i < face.mNumVertices; ++i)
+			{
+				sums[POSITIONS].add(face.mPositions[i].getF32ptr(), 3, false);
+				sums[TEXCOORDS].add(face.mTexCoords[i].mV, 2, false);
+				sums[TANGENTS].add(face.mTangents[i].getF32ptr(), 3, true);
+				if (!unstable[i])
+				{
+					sums[NORMALS].add(face.mNormals[i].getF32ptr(), 3, true);
+					sums[HANDEDNESS].add(face.mTangents[i].getF32ptr()[3]);
+				}
+			}
+		}
+	}
+
+	// A lumpy sphere, so the map passes the sculpt area checks at every stitching type.
+	void make_sculpt_map(std::vector<U8>& data, U16 width, U16 height)
+	{
+		data.resize(width * height * 3);
+		for (U16 y = 0; y < height; ++y)
+		{
+			F32 phi = F_PI * y / (height - 1);
+			for (U16 x = 0; x < width; ++x)
+			{
+				F32 theta = F_TWO_PI * x / width;
+				F32 r = 0.85f + 0.15f * sinf(5.f * theta) * sinf(3.f * phi);
+				U8* rgb = &data[(x + y * width) * 3];
+				rgb[0] = (U8)(127.5f + 127.f * r * sinf(phi) * cosf(theta));
+				rgb[1] = (U8)(127.5f + 127.f * r * sinf(phi) * sinf(theta));
+				rgb[2] = (U8)(127.5f + 127.f * r * cosf(phi));
+			}
+		}
+	}
+
+	// The parameter sweep: prim shapes at the lowest and highest LOD, then every
+	// sculpt stitching type with and without mirror and invert.
+	void make_sweep(std::vector<LLVolumeParams>& params, std::vector<F32>& details)
+	{
+		static const struct
+		{
+			U8 mProfile;
+			U8 mPath;
+			F32 mHollow;
+			F32 mCutBegin;
+			F32 mCutEnd;
+			F32 mTwist;
+			F32 mTaper;
+		} shapes[] = {
+			{ LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE, 0.f, 0.f, 1.f, 0.f, 0.f },			// box
+			{ LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE, 0.5f, 0.125f, 0.75f, 0.3f, 0.2f },	// hollow cut box
+			{ LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_LINE, 0.f, 0.f, 1.f, 0.f, 0.f },			// cylinder
+			{ LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_LINE, 0.35f, 0.25f, 1.f, -0.5f, 0.f },	// hollow cut cylinder
+			{ LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PATH_LINE, 0.f, 0.f, 1.f, 0.2f, 0.4f },		// prism
+			{ LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE, 0.f, 0.f, 1.f, 0.f, 0.f },	// sphere
+			{ LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE, 0.2f, 0.f, 0.625f, 0.f, 0.f },	// hollow cut sphere
+			{ LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE, 0.f, 0.f, 1.f, 0.f, 0.f },		// torus
+			{ LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE, 0.45f, 0.f, 0.5f, 0.4f, 0.f },	// hollow cut torus
+			{ LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_CIRCLE, 0.25f, 0.f, 1.f, 0.1f, 0.f },		// tube
+			{ LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PATH_CIRCLE, 0.f, 0.3f, 1.f, 0.f, 0.f },		// ring
+		};
+		static const F32 shape_details[] = { 1.f, 4.f };
+
+		for (size_t d = 0; d < LL_ARRAY_SIZE(shape_details); ++d)
+		{
+			for (size_t s = 0; s < LL_ARRAY_SIZE(shapes); ++s)
+			{
+				LLVolumeParams shape;
+				shape.setType(shapes[s].mProfile, shapes[s].mPath);
+				shape.setHollow(shapes[s].mHollow);
+				shape.setBeginAndEndS(shapes[s].mCutBegin, shapes[s].mCutEnd);
+				shape.setTwistEnd(shapes[s].mTwist);
+				shape.setTaper(shapes[s].mTaper, 0.f);
+				params.push_back(shape);
+				details.push_back(shape_details[d]);
+			}
+		}
+
+		static const U8 flags[] = { 0, LL_SCULPT_FLAG_MIRROR, LL_SCULPT_FLAG_INVERT, LL_SCULPT_FLAG_MIRROR | LL_SCULPT_FLAG_INVERT };
+		for (U8 stitching = LL_SCULPT_TYPE_SPHERE; stitching <= LL_SCULPT_TYPE_CYLINDER; ++stitching)
+		{
+			for (size_t f = 0; f < LL_ARRAY_SIZE(flags); ++f)
+			{
+				LLVolumeParams sculpt;
+				sculpt.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+				sculpt.setSculptID(SCULPT_ID, stitching | flags[f]);
+				params.push_back(sculpt);
+				details.push_back(2.f);
+			}
+		}
+	}
+
+	// Checksums of the meshes make_sweep() describes, in the same order, as
+	// generated before the volume code was streamlined. When a change to the
+	// generated geometry is intended, the failure messages give the new values.
+	const struct
+	{
+		U32 mVertices;
+		F64 mSums[NUM_STREAMS];
+	} reference[] = {
+		// prim shapes at detail 1
+		{ 24, { 0.7934578477, 1.671874893, 34.33886681, 10.91113365, 35.56640625 } },
+		{ 52, { 7.114633467, -4.400156266, 72.35382203, 38.58529176, 49.78320312 } },
+		{ 30, { 2.706842973, 3.100624843, 45.30343059, 24.66327904, 44.83105469 } },
+		{ 56, { 0.9677909555, 9.26758044, 79.4765043, 2.89525547, 48.18945312 } },
+		{ 22, { 1.570046007, 1.551064672, 34.29059288, 17.95720154, 32.75585938 } },
+		{ 28, { 1.63562258, 2.541989674, 41.58789134, -18.76515005, 2.6171875 } },
+		{ 70, { 13.85053288, -20.56826845, 85.74916302, -6.943480054, 21.12011719 } },
+		{ 49, { -5.282292482, 4.670735616, 72.76074373, 6.691425695, 5.706054688 } },
+		{ 100, { 5.965271046, -3.59338493, 120.5387038, -5.211795342, 60.21191406 } },
+		{ 146, { 4.848825135, 19.12209555, 177.4598407, -13.76616995, 86.80175781 } },
+		{ 70, { 2.124905664, 15.48712878, 115.1872085, 30.11806062, 41.45800781 } },
+		// prim shapes at detail 4
+		{ 96, { -3.414222902, -3.250000995, 142.8235689, 46.62305095, 143.1904297 } },
+		{ 220, { 54.07409035, 0.9341194251, 300.8823709, 117.3904763, 158.8632812 } },
+		{ 152, { 3.404774287, 4.803574647, 229.9356262, 83.81158715, 227.4873047 } },
+		{ 412, { -29.03335107, 35.23093849, 576.9263883, -69.95644703, 162.6572266 } },
+		{ 70, { 2.187504223, 3.885111599, 106.766432, 38.44018942, 104.5195312 } },
+		{ 325, { 5.211687913, 19.32036096, 486.9738311, -283.0000779, 340.0830078 } },
+		{ 550, { 103.1483794, -61.59741395, 619.8872886, -358.0833416, 75.24609375 } },
+		{ 625, { -19.45012665, 40.23459438, 937.9366804, -2.727662268, 680.8320312 } },
+		{ 952, { 115.3558158, -4.412975985, 1076.935284, 14.7940688, 229.2939453 } },
+		{ 1144, { 10.51063404, 50.30259853, 1331.819361, -2.455888126, 482.7167969 } },
+		{ 400, { 36.81540977, 46.08450042, 668.3211031, 105.0426858, 376.8232422 } },
+		// sculpts: sphere, torus, plane and cylinder stitching, each plain, mirrored,
+		// inverted and both
+		{ 1105, { 10.96522588, -36.89246055, 1655.479904, 74.8139138, 1557.758789 } },
+		{ 1105, { -34.16328563, 67.84458775, 1656.414108, 81.7610701, -1557.758789 } },
+		{ 1105, { 10.53004276, 19.39306499, 1656.414108, 74.63969601, -1557.758789 } },
+		{ 1105, { -33.44773338, -100.6169713, 1655.479904, 77.8290047, 1557.758789 } },
+		{ 1105, { 31.82901434, -36.97110704, 1655.479904, 74.81388229, 1557.758789 } },
+		{ 1105, { -13.29949717, 64.71969901, 1656.414108, 81.76103531, -1557.758789 } },
+		{ 1105, { 31.39383121, 19.53651576, 1656.414108, 74.63964976, -1557.758789 } },
+		{ 1105, { -12.58394492, -97.41266587, 1655.479904, 77.82900294, 1557.758789 } },
+		{ 1105, { 5.542699829, -57.71901381, 1655.479904, 79.41282061, 1557.758789 } },
+		{ 1105, { -38.57483504, 39.9058619, 1656.414108, 76.28696643, -1557.758789 } },
+		{ 1105, { 4.963774293, 38.42284944, 1656.414108, 83.4163751, -1557.758789 } },
+		{ 1105, { -37.89404075, -72.46161298, 1655.479904, 67.81681806, 1557.758789 } },
+		{ 1105, { 10.96522588, -36.89246055, 1655.479904, 74.81390664, 1557.758789 } },
+		{ 1105, { -34.16328563, 67.84458775, 1656.414108, 81.76106129, -1557.758789 } },
+		{ 1105, { 10.53004276, 19.39306499, 1656.414108, 74.63968821, -1557.758789 } },
+		{ 1105, { -33.44773338, -100.6169713, 1655.479904, 77.82900237, 1557.758789 } },
+	};
+
+	// Relative to the sum of the weighted magnitudes; leaves room for compilers
+	// and instruction sets that round differently.
+	const F64 TOLERANCE = 1e-5;
+}
+
+namespace tut
+{
+	struct volume_test
+	{
+		volume_test()
+		{
+			make_sweep(mParams, mDetails);
+			make_sculpt_map(mSculptMap, SCULPT_WIDTH, SCULPT_HEIGHT);
+		}
+
+		enum { SCULPT_WIDTH = 32, SCULPT_HEIGHT = 128 };
+
+		std::vector<LLVolumeParams> mParams;
+		std::vector<F32> mDetails;
+		std::vector<U8> mSculptMap;
+	};
+	typedef test_group<volume_test> volume_t;
+	typedef volume_t::object volume_object_t;
+	tut::volume_t tut_volume("LLVolume");
+
+	template<> template<>
+	void volume_object_t::test<1>()
+	{
+		ensure_equals("sweep size", mParams.size(), LL_ARRAY_SIZE(reference));
+
+		static const char* stream_names[NUM_STREAMS] = { "positions", "normals", "tex coords", "tangents", "handedness" };
+		for (size_t v = 0; v < mParams.size(); ++v)
+		{
+			LLPointer<LLVolume> volume = new LLVolume(mParams[v], mDetails[v]);
+			if (mParams[v].isSculpt())
+			{
+				volume->sculpt(SCULPT_WIDTH, SCULPT_HEIGHT, 3, &mSculptMap[0], 0, false);
+			}
+
+			WeightedSum sums[NUM_STREAMS];
+			checksum_volume(volume, sums);
+
+			ensure_equals(llformat("volume %d vertices", (S32)v), sums[POSITIONS].mCount / 3, reference[v].mVertices);
+			for (S32 s = 0; s < NUM_STREAMS; ++s)
+			{
+				F64 error = fabs(sums[s].mSum - reference[v].mSums[s]);
+				ensure(llformat("volume %d %s: %.10g, expected %.10g", (S32)v, stream_names[s], sums[s].mSum, reference[v].mSums[s]),
+					   error <= TOLERANCE * sums[s].mScale);
+			}
+		}
+	}
+}
@@ -1325,7 +1325,7 @@ bool BufferedCurlEasyRequest::sShuttingDown = false;
 AIAverage BufferedCurlEasyRequest::sHTTPBandwidth(25);
 
 BufferedCurlEasyRequest::BufferedCurlEasyRequest() :
-	mRequestTransferedBytes(0), mTotalRawBytes(0), mStatus(HTTP_INTERNAL_ERROR_OTHER), mBufferEventsTarget(NULL), mCapabilityType(number_of_capability_types)
+	mRequestTransferedBytes(0), mTotalRawBytes(0), mTotalDecodedBytes(0), mStatus(HTTP_INTERNAL_ERROR_OTHER), mBufferEventsTarget(NULL), mCapabilityType(number_of_capability_types), mDecodeWhileReceiving(false)
 {
   AICurlInterface::Stats::BufferedCurlEasyRequest_count++;
 }
@@ -1412,6 +1412,7 @@ void BufferedCurlEasyRequest::resetState(void)
   mInput.reset();
   mRequestTransferedBytes = 0;
   mTotalRawBytes = 0;
+  mTotalDecodedBytes = 0;
   mBufferEventsTarget = NULL;
   mStatus = HTTP_INTERNAL_ERROR_OTHER;
 }
@@ -1487,6 +1488,7 @@ void BufferedCurlEasyRequest::prepRequest(AICurlEasyRequest_wat& curl_easy_reque
   // Cache capability type, because it will be needed even after the responder was removed.
   mCapabilityType = responder->capability_type();
   mIsEventPoll = responder->is_event_poll();
+  mDecodeWhileReceiving = responder->decodeWhileReceiving();
 
   // Send header events to responder if needed.
   if (mResponder->needsHeaders())
@@ -409,6 +409,21 @@ void AIPerService::removed_from_multi_handle(AICapabilityType capability_type, b
   }
 }
 
+void AIPerService::transfer_finished(size_t bytes_on_wire, size_t bytes_decoded, bool new_connection, F64 time_to_first_byte)
+{
+  mTransferStats.mBytesOnWire += bytes_on_wire;
+  mTransferStats.mBytesDecoded += bytes_decoded;
+  if (new_connection)
+  {
+	++mTransferStats.mNewConnections;
+  }
+  else
+  {
+	++mTransferStats.mReusedConnections;
+  }
+  mTransferStats.mTimeToFirstByte += time_to_first_byte;
+}
+
 // Returns true if the request was queued.
 bool AIPerService::queue(AICurlEasyRequest const& easy_request, AICapabilityType capability_type, bool force_queuing)
 {
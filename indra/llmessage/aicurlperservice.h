@@ -173,6 +173,19 @@ class AIPerService {
 	int mEventPolls;							// Number of active event poll handles with this service.
 	int mEstablishedConnections;				// Number of connected sockets to this service.
 
+	// Totals over all finished (non event poll) transfers that received data, for the HTTP debug console.
+	struct TransferStats {
+	  U64 mBytesOnWire;							// Body bytes as received, before decoding any Content-Encoding.
+	  U64 mBytesDecoded;						// Body bytes passed on to the responders.
+	  U32 mNewConnections;						// Transfers that had to connect first.
+	  U32 mReusedConnections;					// Transfers that reused an already open connection.
+	  F64 mTimeToFirstByte;						// Sum of the time between starting a transfer and receiving the first byte, in seconds.
+
+	  TransferStats(void) : mBytesOnWire(0), mBytesDecoded(0), mNewConnections(0), mReusedConnections(0), mTimeToFirstByte(0) { }
+	  U32 transfers(void) const { return mNewConnections + mReusedConnections; }
+	};
+	TransferStats mTransferStats;
+
 	U32 mUsedCT;								// Bit mask with one bit per capability type. A '1' means the capability was in use since the last resetUsedCT().
 	U32 mCTInUse;								// Bit mask with one bit per capability type. A '1' means the capability is in use right now.
 
@@ -274,6 +287,8 @@ class AIPerService {
 	void removed_from_multi_handle(AICapabilityType capability_type, bool event_poll,
 								   bool downloaded_something, bool success);			// Called when an easy handle for this service is removed again from the multi handle.
 	void download_started(AICapabilityType capability_type) { ++mCapabilityType[capability_type].mDownloading; }
+	void transfer_finished(size_t bytes_on_wire, size_t bytes_decoded, bool new_connection, F64 time_to_first_byte);	// Called for each finished transfer that received data.
+	TransferStats const& transfer_stats(void) const { return mTransferStats; }
 	bool throttled(AICapabilityType capability_type) const;		// Returns true if the maximum number of allowed requests for this service/capability type have been added to the multi handle.
 	bool nothing_added(AICapabilityType capability_type) const { return mCapabilityType[capability_type].mAdded == 0; }
 
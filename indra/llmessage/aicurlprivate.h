@@ -422,11 +422,13 @@ class BufferedCurlEasyRequest : public CurlEasyRequest {
 	LLHTTPClient::ResponderPtr mResponder;
 	AICapabilityType mCapabilityType;
 	bool mIsEventPoll;
+	bool mDecodeWhileReceiving;							// Cached responder->decodeWhileReceiving().
 	//U32 mBodyLimit;									// From the old LLURLRequestDetail::mBodyLimit, but never used.
 	U32 mStatus;										// HTTP status, decoded from the first header line.
 	std::string mReason;								// The "reason" from the same header line.
 	U32 mRequestTransferedBytes;
 	size_t mTotalRawBytes;								// Raw body data (still, possibly, compressed) received from the server so far.
+	size_t mTotalDecodedBytes;							// Body data written to mOutput so far (after decoding any Content-Encoding).
 	AIBufferedCurlEasyRequestEvents* mBufferEventsTarget;
 
   public:
@@ -476,6 +478,9 @@ class BufferedCurlEasyRequest : public CurlEasyRequest {
 	// Return true if any data was received.
 	bool received_data(void) const { return mTotalRawBytes > 0; }
 
+	// Pass the size, compression, connection reuse and latency of the finished transfer to the HTTP debug console.
+	void update_transfer_stats(AIPerService& per_service) const;
+
 #ifdef CWDEBUG
 	// Connection accounting for debug purposes.
 	void connection_established(int connectionnr);
@@ -1856,7 +1856,12 @@ CURLMcode MultiHandle::remove_easy_request(addedEasyRequests_type::iterator cons
 	capability_type = curl_easy_request_w->capability_type();
 	event_poll = curl_easy_request_w->is_event_poll();
 	per_service = curl_easy_request_w->getPerServicePtr();
-	PerService_wat(*per_service)->removed_from_multi_handle(capability_type, event_poll, downloaded_something, success);		// (About to be) removed from mAddedEasyRequests.
+	PerService_wat per_service_w(*per_service);
+	per_service_w->removed_from_multi_handle(capability_type, event_poll, downloaded_something, success);		// (About to be) removed from mAddedEasyRequests.
+	if (downloaded_something && !event_poll)
+	{
+	  curl_easy_request_w->update_transfer_stats(*per_service_w);
+	}
 #ifdef SHOW_ASSERT
 	curl_easy_request_w->mRemovedPerCommand = as_per_command;
 #endif
@@ -2182,7 +2187,16 @@ size_t BufferedCurlEasyRequest::curlWriteCallback(char* data, size_t size, size_
   S32 bytes = size * nmemb;		// The amount to write.
   // BufferedCurlEasyRequest::setBodyLimit is never called, so buffer_w->mBodyLimit is infinite.
   //S32 bytes = llmin(size * nmemb, buffer_w->mBodyLimit); buffer_w->mBodyLimit -= bytes;
-  self_w->getOutput()->append(sChannels.in(), (U8 const*)data, bytes);
+  if (self_w->mDecodeWhileReceiving && self_w->mResponder && LLHTTPClient::ResponderBase::isGoodStatus(self_w->mStatus))
+  {
+	// Parse LLSD here, so that the main thread doesn't have to do it all at once when the transfer finished.
+	self_w->mResponder->decode_llsd_body_part(data, bytes);
+  }
+  else
+  {
+	self_w->getOutput()->append(sChannels.in(), (U8 const*)data, bytes);
+  }
+  self_w->mTotalDecodedBytes += bytes;
   // Update HTTP bandwith.
   self_w->update_body_bandwidth();
   // Update timeout administration.
@@ -2219,6 +2233,15 @@ void BufferedCurlEasyRequest::update_body_bandwidth(void)
   }
 }
 
+void BufferedCurlEasyRequest::update_transfer_stats(AIPerService& per_service) const
+{
+  long new_connections;		// The number of connections libcurl had to create for this transfer; zero if one was reused.
+  double starttransfer_time;	// Seconds until the first byte of the response was received.
+  getinfo(CURLINFO_NUM_CONNECTS, &new_connections);
+  getinfo(CURLINFO_STARTTRANSFER_TIME, &starttransfer_time);
+  per_service.transfer_finished(mTotalRawBytes, mTotalDecodedBytes, new_connections > 0, starttransfer_time);
+}
+
 //static
 size_t BufferedCurlEasyRequest::curlReadCallback(char* data, size_t size, size_t nmemb, void* user_data)
 {
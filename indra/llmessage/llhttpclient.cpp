@@ -247,7 +247,9 @@ bool LLHTTPClient::getByteRange(std::string const& url, AIHTTPHeaders& headers,
 			char const* const range_format = (range_end >= HTTP_REQUESTS_RANGE_END_MAX) ? "bytes=%d-" : "bytes=%d-%d";
 			headers.addHeader("Range", llformat(range_format, offset, range_end));
 		}
-		request(url, HTTP_GET, NULL, responder, headers, NULL/*,*/ DEBUG_CURLIO_PARAM(debug));
+		// A Range applies to the content-coded (encoded) body, so don't accept a Content-Encoding
+		// or the offsets would no longer match the resource we are assembling.
+		request(url, HTTP_GET, NULL, responder, headers, NULL/*,*/ DEBUG_CURLIO_PARAM(debug), keep_alive, no_does_authentication, no_allow_compressed_reply);
 	}
 	catch(AICurlNoEasyHandle const&)
 	{
@@ -287,7 +289,7 @@ void LLHTTPClient::get(std::string const& url, LLSD const& query, ResponderPtr r
 // class LLHTTPClient::ResponderBase
 //
 
-LLHTTPClient::ResponderBase::ResponderBase(void) : mReferenceCount(0), mCode(CURLE_FAILED_INIT), mFinished(false)
+LLHTTPClient::ResponderBase::ResponderBase(void) : mReferenceCount(0), mCode(CURLE_FAILED_INIT), mFinished(false), mBodyParseError(false)
 {
 	DoutEntering(dc::curl, "AICurlInterface::Responder() with this = " << (void*)this);
 	AICurlInterface::Stats::ResponderBase_count++;
@@ -312,9 +314,25 @@ AIHTTPTimeoutPolicy const& LLHTTPClient::ResponderBase::getHTTPTimeoutPolicy(voi
 	return AIHTTPTimeoutPolicy::getDebugSettingsCurlTimeout();
 }
 
+// CURL-THREAD
+void LLHTTPClient::ResponderBase::decode_llsd_body_part(char const* data, size_t len)
+{
+	if (!mBodyParser)
+	{
+		mBodyParser = new LLSDXMLParser;
+	}
+	if (!mBodyParseError && !mBodyParser->parsePartial(data, len))
+	{
+		// Keep receiving the rest, so that the transfer itself doesn't fail.
+		mBodyParseError = true;
+	}
+}
+
 void LLHTTPClient::ResponderBase::decode_llsd_body(LLChannelDescriptors const& channels, buffer_ptr_t const& buffer)
 {
 	AICurlInterface::Stats::llsd_body_count++;
+	LLPointer<LLSDXMLParser> body_parser = mBodyParser;
+	mBodyParser = NULL;
 	if (is_internal_http_error(mStatus))
 	{
 		// In case of an internal error (ie, a curl error), a description of the (curl) error is the best we can do.
@@ -322,6 +340,17 @@ void LLHTTPClient::ResponderBase::decode_llsd_body(LLChannelDescriptors const& c
 	    mContent = mReason;
 		return;
 	}
+	if (body_parser)
+	{
+		// The body was already parsed by the curl thread, while it was received.
+		if (mBodyParseError || body_parser->finishParse(mContent) == LLSDParser::PARSE_FAILURE)
+		{
+			LL_WARNS() << "Failed to deserialize LLSD. " << mURL << " [" << mStatus << "]: " << mReason << LL_ENDL;
+			AICurlInterface::Stats::llsd_body_parse_error++;
+			mContent.clear();
+		}
+		return;
+	}
 	// If the status indicates success (and we get here) then we expect the body to be LLSD.
 	bool const should_be_llsd = isGoodStatus(mStatus);
 	if (should_be_llsd)
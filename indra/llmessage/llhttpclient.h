@@ -37,12 +37,14 @@
 
 #include "llassettype.h"
 #include "llhttpstatuscodes.h"
+#include "llpointer.h"
 #include "aihttpheaders.h"
 #include "aicurlperservice.h"
 
 class LLUUID;
 class LLPumpIO;
 class LLSD;
+class LLSDXMLParser;
 class AIHTTPTimeoutPolicy;
 class LLBufferArray;
 class LLChannelDescriptors;
@@ -159,6 +161,7 @@ public:
 		virtual ~ResponderBase();
 
 		// Read body from buffer and put it into mContent. If mStatus indicates success, interpret it as LLSD, otherwise copy it as-is.
+		// If the body was already parsed while it was received (see decodeWhileReceiving()) then this just picks up the result.
 		void decode_llsd_body(LLChannelDescriptors const& channels, buffer_ptr_t const& buffer);
 
 		// Read body from buffer and put it into content. Always copy it as-is.
@@ -186,6 +189,11 @@ public:
 		// Set when the transaction finished (with or without errors).
 		bool mFinished;
 
+	private:
+		// Parser of an LLSD body that is decoded while it is received; the body then never ends up in the buffer.
+		LLPointer<LLSDXMLParser> mBodyParser;
+		bool mBodyParseError;
+
 	public:
 		// Called to set the URL of the current request for this Responder,
 		// used only when printing debug output regarding activity of the Responder.
@@ -276,6 +284,14 @@ public:
 		// The default is to keep connections open for possible reuse.
 		virtual bool forbidReuse(void) const { return false; }
 
+		// A derived class should return true if the LLSD body of a reply with a good status should be parsed by the curl thread
+		// while it is being received, rather than all at once by decode_llsd_body. The buffer passed to finished() then doesn't
+		// contain the body.
+		virtual bool decodeWhileReceiving(void) const { return false; }
+
+		// Called by the curl thread for consecutive parts of the body when decodeWhileReceiving() returns true.
+		void decode_llsd_body_part(char const* data, size_t len);
+
 		// A derived class should return true if curl should not follow redirections, but instead pass redirection status codes to the responder.
 		// The default is to follow redirections and not pass them to the responder.
 		virtual bool pass_redirect_status(void) const { return false; }
@@ -400,6 +416,10 @@ public:
 	 * Classes derived from ResponderWithResult must implement result, and either errorWithContent or error.
 	 */
 	class ResponderWithResult : public ResponderBase {
+	public:
+		// Derived classes never see the raw body, so large LLSD replies can be parsed off the main thread.
+		/*virtual*/ bool decodeWhileReceiving(void) const { return true; }
+
 	protected:
 		// The responder finished. Do not override this function in derived classes; use ResponderWithCompleted instead.
 		/*virtual*/ void finished(CURLcode code, U32 http_status, std::string const& reason, LLChannelDescriptors const& channels, buffer_ptr_t const& buffer);
@@ -438,6 +458,8 @@ public:
 	 */
 	class ResponderIgnoreBody : public ResponderWithResult {
 		void httpSuccess(void) { }
+	public:
+		/*virtual*/ bool decodeWhileReceiving(void) const { return false; }
 	};
 
 	/**
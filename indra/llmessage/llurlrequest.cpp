@@ -209,6 +209,14 @@ void LLURLRequest::useProxy(const std::string &proxy)
 }
 #endif
 
+char const* LLURLRequest::accept_encoding(void) const
+{
+	// An empty string makes libcurl offer every encoding it was built with (gzip and deflate)
+	// and decode the response before it is written to the output buffer; NULL would not send
+	// an Accept-Encoding header at all, so that the server never compresses.
+	return mNoCompression ? "identity" : "";
+}
+
 bool LLURLRequest::configure(AICurlEasyRequest_wat const& curlEasyRequest_w)
 {
 	bool rv = false;
@@ -224,7 +232,7 @@ bool LLURLRequest::configure(AICurlEasyRequest_wat const& curlEasyRequest_w)
 			curlEasyRequest_w->setopt(CURLOPT_HTTPGET, 1);
 
 			// Set Accept-Encoding to allow response compression
-			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, mNoCompression ? "identity" : nullptr);
+			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, accept_encoding());
 			rv = true;
 			break;
 
@@ -234,7 +242,7 @@ bool LLURLRequest::configure(AICurlEasyRequest_wat const& curlEasyRequest_w)
 			curlEasyRequest_w->setPut(mBodySize, mKeepAlive);
 
 			// Set Accept-Encoding to allow response compression
-			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, mNoCompression ? "identity" : nullptr);
+			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, accept_encoding());
 			rv = true;
 			break;
 			
@@ -243,7 +251,7 @@ bool LLURLRequest::configure(AICurlEasyRequest_wat const& curlEasyRequest_w)
 
 			curlEasyRequest_w->setPatch(mBodySize, mKeepAlive);
 			
-			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, mNoCompression ? "identity" : nullptr);
+			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, accept_encoding());
 			rv = true;
 			break;
 			
@@ -253,7 +261,7 @@ bool LLURLRequest::configure(AICurlEasyRequest_wat const& curlEasyRequest_w)
 			curlEasyRequest_w->setPost(mBodySize, mKeepAlive);
 
 			// Set Accept-Encoding to allow response compression
-			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, mNoCompression ? "identity" : nullptr);
+			curlEasyRequest_w->setopt(CURLOPT_ACCEPT_ENCODING, accept_encoding());
 			rv = true;
 			break;
 
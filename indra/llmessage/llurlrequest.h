@@ -103,6 +103,9 @@ class LLURLRequest : public AICurlEasyRequestStateMachine {
 	 */
 	bool configure(AICurlEasyRequest_wat const& curlEasyRequest_w);
 
+	// The value for CURLOPT_ACCEPT_ENCODING.
+	char const* accept_encoding(void) const;
+
   private:
 	ERequestAction mAction;
 	std::string mURL;
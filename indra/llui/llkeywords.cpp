@@ -59,7 +59,12 @@ inline BOOL LLKeywordToken::isHead(const llwchar* s) const
 	return res;
 }
 
-LLKeywords::LLKeywords() : mLoaded(FALSE)
+LLKeywords::LLKeywords() :
+	mLoaded(FALSE),
+	mWordTrieDirty(true),
+	mLexedEnd(0),
+	mLexedValid(false),
+	mSegmentCount(0)
 {
 }
 
@@ -240,6 +245,8 @@ void LLKeywords::addToken(LLKeywordToken::TOKEN_TYPE type,
 	LLWString key = utf8str_to_wstring(key_in);
 	LLWString tool_tip = utf8str_to_wstring(tool_tip_in);
 	LLWString delimiter = utf8str_to_wstring(delimiter_in);
+	mWordTrieDirty = true;
+	mLexedValid = false;
 	switch(type)
 	{
 	case LLKeywordToken::WORD:
@@ -360,248 +367,453 @@ LLTrace::BlockTimerStatHandle FTM_SYNTAX_COLORING("Syntax Coloring");
 void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLWString& wtext, const LLColor4 &defaultColor)
 {
 	LL_RECORD_BLOCK_TIME(FTM_SYNTAX_COLORING);
-	seg_list->clear();
 
-	if( wtext.empty() )
+	if (mWordTrieDirty)
 	{
+		buildWordTrie();
+	}
+
+	mLexedText = wtext;
+	mLexedSpans.clear();
+	mLexedValid = true;
+
+	const llwchar* base = mLexedText.c_str();
+	S32 pos = 0;
+	while (lexLine(base, pos, mLexedSpans))
+	{
+	}
+	mLexedEnd = pos;
+
+	buildSegments(*seg_list, mLexedText.size(), defaultColor);
+}
+
+LLTrace::BlockTimerStatHandle FTM_SYNTAX_COLORING_INCREMENTAL("Syntax Coloring Incremental");
+
+void LLKeywords::updateSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLWString& wtext, const LLColor4 &defaultColor)
+{
+	if (!mLexedValid || mWordTrieDirty)
+	{
+		findSegments(seg_list, wtext, defaultColor);
 		return;
 	}
-	
-	S32 text_len = wtext.size();
 
-	seg_list->push_back( new LLTextSegment( LLColor3(defaultColor), 0, text_len ) ); 
+	LL_RECORD_BLOCK_TIME(FTM_SYNTAX_COLORING_INCREMENTAL);
 
-	const llwchar* base = wtext.c_str();
-	const llwchar* cur = base;
-	//const llwchar* line = NULL;
+	// Find the changed range: [prefix, new_len - suffix) replaced [prefix, old_len - suffix).
+	const S32 old_len = mLexedText.size();
+	const S32 new_len = wtext.size();
+	const llwchar* old_text = mLexedText.c_str();
+	const llwchar* new_text = wtext.c_str();
+	S32 prefix = 0;
+	const S32 min_len = llmin(old_len, new_len);
+	while (prefix < min_len && old_text[prefix] == new_text[prefix])
+	{
+		++prefix;
+	}
+	S32 suffix = 0;
+	while (suffix < min_len - prefix && old_text[old_len - 1 - suffix] == new_text[new_len - 1 - suffix])
+	{
+		++suffix;
+	}
+	const S32 delta = new_len - old_len;
+	const S32 damage_end = new_len - suffix;
 
-	while( *cur )
+	// Lexing is restarted at the start of the line containing the change, or earlier
+	// if that line start is in the middle of a span crossing lines (block comments, strings).
+	S32 restart = prefix;
+	while (true)
 	{
-		if( *cur == '\n' || cur == base )
+		while (restart > 0 && new_text[restart - 1] != '\n')
 		{
-			if( *cur == '\n' )
+			--restart;
+		}
+		// A span ending exactly here may be one left open by the end of the old text.
+		token_span_list_t::const_iterator crossing = firstSpanEndingAfter(restart - 1);
+		if (crossing == mLexedSpans.end() || crossing->mStart >= restart)
+		{
+			break;
+		}
+		restart = crossing->mStart;
+	}
+
+	const token_span_list_t& old_spans = mLexedSpans;
+	token_span_list_t spans(old_spans.begin(), firstSpanEndingAfter(restart - 1));
+	const size_t kept_spans = spans.size();
+	size_t relexed_spans_end = 0;
+
+	// Lex line by line until we are past the change, at a line start where the old
+	// lexing was in the same (fresh) state; from there on the old spans still apply.
+	S32 pos = restart;
+	S32 lexed_end = -1;
+	while (true)
+	{
+		if (pos >= damage_end)
+		{
+			const S32 old_pos = pos - delta;
+			if (old_pos <= mLexedEnd && (old_pos == 0 || old_text[old_pos - 1] == '\n'))
 			{
-				cur++;
-				if( !*cur || *cur == '\n' )
+				token_span_list_t::const_iterator old_span = firstSpanEndingAfter(old_pos - 1);
+				if (old_span == mLexedSpans.end() || old_span->mStart >= old_pos)
 				{
-					continue;
+					relexed_spans_end = spans.size();
+					for (; old_span != mLexedSpans.end(); ++old_span)
+					{
+						TokenSpan span = *old_span;
+						span.mStart += delta;
+						span.mEnd += delta;
+						spans.push_back(span);
+					}
+					lexed_end = mLexedEnd + delta;
+					break;
 				}
 			}
+		}
+		if (!lexLine(new_text, pos, spans))
+		{
+			relexed_spans_end = spans.size();
+			lexed_end = pos;
+			break;
+		}
+	}
 
-			// Start of a new line
-			//line = cur;
+	mLexedText = wtext;
+	mLexedSpans.swap(spans);
+	mLexedEnd = lexed_end;
 
-			// Skip white space
-			while( *cur && isspace(*cur) && (*cur != '\n')  )
-			{
-				cur++;
-			}
-			if( !*cur || *cur == '\n' )
-			{
-				continue;
-			}
+	// LLTextEditor may have cut segments up while removing text; start over then.
+	if (seg_list->size() != mSegmentCount || (!seg_list->empty() && seg_list->back()->getEnd() != old_len))
+	{
+		buildSegments(*seg_list, new_len, defaultColor);
+		return;
+	}
+	spliceSegments(*seg_list, kept_spans, relexed_spans_end, old_len, new_len, defaultColor);
+}
 
-			// cur is now at the first non-whitespace character of a new line	
+// Replaces the segments of the spans that were lexed again, [first_span, last_span) of
+// mLexedSpans, and of the default colored runs around them; the segments of the spans
+// before them are kept as is, those of the spans after them are moved along.
+void LLKeywords::spliceSegments(std::vector<LLTextSegmentPtr>& seg_list, size_t first_span, size_t last_span,
+								S32 old_len, S32 new_len, const LLColor4 &defaultColor)
+{
+	const S32 delta = new_len - old_len;
+	const S32 start = first_span ? mLexedSpans[first_span - 1].mEnd : 0;
+	const bool has_tail = last_span < mLexedSpans.size();
+	const S32 new_end = has_tail ? mLexedSpans[last_span].mStart : new_len;
+	const S32 old_end = has_tail ? new_end - delta : old_len;
+
+	// Segments are contiguous and sorted, and none of them crosses start or old_end.
+	struct StartsBefore
+	{
+		bool operator()(const LLTextSegmentPtr& segment, S32 pos) const { return segment->getStart() < pos; }
+	};
+	std::vector<LLTextSegmentPtr>::iterator first = std::lower_bound(seg_list.begin(), seg_list.end(), start, StartsBefore());
+	std::vector<LLTextSegmentPtr>::iterator last = std::lower_bound(first, seg_list.end(), old_end, StartsBefore());
+
+	if (delta)
+	{
+		for (std::vector<LLTextSegmentPtr>::iterator iter = last; iter != seg_list.end(); ++iter)
+		{
+			(*iter)->setStart((*iter)->getStart() + delta);
+			(*iter)->setEnd((*iter)->getEnd() + delta);
+		}
+	}
+
+	std::vector<LLTextSegmentPtr> replacement;
+	appendSegments(replacement, mLexedSpans.begin() + first_span, mLexedSpans.begin() + last_span, start, new_end, defaultColor);
+
+	// Overwrite in place where possible, so that typing within a line doesn't move the whole list.
+	const size_t replaced = last - first;
+	const size_t common = llmin(replaced, replacement.size());
+	std::copy(replacement.begin(), replacement.begin() + common, first);
+	if (replacement.size() > common)
+	{
+		seg_list.insert(first + common, replacement.begin() + common, replacement.end());
+	}
+	else
+	{
+		seg_list.erase(first + common, last);
+	}
+	mSegmentCount = seg_list.size();
+}
+
+LLKeywords::token_span_list_t::const_iterator LLKeywords::firstSpanEndingAfter(S32 pos) const
+{
+	// Spans don't overlap, so they are sorted by their end as well.
+	token_span_list_t::const_iterator low = mLexedSpans.begin();
+	token_span_list_t::const_iterator high = mLexedSpans.end();
+	while (low != high)
+	{
+		token_span_list_t::const_iterator mid = low + (high - low) / 2;
+		if (mid->mEnd > pos)
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+	return low;
+}
+
+void LLKeywords::buildSegments(std::vector<LLTextSegmentPtr>& seg_list, S32 text_len, const LLColor4 &defaultColor)
+{
+	seg_list.clear();
+	appendSegments(seg_list, mLexedSpans.begin(), mLexedSpans.end(), 0, text_len, defaultColor);
+	mSegmentCount = seg_list.size();
+}
+
+// Appends the segments covering [start, end): one per span, and default colored ones in between.
+void LLKeywords::appendSegments(std::vector<LLTextSegmentPtr>& seg_list, token_span_list_t::const_iterator first_span,
+								token_span_list_t::const_iterator last_span, S32 start, S32 end, const LLColor4 &defaultColor)
+{
+	S32 pos = start;
+	for (token_span_list_t::const_iterator iter = first_span; iter != last_span; ++iter)
+	{
+		llassert(iter->mEnd <= end);
+		if (iter->mStart > pos)
+		{
+			seg_list.push_back( new LLTextSegment( defaultColor, pos, iter->mStart ) );
+		}
+		LLTextSegmentPtr text_segment = new LLTextSegment( iter->mToken->getColor(), iter->mStart, iter->mEnd );
+		text_segment->setToken( iter->mToken );
+		seg_list.push_back( text_segment );
+		pos = iter->mEnd;
+	}
+	if (end > pos)
+	{
+		seg_list.push_back( new LLTextSegment( defaultColor, pos, end ) );
+	}
+}
+
+// Lexes the line starting at pos, which must be 0 or follow a newline that isn't inside
+// a span. Spans that start on this line may continue over the following lines.
+// Returns false when the end of the text was reached; otherwise pos is updated to the
+// start of the next line.
+bool LLKeywords::lexLine(const llwchar* base, S32& pos, token_span_list_t& spans)
+{
+	const llwchar* cur = base + pos;
+
+	// Skip white space
+	while( *cur && isspace(*cur) && (*cur != '\n')  )
+	{
+		cur++;
+	}
+
+	if( *cur && *cur != '\n' )
+	{
+		// cur is now at the first non-whitespace character of a new line	
 		
-			// Line start tokens
+		// Line start tokens
+		for (token_list_t::iterator iter = mLineTokenList.begin();
+			 iter != mLineTokenList.end(); ++iter)
+		{
+			LLKeywordToken* cur_token = *iter;
+			if( cur_token->isHead( cur ) )
 			{
-				BOOL line_done = FALSE;
-				for (token_list_t::iterator iter = mLineTokenList.begin();
-					 iter != mLineTokenList.end(); ++iter)
+				S32 seg_start = cur - base;
+				while( *cur && *cur != '\n' )
 				{
-					LLKeywordToken* cur_token = *iter;
-					if( cur_token->isHead( cur ) )
-					{
-						S32 seg_start = cur - base;
-						while( *cur && *cur != '\n' )
-						{
-							// skip the rest of the line
-							cur++;
-						}
-						S32 seg_end = cur - base;
-						
-						LLTextSegmentPtr text_segment = new LLTextSegment( cur_token->getColor(), seg_start, seg_end );
-						text_segment->setToken( cur_token );
-						insertSegment( *seg_list, text_segment, text_len, defaultColor);
-						line_done = TRUE; // to break out of second loop.
-						break;
-					}
-				}
-
-				if( line_done )
-				{
-					continue;
+					// skip the rest of the line
+					cur++;
 				}
+				TokenSpan span = { seg_start, (S32)(cur - base), cur_token };
+				spans.push_back(span);
+				break;
 			}
 		}
+	}
 
-		// Skip white space
-		while( *cur && isspace(*cur) && (*cur != '\n')  )
-		{
-			cur++;
-		}
-
-		while( *cur && *cur != '\n' )
+	while( *cur && *cur != '\n' )
+	{
+		// Check against delimiters
 		{
-			// Check against delimiters
+			S32 seg_start = 0;
+			LLKeywordToken* cur_delimiter = NULL;
+			for (token_list_t::iterator iter = mDelimiterTokenList.begin();
+				 iter != mDelimiterTokenList.end(); ++iter)
 			{
-				S32 seg_start = 0;
-				LLKeywordToken* cur_delimiter = NULL;
-				for (token_list_t::iterator iter = mDelimiterTokenList.begin();
-					 iter != mDelimiterTokenList.end(); ++iter)
+				LLKeywordToken* delimiter = *iter;
+				if( delimiter->isHead( cur ) )
 				{
-					LLKeywordToken* delimiter = *iter;
-					if( delimiter->isHead( cur ) )
-					{
-						cur_delimiter = delimiter;
-						break;
-					}
+					cur_delimiter = delimiter;
+					break;
 				}
+			}
 
-				if( cur_delimiter )
+			if( cur_delimiter )
+			{
+				S32 between_delimiters = 0;
+				S32 seg_end = 0;
+
+				seg_start = cur - base;
+				cur += cur_delimiter->getLengthHead();
+				
+				LLKeywordToken::TOKEN_TYPE type = cur_delimiter->getType();
+				if( type == LLKeywordToken::TWO_SIDED_DELIMITER || type == LLKeywordToken::DOUBLE_QUOTATION_MARKS )
 				{
-					S32 between_delimiters = 0;
-					S32 seg_end = 0;
-
-					seg_start = cur - base;
-					cur += cur_delimiter->getLengthHead();
-					
-					LLKeywordToken::TOKEN_TYPE type = cur_delimiter->getType();
-					if( type == LLKeywordToken::TWO_SIDED_DELIMITER || type == LLKeywordToken::DOUBLE_QUOTATION_MARKS )
+					while( *cur && !cur_delimiter->isTail(cur))
 					{
-						while( *cur && !cur_delimiter->isTail(cur))
+						// Check for an escape sequence.
+						if (type == LLKeywordToken::DOUBLE_QUOTATION_MARKS && *cur == '\\')
 						{
-							// Check for an escape sequence.
-							if (type == LLKeywordToken::DOUBLE_QUOTATION_MARKS && *cur == '\\')
+							// Count the number of backslashes.
+							S32 num_backslashes = 0;
+							while (*cur == '\\')
+							{
+								num_backslashes++;
+								between_delimiters++;
+								cur++;
+							}
+							// Is the next character the end delimiter?
+							if (cur_delimiter->isTail(cur))
 							{
-								// Count the number of backslashes.
-								S32 num_backslashes = 0;
-								while (*cur == '\\')
+								// Is there was an odd number of backslashes, then this delimiter
+								// does not end the sequence.
+								if (num_backslashes % 2 == 1)
 								{
-									num_backslashes++;
 									between_delimiters++;
 									cur++;
 								}
-								// Is the next character the end delimiter?
-								if (cur_delimiter->isTail(cur))
+								else
 								{
-									// Is there was an odd number of backslashes, then this delimiter
-									// does not end the sequence.
-									if (num_backslashes % 2 == 1)
-									{
-										between_delimiters++;
-										cur++;
-									}
-									else
-									{
-										// This is an end delimiter.
-										break;
-									}
+									// This is an end delimiter.
+									break;
 								}
 							}
-							else
-							{
-								between_delimiters++;
-								cur++;
-							}
-						}
-
-						if( *cur )
-						{
-							cur += cur_delimiter->getLengthHead();
-							seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead() + cur_delimiter->getLengthTail();
 						}
 						else
 						{
-							// eof
-							seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead();
+							between_delimiters++;
+							cur++;
 						}
 					}
+
+					if( *cur )
+					{
+						cur += cur_delimiter->getLengthHead();
+						seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead() + cur_delimiter->getLengthTail();
+					}
 					else
 					{
-						llassert( cur_delimiter->getType() == LLKeywordToken::ONE_SIDED_DELIMITER );
-						// Left side is the delimiter.  Right side is eol or eof.
-						while( *cur && ('\n' != *cur) )
-						{
-							between_delimiters++;
-							cur++;
-						}
+						// eof
 						seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead();
 					}
-
-
-					LLTextSegmentPtr text_segment = new LLTextSegment( cur_delimiter->getColor(), seg_start, seg_end );
-					text_segment->setToken( cur_delimiter );
-					insertSegment( *seg_list, text_segment, text_len, defaultColor);
-
-					// Note: we don't increment cur, since the end of one delimited seg may be immediately
-					// followed by the start of another one.
-					continue;
-				}
-			}
-
-			// check against words
-			llwchar prev = cur > base ? *(cur-1) : 0;
-			if( !isalnum( prev ) && (prev != '_') && (prev != '#'))
-			{
-				const llwchar* p = cur;
-				while( isalnum( *p ) || (*p == '_') || (*p == '#') )
-				{
-					p++;
 				}
-				S32 seg_len = p - cur;
-				if( seg_len > 0 )
+				else
 				{
-					WStringMapIndex word( cur, seg_len );
-					word_token_map_t::iterator map_iter = mWordTokenMap.find(word);
-					if( map_iter != mWordTokenMap.end() )
+					llassert( cur_delimiter->getType() == LLKeywordToken::ONE_SIDED_DELIMITER );
+					// Left side is the delimiter.  Right side is eol or eof.
+					while( *cur && ('\n' != *cur) )
 					{
-						LLKeywordToken* cur_token = map_iter->second;
-						S32 seg_start = cur - base;
-						S32 seg_end = seg_start + seg_len;
-
-						// LL_INFOS() << "Seg: [" << word.c_str() << "]" << LL_ENDL;
-
-
-						LLTextSegmentPtr text_segment = new LLTextSegment( cur_token->getColor(), seg_start, seg_end );
-						text_segment->setToken( cur_token );
-						insertSegment( *seg_list, text_segment, text_len, defaultColor);
+						between_delimiters++;
+						cur++;
 					}
-					cur += seg_len; 
-					continue;
+					seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead();
 				}
+
+				TokenSpan span = { seg_start, seg_end, cur_delimiter };
+				spans.push_back(span);
+
+				// Note: we don't increment cur, since the end of one delimited seg may be immediately
+				// followed by the start of another one.
+				continue;
 			}
+		}
 
-			if( *cur && *cur != '\n' )
+		// check against words
+		llwchar prev = cur > base ? *(cur-1) : 0;
+		if( !isalnum( prev ) && (prev != '_') && (prev != '#'))
+		{
+			const llwchar* p = cur;
+			while( isalnum( *p ) || (*p == '_') || (*p == '#') )
+			{
+				p++;
+			}
+			S32 seg_len = p - cur;
+			if( seg_len > 0 )
 			{
-				cur++;
+				LLKeywordToken* cur_token = findWord( cur, seg_len );
+				if( cur_token )
+				{
+					S32 seg_start = cur - base;
+					TokenSpan span = { seg_start, seg_start + seg_len, cur_token };
+					spans.push_back(span);
+				}
+				cur += seg_len; 
+				continue;
 			}
 		}
+
+		if( *cur && *cur != '\n' )
+		{
+			cur++;
+		}
 	}
+
+	pos = cur - base;
+	if( !*cur )
+	{
+		return false;
+	}
+	// Skip the newline
+	pos++;
+	return true;
 }
 
-void LLKeywords::insertSegment(std::vector<LLTextSegmentPtr>& seg_list, LLTextSegmentPtr new_segment, S32 text_len, const LLColor4 &defaultColor )
+void LLKeywords::buildWordTrie()
 {
-	LLTextSegmentPtr last = seg_list.back();
-	S32 new_seg_end = new_segment->getEnd();
-	llassert(new_seg_end <= text_len);
+	mWordTrie.clear();
+	WordTrieNode root = { 0, -1, -1, NULL };
+	mWordTrie.push_back(root);
 
-	if( new_segment->getStart() == last->getStart() )
-	{
-		seg_list.pop_back();
-	}
-	else
+	for (word_token_map_t::const_iterator iter = mWordTokenMap.begin(); iter != mWordTokenMap.end(); ++iter)
 	{
-		last->setEnd( new_segment->getStart() );
+		const LLWString& word = iter->second->getToken();
+		S32 node = 0;
+		for (LLWString::const_iterator c = word.begin(); c != word.end(); ++c)
+		{
+			// Children are kept sorted by character.
+			S32* link = &mWordTrie[node].mFirstChild;
+			while (*link >= 0 && mWordTrie[*link].mChar < *c)
+			{
+				link = &mWordTrie[*link].mNextSibling;
+			}
+			if (*link >= 0 && mWordTrie[*link].mChar == *c)
+			{
+				node = *link;
+				continue;
+			}
+			WordTrieNode child = { *c, -1, *link, NULL };
+			node = mWordTrie.size();
+			*link = node;	// Must happen before push_back() invalidates link.
+			mWordTrie.push_back(child);
+		}
+		mWordTrie[node].mToken = iter->second;
 	}
-	seg_list.push_back( new_segment );
 
-	if( new_seg_end < text_len )
+	mWordTrieDirty = false;
+}
+
+LLKeywordToken* LLKeywords::findWord(const llwchar* word, S32 length) const
+{
+	S32 node = 0;
+	for (S32 i = 0; i < length; ++i)
 	{
-		seg_list.push_back( new LLTextSegment( defaultColor, new_seg_end, text_len ) );
+		node = mWordTrie[node].mFirstChild;
+		while (node >= 0 && mWordTrie[node].mChar < word[i])
+		{
+			node = mWordTrie[node].mNextSibling;
+		}
+		if (node < 0 || mWordTrie[node].mChar != word[i])
+		{
+			return NULL;
+		}
 	}
+	return mWordTrie[node].mToken;
 }
 
+
 #ifdef _DEBUG
 void LLKeywords::dump()
 {
@@ -39,6 +39,7 @@
 #include <map>
 #include <list>
 #include <deque>
+#include <vector>
 #include "llpointer.h"
 
 class LLTextSegment;
@@ -108,6 +109,9 @@ public:
 	BOOL		isLoaded() const	{ return mLoaded; }
 
 	void		findSegments(std::vector<LLTextSegmentPtr> *seg_list, const LLWString& text, const LLColor4 &defaultColor );
+	// Same result as findSegments(), but only re-lexes the lines that changed since
+	// the last call to either function; use when text is an edit of the previous text.
+	void		updateSegments(std::vector<LLTextSegmentPtr> *seg_list, const LLWString& text, const LLColor4 &defaultColor );
 
 	// Add the token as described
 	void addToken(LLKeywordToken::TOKEN_TYPE type,
@@ -151,14 +155,51 @@ public:
 #endif
 
 private:
+	// A highlighted run of text; everything in between uses the default color.
+	struct TokenSpan
+	{
+		S32 mStart;
+		S32 mEnd;
+		LLKeywordToken* mToken;
+	};
+	typedef std::vector<TokenSpan> token_span_list_t;
+
+	// Words are looked up in a trie built from mWordTokenMap, to avoid comparing
+	// whole strings for every identifier in the text.
+	struct WordTrieNode
+	{
+		llwchar mChar;
+		S32 mFirstChild;
+		S32 mNextSibling;
+		LLKeywordToken* mToken;
+	};
+
 	LLColor3	readColor(const std::string& s);
-	void		insertSegment(std::vector<LLTextSegmentPtr>& seg_list, LLTextSegmentPtr new_segment, S32 text_len, const LLColor4 &defaultColor);
+	void		appendSegments(std::vector<LLTextSegmentPtr>& seg_list, token_span_list_t::const_iterator first_span,
+							   token_span_list_t::const_iterator last_span, S32 start, S32 end, const LLColor4 &defaultColor);
+	void		buildSegments(std::vector<LLTextSegmentPtr>& seg_list, S32 text_len, const LLColor4 &defaultColor);
+	void		spliceSegments(std::vector<LLTextSegmentPtr>& seg_list, size_t first_span, size_t last_span,
+							   S32 old_len, S32 new_len, const LLColor4 &defaultColor);
+	bool		lexLine(const llwchar* base, S32& pos, token_span_list_t& spans);
+	token_span_list_t::const_iterator firstSpanEndingAfter(S32 pos) const;
+	void		buildWordTrie();
+	LLKeywordToken* findWord(const llwchar* word, S32 length) const;
 
 	BOOL		mLoaded;
 	word_token_map_t mWordTokenMap;
 	typedef std::deque<LLKeywordToken*> token_list_t;
 	token_list_t mLineTokenList;
 	token_list_t mDelimiterTokenList;
+
+	std::vector<WordTrieNode> mWordTrie;	// Node 0 is the root.
+	bool		mWordTrieDirty;
+
+	// Result of the last lexing pass, used by updateSegments().
+	LLWString	mLexedText;
+	token_span_list_t mLexedSpans;
+	S32			mLexedEnd;					// Where lexing stopped; only before the end of mLexedText if it contains a NUL.
+	bool		mLexedValid;
+	size_t		mSegmentCount;				// Size of the segment list built from mLexedSpans.
 };
 
 #endif  // LL_LLKEYWORDS_H
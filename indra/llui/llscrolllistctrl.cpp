@@ -45,6 +45,7 @@
 #include "llscrolllistcell.h"
 #include "llscrolllistcolumn.h"
 #include "llscrolllistitem.h"
+#include "llscrolllistrowmodel.h"
 #include "llstring.h"
 #include "llui.h"
 #include "lluictrlfactory.h"
@@ -135,6 +136,9 @@ LLScrollListCtrl::LLScrollListCtrl(const std::string& name, const LLRect& rect,
 	mHighlightedItem(-1),
 	mBorder(NULL),
 	mSortCallback(NULL),
+	mRowModel(NULL),
+	mMaterializedRows(0),
+	mDrawStamp(0),
 	mPopupMenu(NULL),
 	mCommentTextView(NULL),
 	mNumDynamicWidthColumns(0),
@@ -528,7 +532,7 @@ BOOL LLScrollListCtrl::addItem( LLScrollListItem* item, EAddPosition pos, BOOL r
 				if (mSortColumns.empty() || mSortColumns[0].first != 0)
 				{
 					// sort by column 0, in ascending order
-					std::stable_sort(mItemList.begin(), mItemList.end(), SortScrollListItem({ {0,true} }, mSortCallback));
+					sortItems({ {0,true} });
 				}
 
 				// ADD_SORTED just sorts by first column...
@@ -1207,7 +1211,8 @@ LLScrollListItem* LLScrollListCtrl::getItemByLabel(const std::string& label, BOO
 	{
 		LLScrollListItem* item = *iter;
 
-		std::string item_text = item->getColumn(column)->getValue().asString();	// Only select enabled items with matching names
+		std::string item_text;	// Only select enabled items with matching names
+		if (!getItemText(item, column, item_text)) continue;
 		if (!case_sensitive)
 		{
 			LLStringUtil::toLower(item_text);
@@ -1245,8 +1250,8 @@ BOOL LLScrollListCtrl::selectItemByPrefix(const LLWString& target, BOOL case_sen
 			if (item->getFiltered()) continue;
 
 			// Only select enabled items with matching names
-			LLScrollListCell* cellp = item->getColumn(getSearchColumn());
-			BOOL select = cellp ? item->getEnabled() && ('\0' == cellp->getValue().asString()[0]) : FALSE;
+			std::string item_text;
+			BOOL select = getItemText(item, getSearchColumn(), item_text) ? item->getEnabled() && item_text.empty() : FALSE;
 			if (select)
 			{
 				selectItem(item);
@@ -1271,12 +1276,12 @@ BOOL LLScrollListCtrl::selectItemByPrefix(const LLWString& target, BOOL case_sen
 			if (item->getFiltered()) continue;
 
 			// Only select enabled items with matching names
-			LLScrollListCell* cellp = item->getColumn(getSearchColumn());
-			if (!cellp)
+			std::string item_text;
+			if (!getItemText(item, getSearchColumn(), item_text))
 			{
 				continue;
 			}
-			LLWString item_label = utf8str_to_wstring(cellp->getValue().asString());
+			LLWString item_label = utf8str_to_wstring(item_text);
 			if (!case_sensitive)
 			{
 				LLWStringUtil::toLower(item_label);
@@ -1291,7 +1296,11 @@ BOOL LLScrollListCtrl::selectItemByPrefix(const LLWString& target, BOOL case_sen
 			{
 				// find offset of matching text (might have leading whitespace)
 				S32 offset = item_label.find(target_trimmed);
-				cellp->highlightText(offset, target_trimmed.size());
+				materializeItem(item);
+				if (LLScrollListCell* cellp = item->getColumn(getSearchColumn()))
+				{
+					cellp->highlightText(offset, target_trimmed.size());
+				}
 				selectItem(item);
 				found = TRUE;
 				break;
@@ -1312,9 +1321,10 @@ const std::string LLScrollListCtrl::getSelectedItemLabel(S32 column) const
 	LLScrollListItem* item;
 
 	item = getFirstSelected();
-	if (item)
+	std::string label;
+	if (item && getItemText(item, column, label))
 	{
-		return item->getColumn(column)->getValue().asString();
+		return label;
 	}
 
 	return LLStringUtil::null;
@@ -1427,6 +1437,8 @@ void LLScrollListCtrl::drawItems()
 	LLRect item_rect;
 
 	LLGLSUIDefault gls_ui;
+
+	++mDrawStamp;
 	
 	{
 		LLLocalClipRect clip(mItemListRect);
@@ -1494,6 +1506,10 @@ void LLScrollListCtrl::drawItems()
 						continue;
 					}
 
+					// Virtual rows only get cells once they are on screen
+					materializeItem(item);
+					item->mDrawStamp = mDrawStamp;
+
 					fg_color = (item->getEnabled() ? mFgUnselectedColor : mFgDisabledColor);
 					if (item->getSelected() && mCanSelect)
 					{
@@ -1528,6 +1544,28 @@ void LLScrollListCtrl::drawItems()
 		}
 
 	}
+
+	releaseVirtualCells();
+}
+
+void LLScrollListCtrl::releaseVirtualCells()
+{
+	// Keep a few pages worth of cells around so small scrolls stay cheap
+	if (mMaterializedRows <= llmax(4 * getLinesPerPage(), 64)) return;
+
+	mMaterializedRows = 0;
+	for (LLScrollListItem* item : mItemList)
+	{
+		if (!item->mVirtual || !item->getNumColumns()) continue;
+		if (item->mDrawStamp != mDrawStamp)
+		{
+			item->setNumColumns(0);
+		}
+		else
+		{
+			++mMaterializedRows;
+		}
+	}
 }
 
 
@@ -1920,6 +1958,7 @@ LLScrollListItem* LLScrollListCtrl::hitItem( S32 x, S32 y )
 		{
 			if (item->getEnabled() && item_rect.pointInRect( x, y ))
 			{
+				materializeItem(item);
 				hit_item = item;
 				break;
 			}
@@ -1986,6 +2025,22 @@ S32 LLScrollListCtrl::getRowOffsetFromIndex(S32 index)
 
 bool LLScrollListCtrl::filterItem(LLScrollListItem* item)
 {
+	if (item->mVirtual && mRowModel)
+	{
+		// Match on the model's keys, so rows need no cells to be filtered
+		std::string text;
+		for (S32 column = 0, count = getNumColumns(); column < count; ++column)
+		{
+			if (getItemText(item, column, text) && boost::icontains(text, mFilter))
+			{
+				item->setFiltered(false);
+				return false;
+			}
+		}
+		item->setFiltered(true);
+		return true;
+	}
+
 	for (const auto& column : item->mColumns)
 	{
 		// Only filter text, search tooltip because it'll usually be the text anyway.
@@ -2272,16 +2327,20 @@ BOOL LLScrollListCtrl::handleUnicodeCharHere(llwchar uni_char)
 			LLScrollListItem* item = *iter;
 			if (!item->getFiltered())
 			{
-				LLScrollListCell* cellp = item->getColumn(getSearchColumn());
-				if (cellp)
+				std::string item_text;
+				if (getItemText(item, getSearchColumn(), item_text))
 				{
 					// Only select enabled items with matching first characters
-					LLWString item_label = utf8str_to_wstring(cellp->getValue().asString());
-					if (item->getEnabled() && LLStringOps::toLower(item_label[0]) == uni_char)
+					LLWString item_label = utf8str_to_wstring(item_text);
+					if (item->getEnabled() && !item_label.empty() && LLStringOps::toLower(item_label[0]) == uni_char)
 					{
 						selectItem(item);
 						mNeedsScroll = true;
-						cellp->highlightText(0, 1);
+						materializeItem(item);
+						if (LLScrollListCell* cellp = item->getColumn(getSearchColumn()))
+						{
+							cellp->highlightText(0, 1);
+						}
 						mSearchTimer.reset();
 
 						if (mCommitOnKeyboardMovement
@@ -2483,11 +2542,7 @@ void LLScrollListCtrl::updateSort() const
 {
 	if (hasSortOrder() && !isSorted())
 	{
-		// do stable sort to preserve any previous sorts
-		std::stable_sort(
-			mItemList.begin(), 
-			mItemList.end(), 
-			SortScrollListItem(mSortColumns,mSortCallback));
+		sortItems(mSortColumns);
 
 		mSorted = true;
 	}
@@ -2499,11 +2554,68 @@ void LLScrollListCtrl::sortOnce(S32 column, BOOL ascending)
 	std::vector<sort_column_t > sort_column;
 	sort_column.push_back(std::make_pair(column, ascending));
 
-	// do stable sort to preserve any previous sorts
-	std::stable_sort(
-		mItemList.begin(), 
-		mItemList.end(), 
-		SortScrollListItem(sort_column,mSortCallback));
+	sortItems(sort_column);
+}
+
+// do stable sort to preserve any previous sorts
+void LLScrollListCtrl::sortItems(const sort_order_t& sort_orders) const
+{
+	if (mSortCallback && mRowModel)
+	{
+		// Virtual rows have no cells for a custom comparison to look at
+		LL_WARNS_ONCE() << "Scroll list " << getName() << " has a row model; ignoring its sort callback" << LL_ENDL;
+	}
+	else if (mSortCallback)
+	{
+		// Custom comparisons want the items themselves
+		std::stable_sort(mItemList.begin(), mItemList.end(), SortScrollListItem(sort_orders, mSortCallback));
+		return;
+	}
+
+	const size_t num_keys = sort_orders.size();
+	const size_t count = mItemList.size();
+	if (count < 2 || !num_keys) return;
+
+	// Read every row's text once instead of twice per comparison, and sort
+	// the rows' indices on it.
+	std::vector<std::string> keys(count * num_keys);
+	std::vector<bool> has_key(count * num_keys);
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (size_t k = 0; k < num_keys; ++k)
+		{
+			has_key[i * num_keys + k] = getItemText(mItemList[i], sort_orders[k].first, keys[i * num_keys + k]);
+		}
+	}
+
+	std::vector<U32> order(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		order[i] = (U32)i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](U32 a, U32 b)
+	{
+		// same precedence as SortScrollListItem: last sort column first
+		for (size_t k = num_keys; k-- > 0; )
+		{
+			const size_t key_a = a * num_keys + k, key_b = b * num_keys + k;
+			if (!has_key[key_a] || !has_key[key_b]) continue;
+
+			S32 result = LLStringUtil::compareDict(keys[key_a], keys[key_b]);
+			if (result != 0)
+			{
+				return sort_orders[k].second ? result < 0 : result > 0;
+			}
+		}
+		return false;
+	});
+
+	item_list sorted;
+	for (U32 index : order)
+	{
+		sorted.push_back(mItemList[index]);
+	}
+	mItemList.swap(sorted);
 }
 
 void LLScrollListCtrl::dirtyColumns() 
@@ -2883,6 +2995,18 @@ void	LLScrollListCtrl::copy() const
 	std::string buffer;
 	for (auto item : getAllSelected())
 	{
+		if (item->mVirtual && mRowModel)
+		{
+			std::string text;
+			for (S32 column = 0, count = getNumColumns(); column < count; ++column)
+			{
+				getItemText(item, column, text);
+				if (column) buffer += ',';
+				buffer += text;
+			}
+			buffer += '\n';
+			continue;
+		}
 		buffer += item->getContentsCSV() + '\n';
 	}
 	gClipboard.copyFromSubstring(utf8str_to_wstring(buffer), 0, buffer.length());
@@ -3186,6 +3310,13 @@ LLScrollListItem* LLScrollListCtrl::addRow(LLScrollListItem *new_item, const LLS
 {
 	LL_RECORD_BLOCK_TIME(FTM_ADD_SCROLLLIST_ELEMENT);
 	if (!item_p.validateBlock() || !new_item) return NULL;
+	setRowCells(new_item, item_p);
+	addItem(new_item, pos);
+	return new_item;
+}
+
+void LLScrollListCtrl::setRowCells(LLScrollListItem* new_item, const LLScrollListItem::Params& item_p)
+{
 	new_item->setNumColumns(mColumns.size());
 
 	// Add any columns we don't already have
@@ -3286,9 +3417,167 @@ LLScrollListItem* LLScrollListCtrl::addRow(LLScrollListItem *new_item, const LLS
 			new_item->setColumn(column_idx, new LLScrollListSpacer(cell_p));
 		}
 	}
+}
 
-	addItem(new_item, pos);
-	return new_item;
+void LLScrollListCtrl::addVirtualRows(const std::vector<LLSD>& values, EAddPosition pos)
+{
+	if (!mRowModel || values.empty()) return;
+
+	const size_t room = getItemCount() < mMaxItemCount ? mMaxItemCount - getItemCount() : 0;
+	const size_t count = llmin(values.size(), room);
+	if (!count) return;
+
+	std::vector<LLScrollListItem*> new_items;
+	new_items.reserve(count);
+	S32 unfiltered = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		LLScrollListItem::Params item_p;
+		item_p.value = values[i];
+		LLScrollListItem* item = new LLScrollListItem(item_p);
+		item->mVirtual = true;
+		if (mFilter.empty() || !filterItem(item))
+		{
+			++unfiltered;
+		}
+		new_items.push_back(item);
+	}
+
+	if (pos == ADD_TOP)
+	{
+		mItemList.insert(mItemList.begin(), new_items.begin(), new_items.end());
+	}
+	else
+	{
+		mItemList.insert(mItemList.end(), new_items.begin(), new_items.end());
+	}
+	setNeedsSort();
+
+	// Sorting happens on the model's keys, so only the first row needs cells
+	// to measure the line height
+	if (mLineHeight == 0)
+	{
+		materializeItem(new_items.front());
+	}
+
+	if (!mFilter.empty())
+	{
+		mScrollbar->setDocSize(mScrollbar->getDocSize() + unfiltered);
+	}
+	updateLayout();
+}
+
+void LLScrollListCtrl::materializeItem(LLScrollListItem* item)
+{
+	if (!item->mVirtual || !mRowModel || item->getNumColumns()) return;
+
+	LLScrollListItem::Params item_p;
+	mRowModel->buildRow(item->getValue(), item_p);
+	setRowCells(item, item_p);
+	updateLineHeightInsert(item);
+	++mMaterializedRows;
+}
+
+void LLScrollListCtrl::dirtyVirtualRow(LLScrollListItem* item)
+{
+	if (!item || !item->mVirtual) return;
+
+	// Cells get rebuilt from the model next time the row is drawn
+	if (item->getNumColumns())
+	{
+		item->setNumColumns(0);
+		--mMaterializedRows;
+	}
+	if (!mFilter.empty())
+	{
+		const bool was_filtered = item->getFiltered();
+		if (filterItem(item) != was_filtered)
+		{
+			mScrollbar->setDocSize(mScrollbar->getDocSize() + (was_filtered ? 1 : -1));
+		}
+	}
+	setNeedsSort();
+}
+
+bool LLScrollListCtrl::getItemText(const LLScrollListItem* item, S32 column, std::string& text) const
+{
+	if (item->mVirtual && mRowModel)
+	{
+		if (column < 0 || column >= (S32)mColumnsIndexed.size()) return false;
+		text = mRowModel->getKey(item->getValue(), mColumnsIndexed[column]->mName);
+		return true;
+	}
+
+	const LLScrollListCell* cell = item->getColumn(column);
+	if (!cell) return false;
+	text = cell->getValue().asString();
+	return true;
+}
+
+bool LLScrollListCtrl::updateRow(LLScrollListItem* item, const LLScrollListItem::Params& item_p)
+{
+	if (!item || !item_p.validateBlock()) return false;
+
+	bool changed = false;
+	S32 col_index = 0;
+	for (LLInitParam::ParamIterator<LLScrollListCell::Params>::const_iterator itor = item_p.columns.begin();
+		itor != item_p.columns.end();
+		++itor, ++col_index)
+	{
+		const LLScrollListCell::Params& cell_p = *itor;
+		std::string column = cell_p.column;
+		if (column.empty())
+		{
+			column = fmt::to_string(col_index);
+		}
+
+		LLScrollListColumn* columnp = getColumn(column);
+		if (!columnp) continue;
+
+		S32 index = columnp->mIndex;
+		LLScrollListCell* cell = item->getColumn(index);
+		if (cell && cell->getValue().asString() == cell_p.value().asString())
+		{
+			// Same content: only the cheap presentation attributes may have changed
+			if (cell_p.color.isProvided())
+			{
+				cell->setColor(cell_p.color);
+			}
+			cell->setToolTip(cell_p.tool_tip);
+			if (cell->isText())
+			{
+				static_cast<LLScrollListText*>(cell)->setFontStyle(LLFontGL::getStyleFromString(cell_p.font_style));
+			}
+			continue;
+		}
+
+		LLScrollListCell::Params new_cell_p = cell_p;
+		if (!new_cell_p.width.isProvided())
+		{
+			new_cell_p.width = columnp->getWidth();
+		}
+		new_cell_p.font_halign = columnp->mFontAlignment;
+		if (LLScrollListCell* new_cell = LLScrollListCell::create(new_cell_p))
+		{
+			item->setColumn(index, new_cell);
+		}
+		changed = true;
+
+		for (const auto& sort_column : mSortColumns)
+		{
+			if (sort_column.first == index)
+			{
+				setNeedsSort();
+				break;
+			}
+		}
+	}
+
+	if (changed)
+	{
+		dirtyColumns();
+	}
+	return changed;
 }
 
 LLScrollListItem* LLScrollListCtrl::addSimpleElement(const std::string& value, EAddPosition pos, const LLSD& id)
@@ -46,6 +46,7 @@
 #include "llscrolllistcolumn.h"
 
 class LLMenuGL;
+class LLScrollListRowModel;
 
 class LLScrollListCtrl : public LLUICtrl, public LLEditMenuHandler, 
 	public LLCtrlListInterface, public LLCtrlScrollInterface
@@ -112,6 +113,21 @@ public:
 	virtual LLScrollListItem* addElement(const LLSD& element, EAddPosition pos = ADD_BOTTOM, void* userdata = NULL);
 	virtual LLScrollListItem* addRow(LLScrollListItem *new_item, const LLScrollListItem::Params& value, EAddPosition pos = ADD_BOTTOM);
 	virtual LLScrollListItem* addRow(const LLScrollListItem::Params& value, EAddPosition pos = ADD_BOTTOM);
+	// Applies value to an existing row: cells whose value differs are replaced, the others get
+	// their color, tool tip and font style refreshed in place. Columns must already exist.
+	// Returns true if any cell value changed.
+	bool updateRow(LLScrollListItem* item, const LLScrollListItem::Params& value);
+
+	// Virtualized mode, for lists of many thousands of rows: rows added through addVirtualRows()
+	// only keep their value. Their cells are built by the row model when they scroll into view
+	// and dropped again once they are out of it, sorting and filtering read the model's keys;
+	// a sort callback is not used in this mode.
+	// The model is not owned and must outlive the list or be reset.
+	void			setRowModel(const LLScrollListRowModel* model) { mRowModel = model; }
+	const LLScrollListRowModel* getRowModel() const { return mRowModel; }
+	void			addVirtualRows(const std::vector<LLSD>& values, EAddPosition pos = ADD_BOTTOM);
+	// Call when the model's data of a virtual row changed: rebuilds its cells and re-filters it.
+	void			dirtyVirtualRow(LLScrollListItem* item);
 	// Simple add element. Takes a single array of:
 	// [ "value" => value, "font" => font, "font-style" => style ]
 	virtual void clearRows(); // clears all elements
@@ -419,6 +435,12 @@ private:
 	void			selectPrevItem(BOOL extend_selection);
 	void			selectNextItem(BOOL extend_selection);
 	void			drawItems();
+	void			releaseVirtualCells();
+
+	void			setRowCells(LLScrollListItem* item, const LLScrollListItem::Params& item_p);
+	void			materializeItem(LLScrollListItem* item);
+	bool			getItemText(const LLScrollListItem* item, S32 column, std::string& text) const;
+	void			sortItems(const sort_order_t& sort_orders) const;
 
 	void            updateLineHeightInsert(LLScrollListItem* item);
 	void			reportInvalidInput();
@@ -504,6 +526,10 @@ private:
 	sort_order_t	mSortColumns;
 
 	sort_signal_t*	mSortCallback;
+
+	const LLScrollListRowModel* mRowModel;
+	S32				mMaterializedRows;	// virtual rows with cells, counting ones deleted since
+	U32				mDrawStamp;
 }; // end class LLScrollListCtrl
 
 #endif  // LL_SCROLLLISTCTRL_H
@@ -39,6 +39,8 @@ LLScrollListItem::LLScrollListItem( const Params& p )
 :	mSelected(FALSE),
 	mEnabled(p.enabled),
 	mFiltered(false),
+	mVirtual(false),
+	mDrawStamp(0),
 	mUserdata(p.userdata),
 	mItemValue(p.value),
 	mColumns()
@@ -74,6 +74,10 @@ public:
 	void	setFiltered(bool b)				{ if (mFiltered = b) mSelected = false; }
 	bool	getFiltered() const				{ return mFiltered; }
 
+	// Virtual rows only hold their value, their cells are built from the
+	// list's row model while they are on screen (see LLScrollListRowModel).
+	bool	isVirtual() const				{ return mVirtual; }
+
 	void	setUserdata( void* userdata )	{ mUserdata = userdata; }
 	void*	getUserdata() const 			{ return mUserdata; }
 
@@ -104,6 +108,8 @@ private:
 	BOOL	mSelected;
 	BOOL	mEnabled;
 	bool	mFiltered;
+	bool	mVirtual;
+	U32		mDrawStamp;
 	void*	mUserdata;
 	LLSD	mItemValue;
 	std::vector<LLScrollListCell *> mColumns;
@@ -0,0 +1,52 @@
+/** 
+ * @file llscrolllistrowmodel.h
+ * @brief Data source of the rows of a virtualized LLScrollListCtrl
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSCROLLLISTROWMODEL_H
+#define LL_LLSCROLLLISTROWMODEL_H
+
+#include "llscrolllistitem.h"
+
+// Supplies the content of the virtual rows of an LLScrollListCtrl. The list
+// only keeps each row's value: cells are built through buildRow() for the
+// rows that scroll into view, while sorting, filtering and type-ahead read
+// plain text through getKey() without building anything.
+class LLScrollListRowModel
+{
+public:
+	virtual ~LLScrollListRowModel() {}
+
+	// Fills in the columns of the row identified by value, as addRow() takes them.
+	virtual void buildRow(const LLSD& value, LLScrollListItem::Params& row) const = 0;
+
+	// Text of the named column of the row, as its cell would display it.
+	virtual std::string getKey(const LLSD& value, const std::string& column) const = 0;
+};
+
+#endif // LL_LLSCROLLLISTROWMODEL_H
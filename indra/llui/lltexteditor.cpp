@@ -4593,7 +4593,9 @@ S32 LLTextEditor::insertStringNoUndo(const S32 pos, const LLWString &wstr)
 
 S32 LLTextEditor::removeStringNoUndo(S32 pos, S32 length)
 {
-	auto seg_iter = getSegIterContaining(pos);
+	// Syntax highlighting splices its own segments in updateSegments(), and can only
+	// do that while they still line up with the text it colored last; leave them be.
+	auto seg_iter = mKeywords.isLoaded() ? mSegments.end() : getSegIterContaining(pos);
 	S32 end = pos + length;
 	while(seg_iter != mSegments.end())
 	{
@@ -4788,7 +4790,7 @@ void LLTextEditor::updateSegments()
 		if (mKeywords.isLoaded())
 		{
 			// HACK:  No non-ascii keywords for now
-			mKeywords.findSegments(&mSegments, mWText, mDefaultColor);
+			mKeywords.updateSegments(&mSegments, mWText, mDefaultColor);
 		}
 		else if (mAllowEmbeddedItems)
 		{
@@ -69,11 +69,13 @@
 #include "lltexteditor.h"
 #include "llui.h"
 #include "lluiimage.h"
+#include "lluixmlcache.h"
 #include "llviewborder.h"
 
 LLTrace::BlockTimerStatHandle FTM_WIDGET_CONSTRUCTION("Widget Construction");
 LLTrace::BlockTimerStatHandle FTM_INIT_FROM_PARAMS("Widget InitFromParams");
 LLTrace::BlockTimerStatHandle FTM_WIDGET_SETUP("Widget Setup");
+static LLTrace::BlockTimerStatHandle FTM_XUI_PARSE("XUI Parse");
 
 const char XML_HEADER[] = "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n";
 
@@ -189,14 +191,24 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNo
 		}
 	}
 
+	std::vector<std::string> paths =
+	gDirUtilp->findSkinnedFilenames(LLDir::XUI, xui_filename);
+
+	// The cache entry depends on the base file and every localized layer merged into it.
+	std::vector<std::string> layer_files(1, full_filename);
+	layer_files.insert(layer_files.end(), paths.begin(), paths.end());
+	LLUIXMLCache& xui_cache = LLUIXMLCache::instance();
+	if (xui_cache.get(layer_files, root))
+	{
+		return true;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_XUI_PARSE);
 	if (!LLXMLNode::parseFile(full_filename, root, NULL))
 	{
 		LL_WARNS() << "Problem reading UI description file: " << full_filename << LL_ENDL;
 		return false;
 	}
-	
-	std::vector<std::string> paths =
-	gDirUtilp->findSkinnedFilenames(LLDir::XUI, xui_filename);
 
 	for ( auto& layer_filename : paths )
 	{
@@ -218,6 +230,8 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNo
 		}
 	}
 
+	xui_cache.put(layer_files, root);
+
 	return true;
 }
 
@@ -0,0 +1,321 @@
+/** 
+ * @file lluixmlcache.cpp
+ * @brief Binary cache of parsed and merged XUI description files
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lluixmlcache.h"
+
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "llfasttimer.h"
+#include "llmd5.h"
+#include "llui.h"
+
+static const U32 XUI_CACHE_MAGIC = 0x43495558;	// "XUIC"
+static const U32 XUI_CACHE_VERSION = 1;
+static const char XUI_CACHE_SUBDIR[] = "xui";
+static const char XUI_CACHE_EXTENSION[] = ".xuib";
+
+static LLTrace::BlockTimerStatHandle FTM_XUI_CACHE_READ("XUI Cache Read");
+static LLTrace::BlockTimerStatHandle FTM_XUI_CACHE_WRITE("XUI Cache Write");
+
+namespace
+{
+
+void append_u32(std::string& out, U32 value)
+{
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		out.push_back((char)((value >> shift) & 0xff));
+	}
+}
+
+void append_u64(std::string& out, U64 value)
+{
+	append_u32(out, (U32)(value & 0xffffffff));
+	append_u32(out, (U32)(value >> 32));
+}
+
+bool read_u32(const std::string& in, size_t& pos, U32& value)
+{
+	if (in.size() < pos + 4)
+	{
+		return false;
+	}
+	const U8* p = (const U8*)in.data() + pos;
+	value = (U32)p[0] | ((U32)p[1] << 8) | ((U32)p[2] << 16) | ((U32)p[3] << 24);
+	pos += 4;
+	return true;
+}
+
+bool read_u64(const std::string& in, size_t& pos, U64& value)
+{
+	U32 low, high;
+	if (!read_u32(in, pos, low) || !read_u32(in, pos, high))
+	{
+		return false;
+	}
+	value = (U64)low | ((U64)high << 32);
+	return true;
+}
+
+} // namespace
+
+LLUIXMLCache::LLUIXMLCache()
+:	mHits(0),
+	mMisses(0)
+{
+}
+
+// static
+bool LLUIXMLCache::enabled()
+{
+	static LLUICachedControl<bool> xui_cache_enabled("XUICacheEnabled", true);
+	return xui_cache_enabled;
+}
+
+// static
+std::string LLUIXMLCache::makeKey(const std::vector<std::string>& files)
+{
+	std::string key = LLUI::getLanguage();
+	for (std::vector<std::string>::const_iterator iter = files.begin(); iter != files.end(); ++iter)
+	{
+		key += '\n';
+		key += *iter;
+	}
+	return key;
+}
+
+// static
+bool LLUIXMLCache::getStamps(const std::vector<std::string>& files, stamps_t& stamps)
+{
+	stamps.resize(files.size());
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		llstat file_status;
+		if (LLFile::stat(files[i], &file_status) != 0)
+		{
+			return false;
+		}
+		stamps[i].mModified = (U64)file_status.st_mtime;
+		stamps[i].mSize = (U64)file_status.st_size;
+	}
+	return true;
+}
+
+// static
+std::string LLUIXMLCache::getCacheFilename(const std::string& key)
+{
+	std::string cache_dir = gDirUtilp->getCacheDir();
+	if (cache_dir.empty())
+	{
+		// Too early during startup; stick to the in-memory cache.
+		return std::string();
+	}
+	LLMD5 md5;
+	md5.update(key);
+	md5.finalize();
+	char digest[MD5HEX_STR_SIZE];
+	md5.hex_digest(digest);
+	return gDirUtilp->add(gDirUtilp->add(cache_dir, XUI_CACHE_SUBDIR), std::string(digest) + XUI_CACHE_EXTENSION);
+}
+
+bool LLUIXMLCache::get(const std::vector<std::string>& files, LLXMLNodePtr& root)
+{
+	if (files.empty() || !enabled())
+	{
+		return false;
+	}
+
+	stamps_t stamps;
+	if (!getStamps(files, stamps))
+	{
+		return false;
+	}
+
+	std::string key = makeKey(files);
+	entries_t::iterator iter = mEntries.find(key);
+	if (iter == mEntries.end())
+	{
+		Entry entry;
+		if (!readEntry(key, entry))
+		{
+			++mMisses;
+			return false;
+		}
+		iter = mEntries.insert(entries_t::value_type(key, entry)).first;
+	}
+
+	Entry& entry = iter->second;
+	if (entry.mStamps != stamps)
+	{
+		// One of the layers was edited since we compiled it.
+		mEntries.erase(iter);
+		++mMisses;
+		return false;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_XUI_CACHE_READ);
+	if (!LLXMLNode::parseBinary((const U8*)entry.mData.data(), (U32)entry.mData.size(), root))
+	{
+		LL_WARNS() << "Discarding corrupt XUI cache entry for " << files.front() << LL_ENDL;
+		mEntries.erase(iter);
+		++mMisses;
+		return false;
+	}
+	++mHits;
+	return true;
+}
+
+void LLUIXMLCache::put(const std::vector<std::string>& files, LLXMLNodePtr& root)
+{
+	if (files.empty() || root.isNull() || !enabled())
+	{
+		return;
+	}
+
+	Entry entry;
+	if (!getStamps(files, entry.mStamps))
+	{
+		return;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_XUI_CACHE_WRITE);
+	root->writeBinary(entry.mData);
+	std::string key = makeKey(files);
+	writeEntry(key, entry);
+	mEntries[key] = entry;
+}
+
+void LLUIXMLCache::clear(bool remove_files)
+{
+	mEntries.clear();
+	if (remove_files && !gDirUtilp->getCacheDir().empty())
+	{
+		std::string dir = gDirUtilp->add(gDirUtilp->getCacheDir(), XUI_CACHE_SUBDIR);
+		LLDirIterator iter(dir, std::string("*") + XUI_CACHE_EXTENSION);
+		std::string filename;
+		while (iter.next(filename))
+		{
+			LLFile::remove(gDirUtilp->add(dir, filename));
+		}
+	}
+}
+
+// File layout: magic, version, key, number of stamps, stamps, LLXMLNode binary data.
+bool LLUIXMLCache::readEntry(const std::string& key, Entry& entry)
+{
+	std::string filename = getCacheFilename(key);
+	if (filename.empty())
+	{
+		return false;
+	}
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if (!fp)
+	{
+		return false;
+	}
+	std::string contents;
+	char buffer[16384];
+	size_t nread;
+	while ((nread = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+	{
+		contents.append(buffer, nread);
+	}
+	fclose(fp);
+
+	size_t pos = 0;
+	U32 magic, version, key_size, num_stamps;
+	if (!read_u32(contents, pos, magic) || magic != XUI_CACHE_MAGIC ||
+		!read_u32(contents, pos, version) || version != XUI_CACHE_VERSION ||
+		!read_u32(contents, pos, key_size) || contents.size() < pos + key_size ||
+		contents.compare(pos, key_size, key) != 0)
+	{
+		// Stale format or (unlikely) digest collision.
+		return false;
+	}
+	pos += key_size;
+	if (!read_u32(contents, pos, num_stamps) || num_stamps > 64)
+	{
+		return false;
+	}
+	entry.mStamps.resize(num_stamps);
+	for (U32 i = 0; i < num_stamps; ++i)
+	{
+		if (!read_u64(contents, pos, entry.mStamps[i].mModified) || !read_u64(contents, pos, entry.mStamps[i].mSize))
+		{
+			return false;
+		}
+	}
+	entry.mData.assign(contents, pos, std::string::npos);
+	return true;
+}
+
+void LLUIXMLCache::writeEntry(const std::string& key, const Entry& entry)
+{
+	std::string filename = getCacheFilename(key);
+	if (filename.empty())
+	{
+		return;
+	}
+	LLFile::mkdir_nowarn(gDirUtilp->getDirName(filename), 0700);
+
+	std::string header;
+	append_u32(header, XUI_CACHE_MAGIC);
+	append_u32(header, XUI_CACHE_VERSION);
+	append_u32(header, (U32)key.size());
+	header.append(key);
+	append_u32(header, (U32)entry.mStamps.size());
+	for (stamps_t::const_iterator iter = entry.mStamps.begin(); iter != entry.mStamps.end(); ++iter)
+	{
+		append_u64(header, iter->mModified);
+		append_u64(header, iter->mSize);
+	}
+
+	// Write to a temporary file first so that a crash never leaves a truncated entry behind.
+	std::string tmp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(tmp_filename, "wb");
+	if (!fp)
+	{
+		return;
+	}
+	bool ok = fwrite(header.data(), 1, header.size(), fp) == header.size() &&
+			  fwrite(entry.mData.data(), 1, entry.mData.size(), fp) == entry.mData.size();
+	fclose(fp);
+	if (ok)
+	{
+		// rename() doesn't replace existing files on Windows.
+		LLFile::remove_nowarn(filename);
+	}
+	if (!ok || LLFile::rename_nowarn(tmp_filename, filename) != 0)
+	{
+		LLFile::remove_nowarn(tmp_filename);
+	}
+}
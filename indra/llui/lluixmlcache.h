@@ -0,0 +1,95 @@
+/** 
+ * @file lluixmlcache.h
+ * @brief Binary cache of parsed and merged XUI description files
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUIXMLCACHE_H
+#define LL_LLUIXMLCACHE_H
+
+#include "llsingleton.h"
+#include "llxmlnode.h"
+
+//
+// LLUIXMLCache keeps the compiled (LLXMLNode::writeBinary) form of every XUI
+// file that LLUICtrlFactory::getLayeredXMLNode builds, both in memory and in
+// the "xui" subdirectory of the cache directory. An entry is keyed on the
+// UI language and the list of layer files that were merged into it, and is
+// only used while the size and modification time of each of those files are
+// unchanged. Decoding an entry skips expat and the localization merge pass.
+//
+class LLUIXMLCache : public LLSingleton<LLUIXMLCache>
+{
+	friend class LLSingleton<LLUIXMLCache>;
+	LLUIXMLCache();
+
+public:
+	// Build root from the cache for the given layer files, base file first.
+	// Returns false when there is no valid entry.
+	bool get(const std::vector<std::string>& files, LLXMLNodePtr& root);
+
+	// Remember the merged tree root for the given layer files.
+	void put(const std::vector<std::string>& files, LLXMLNodePtr& root);
+
+	// Forget all in-memory entries; with remove_files also delete the disk cache.
+	void clear(bool remove_files = false);
+
+	static bool enabled();
+
+	U32 getHits() const { return mHits; }
+	U32 getMisses() const { return mMisses; }
+
+private:
+	struct FileStamp
+	{
+		FileStamp() : mModified(0), mSize(0) { }
+		bool operator==(const FileStamp& rhs) const { return mModified == rhs.mModified && mSize == rhs.mSize; }
+		U64 mModified;
+		U64 mSize;
+	};
+	typedef std::vector<FileStamp> stamps_t;
+
+	struct Entry
+	{
+		stamps_t mStamps;
+		std::string mData;			// LLXMLNode::writeBinary output.
+	};
+	typedef std::map<std::string, Entry> entries_t;
+
+	static std::string makeKey(const std::vector<std::string>& files);
+	static bool getStamps(const std::vector<std::string>& files, stamps_t& stamps);
+	static std::string getCacheFilename(const std::string& key);
+
+	bool readEntry(const std::string& key, Entry& entry);
+	void writeEntry(const std::string& key, const Entry& entry);
+
+	entries_t mEntries;
+	U32 mHits;
+	U32 mMisses;
+};
+
+#endif // LL_LLUIXMLCACHE_H
@@ -51,6 +51,7 @@ std::string localize_slapp_label(const std::string& url, const std::string& full
 
 
 LLUrlEntryBase::LLUrlEntryBase()
+:	mCaseSensitiveTriggers(false)
 {
 }
 
@@ -244,6 +245,7 @@ LLUrlEntryHTTP::LLUrlEntryHTTP()
 {
 	mPattern = boost::regex("https?://([^\\s/?\\.#]+\\.?)+\\.\\w+(:\\d+)?(/\\S*)?",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("http");
 	mMenuName = "menu_url_http.xml";
 	mTooltip = LLTrans::getString("TooltipHttpUrl");
 }
@@ -275,6 +277,7 @@ LLUrlEntryHTTPLabel::LLUrlEntryHTTPLabel()
 {
 	mPattern = boost::regex("\\[(https?://\\S+|\\S+\\.([^\\s<]*)?)[ \t]+[^\\]]+\\]",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("[");
 	mMenuName = "menu_url_http.xml";
 	mTooltip = LLTrans::getString("TooltipHttpUrl");
 }
@@ -306,6 +309,7 @@ LLUrlEntryHTTPNoProtocol::LLUrlEntryHTTPNoProtocol()
 {
 	mPattern = boost::regex("\\bwww\\.\\S+\\.([^\\s<]*)?\\b", // i.e. www.FOO.BAR
 		boost::regex::perl | boost::regex::icase);
+	addTrigger("www.");
 	mMenuName = "menu_url_http.xml";
 	mTooltip = LLTrans::getString("TooltipHttpUrl");
 }
@@ -339,6 +343,7 @@ LLUrlEntryInvalidSLURL::LLUrlEntryInvalidSLURL()
 {
 	mPattern = boost::regex("(https?://(maps.secondlife.com|slurl.com)/secondlife/|secondlife://(/app/(worldmap|teleport)/)?)[^ /]+(/-?[0-9]+){1,3}(/?(\\?\\S*)?)?",
 									boost::regex::perl|boost::regex::icase);
+	addTrigger("secondlife");
 	mMenuName = "menu_url_http.xml";
 	mTooltip = LLTrans::getString("TooltipHttpUrl");
 }
@@ -426,6 +431,7 @@ LLUrlEntrySLURL::LLUrlEntrySLURL()
 	// see http://slurl.com/about.php for details on the SLURL format
 	mPattern = boost::regex("https?://(maps.secondlife.com|slurl.com)/secondlife/[^ /]+(/\\d+){0,3}(/?(\\?\\S*)?)?",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/secondlife/");
 	mIcon = "Hand";
 	mMenuName = "menu_url_slurl.xml";
 	mTooltip = LLTrans::getString("TooltipSLURL");
@@ -499,6 +505,8 @@ LLUrlEntrySecondlifeURL::LLUrlEntrySecondlifeURL()
 { 
 	mPattern = boost::regex("\\b(https?://)?([-\\w\\.]*\\.)?(secondlife|lindenlab)\\.com(:\\d{1,5})?(/\\S*)?",
 		boost::regex::perl|boost::regex::icase);
+	addTrigger("secondlife.com");
+	addTrigger("lindenlab.com");
 	
 	mIcon = "Hand";
 	mMenuName = "menu_url_http.xml";
@@ -537,6 +545,8 @@ LLUrlEntrySimpleSecondlifeURL::LLUrlEntrySimpleSecondlifeURL()
   {
 	mPattern = boost::regex("(https?://)?([-\\w\\.]*\\.)?(secondlife|lindenlab)\\.com(?!\\S)",
 		boost::regex::perl|boost::regex::icase);
+	addTrigger("secondlife.com");
+	addTrigger("lindenlab.com");
 
 	mIcon = "Hand";
 	mMenuName = "menu_url_http.xml";
@@ -551,6 +561,7 @@ LLUrlEntryAgent::LLUrlEntryAgent()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/agent/[\\da-f-]+/\\w+",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/agent/");
 	mMenuName = "menu_url_agent.xml";
 	mIcon = "Generic_Person";
 }
@@ -810,6 +821,7 @@ LLUrlEntryAgentCompleteName::LLUrlEntryAgentCompleteName()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/agent/[\\da-f-]+/completename",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/agent/");
 }
 
 std::string LLUrlEntryAgentCompleteName::getName(const LLAvatarName& avatar_name)
@@ -826,6 +838,7 @@ LLUrlEntryAgentLegacyName::LLUrlEntryAgentLegacyName()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/agent/[\\da-f-]+/legacyname",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/agent/");
 }
 
 std::string LLUrlEntryAgentLegacyName::getName(const LLAvatarName& avatar_name)
@@ -842,6 +855,7 @@ LLUrlEntryAgentDisplayName::LLUrlEntryAgentDisplayName()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/agent/[\\da-f-]+/displayname",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/agent/");
 }
 
 std::string LLUrlEntryAgentDisplayName::getName(const LLAvatarName& avatar_name)
@@ -858,6 +872,7 @@ LLUrlEntryAgentUserName::LLUrlEntryAgentUserName()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/agent/[\\da-f-]+/username",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/agent/");
 }
 
 std::string LLUrlEntryAgentUserName::getName(const LLAvatarName& avatar_name)
@@ -875,6 +890,7 @@ LLUrlEntryGroup::LLUrlEntryGroup()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/group/[\\da-f-]+/\\w+",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/group/");
 	mMenuName = "menu_url_group.xml";
 	mIcon = "Generic_Group";
 	mTooltip = LLTrans::getString("TooltipGroupUrl");
@@ -951,6 +967,7 @@ LLUrlEntryInventory::LLUrlEntryInventory()
 	//x-grid-info://lincoln.lindenlab.com/app/inventory/0e346d8b-4433-4d66-a6b0-fd37083abc4c/select?name=name with spaces&param2=value
 	mPattern = boost::regex(APP_HEADER_REGEX "/inventory/[\\da-f-]+/\\w+\\S*",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/inventory/");
 	mMenuName = "menu_url_inventory.xml";
 }
 
@@ -968,6 +985,7 @@ LLUrlEntryObjectIM::LLUrlEntryObjectIM()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/objectim/[\\da-f-]+\?\\S*\\w",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/objectim/");
 	mMenuName = "menu_url_objectim.xml";
 }
 
@@ -1005,6 +1023,7 @@ LLUrlEntryParcel::LLUrlEntryParcel()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/parcel/[\\da-f-]+/about",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/parcel/");
 	mMenuName = "menu_url_parcel.xml";
 	mTooltip = LLTrans::getString("TooltipParcelUrl");
 
@@ -1093,6 +1112,9 @@ LLUrlEntryPlace::LLUrlEntryPlace()
 {
 	mPattern = boost::regex("((((x-grid-info://)|(x-grid-location-info://))[-\\w\\.]+(:\\d+)?/region/)|(secondlife://))\\S+/?(\\d+/\\d+/\\d+|\\d+/\\d+)/?",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("x-grid-info://");
+	addTrigger("x-grid-location-info://");
+	addTrigger("secondlife://");
 	mMenuName = "menu_url_slurl.xml";
 	mTooltip = LLTrans::getString("TooltipSLURL");
 }
@@ -1156,6 +1178,7 @@ LLUrlEntryRegion::LLUrlEntryRegion()
 {
 	mPattern = boost::regex(X_GRID_OR_SECONDLIFE_HEADER_REGEX"//app/region/[^/\\s]+(/\\d+)?(/\\d+)?(/\\d+)?/?",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/region/");
 	mMenuName = "menu_url_slurl.xml";
 	mTooltip = LLTrans::getString("TooltipSLURL");
 }
@@ -1229,6 +1252,7 @@ LLUrlEntryTeleport::LLUrlEntryTeleport()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/teleport/\\S+(/\\d+)?(/\\d+)?(/\\d+)?/?\\S*",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/teleport/");
 	mMenuName = "menu_url_teleport.xml";
 	mTooltip = LLTrans::getString("TooltipTeleportUrl");
 }
@@ -1299,6 +1323,9 @@ LLUrlEntrySL::LLUrlEntrySL()
 {
 	mPattern = boost::regex(X_GRID_OR_SECONDLIFE_HEADER_REGEX "(\\w+)?(:\\d+)?/\\S+",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("x-grid-info://");
+	addTrigger("x-grid-location-info://");
+	addTrigger("secondlife://");
 	mMenuName = "menu_url_slapp.xml";
 	mTooltip = LLTrans::getString("TooltipSLAPP");
 }
@@ -1316,6 +1343,9 @@ LLUrlEntrySLLabel::LLUrlEntrySLLabel()
 {
 	mPattern = boost::regex("\\[" X_GRID_OR_SECONDLIFE_HEADER_REGEX "\\S+[ \t]+[^\\]]+\\]",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("x-grid-info://");
+	addTrigger("x-grid-location-info://");
+	addTrigger("secondlife://");
 	mMenuName = "menu_url_slapp.xml";
 	mTooltip = LLTrans::getString("TooltipSLAPP");
 }
@@ -1365,6 +1395,7 @@ LLUrlEntryWorldMap::LLUrlEntryWorldMap()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/worldmap/\\S+/?(\\d+)?/?(\\d+)?/?(\\d+)?/?\\S*",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/worldmap/");
 	mMenuName = "menu_url_map.xml";
 	mTooltip = LLTrans::getString("TooltipMapUrl");
 }
@@ -1406,6 +1437,7 @@ LLUrlEntryNoLink::LLUrlEntryNoLink()
 {
 	mPattern = boost::regex("<nolink>.*?</nolink>",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("<nolink>");
 }
 
 std::string LLUrlEntryNoLink::getUrl(const std::string &url) const
@@ -1435,6 +1467,7 @@ LLUrlEntryIcon::LLUrlEntryIcon()
 {
 	mPattern = boost::regex("<icon\\s*>\\s*([^<]*)?\\s*</icon\\s*>",
 							boost::regex::perl|boost::regex::icase);
+	addTrigger("<icon");
 }
 
 std::string LLUrlEntryIcon::getUrl(const std::string &url) const
@@ -1467,6 +1500,7 @@ LLUrlEntryEmail::LLUrlEntryEmail()
 {
 	mPattern = boost::regex("(mailto:)?[\\w\\.\\-]+@[\\w\\.\\-]+\\.[a-z]{2,63}",
 							boost::regex::perl | boost::regex::icase);
+	addTrigger("@");
 	mMenuName = "menu_url_email.xml";
 	mTooltip = LLTrans::getString("TooltipEmail");
 }
@@ -1497,6 +1531,7 @@ LLUrlEntryExperienceProfile::LLUrlEntryExperienceProfile()
 {
 	mPattern = boost::regex(APP_HEADER_REGEX "/experience/[\\da-f-]+/\\w+\\S*",
 		boost::regex::perl|boost::regex::icase);
+	addTrigger("/app/experience/");
 	mIcon = "Generic_Experience";
 	mMenuName = "menu_url_experience.xml";
 }
@@ -1553,6 +1588,19 @@ LLUrlEntryJira::LLUrlEntryJira()
 {
 	mPattern = boost::regex("(\\b(?:ALCH|SV|BUG|CHOP|FIRE|MAINT|OPEN|SCR|STORM|SVC|VWR|WEB)-\\d+)",
 							boost::regex::perl);
+	mCaseSensitiveTriggers = true;
+	addTrigger("ALCH-");
+	addTrigger("SV-");
+	addTrigger("BUG-");
+	addTrigger("CHOP-");
+	addTrigger("FIRE-");
+	addTrigger("MAINT-");
+	addTrigger("OPEN-");
+	addTrigger("SCR-");
+	addTrigger("STORM-");
+	addTrigger("SVC-");
+	addTrigger("VWR-");
+	addTrigger("WEB-");
 	mMenuName = "menu_url_http.xml";
 	mTooltip = LLTrans::getString("TooltipHttpUrl");
 }
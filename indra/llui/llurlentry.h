@@ -67,7 +67,13 @@ public:
 	virtual ~LLUrlEntryBase();
 	
 	/// Return the regex pattern that matches this Url 
-	boost::regex getPattern() const { return mPattern; }
+	const boost::regex& getPattern() const { return mPattern; }
+
+	/// Return literals of which every match contains at least one, or
+	/// nothing if the pattern has no such literal (lower case unless
+	/// hasCaseSensitiveTriggers())
+	const std::vector<std::string>& getTriggers() const { return mTriggers; }
+	bool hasCaseSensitiveTriggers() const { return mCaseSensitiveTriggers; }
 
 	/// Return the url from a string that matched the regex
 	virtual std::string getUrl(const std::string &string) const;
@@ -116,6 +122,7 @@ protected:
 	std::string urlToLabelWithGreyQuery(const std::string &url) const;
 	std::string urlToGreyQuery(const std::string &url) const;
 	virtual void callObservers(const std::string &id, const std::string &label, const std::string& icon);
+	void addTrigger(const std::string &literal) { mTriggers.push_back(literal); }
 
 	typedef struct {
 		std::string url;
@@ -127,6 +134,8 @@ protected:
 	std::string                                    	mMenuName;
 	std::string                                    	mTooltip;
 	std::multimap<std::string, LLUrlEntryObserver>	mObservers;
+	std::vector<std::string>						mTriggers;
+	bool											mCaseSensitiveTriggers;
 };
 
 ///
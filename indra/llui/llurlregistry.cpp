@@ -39,6 +39,9 @@ void LLUrlRegistryNullCallback(const std::string &url, const std::string &label,
 }
 
 LLUrlRegistry::LLUrlRegistry()
+:	mTriggerSymbols(0),
+	mTriggersDirty(true),
+	mUseTriggers(true)
 {
 	mUrlEntry.reserve(23); // <alchemy/>
 
@@ -105,9 +108,161 @@ void LLUrlRegistry::registerUrl(LLUrlEntryBase *url, bool force_front)
 			mUrlEntry.insert(mUrlEntry.begin(), url);
 		else
 		mUrlEntry.push_back(url);
+		mTriggersDirty = true;
 	}
 }
 
+void LLUrlRegistry::addTrigger(const std::string &literal, bool case_sensitive, S32 entry)
+{
+	Trigger trigger;
+	trigger.mLiteral = literal;
+	trigger.mCaseSensitive = case_sensitive;
+	trigger.mEntry = entry;
+	if (!case_sensitive)
+	{
+		LLStringUtil::toLower(trigger.mLiteral);
+	}
+	mTriggers.push_back(trigger);
+}
+
+void LLUrlRegistry::buildTriggerMatcher()
+{
+	mTriggers.clear();
+	mTriggerlessEntries.assign(mUrlEntry.size(), 0);
+
+	// the literals of stringHasUrl() and stringHasJira(); as before, no
+	// regex is run at all unless one of these occurs in the text
+	static const char* const heuristic_literals[] = {
+		"://", "www.", ".com", ".net", ".edu", ".org", "<nolink>", "<icon", "@",
+		"ALCH", "SV", "BUG", "CHOP", "FIRE", "MAINT", "OPEN", "SCR", "STORM", "SVC", "VWR", "WEB"
+	};
+	for (size_t i = 0; i < LL_ARRAY_SIZE(heuristic_literals); ++i)
+	{
+		addTrigger(heuristic_literals[i], true, -1);
+	}
+
+	for (size_t i = 0; i < mUrlEntry.size(); ++i)
+	{
+		const std::vector<std::string>& literals = mUrlEntry[i]->getTriggers();
+		if (literals.empty())
+		{
+			mTriggerlessEntries[i] = 1;
+		}
+		for (std::vector<std::string>::const_iterator it = literals.begin(); it != literals.end(); ++it)
+		{
+			addTrigger(*it, mUrlEntry[i]->hasCaseSensitiveTriggers(), (S32)i);
+		}
+	}
+
+	// the automaton works on case folded bytes; case sensitive triggers are
+	// verified against the original text when they are found
+	memset(mTriggerSymbol, 0, sizeof(mTriggerSymbol));
+	mTriggerSymbols = 1;
+	for (std::vector<Trigger>::const_iterator it = mTriggers.begin(); it != mTriggers.end(); ++it)
+	{
+		for (std::string::const_iterator c = it->mLiteral.begin(); c != it->mLiteral.end(); ++c)
+		{
+			U8 folded = (U8)tolower((U8)*c);
+			if (!mTriggerSymbol[folded])
+			{
+				mTriggerSymbol[folded] = mTriggerSymbol[toupper(folded)] = mTriggerSymbols++;
+			}
+		}
+	}
+
+	// build the trie; 0 is the root and doubles as "no transition" while building
+	mTriggerTransitions.assign(mTriggerSymbols, 0);
+	mTriggerOutputs.assign(1, std::vector<U16>());
+	for (U16 t = 0; t < (U16)mTriggers.size(); ++t)
+	{
+		U32 state = 0;
+		const std::string& literal = mTriggers[t].mLiteral;
+		for (std::string::const_iterator c = literal.begin(); c != literal.end(); ++c)
+		{
+			U32 symbol = mTriggerSymbol[(U8)*c];
+			U32 next = mTriggerTransitions[state * mTriggerSymbols + symbol];
+			if (!next)
+			{
+				next = mTriggerOutputs.size();
+				mTriggerOutputs.push_back(std::vector<U16>());
+				mTriggerTransitions.resize(mTriggerTransitions.size() + mTriggerSymbols, 0);
+				mTriggerTransitions[state * mTriggerSymbols + symbol] = (U16)next;
+			}
+			state = next;
+		}
+		mTriggerOutputs[state].push_back(t);
+	}
+
+	// breadth first, turn the trie into a DFA: missing transitions follow the
+	// failure link, and every state inherits the outputs of its failure state
+	std::vector<U16> fail(mTriggerOutputs.size(), 0);
+	std::vector<U16> queue;
+	for (U32 symbol = 0; symbol < mTriggerSymbols; ++symbol)
+	{
+		if (U16 next = mTriggerTransitions[symbol])
+		{
+			queue.push_back(next);
+		}
+	}
+	for (size_t head = 0; head < queue.size(); ++head)
+	{
+		U16 state = queue[head];
+		const std::vector<U16>& inherited = mTriggerOutputs[fail[state]];
+		mTriggerOutputs[state].insert(mTriggerOutputs[state].end(), inherited.begin(), inherited.end());
+		for (U32 symbol = 0; symbol < mTriggerSymbols; ++symbol)
+		{
+			U16& next = mTriggerTransitions[state * mTriggerSymbols + symbol];
+			U16 fallback = mTriggerTransitions[fail[state] * mTriggerSymbols + symbol];
+			if (next)
+			{
+				fail[next] = fallback;
+				queue.push_back(next);
+			}
+			else
+			{
+				next = fallback;
+			}
+		}
+	}
+
+	mTriggersDirty = false;
+}
+
+// returns whether the text passed the "might contain a Url" heuristic, and
+// flags the entries that need to run their regex in triggered
+bool LLUrlRegistry::scanTriggers(const std::string &text, std::vector<U8> &triggered) const
+{
+	triggered = mTriggerlessEntries;
+	bool might_have_url = false;
+
+	const char* data = text.data();
+	U32 state = 0;
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		state = mTriggerTransitions[state * mTriggerSymbols + mTriggerSymbol[(U8)data[i]]];
+		const std::vector<U16>& outputs = mTriggerOutputs[state];
+		for (std::vector<U16>::const_iterator it = outputs.begin(); it != outputs.end(); ++it)
+		{
+			const Trigger& trigger = mTriggers[*it];
+			if (trigger.mCaseSensitive &&
+				memcmp(data + i + 1 - trigger.mLiteral.size(), trigger.mLiteral.data(), trigger.mLiteral.size()))
+			{
+				continue;
+			}
+			if (trigger.mEntry < 0)
+			{
+				might_have_url = true;
+			}
+			else
+			{
+				triggered[trigger.mEntry] = 1;
+			}
+		}
+	}
+
+	return might_have_url;
+}
+
 static bool matchRegex(const char *text, const boost::regex& regex, U32 &start, U32 &end)
 {
 	boost::cmatch result;
@@ -192,8 +347,22 @@ static bool stringHasJira(const std::string &text)
 
 bool LLUrlRegistry::findUrl(const std::string &text, LLUrlMatch &match, const LLUrlLabelCallback &cb, bool is_content_trusted)
 {
+	std::vector<U8> triggered;
+	if (mUseTriggers)
+	{
+		if (mTriggersDirty)
+		{
+			buildTriggerMatcher();
+		}
+		// avoid costly regexes if there is clearly no URL in the text, and
+		// only try the entries whose literals occur in it
+		if (!scanTriggers(text, triggered))
+		{
+			return false;
+		}
+	}
 	// avoid costly regexes if there is clearly no URL in the text
-	if (!(stringHasUrl(text) || stringHasJira(text))) // <alchemy/>
+	else if (!(stringHasUrl(text) || stringHasJira(text))) // <alchemy/>
 	{
 		return false;
 	}
@@ -211,6 +380,11 @@ bool LLUrlRegistry::findUrl(const std::string &text, LLUrlMatch &match, const LL
 			continue;
 		}
 
+		if (mUseTriggers && !triggered[it - mUrlEntry.begin()])
+		{
+			continue;
+		}
+
 		LLUrlEntryBase *url_entry = *it;
 
 		U32 start = 0, end = 0;
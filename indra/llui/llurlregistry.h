@@ -85,11 +85,38 @@ public:
 	bool isUrl(const std::string &text);
 	bool isUrl(const LLWString &text);
 
+	// only run the regexes of entries whose trigger literals occur in the
+	// text (default); turning this off is only useful for benchmarking
+	void setUseTriggers(bool use_triggers) { mUseTriggers = use_triggers; }
+
 private:
 	LLUrlRegistry();
 	friend class LLSingleton<LLUrlRegistry>;
 
+	struct Trigger
+	{
+		std::string mLiteral;	// lower case unless mCaseSensitive
+		bool mCaseSensitive;
+		S32 mEntry;				// index into mUrlEntry, or -1 for the "might contain a Url" heuristic
+	};
+
+	void addTrigger(const std::string &literal, bool case_sensitive, S32 entry);
+	void buildTriggerMatcher();
+	bool scanTriggers(const std::string &text, std::vector<U8> &triggered) const;
+
 	std::vector<LLUrlEntryBase *> mUrlEntry;
+
+	// Aho-Corasick automaton over the trigger literals of all entries, so that
+	// a single pass over the text tells which entries can possibly match.
+	std::vector<Trigger> mTriggers;
+	std::vector<U16> mTriggerTransitions;				// [state * mTriggerSymbols + symbol] -> state
+	std::vector<std::vector<U16> > mTriggerOutputs;		// state -> triggers ending there
+	std::vector<U8> mTriggerlessEntries;				// entries that always need their regex run
+	U8 mTriggerSymbol[256];								// byte -> case folded symbol, 0 if in no trigger
+	U32 mTriggerSymbols;
+	bool mTriggersDirty;
+	bool mUseTriggers;
+
 	LLUrlEntryBase*	mUrlEntryTrusted;
 	LLUrlEntryBase*	mUrlEntryIcon;
 	LLUrlEntryBase* mLLUrlEntryInvalidSLURL;
@@ -878,6 +878,247 @@ bool LLXMLNode::parseStream(
 }
 
 
+//-----------------------------------------------------------------------------
+// Binary serialization
+//-----------------------------------------------------------------------------
+
+namespace
+{
+
+const U32 XML_BINARY_MAGIC = 0x42584d4c;	// "LMXB"
+const U32 XML_BINARY_VERSION = 1;
+
+class LLXMLBinaryWriter
+{
+public:
+	LLXMLBinaryWriter(std::string& output) : mOutput(output) { }
+
+	void writeU8(U8 value) { mOutput.push_back((char)value); }
+	void writeU32(U32 value)
+	{
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			mOutput.push_back((char)((value >> shift) & 0xff));
+		}
+	}
+	void writeString(const std::string& value)
+	{
+		writeU32((U32)value.size());
+		mOutput.append(value);
+	}
+
+	U32 nameIndex(const LLStringTableEntry* name)
+	{
+		name_map_t::iterator iter = mNameMap.find(name);
+		if (iter != mNameMap.end())
+		{
+			return iter->second;
+		}
+		U32 index = (U32)mNames.size();
+		mNames.push_back(name);
+		mNameMap[name] = index;
+		return index;
+	}
+
+	const std::vector<const LLStringTableEntry*>& getNames() const { return mNames; }
+
+private:
+	typedef std::map<const LLStringTableEntry*, U32> name_map_t;
+
+	std::string& mOutput;
+	name_map_t mNameMap;
+	std::vector<const LLStringTableEntry*> mNames;
+};
+
+class LLXMLBinaryReader
+{
+public:
+	LLXMLBinaryReader(const U8* buffer, U32 length) : mCur(buffer), mEnd(buffer + length), mError(false) { }
+
+	bool error() const { return mError; }
+
+	U8 readU8()
+	{
+		if (mCur >= mEnd)
+		{
+			mError = true;
+			return 0;
+		}
+		return *mCur++;
+	}
+	U32 readU32()
+	{
+		if (mEnd - mCur < 4)
+		{
+			mError = true;
+			return 0;
+		}
+		U32 value = (U32)mCur[0] | ((U32)mCur[1] << 8) | ((U32)mCur[2] << 16) | ((U32)mCur[3] << 24);
+		mCur += 4;
+		return value;
+	}
+	void readString(std::string& value)
+	{
+		U32 size = readU32();
+		if (mError || (U32)(mEnd - mCur) < size)
+		{
+			mError = true;
+			value.clear();
+			return;
+		}
+		value.assign((const char*)mCur, size);
+		mCur += size;
+	}
+
+	std::vector<LLStringTableEntry*> mNames;
+
+private:
+	const U8* mCur;
+	const U8* mEnd;
+	bool mError;
+};
+
+void write_binary_node(LLXMLBinaryWriter& writer, LLXMLNode* node)
+{
+	writer.writeU32(writer.nameIndex(node->getName()));
+	writer.writeU8(node->mIsAttribute ? 1 : 0);
+	writer.writeU8((U8)node->mType);
+	writer.writeU8((U8)node->mEncoding);
+	writer.writeU32(node->mVersionMajor);
+	writer.writeU32(node->mVersionMinor);
+	writer.writeU32(node->mLength);
+	writer.writeU32(node->mPrecision);
+	writer.writeU32((U32)node->mLineNumber);
+	writer.writeString(node->mID);
+	writer.writeString(node->getValue());
+
+	writer.writeU32((U32)node->mAttributes.size());
+	for (LLXMLAttribList::iterator iter = node->mAttributes.begin(); iter != node->mAttributes.end(); ++iter)
+	{
+		write_binary_node(writer, iter->second);
+	}
+
+	U32 num_children = node->getChildCount();
+	writer.writeU32(num_children);
+	for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+	{
+		write_binary_node(writer, child);
+	}
+}
+
+} // namespace
+
+void LLXMLNode::writeBinary(std::string& output)
+{
+	// Nodes first, so that the name table is complete when we write it.
+	std::string nodes;
+	LLXMLBinaryWriter node_writer(nodes);
+	write_binary_node(node_writer, this);
+
+	LLXMLBinaryWriter writer(output);
+	writer.writeU32(XML_BINARY_MAGIC);
+	writer.writeU32(XML_BINARY_VERSION);
+	const std::vector<const LLStringTableEntry*>& names = node_writer.getNames();
+	writer.writeU32((U32)names.size());
+	for (std::vector<const LLStringTableEntry*>::const_iterator iter = names.begin(); iter != names.end(); ++iter)
+	{
+		writer.writeString((*iter)->mString);
+	}
+	output.append(nodes);
+}
+
+static LLXMLNodePtr read_binary_node(LLXMLBinaryReader& reader, LLXMLNode* parent, S32 depth)
+{
+	U32 name_index = reader.readU32();
+	if (reader.error() || name_index >= reader.mNames.size() || depth > 256)
+	{
+		return LLXMLNodePtr();
+	}
+	BOOL is_attribute = reader.readU8() ? TRUE : FALSE;
+	LLXMLNodePtr node = new LLXMLNode(reader.mNames[name_index], is_attribute);
+	node->mType = (LLXMLNode::ValueType)reader.readU8();
+	node->mEncoding = (LLXMLNode::Encoding)reader.readU8();
+	node->mVersionMajor = reader.readU32();
+	node->mVersionMinor = reader.readU32();
+	node->mLength = reader.readU32();
+	node->mPrecision = reader.readU32();
+	node->mLineNumber = (S32)reader.readU32();
+	reader.readString(node->mID);
+	std::string value;
+	reader.readString(value);
+	if (reader.error())
+	{
+		return LLXMLNodePtr();
+	}
+	// setValue() turns containers into TYPE_UNKNOWN; keep the stored type.
+	LLXMLNode::ValueType type = node->mType;
+	node->setValue(value);
+	node->mType = type;
+
+	if (parent)
+	{
+		parent->addChild(node);
+	}
+
+	U32 num_attributes = reader.readU32();
+	for (U32 i = 0; i < num_attributes && !reader.error(); ++i)
+	{
+		if (read_binary_node(reader, node, depth + 1).isNull())
+		{
+			return LLXMLNodePtr();
+		}
+	}
+	U32 num_children = reader.readU32();
+	for (U32 i = 0; i < num_children && !reader.error(); ++i)
+	{
+		if (read_binary_node(reader, node, depth + 1).isNull())
+		{
+			return LLXMLNodePtr();
+		}
+	}
+	return reader.error() ? LLXMLNodePtr() : node;
+}
+
+// static
+bool LLXMLNode::parseBinary(
+	const U8* buffer,
+	U32 length,
+	LLXMLNodePtr& node)
+{
+	node = NULL;
+	LLXMLBinaryReader reader(buffer, length);
+	if (reader.readU32() != XML_BINARY_MAGIC || reader.readU32() != XML_BINARY_VERSION)
+	{
+		return false;
+	}
+	U32 num_names = reader.readU32();
+	if (reader.error() || num_names > length)
+	{
+		return false;
+	}
+	reader.mNames.reserve(num_names);
+	std::string name;
+	for (U32 i = 0; i < num_names; ++i)
+	{
+		reader.readString(name);
+		if (reader.error())
+		{
+			return false;
+		}
+		reader.mNames.push_back(gStringTable.addStringEntry(name));
+	}
+
+	LLXMLNodePtr root = read_binary_node(reader, NULL, 0);
+	if (root.isNull())
+	{
+		LL_WARNS() << "Corrupt binary XML data." << LL_ENDL;
+		return false;
+	}
+	root->updateDefault();
+	node = root;
+	return true;
+}
+
 BOOL LLXMLNode::isFullyDefault()
 {
 	if (mDefault.isNull())
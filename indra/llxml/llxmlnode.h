@@ -152,6 +152,14 @@ public:
 	static bool updateNode(
 		LLXMLNodePtr& node,
 		LLXMLNodePtr& update_node);
+
+	// Compact binary form of a node tree, used to cache parsed (and merged) XUI files.
+	// Names are stored once in a table and re-interned through gStringTable when read.
+	void writeBinary(std::string& output);
+	static bool parseBinary(
+		const U8* buffer,
+		U32 length,
+		LLXMLNodePtr& node);
 	static LLXMLNodePtr replaceNode(LLXMLNodePtr node, LLXMLNodePtr replacement_node);
 	
 	static bool getLayeredXMLNode(LLXMLNodePtr& root, const std::vector<std::string>& paths);
@@ -149,6 +149,145 @@ void LLXmlTree::writeNode(LLXmlTreeNode *node, std::string &buffer, const std::s
 }
 
 
+static const U32 XML_TREE_BINARY_MAGIC = 0x54584c4c;	// "LLXT"
+static const U32 XML_TREE_BINARY_VERSION = 1;
+
+namespace
+{
+
+void append_u32(std::string& output, U32 value)
+{
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		output.push_back((char)((value >> shift) & 0xff));
+	}
+}
+
+void append_string(std::string& output, const std::string& value)
+{
+	append_u32(output, (U32)value.size());
+	output.append(value);
+}
+
+bool read_u32(const U8*& cur, const U8* end, U32& value)
+{
+	if (end - cur < 4)
+	{
+		return false;
+	}
+	value = (U32)cur[0] | ((U32)cur[1] << 8) | ((U32)cur[2] << 16) | ((U32)cur[3] << 24);
+	cur += 4;
+	return true;
+}
+
+bool read_string(const U8*& cur, const U8* end, std::string& value)
+{
+	U32 size;
+	if (!read_u32(cur, end, size) || (U32)(end - cur) < size)
+	{
+		return false;
+	}
+	value.assign((const char*)cur, size);
+	cur += size;
+	return true;
+}
+
+} // namespace
+
+// Layout: magic, version, root node. A node is its name, contents, number of
+// attributes, attribute name/value pairs, number of children and the children.
+void LLXmlTree::writeBinary(std::string& output) const
+{
+	append_u32(output, XML_TREE_BINARY_MAGIC);
+	append_u32(output, XML_TREE_BINARY_VERSION);
+	if (mRoot)
+	{
+		writeBinaryNode(mRoot, output);
+	}
+}
+
+void LLXmlTree::writeBinaryNode(LLXmlTreeNode* node, std::string& output) const
+{
+	append_string(output, node->mName);
+	append_string(output, node->mContents);
+	append_u32(output, (U32)node->mAttributes.size());
+	for (LLXmlTreeNode::attribute_map_t::const_iterator iter = node->mAttributes.begin(); iter != node->mAttributes.end(); ++iter)
+	{
+		append_string(output, *iter->first);
+		append_string(output, *iter->second);
+	}
+	append_u32(output, (U32)node->mChildList.size());
+	for (LLXmlTreeNode::child_list_t::const_iterator iter = node->mChildList.begin(); iter != node->mChildList.end(); ++iter)
+	{
+		writeBinaryNode(*iter, output);
+	}
+}
+
+bool LLXmlTree::parseBinary(const U8* buffer, U32 length)
+{
+	cleanup();
+
+	const U8* cur = buffer;
+	const U8* end = buffer + length;
+	U32 magic, version;
+	if (!read_u32(cur, end, magic) || magic != XML_TREE_BINARY_MAGIC ||
+		!read_u32(cur, end, version) || version != XML_TREE_BINARY_VERSION)
+	{
+		return false;
+	}
+	if (cur == end)
+	{
+		// Empty tree.
+		return true;
+	}
+	mRoot = readBinaryNode(cur, end, NULL, 0);
+	if (!mRoot || cur != end)
+	{
+		LL_WARNS() << "Corrupt binary XML tree." << LL_ENDL;
+		cleanup();
+		return false;
+	}
+	return true;
+}
+
+LLXmlTreeNode* LLXmlTree::readBinaryNode(const U8*& cur, const U8* end, LLXmlTreeNode* parent, S32 depth)
+{
+	std::string name;
+	if (depth > 256 || !read_string(cur, end, name))
+	{
+		return NULL;
+	}
+	LLXmlTreeNode* node = new LLXmlTreeNode(name, parent, this);
+	U32 count;
+	bool ok = read_string(cur, end, node->mContents) && read_u32(cur, end, count) && count <= (U32)(end - cur);
+	std::string value;
+	for (U32 i = 0; ok && i < count; ++i)
+	{
+		ok = read_string(cur, end, name) && read_string(cur, end, value);
+		if (ok)
+		{
+			node->addAttribute(name, value);
+		}
+	}
+	ok = ok && read_u32(cur, end, count) && count <= (U32)(end - cur);
+	for (U32 i = 0; ok && i < count; ++i)
+	{
+		LLXmlTreeNode* child = readBinaryNode(cur, end, node, depth + 1);
+		if (child)
+		{
+			node->addChild(child);
+		}
+		ok = child != NULL;
+	}
+	if (!ok)
+	{
+		delete node;
+		return NULL;
+	}
+	return node;
+}
+
+
 //////////////////////////////////////////////////////////////
 // LLXmlTreeNode
 
@@ -69,6 +69,12 @@ public:
 	void write(std::string &buffer) const;
 	void writeNode(LLXmlTreeNode *node, std::string &buffer, const std::string &indent) const;
 
+	// Compact binary form of the tree, for on-disk caches. parseBinary()
+	// rebuilds the tree from it without running expat; it returns false if
+	// the data is corrupt or of an older format.
+	void writeBinary(std::string& output) const;
+	bool parseBinary(const U8* buffer, U32 length);
+
 	static LLStdStringHandle addAttributeString( const std::string& name)
 	{
 		return sAttributeKeys.addString( name );
@@ -78,6 +84,10 @@ public:
 	// global
 	static LLStdStringTable sAttributeKeys;
 	
+private:
+	void writeBinaryNode(LLXmlTreeNode* node, std::string& output) const;
+	LLXmlTreeNode* readBinaryNode(const U8*& cur, const U8* end, LLXmlTreeNode* parent, S32 depth);
+
 protected:
 	LLXmlTreeNode* mRoot;
 	LLXmlTreeParser *mParser;
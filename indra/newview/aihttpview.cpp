@@ -67,6 +67,7 @@ class AIServiceBar : public LLView
 
 int const mc_col = number_of_capability_types;				// Maximum connections column.
 int const bw_col = number_of_capability_types + 1;			// Bandwidth column.
+int const ts_col = number_of_capability_types + 2;			// Transfer statistics column.
 
 void AIServiceBar::draw()
 {
@@ -84,6 +85,7 @@ void AIServiceBar::draw()
   int established_connections;
   int concurrent_connections;
   size_t bandwidth;
+  AIPerService::TransferStats transfer_stats;
   {
 	PerService_rat per_service_r(*mPerService);
 	is_used = per_service_r->is_used();
@@ -93,6 +95,7 @@ void AIServiceBar::draw()
 	established_connections = per_service_r->mEstablishedConnections;
 	concurrent_connections = per_service_r->mConcurrentConnections;
 	bandwidth = per_service_r->bandwidth().truncateData(AIHTTPView::getTime_40ms());
+	transfer_stats = per_service_r->transfer_stats();
 	cts = per_service_r->mCapabilityType;	// Not thread-safe, but we're only reading from it and only using the results to show in a debug console.
   }
   for (int col = 0; col < number_of_capability_types; ++col)
@@ -171,6 +174,21 @@ void AIServiceBar::draw()
   start += LLFontGL::getFontMonospace()->getWidth(text);
   text = llformat("/%lu", max_bandwidth / 125);
   LLFontGL::getFontMonospace()->renderUTF8(text, 0, start, height, text_color, LLFontGL::LEFT, LLFontGL::TOP);
+  start += LLFontGL::getFontMonospace()->getWidth(text);
+  start = mHTTPView->updateColumn(ts_col, start);
+  U32 transfers = transfer_stats.transfers();
+  if (transfers == 0)
+  {
+	text = " | ";
+  }
+  else
+  {
+	// Received body size as percentage of the decoded size, kB decoded, new/reused connections and average time to first byte.
+	U32 wire_percentage = transfer_stats.mBytesDecoded ? (U32)(100 * transfer_stats.mBytesOnWire / transfer_stats.mBytesDecoded) : 100;
+	text = llformat(" | %u%% of %llu,%u/%u,%.0f", wire_percentage, transfer_stats.mBytesDecoded / 1024,
+		transfer_stats.mNewConnections, transfer_stats.mReusedConnections, transfer_stats.mTimeToFirstByte * 1000.0 / transfers);
+  }
+  LLFontGL::getFontMonospace()->renderUTF8(text, 0, start, height, text_color, LLFontGL::LEFT, LLFontGL::TOP);
 }
 
 LLRect AIServiceBar::getRequiredRect(void)
@@ -223,6 +241,10 @@ void AIGLHTTPHeaderBar::draw(void)
   text = " | Tot/Max BW (kbit/s)";
   start = mHTTPView->updateColumn(bw_col, start);
   LLFontGL::getFontMonospace()->renderUTF8(text, 0, start, height, LLColor4::green, LLFontGL::LEFT, LLFontGL::TOP);
+  start += LLFontGL::getFontMonospace()->getWidth(text);
+  text = " | Wire% of kB,new/reused,TTFB ms";
+  start = mHTTPView->updateColumn(ts_col, start);
+  LLFontGL::getFontMonospace()->renderUTF8(text, 0, start, height, LLColor4::green, LLFontGL::LEFT, LLFontGL::TOP);
   mHTTPView->setWidth(start + LLFontGL::getFontMonospace()->getWidth(text) + h_offset);
 
   // Second header line.
@@ -38,6 +38,7 @@
 #include "llfiltereditor.h"
 #include "llscrolllistctrl.h"
 #include "llscrolllistitem.h"
+#include "llscrolllistrowmodel.h"
 #include "lluictrlfactory.h"
 
 #include "llagent.h"
@@ -48,8 +49,54 @@
 const std::string request_string = "JCFloaterAreaSearch::Requested_\xF8\xA7\xB5";
 const F32 min_refresh_interval = 0.25f;	// Minimum interval between list refreshes in seconds.
 
+class JCFloaterAreaSearch::ResultRowModel : public LLScrollListRowModel
+{
+public:
+	ResultRowModel(const boost::unordered_map<LLUUID, ObjectData>& objects) : mObjects(objects) {}
+
+	/*virtual*/ void buildRow(const LLSD& value, LLScrollListItem::Params& row) const
+	{
+		row.value = value;
+		row.columns.add().column("Name").value(getKey(value, "Name"));
+		row.columns.add().column("Description").value(getKey(value, "Description"));
+		row.columns.add().column("Owner").value(getKey(value, "Owner"));
+		row.columns.add().column("Group").value(getKey(value, "Group"));
+	}
+
+	/*virtual*/ std::string getKey(const LLSD& value, const std::string& column) const
+	{
+		std::string text;
+		const auto& it = mObjects.find(value.asUUID());
+		if (it == mObjects.end())
+		{
+			return text;
+		}
+		if (column == "Name")
+		{
+			text = it->second.name;
+		}
+		else if (column == "Description")
+		{
+			text = it->second.desc;
+		}
+		else if (column == "Owner")
+		{
+			gCacheName->getFullName(it->second.owner_id, text);
+		}
+		else if (column == "Group")
+		{
+			gCacheName->getGroupName(it->second.group_id, text);
+		}
+		return text;
+	}
+
+private:
+	const boost::unordered_map<LLUUID, ObjectData>& mObjects;
+};
+
 JCFloaterAreaSearch::JCFloaterAreaSearch(const LLSD& data) :
 	LLFloater(),
+	mRowModel(new ResultRowModel(mCachedObjects)),
 	mCounterText(0),
 	mResultList(0),
 	mLastRegion(0),
@@ -78,6 +125,7 @@ void JCFloaterAreaSearch::close(bool app)
 BOOL JCFloaterAreaSearch::postBuild()
 {
 	mResultList = getChild<LLScrollListCtrl>("result_list");
+	mResultList->setRowModel(mRowModel.get());
 	mResultList->setDoubleClickCallback(boost::bind(&JCFloaterAreaSearch::onDoubleClick,this));
 	mResultList->sortByColumn("Name", TRUE);
 	auto tp = getChild<LLButton>("TP");
@@ -210,6 +258,7 @@ void JCFloaterAreaSearch::results()
 	uuid_vec_t selected = mResultList->getSelectedIDs();
 	S32 scrollpos = mResultList->getScrollPos();
 	mResultList->deleteAllItems();
+	std::vector<LLSD> rows;
 	S32 i;
 	S32 total = gObjectList.getNumObjects();
 
@@ -236,8 +285,6 @@ void JCFloaterAreaSearch::results()
 						gCacheName->getFullName(it->second.owner_id, object_owner);
 						gCacheName->getGroupName(it->second.group_id, object_group);
 						//LL_INFOS() << "both names are loaded or aren't needed" << LL_ENDL;
-						std::string onU = object_owner;
-						std::string cnU = object_group;
 						LLStringUtil::toLower(object_name);
 						LLStringUtil::toLower(object_desc);
 						LLStringUtil::toLower(object_owner);
@@ -248,21 +295,7 @@ void JCFloaterAreaSearch::results()
 							(mFilterStrings[LIST_OBJECT_GROUP].empty() || object_group.find(mFilterStrings[LIST_OBJECT_GROUP]) != std::string::npos))
 						{
 							//LL_INFOS() << "pass" << LL_ENDL;
-							LLSD element;
-							element["id"] = object_id;
-							element["columns"][LIST_OBJECT_NAME]["column"] = "Name";
-							element["columns"][LIST_OBJECT_NAME]["type"] = "text";
-							element["columns"][LIST_OBJECT_NAME]["value"] = it->second.name;
-							element["columns"][LIST_OBJECT_DESC]["column"] = "Description";
-							element["columns"][LIST_OBJECT_DESC]["type"] = "text";
-							element["columns"][LIST_OBJECT_DESC]["value"] = it->second.desc;
-							element["columns"][LIST_OBJECT_OWNER]["column"] = "Owner";
-							element["columns"][LIST_OBJECT_OWNER]["type"] = "text";
-							element["columns"][LIST_OBJECT_OWNER]["value"] = onU;
-							element["columns"][LIST_OBJECT_GROUP]["column"] = "Group";
-							element["columns"][LIST_OBJECT_GROUP]["type"] = "text";
-							element["columns"][LIST_OBJECT_GROUP]["value"] = cnU;			//ai->second;
-							mResultList->addElement(element, ADD_BOTTOM);
+							rows.push_back(object_id);
 						}
 						
 					}
@@ -271,6 +304,7 @@ void JCFloaterAreaSearch::results()
 		}
 	}
 
+	mResultList->addVirtualRows(rows);
 	mResultList->updateSort();
 	mResultList->selectMultiple(selected);
 	mResultList->setScrollPos(scrollpos);
@@ -92,6 +92,11 @@ private:
 	void teleportToSelected();
 	void lookAtSelected();
 
+	// Builds result rows from mCachedObjects, so the list only holds the
+	// ids of the thousands of objects a region can have.
+	class ResultRowModel;
+	std::unique_ptr<ResultRowModel> mRowModel;
+
 	LLTextBox* mCounterText;
 	LLScrollListCtrl* mResultList;
 	LLFrameTimer mLastUpdateTimer;
@@ -85,6 +85,7 @@
 #include "llviewerstats.h"
 #include "llviewerwindow.h"
 #include "llvoavatarself.h"
+#include "llvocache.h"
 #include "llvoiceclient.h"
 #include "llworld.h"
 #include "llworldmap.h"
@@ -4252,6 +4253,11 @@ void LLAgent::teleportRequest(
 	bool is_local = (region_handle == to_region_handle(getPositionGlobal()));
 	if(regionp && teleportCore(is_local))
 	{
+		if (!is_local && LLVOCache::hasInstance())
+		{
+			// The destination is known already, get its objects ready.
+			LLVOCache::getInstance()->prefetch(region_handle, &pos_local);
+		}
 		LL_INFOS("") << "TeleportLocationRequest: '" << region_handle << "':"
 					 << pos_local << LL_ENDL;
 		LLMessageSystem* msg = gMessageSystem;
@@ -124,6 +124,7 @@
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
 #include "llimageworker.h"
+#include "lljobsystem.h"
 
 // <edit>
 #include "aicurleasyrequeststatemachine.h"
@@ -189,6 +190,7 @@
 #include "lldrawpoolbump.h"
 #include "llvieweraudio.h"
 #include "llimview.h"
+#include "llinventorysearchindex.h"
 #include "llviewerthrottle.h"
 #include "llparcel.h"
 #include "llviewerassetstats.h"
@@ -278,7 +280,7 @@ extern BOOL gRandomizeFramerate;
 extern BOOL gPeriodicSlowFrame;
 extern BOOL gDebugGL;
 
-extern void startEngineThread(void);
+extern void startEngineThread(U32 number_of_threads);
 extern void stopEngineThread(void);
 
 ////////////////////////////////////////////////////////////
@@ -978,6 +980,7 @@ bool LLAppViewer::init()
 	{
 		LLError::setPrintLocation(true);
 	}
+	LLError::setAsyncLogging(gSavedSettings.getBOOL("AsyncLogging"));
 	
 	LLWeb::initClass();			  // do this after LLUI
 
@@ -1760,6 +1763,9 @@ bool LLAppViewer::cleanup()
 		gViewerWindow->shutdownViews();
 
 	LL_INFOS() << "Cleaning up Inventory" << LL_ENDL;
+
+	// Stops the inventory search thread and removes its observer.
+	LLInventorySearch::cleanupClass();
 	
 	// Cleanup Inventory after the UI since it will delete any remaining observers
 	// (Deleted observers should have already removed themselves)
@@ -1955,6 +1961,8 @@ bool LLAppViewer::cleanup()
 	delete sImageDecodeThread;
     sImageDecodeThread = nullptr;
 
+	LLJobSystem::cleanupClass();
+
 
 
 	LL_INFOS() << "Cleaning up Media and Textures" << LL_ENDL;
@@ -2034,6 +2042,9 @@ bool LLAppViewer::cleanup()
 
 	LLError::LLCallStacks::cleanup();
 
+	// Write what is still queued; everything logged from here on is written immediately.
+	LLError::setAsyncLogging(false);
+
 	removeMarkerFiles();
 
 	MEM_TRACK_RELEASE
@@ -2078,8 +2089,8 @@ bool LLAppViewer::initThreads()
 		LLWatchdog::getInstance()->init(watchdog_killer_callback);
 	}
 
-	// State machine thread.
-	startEngineThread();
+	// State machine thread(s).
+	startEngineThread(gSavedSettings.getU32("StateMachineThreads"));
 
 	AICurlInterface::startCurlThread(&gSavedSettings);
 
@@ -2088,8 +2099,15 @@ bool LLAppViewer::initThreads()
 	LLVFSThread::initClass(enable_threads && false);
 	LLLFSThread::initClass(enable_threads && false);
 
+	// Shared worker threads for background jobs.
+	if (enable_threads)
+	{
+		LLJobSystem::instance().start(gSavedSettings.getS32("JobSystemWorkers"));
+	}
+
 	// Image decoding
-	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
+	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true,
+															  enable_threads ? llmax(gSavedSettings.getS32("ImageDecodeJobs"), 0) : 0);
 	LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
 	LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(),
 													sImageDecodeThread,
@@ -2954,6 +2972,9 @@ void LLAppViewer::handleViewerCrash()
 	//print out recorded call stacks if there are any.
 	LLError::LLCallStacks::print();
 
+	// Make sure the messages that led up to the crash end up in the log.
+	LLError::flushAsyncLog();
+
 	LLAppViewer* pApp = LLAppViewer::instance();
 	if (pApp->beingDebugged())
 	{
@@ -4097,6 +4118,11 @@ void LLAppViewer::idle()
 		gMainThreadEngine.mainloop();
 	}
 
+	{
+		LAZY_FT("LLJobSystem::updateMainThread");
+		LLJobSystem::instance().updateMainThread(5.f);
+	}
+
 	// Must wait until both have avatar object and mute list, so poll
 	// here.
 	{
@@ -4325,6 +4351,11 @@ void LLAppViewer::idle()
 		{
 			gObjectList.update(gAgent, *LLWorld::getInstance());
 		}
+
+		if (LLVOCache::hasInstance())
+		{
+			LLVOCache::getInstance()->updatePrefetches(gObjectList.mNumNewObjects, gObjectList.getNumStagedUpdates());
+		}
 	}
 
 	//////////////////////////////////////
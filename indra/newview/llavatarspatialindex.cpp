@@ -0,0 +1,244 @@
+/** 
+ * @file llavatarspatialindex.cpp
+ * @brief Grid index of the avatars reported by coarse location updates.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llavatarspatialindex.h"
+
+#include "llviewerregion.h"
+
+LLVector3d unpackLocalToGlobalPosition(U32 compact_local, const LLVector3d& origin);
+
+const F64 LLAvatarSpatialIndex::CELL_SIZE = 64.0;
+
+LLAvatarSpatialIndex::LLAvatarSpatialIndex()
+:	mUpdateStamp(0)
+{
+}
+
+// static
+U64 LLAvatarSpatialIndex::getCellKey(const LLVector3d& pos_global)
+{
+	const S32 x = (S32)floor(pos_global.mdV[VX] / CELL_SIZE);
+	const S32 y = (S32)floor(pos_global.mdV[VY] / CELL_SIZE);
+	return ((U64)(U32)x << 32) | (U32)y;
+}
+
+void LLAvatarSpatialIndex::updateRegion(const LLViewerRegion* region)
+{
+	updateRegion(region->getHandle(), region->getOriginGlobal(), region->mMapAvatars, region->mMapAvatarIDs);
+}
+
+void LLAvatarSpatialIndex::updateRegion(U64 region_handle, const LLVector3d& origin_global,
+										const std::vector<U32>& locations, const uuid_vec_t& ids)
+{
+	// Old style messages carry no agent data, there is nothing to key those on.
+	const size_t count = llmin(locations.size(), ids.size());
+
+	++mUpdateStamp;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (ids[i].notNull())
+		{
+			setPosition(ids[i], unpackLocalToGlobalPosition(locations[i], origin_global), region_handle);
+		}
+	}
+
+	// Whoever this region reported last time but not now has left it.
+	uuid_vec_t& previous = mRegionAvatars[region_handle];
+	uuid_vec_t departed;
+	for (const LLUUID& id : previous)
+	{
+		entry_map_t::const_iterator it = mEntries.find(id);
+		if (it != mEntries.end() && it->second.mRegionHandle == region_handle && it->second.mSeen != mUpdateStamp)
+		{
+			departed.push_back(id);
+		}
+	}
+	previous.assign(ids.begin(), ids.begin() + count);
+
+	if (departed.empty()) return;
+
+	for (const LLUUID& id : departed)
+	{
+		// The previous list may have named an avatar twice.
+		entry_map_t::iterator it = mEntries.find(id);
+		if (it == mEntries.end()) continue;
+
+		// Avatars crossing into a neighbour that has not sent its own update
+		// yet are still in that neighbour's last list: hand them over instead
+		// of reporting them gone and back again.
+		bool handed_over = false;
+		for (const auto& region : mRegionAvatars)
+		{
+			if (region.first != region_handle &&
+				std::find(region.second.begin(), region.second.end(), id) != region.second.end())
+			{
+				it->second.mRegionHandle = region.first;
+				handed_over = true;
+				break;
+			}
+		}
+
+		if (!handed_over)
+		{
+			erase(it);
+		}
+	}
+}
+
+void LLAvatarSpatialIndex::removeRegion(U64 region_handle)
+{
+	auto region = mRegionAvatars.find(region_handle);
+	if (region == mRegionAvatars.end()) return;
+
+	uuid_vec_t ids;
+	ids.swap(region->second);
+	mRegionAvatars.erase(region);
+
+	for (const LLUUID& id : ids)
+	{
+		entry_map_t::iterator it = mEntries.find(id);
+		if (it != mEntries.end() && it->second.mRegionHandle == region_handle)
+		{
+			erase(it);
+		}
+	}
+}
+
+const LLAvatarSpatialIndex::Entry* LLAvatarSpatialIndex::find(const LLUUID& id) const
+{
+	entry_map_t::const_iterator it = mEntries.find(id);
+	return it != mEntries.end() ? &it->second : NULL;
+}
+
+void LLAvatarSpatialIndex::getAvatarsInRange(const LLVector3d& center, F32 radius, uuid_vec_t& ids,
+											 std::vector<LLVector3d>* positions) const
+{
+	const F64 radius_squared = (F64)radius * radius;
+
+	const U64 min_cell = getCellKey(center - LLVector3d(radius, radius, 0.0));
+	const U64 max_cell = getCellKey(center + LLVector3d(radius, radius, 0.0));
+	const S32 min_x = (S32)(min_cell >> 32), max_x = (S32)(max_cell >> 32);
+	const S32 min_y = (S32)(U32)min_cell, max_y = (S32)(U32)max_cell;
+	const F64 cells = ((F64)max_x - min_x + 1) * ((F64)max_y - min_y + 1);
+
+	// Huge radii would visit mostly empty cells, walking the entries is cheaper then.
+	if (cells > (F64)mCells.size())
+	{
+		for (const auto& entry : mEntries)
+		{
+			if (dist_vec_squared(entry.second.mPosGlobal, center) <= radius_squared)
+			{
+				ids.push_back(entry.first);
+				if (positions) positions->push_back(entry.second.mPosGlobal);
+			}
+		}
+		return;
+	}
+
+	for (S32 x = min_x; x <= max_x; ++x)
+	{
+		for (S32 y = min_y; y <= max_y; ++y)
+		{
+			auto cell = mCells.find(((U64)(U32)x << 32) | (U32)y);
+			if (cell == mCells.end()) continue;
+
+			for (const LLUUID& id : cell->second)
+			{
+				const Entry& entry = mEntries.find(id)->second;
+				if (dist_vec_squared(entry.mPosGlobal, center) <= radius_squared)
+				{
+					ids.push_back(id);
+					if (positions) positions->push_back(entry.mPosGlobal);
+				}
+			}
+		}
+	}
+}
+
+boost::signals2::connection LLAvatarSpatialIndex::setChangeCallback(const change_signal_t::slot_type& cb)
+{
+	return mChangeSignal.connect(cb);
+}
+
+void LLAvatarSpatialIndex::setPosition(const LLUUID& id, const LLVector3d& pos_global, U64 region_handle)
+{
+	const U64 cell = getCellKey(pos_global);
+	auto inserted = mEntries.emplace(id, Entry());
+	Entry& entry = inserted.first->second;
+	entry.mRegionHandle = region_handle;
+	entry.mSeen = mUpdateStamp;
+
+	if (inserted.second)
+	{
+		entry.mPosGlobal = pos_global;
+		entry.mCell = cell;
+		mCells[cell].push_back(id);
+		mChangeSignal(id, AVATAR_ADDED);
+	}
+	else if (entry.mPosGlobal != pos_global)
+	{
+		entry.mPosGlobal = pos_global;
+		if (entry.mCell != cell)
+		{
+			removeFromCell(entry.mCell, id);
+			entry.mCell = cell;
+			mCells[cell].push_back(id);
+		}
+		mChangeSignal(id, AVATAR_MOVED);
+	}
+}
+
+void LLAvatarSpatialIndex::erase(entry_map_t::iterator it)
+{
+	const LLUUID id = it->first;
+	removeFromCell(it->second.mCell, id);
+	mEntries.erase(it);
+	mChangeSignal(id, AVATAR_REMOVED);
+}
+
+void LLAvatarSpatialIndex::removeFromCell(U64 cell, const LLUUID& id)
+{
+	auto it = mCells.find(cell);
+	if (it == mCells.end()) return;
+
+	uuid_vec_t& ids = it->second;
+	uuid_vec_t::iterator found = std::find(ids.begin(), ids.end(), id);
+	if (found != ids.end())
+	{
+		*found = ids.back();
+		ids.pop_back();
+	}
+	if (ids.empty())
+	{
+		mCells.erase(it);
+	}
+}
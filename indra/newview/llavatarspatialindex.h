@@ -0,0 +1,110 @@
+/** 
+ * @file llavatarspatialindex.h
+ * @brief Grid index of the avatars reported by coarse location updates.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLAVATARSPATIALINDEX_H
+#define LL_LLAVATARSPATIALINDEX_H
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include <boost/signals2.hpp>
+
+#include "llsingleton.h"
+#include "lluuid.h"
+#include "v3dmath.h"
+
+class LLViewerRegion;
+
+// Keeps every avatar known from the regions' coarse location updates,
+// keyed by UUID and bucketed in a grid of fixed size cells so that range
+// queries only visit the cells they overlap. Each update is reconciled
+// against the previous one from the same region, and listeners are told
+// about avatars that appear, move or leave instead of rescanning the
+// region lists themselves.
+class LLAvatarSpatialIndex : public LLSingleton<LLAvatarSpatialIndex>
+{
+public:
+	enum EChange
+	{
+		AVATAR_ADDED,
+		AVATAR_MOVED,
+		AVATAR_REMOVED
+	};
+	typedef boost::signals2::signal<void (const LLUUID& id, EChange change)> change_signal_t;
+
+	struct Entry
+	{
+		LLVector3d	mPosGlobal;
+		U64			mRegionHandle;	// region whose coarse list last reported the avatar
+		U64			mCell;
+		U32			mSeen;			// update stamp of the last report from mRegionHandle
+	};
+	typedef absl::flat_hash_map<LLUUID, Entry> entry_map_t;
+
+	// Edge of a grid cell, in meters
+	static const F64 CELL_SIZE;
+
+	LLAvatarSpatialIndex();
+
+	// Reconciles the index with the coarse location list of a region.
+	void updateRegion(const LLViewerRegion* region);
+	void updateRegion(U64 region_handle, const LLVector3d& origin_global,
+					  const std::vector<U32>& locations, const uuid_vec_t& ids);
+
+	// Drops all avatars last reported by the region.
+	void removeRegion(U64 region_handle);
+
+	const Entry* find(const LLUUID& id) const;
+	const entry_map_t& getEntries() const { return mEntries; }
+	size_t size() const { return mEntries.size(); }
+
+	// Appends the avatars within radius of center, with their coarse positions if asked.
+	void getAvatarsInRange(const LLVector3d& center, F32 radius, uuid_vec_t& ids,
+						   std::vector<LLVector3d>* positions = NULL) const;
+
+	boost::signals2::connection setChangeCallback(const change_signal_t::slot_type& cb);
+
+private:
+	void setPosition(const LLUUID& id, const LLVector3d& pos_global, U64 region_handle);
+	void erase(entry_map_t::iterator it);
+	void removeFromCell(U64 cell, const LLUUID& id);
+
+	static U64 getCellKey(const LLVector3d& pos_global);
+
+private:
+	entry_map_t		mEntries;
+	absl::flat_hash_map<U64, uuid_vec_t> mCells;
+	// Last coarse list of every region, used to find departures and handoffs
+	absl::flat_hash_map<U64, uuid_vec_t> mRegionAvatars;
+	change_signal_t	mChangeSignal;
+	U32				mUpdateStamp;
+};
+
+#endif // LL_LLAVATARSPATIALINDEX_H
@@ -258,6 +258,7 @@ LLFloaterAvatarList::LLFloaterAvatarList() :  LLFloater(std::string("radar")),
 	mAvatarList(NULL)
 {
 	LLUICtrlFactory::getInstance()->buildFloater(this, "floater_radar.xml");
+	mAvatarIndexConnection = LLAvatarSpatialIndex::instance().setChangeCallback(boost::bind(&LLFloaterAvatarList::onAvatarIndexChanged, this, _1, _2));
 }
 
 LLFloaterAvatarList::~LLFloaterAvatarList()
@@ -271,6 +272,7 @@ LLFloaterAvatarList::~LLFloaterAvatarList()
 	}
 
 	gSavedSettings.setLLSD("RadarSortOrder", sort);
+	mAvatarsByID.clear();
 	mAvatars.clear();
 }
 
@@ -636,7 +638,9 @@ void LLFloaterAvatarList::updateAvatarList(const LLViewerRegion* region, bool fi
 			{
 				// Avatar not there yet, add it
 				if (announce && gAgent.getRegion()->pointInRegionGlobal(position)) announce_keys.push(avid);
-				mAvatars.push_back(LLAvatarListEntryPtr(entry = new LLAvatarListEntry(avid, name, position)));
+				LLAvatarListEntryPtr new_entry(entry = new LLAvatarListEntry(avid, name, position));
+				mAvatars.push_back(new_entry);
+				mAvatarsByID.emplace(avid, new_entry);
 			}
 
 			// Announce position
@@ -676,22 +680,34 @@ void LLFloaterAvatarList::updateAvatarList(const LLViewerRegion* region, bool fi
 	}
 }
 
-void LLFloaterAvatarList::expireAvatarList(const std::list<LLUUID>& ids)
+void LLFloaterAvatarList::onAvatarIndexChanged(const LLUUID& id, LLAvatarSpatialIndex::EChange change)
 {
-	if (!ids.empty())
+	if (change == LLAvatarSpatialIndex::AVATAR_REMOVED && mAvatarsByID.count(id))
 	{
-		uuid_vec_t existing_avs;
-		std::vector<LLViewerRegion*> neighbors;
-		gAgent.getRegion()->getNeighboringRegions(neighbors);
-		for (const LLViewerRegion* region : neighbors)
-			existing_avs.insert(existing_avs.end(), region->mMapAvatarIDs.begin(), region->mMapAvatarIDs.end());
-		for (const LLUUID& id : ids)
+		mDepartedAvatars.push_back(id);
+	}
+}
+
+void LLFloaterAvatarList::removeAvatarEntry(const LLUUID& id)
+{
+	auto it = mAvatarsByID.find(id);
+	if (it == mAvatarsByID.end()) return;
+
+	mAvatars.erase(std::find(mAvatars.begin(), mAvatars.end(), it->second));
+	mAvatarsByID.erase(it);
+}
+
+void LLFloaterAvatarList::expireAvatarList()
+{
+	if (!mDepartedAvatars.empty())
+	{
+		const LLAvatarSpatialIndex& index(LLAvatarSpatialIndex::instance());
+		for (const LLUUID& id : mDepartedAvatars)
 		{
-			if (std::find(existing_avs.begin(), existing_avs.end(), id) != existing_avs.end()) continue; // Now in another region we know.
-			av_list_t::iterator it(std::find_if(mAvatars.begin(), mAvatars.end(), LLAvatarListEntry::uuidMatch(id)));
-			if (it != mAvatars.end())
-				mAvatars.erase(it);
+			if (index.find(id)) continue; // Came back through another region since.
+			removeAvatarEntry(id);
 		}
+		mDepartedAvatars.clear();
 	}
 
 	refreshAvatarList();
@@ -705,15 +721,22 @@ void LLFloaterAvatarList::updateAvatarSorting()
 		mDirtyAvatarSorting = false;
 		if (mAvatars.size() <= 1) return; // Nothing to sort.
 
-		const std::vector<LLScrollListItem*> list = mAvatarList->getAllData();
-		av_list_t::iterator insert_it = mAvatars.begin();
-		for(std::vector<LLScrollListItem*>::const_iterator it = list.begin(); it != list.end(); ++it)
+		// Listed avatars in display order first, then the ones not displayed yet.
+		av_list_t sorted;
+		sorted.reserve(mAvatars.size());
+		uuid_set_t listed;
+		for (const LLScrollListItem* item : mAvatarList->getAllData())
 		{
-			av_list_t::iterator av_it = std::find_if(mAvatars.begin(),mAvatars.end(),LLAvatarListEntry::uuidMatch((*it)->getUUID()));
-			if (av_it == mAvatars.end()) continue;
-			std::iter_swap(insert_it++, av_it);
-			if (insert_it+1 == mAvatars.end()) return; // We've run out of elements to sort
+			auto it = mAvatarsByID.find(item->getUUID());
+			if (it != mAvatarsByID.end() && listed.insert(it->first).second)
+				sorted.push_back(it->second);
 		}
+		for (const auto& entry : mAvatars)
+		{
+			if (!listed.count(entry->getID()))
+				sorted.push_back(entry);
+		}
+		mAvatars.swap(sorted);
 	}
 }
 
@@ -729,13 +752,11 @@ void LLFloaterAvatarList::refreshAvatarList()
 	// Don't update when interface is hidden
 	if (!getVisible()) return;
 
-	// We rebuild the list fully each time it's refreshed
-	// The assumption is that it's faster to refill it and sort than
-	// to rebuild the whole list.
-	uuid_vec_t selected = mAvatarList->getSelectedIDs();
-	S32 scrollpos = mAvatarList->getScrollPos();
-
-	mAvatarList->deleteAllItems();
+	// Rows outlive refreshes: the ones of avatars still around are updated
+	// in place, which also keeps the selection and scroll position as is.
+	absl::flat_hash_map<LLUUID, LLScrollListItem*> rows;
+	for (LLScrollListItem* item : mAvatarList->getAllData())
+		rows.emplace(item->getUUID(), item);
 
 	LLVector3d mypos = gAgent.getPositionGlobal();
 	LLVector3d posagent;
@@ -1054,12 +1075,25 @@ void LLFloaterAvatarList::refreshAvatarList()
 			element.columns.add(viewer);
 		}
 
-		// Add to list
-		mAvatarList->addRow(element);
+		// Add to list, or refresh the row already there
+		auto row = rows.find(av_id);
+		if (row == rows.end())
+		{
+			mAvatarList->addRow(element);
+		}
+		else
+		{
+			mAvatarList->updateRow(row->second, element);
+			rows.erase(row);
+		}
 	}
 
+	// Whatever is left belongs to avatars that are gone
+	for (const auto& row : rows)
+		mAvatarList->deleteSingleItem(mAvatarList->getItemIndex(row.second));
+
 	for (auto& dead : dead_entries)
-		mAvatars.erase(std::remove(mAvatars.begin(), mAvatars.end(), dead), mAvatars.end());
+		removeAvatarEntry(dead->getID());
 
 	if (mAvatars.empty())
 		setTitle(getString("Title"));
@@ -1074,9 +1108,7 @@ void LLFloaterAvatarList::refreshAvatarList()
 
 	// finish
 	mAvatarList->updateSort();
-	mAvatarList->selectMultiple(selected);
-	mAvatarList->setScrollPos(scrollpos);
-	
+
 	mDirtyAvatarSorting = true;
 
 //	LL_INFOS() << "radar refresh: done" << LL_ENDL;
@@ -1180,8 +1212,8 @@ void LLFloaterAvatarList::trackAvatar(const LLAvatarListEntry* entry) const
 
 LLAvatarListEntry* LLFloaterAvatarList::getAvatarEntry(const LLUUID& avatar) const
 {
-	av_list_t::const_iterator iter = std::find_if(mAvatars.begin(),mAvatars.end(),LLAvatarListEntry::uuidMatch(avatar));
-	return (iter != mAvatars.end()) ? iter->get() : NULL;
+	auto iter = mAvatarsByID.find(avatar);
+	return (iter != mAvatarsByID.end()) ? iter->second.get() : NULL;
 }
 
 BOOL LLFloaterAvatarList::handleKeyHere(KEY key, MASK mask)
@@ -1246,10 +1278,10 @@ void LLFloaterAvatarList::setFocusAvatar(const LLUUID& id)
 
 void LLFloaterAvatarList::setFocusAvatarInternal(const LLUUID& id)
 {
-	av_list_t::iterator iter = std::find_if(mAvatars.begin(),mAvatars.end(),LLAvatarListEntry::uuidMatch(id));
-	if (iter == mAvatars.end()) return;
+	LLAvatarListEntry* entry = getAvatarEntry(id);
+	if (!entry) return;
 	removeFocusFromAll();
-	(*iter)->setFocus(true);
+	entry->setFocus(true);
 }
 
 // Simple function to decrement iterators, wrapping back if needed
@@ -28,6 +28,11 @@
 #include <set>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/signals2.hpp>
+
+#include "absl/container/flat_hash_map.h"
+
+#include "llavatarspatialindex.h"
 
 class LLFloaterAvatarList;
 
@@ -126,13 +131,6 @@ enum ACTIVITY_TYPE
 
 	void setMarked(bool marked) { mMarked = marked; }
 
-	struct uuidMatch
-	{
-		uuidMatch(const LLUUID& id) : mID(id) {}
-		bool operator()(const boost::shared_ptr<LLAvatarListEntry>& l) { return l->getID() == mID; }
-		LLUUID mID;
-	};
-
 private:
 	friend class LLFloaterAvatarList;
 
@@ -207,6 +205,8 @@ public:
 
 	/**
 	 * @brief Refresh avatar list (display)
+	 * Rows of avatars already listed are updated in place, only new and
+	 * departed avatars insert or remove rows.
 	 */
 	void refreshAvatarList();
 
@@ -313,8 +313,10 @@ public:
 	 * This lets dead entries remain for some time. This makes it possible
 	 * to keep people passing by in the list long enough that it's possible
 	 * to do something to them.
+	 * Dead entries are the ones the avatar index reported gone since the
+	 * last call and which have not come back in the meantime.
 	 */
-	void expireAvatarList(const std::list<LLUUID>& ids);
+	void expireAvatarList();
 	void updateAvatarSorting();
 	static bool isCleanup()
 	{
@@ -324,12 +326,17 @@ public:
 
 private:
 	void setFocusAvatarInternal(const LLUUID& id);
+	void onAvatarIndexChanged(const LLUUID& id, LLAvatarSpatialIndex::EChange change);
+	void removeAvatarEntry(const LLUUID& id);
 
 	/**
 	 * @brief Pointer to the avatar scroll list
 	 */
 	LLScrollListCtrl*			mAvatarList;
 	av_list_t	mAvatars;
+	absl::flat_hash_map<LLUUID, LLAvatarListEntryPtr> mAvatarsByID;
+	uuid_vec_t	mDepartedAvatars;
+	boost::signals2::scoped_connection mAvatarIndexConnection;
 	bool		mDirtyAvatarSorting;
 	bool		mCleanup = false;
 
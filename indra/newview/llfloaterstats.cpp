@@ -45,6 +45,7 @@
 #include "pipeline.h"
 #include "llviewerobjectlist.h"
 #include "llviewertexturelist.h"
+#include "llvocache.h"
 #include "lltexturefetch.h"
 #include "sgmemstat.h"
 
@@ -198,7 +199,52 @@ void LLFloaterStats::buildStats()
 		params.mTickSpacing = 20.f;
 		params.mLabelSpacing = 20.f;
 		params.mPerSec = FALSE;
-		render_statviewp->addStat("Object Cache Hit Rate", &(LLViewerStats::getInstance()->mNumNewObjectsStat), params, std::string(), false, true);
+		render_statviewp->addStat("Object Cache Hit Rate", &(LLViewerObjectList::sCacheHitRate), params, std::string(), false, true);
+	}
+
+	{
+		LLStatBar::Parameters params;
+		params.mMinBar = 0.f;
+		params.mMaxBar = 10000.f;
+		params.mTickSpacing = 2500.f;
+		params.mLabelSpacing = 5000.f;
+		params.mPerSec = FALSE;
+		render_statviewp->addStat("Staged Obj Updates", &(LLViewerObjectList::sStagedUpdateCount), params, std::string(), false, true);
+	}
+
+	{
+		LLStatBar::Parameters params;
+		params.mUnitLabel = "msec";
+		params.mMinBar = 0.f;
+		params.mMaxBar = 1000.f;
+		params.mTickSpacing = 100.f;
+		params.mLabelSpacing = 200.f;
+		params.mPerSec = FALSE;
+		params.mDisplayMean = FALSE;
+		render_statviewp->addStat("Obj Update Latency", &(LLViewerObjectList::sStagedUpdateLatency), params, std::string(), false, true);
+	}
+
+	{
+		LLStatBar::Parameters params;
+		params.mUnitLabel = "%";
+		params.mMinBar = 0.f;
+		params.mMaxBar = 100.f;
+		params.mTickSpacing = 20.f;
+		params.mLabelSpacing = 20.f;
+		params.mPerSec = FALSE;
+		render_statviewp->addStat("Cache Prefetch Hits", &(LLVOCache::sPrefetchHitRate), params, std::string(), false, true);
+	}
+
+	{
+		LLStatBar::Parameters params;
+		params.mUnitLabel = "msec";
+		params.mMinBar = 0.f;
+		params.mMaxBar = 20000.f;
+		params.mTickSpacing = 2500.f;
+		params.mLabelSpacing = 5000.f;
+		params.mPerSec = FALSE;
+		params.mDisplayMean = FALSE;
+		render_statviewp->addStat("Arrival to Full Frame", &(LLVOCache::sArrivalTime), params, std::string(), false, true);
 	}
 
 	// Texture statistics
@@ -551,6 +551,18 @@ void LLFolderView::filter( LLInventoryFilter& filter )
 
 	if (getCompletedFilterGeneration() < filter.getCurrentGeneration())
 	{
+		// Folders can only be skipped when their visibility depends on having matching descendants.
+		static const LLCachedControl<bool> use_search_index(gSavedSettings, "InventorySearchIndex", true);
+		if (use_search_index && filter.hasFilterString()
+			&& filter.getShowFolderState() == LLInventoryFilter::SHOW_NON_EMPTY_FOLDERS)
+		{
+			mSearchResult = LLInventorySearch::instance().getResult(filter.getFilterSubString(), getSearchType());
+		}
+		else
+		{
+			mSearchResult = NULL;
+		}
+
 		mPassedFilter = FALSE;
 		mMinWidth = 0;
 		LLFolderViewFolder::filter(filter);
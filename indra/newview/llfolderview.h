@@ -51,6 +51,7 @@
 #include "lleditmenuhandler.h"
 #include "llfontgl.h"
 #include "llinventoryfilter.h"
+#include "llinventorysearchindex.h"
 #include "lltooldraganddrop.h"
 #include "llviewertexture.h"
 
@@ -141,6 +142,8 @@ public:
 
 	// applies filters to control visibility of items
 	virtual void filter( LLInventoryFilter& filter);
+	// Search index answer for the current filter string, if any; valid during filter().
+	const LLInventorySearchResult* getSearchResult() const { return mSearchResult; }
 
 	// Get the last selected item
 	virtual LLFolderViewItem* getCurSelectedItem( void );
@@ -324,6 +327,7 @@ protected:
 	LLFrameTimer					mSearchTimer;
 	LLWString						mSearchString;
 	LLInventoryFilter				mFilter;
+	LLInventorySearchResultPtr		mSearchResult;
 	LLFrameTimer					mMultiSelectionFadeTimer;
 	S32								mArrangeGeneration;
 
@@ -313,6 +313,11 @@ void LLFolderViewItem::refresh()
 		}
 	}
 
+	if (mListener)
+	{
+		LLInventorySearch::instance().updateLabel(mListener->getUUID(), mSearchableLabel, mSearchableLabelDesc, mSearchableLabelCreator);
+	}
+
 	mLabelWidthDirty = true;
 }
 
@@ -1455,6 +1460,18 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 		return;
 	}
 
+	// the search index knows none of our descendants contain the filter string,
+	// so none of them can pass; don't visit them
+	const LLInventorySearchResult* search_result = getRoot()->getSearchResult();
+	if (search_result && mListener
+		&& !getFiltered(filter_generation)
+		&& !search_result->mayContainMatches(mListener->getUUID()))
+	{
+		filter.decrementFilterCount();
+		setCompletedFilterGeneration(filter_generation, FALSE/*dont recurse up to root*/);
+		return;
+	}
+
 	// when applying a filter, matching folders get their contents downloaded first
 	if (filter.isNotDefault()
 		&& getFiltered(filter.getFirstSuccessGeneration())
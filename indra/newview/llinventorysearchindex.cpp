@@ -0,0 +1,628 @@
+/** 
+ * @file llinventorysearchindex.cpp
+ * @brief Inverted index over inventory labels used to speed up filter-as-you-type
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchindex.h"
+
+#include "llcachename.h"
+#include "llinventorymodel.h"
+#include "llviewerinventory.h"
+
+// Number of distinct labels remembered per object.
+static const size_t MAX_LABELS = 4;
+// Posting lists are only rebuilt when at least this many stale entries piled up.
+static const size_t MIN_STALE_POSTINGS = 4096;
+// Number of query results kept around for reuse while typing.
+static const size_t MAX_CACHED_RESULTS = 8;
+
+static LLTrace::BlockTimerStatHandle FTM_INVENTORY_SEARCH_QUERY("Inventory Search Query");
+static LLTrace::BlockTimerStatHandle FTM_INVENTORY_SEARCH_RESULTS("Inventory Search Results");
+
+//-----------------------------------------------------------------------------
+// LLInventorySearchIndex
+//-----------------------------------------------------------------------------
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:	mStalePostings(0),
+	mQueryMark(0)
+{
+}
+
+bool LLInventorySearchIndex::update(const LLUUID& id, const std::string& label,
+									const std::string& description, const std::string& creator)
+{
+	U32 entry_index;
+	index_map_t::iterator it = mIndex.find(id);
+	if (it == mIndex.end())
+	{
+		if (mFreeEntries.empty())
+		{
+			entry_index = mEntries.size();
+			mEntries.push_back(Entry());
+		}
+		else
+		{
+			entry_index = mFreeEntries.back();
+			mFreeEntries.pop_back();
+		}
+		mIndex[id] = entry_index;
+		Entry& entry = mEntries[entry_index];
+		entry.mID = id;
+		entry.mAlive = true;
+	}
+	else
+	{
+		entry_index = it->second;
+	}
+
+	Entry& entry = mEntries[entry_index];
+	bool changed = false;
+
+	std::vector<std::string>::iterator label_it = std::find(entry.mLabels.begin(), entry.mLabels.end(), label);
+	if (label_it == entry.mLabels.end())
+	{
+		if (entry.mLabels.size() >= MAX_LABELS)
+		{
+			entry.mLabels.erase(entry.mLabels.begin());
+			++mStalePostings;
+		}
+		entry.mLabels.push_back(label);
+		addPostings(entry_index, label);
+		changed = true;
+	}
+	else if (label_it + 1 != entry.mLabels.end())
+	{
+		// Most recently reported label goes last, so it's the last one to be dropped.
+		std::rotate(label_it, label_it + 1, entry.mLabels.end());
+	}
+
+	if (entry.mDescription != description)
+	{
+		if (!entry.mDescription.empty())
+		{
+			++mStalePostings;
+		}
+		entry.mDescription = description;
+		addPostings(entry_index, description);
+		changed = true;
+	}
+
+	if (entry.mCreator != creator)
+	{
+		if (!entry.mCreator.empty())
+		{
+			++mStalePostings;
+		}
+		entry.mCreator = creator;
+		addPostings(entry_index, creator);
+		changed = true;
+	}
+
+	if (mStalePostings > MIN_STALE_POSTINGS && mStalePostings > mIndex.size())
+	{
+		rebuildPostings();
+	}
+
+	return changed;
+}
+
+bool LLInventorySearchIndex::remove(const LLUUID& id)
+{
+	index_map_t::iterator it = mIndex.find(id);
+	if (it == mIndex.end())
+	{
+		return false;
+	}
+
+	Entry& entry = mEntries[it->second];
+	entry.mID.setNull();
+	entry.mLabels.clear();
+	entry.mDescription.clear();
+	entry.mCreator.clear();
+	entry.mAlive = false;
+	mFreeEntries.push_back(it->second);
+	mIndex.erase(it);
+	++mStalePostings;
+	return true;
+}
+
+void LLInventorySearchIndex::clear()
+{
+	mEntries.clear();
+	mFreeEntries.clear();
+	mIndex.clear();
+	mPostings.clear();
+	mStalePostings = 0;
+	mQueryMarks.clear();
+}
+
+void LLInventorySearchIndex::addPostings(U32 entry_index, const std::string& text)
+{
+	if (text.size() < 3)
+	{
+		return;
+	}
+	const char* p = text.data();
+	const char* end = p + text.size() - 2;
+	for (; p < end; ++p)
+	{
+		std::vector<U32>& postings = mPostings[trigram(p)];
+		// Repeated trigrams within one string are common ("AAA", "..."); don't store them twice.
+		if (postings.empty() || postings.back() != entry_index)
+		{
+			postings.push_back(entry_index);
+		}
+	}
+}
+
+void LLInventorySearchIndex::rebuildPostings()
+{
+	mPostings.clear();
+	for (U32 i = 0; i < (U32)mEntries.size(); ++i)
+	{
+		const Entry& entry = mEntries[i];
+		if (!entry.mAlive)
+		{
+			continue;
+		}
+		for (std::vector<std::string>::const_iterator it = entry.mLabels.begin(); it != entry.mLabels.end(); ++it)
+		{
+			addPostings(i, *it);
+		}
+		addPostings(i, entry.mDescription);
+		addPostings(i, entry.mCreator);
+	}
+	mStalePostings = 0;
+}
+
+bool LLInventorySearchIndex::matches(const Entry& entry, const std::string& substring, U32 search_type, std::string& buffer) const
+{
+	// Compose the text exactly like LLFolderViewItem::updateSearchLabelType(), once per known label.
+	bool const search_name = !search_type || (search_type & INVENTORY_SEARCH_NAME);
+	std::vector<std::string>::const_iterator it = entry.mLabels.begin();
+	do
+	{
+		buffer.clear();
+		if (search_name && it != entry.mLabels.end())
+		{
+			buffer = *it;
+		}
+		if (search_type & INVENTORY_SEARCH_DESCRIPTION)
+		{
+			if (!buffer.empty())
+			{
+				buffer += " ";
+			}
+			buffer += entry.mDescription;
+		}
+		if (search_type & INVENTORY_SEARCH_CREATOR)
+		{
+			if (!buffer.empty())
+			{
+				buffer += " ";
+			}
+			buffer += entry.mCreator;
+		}
+		if (buffer.find(substring) != std::string::npos)
+		{
+			return true;
+		}
+	}
+	while (search_name && it != entry.mLabels.end() && ++it != entry.mLabels.end());
+	return false;
+}
+
+void LLInventorySearchIndex::queryLinear(const std::string& substring, U32 search_type, uuid_set_t& matches)
+{
+	std::string buffer;
+	for (std::vector<Entry>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		if (it->mAlive && this->matches(*it, substring, search_type, buffer))
+		{
+			matches.insert(it->mID);
+		}
+	}
+}
+
+void LLInventorySearchIndex::query(const std::string& substring, U32 search_type, uuid_set_t& matches)
+{
+	// Spaces can match the separators between name, description and creator, which aren't indexed.
+	S32 const fields = (!search_type || (search_type & INVENTORY_SEARCH_NAME) ? 1 : 0) +
+					   (search_type & INVENTORY_SEARCH_DESCRIPTION ? 1 : 0) +
+					   (search_type & INVENTORY_SEARCH_CREATOR ? 1 : 0);
+	if (substring.size() < 3 || (fields > 1 && substring.find(' ') != std::string::npos))
+	{
+		queryLinear(substring, search_type, matches);
+		return;
+	}
+
+	// Every match contains all trigrams of substring; only verify the entries of the shortest posting list.
+	const std::vector<U32>* candidates = NULL;
+	const char* p = substring.data();
+	const char* end = p + substring.size() - 2;
+	for (; p < end; ++p)
+	{
+		postings_t::const_iterator it = mPostings.find(trigram(p));
+		if (it == mPostings.end())
+		{
+			return;
+		}
+		if (!candidates || it->second.size() < candidates->size())
+		{
+			candidates = &it->second;
+		}
+	}
+
+	// Posting lists can mention an entry more than once after updates; visit each entry once.
+	mQueryMarks.resize(mEntries.size(), 0);
+	if (++mQueryMark == 0)
+	{
+		std::fill(mQueryMarks.begin(), mQueryMarks.end(), 0);
+		mQueryMark = 1;
+	}
+
+	std::string buffer;
+	for (std::vector<U32>::const_iterator it = candidates->begin(); it != candidates->end(); ++it)
+	{
+		U32 const entry_index = *it;
+		if (mQueryMarks[entry_index] == mQueryMark)
+		{
+			continue;
+		}
+		mQueryMarks[entry_index] = mQueryMark;
+		const Entry& entry = mEntries[entry_index];
+		if (entry.mAlive && this->matches(entry, substring, search_type, buffer))
+		{
+			matches.insert(entry.mID);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LLInventorySearchResult
+//-----------------------------------------------------------------------------
+
+bool LLInventorySearchResult::mayContainMatches(const LLUUID& folder_id) const
+{
+	// Folders that aren't part of the inventory model don't get their ancestors recorded.
+	return mAncestors.count(folder_id) || !gInventory.getCategory(folder_id);
+}
+
+//-----------------------------------------------------------------------------
+// LLInventorySearch
+//-----------------------------------------------------------------------------
+
+LLInventorySearch::LLInventorySearch()
+:	mGeneration(1),
+	mThread(NULL),
+	mModelIndexed(false),
+	mRequestedSearchType(0),
+	mRequestedGeneration(0)
+{
+	gInventory.addObserver(this);
+	mThread = new QueryThread(*this);
+	mThread->start();
+}
+
+LLInventorySearch::~LLInventorySearch()
+{
+	if (gInventory.containsObserver(this))
+	{
+		gInventory.removeObserver(this);
+	}
+	delete mThread;
+}
+
+//static
+void LLInventorySearch::cleanupClass()
+{
+	// The query thread must be gone, and we must no longer be observing, before the inventory model is cleaned up.
+	if (instanceExists())
+	{
+		deleteSingleton();
+	}
+}
+
+void LLInventorySearch::changed(U32 mask)
+{
+	if (!mModelIndexed && gInventory.isInventoryUsable())
+	{
+		indexModel();
+	}
+
+	const U32 reindex_mask = LLInventoryObserver::LABEL | LLInventoryObserver::ADD |
+							 LLInventoryObserver::STRUCTURE | LLInventoryObserver::DESCRIPTION;
+	if (!(mask & (reindex_mask | LLInventoryObserver::REMOVE)))
+	{
+		return;
+	}
+
+	bool modified = false;
+	const uuid_set_t& changed_ids = gInventory.getChangedIDs();
+	for (uuid_set_t::const_iterator it = changed_ids.begin(); it != changed_ids.end(); ++it)
+	{
+		LLInventoryObject* obj = gInventory.getObject(*it);
+		if (!obj)
+		{
+			LLMutexLock lock(mIndexMutex);
+			modified |= mSearchIndex.remove(*it);
+		}
+		else if (mask & reindex_mask)
+		{
+			indexObject(obj);
+		}
+	}
+
+	// Moved objects keep their strings, but the folders leading up to them changed;
+	// cached results must collect their ancestors again.
+	if (modified || (mask & (LLInventoryObserver::ADD | LLInventoryObserver::STRUCTURE)))
+	{
+		LLMutexLock lock(mIndexMutex);
+		++mGeneration;
+	}
+}
+
+void LLInventorySearch::indexObject(const LLInventoryObject* obj)
+{
+	// Same strings as LLFolderViewItem::refreshFromListener() computes, except that the
+	// label lacks any suffix; the folder view reports that one when it refreshes.
+	std::string label(obj->getName());
+	LLStringUtil::toUpper(label);
+	std::string description;
+	std::string creator;
+	const LLViewerInventoryItem* item = dynamic_cast<const LLViewerInventoryItem*>(obj);
+	if (item)
+	{
+		description = item->getDescription();
+		LLStringUtil::toUpper(description);
+		if (item->getCreatorUUID().notNull())
+		{
+			gCacheName->getFullName(item->getCreatorUUID(), creator);
+			LLStringUtil::toUpper(creator);
+		}
+	}
+
+	LLMutexLock lock(mIndexMutex);
+	if (mSearchIndex.update(obj->getUUID(), label, description, creator))
+	{
+		++mGeneration;
+	}
+}
+
+// Indexes everything the model holds once it became usable; from then on changed() keeps up.
+void LLInventorySearch::indexModel()
+{
+	mModelIndexed = true;
+
+	const LLUUID* roots[] = { &gInventory.getRootFolderID(), &gInventory.getLibraryRootFolderID() };
+	for (size_t i = 0; i < LL_ARRAY_SIZE(roots); ++i)
+	{
+		if (roots[i]->isNull())
+		{
+			continue;
+		}
+		LLInventoryModel::cat_array_t cats;
+		LLInventoryModel::item_array_t items;
+		gInventory.collectDescendents(*roots[i], cats, items, LLInventoryModel::INCLUDE_TRASH);
+		for (LLInventoryModel::cat_array_t::const_iterator it = cats.begin(); it != cats.end(); ++it)
+		{
+			indexObject(*it);
+		}
+		for (LLInventoryModel::item_array_t::const_iterator it = items.begin(); it != items.end(); ++it)
+		{
+			indexObject(*it);
+		}
+	}
+}
+
+void LLInventorySearch::updateLabel(const LLUUID& id, const std::string& label,
+									const std::string& description, const std::string& creator)
+{
+	if (id.isNull())
+	{
+		return;
+	}
+	LLMutexLock lock(mIndexMutex);
+	if (mSearchIndex.update(id, label, description, creator))
+	{
+		++mGeneration;
+	}
+}
+
+LLInventorySearchResultPtr LLInventorySearch::getResult(const std::string& substring, U32 search_type)
+{
+	processCompleted();
+
+	U32 generation;
+	{
+		LLMutexLock lock(mIndexMutex);
+		generation = mGeneration;
+	}
+
+	// Prefer an exact answer, otherwise the narrowest one for a substring of what we're looking for.
+	LLInventorySearchResultPtr best;
+	for (std::vector<LLInventorySearchResultPtr>::iterator it = mResults.begin(); it != mResults.end(); ++it)
+	{
+		LLInventorySearchResult* result = *it;
+		if (result->mGeneration != generation || !result->covers(substring, search_type))
+		{
+			continue;
+		}
+		if (result->mSubstring == substring)
+		{
+			return result;
+		}
+		if (best.isNull() || result->mSubstring.size() > best->mSubstring.size())
+		{
+			best = result;
+		}
+	}
+
+	if (substring != mRequestedSubstring || search_type != mRequestedSearchType || generation != mRequestedGeneration)
+	{
+		mRequestedSubstring = substring;
+		mRequestedSearchType = search_type;
+		mRequestedGeneration = generation;
+		mThread->submit(new LLInventorySearchResult(substring, search_type));
+	}
+
+	return best;
+}
+
+void LLInventorySearch::runQuery(LLInventorySearchResult& query)
+{
+	LL_RECORD_BLOCK_TIME(FTM_INVENTORY_SEARCH_QUERY);
+	LLMutexLock lock(mIndexMutex);
+	query.mGeneration = mGeneration;
+	mSearchIndex.query(query.mSubstring, query.mSearchType, query.mMatches);
+}
+
+void LLInventorySearch::processCompleted()
+{
+	std::vector<LLInventorySearchResultPtr> completed;
+	if (!mThread->fetchCompleted(completed))
+	{
+		return;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_INVENTORY_SEARCH_RESULTS);
+	for (std::vector<LLInventorySearchResultPtr>::iterator it = completed.begin(); it != completed.end(); ++it)
+	{
+		// The inventory model may only be accessed from the main thread, so the folders
+		// leading up to each match are collected here rather than by the query thread.
+		LLInventorySearchResult* result = *it;
+		for (uuid_set_t::const_iterator match = result->mMatches.begin(); match != result->mMatches.end(); ++match)
+		{
+			LLUUID id = *match;
+			while (id.notNull() && result->mAncestors.insert(id).second)
+			{
+				LLInventoryObject* obj = gInventory.getObject(id);
+				if (!obj)
+				{
+					break;
+				}
+				id = obj->getParentUUID();
+			}
+		}
+		result->mMatches.clear();
+
+		if (mResults.size() >= MAX_CACHED_RESULTS)
+		{
+			mResults.erase(mResults.begin());
+		}
+		mResults.push_back(result);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LLInventorySearch::QueryThread
+//-----------------------------------------------------------------------------
+
+LLInventorySearch::QueryThread::QueryThread(LLInventorySearch& search)
+:	LLThread("Inventory Search"),
+	mSearch(search),
+	mQuitting(false)
+{
+	mSignal = new LLCondition;
+}
+
+LLInventorySearch::QueryThread::~QueryThread()
+{
+	shutdown();
+
+	delete mSignal;
+	mSignal = NULL;
+}
+
+void LLInventorySearch::QueryThread::shutdown()
+{
+	if (mSignal)
+	{
+		mSignal->lock();
+		mQuitting = true;
+		mSignal->signal();
+		// terminated() wakes us up.
+		while (!isStopped())
+		{
+			mSignal->wait();
+		}
+		mSignal->unlock();
+	}
+}
+
+void LLInventorySearch::QueryThread::terminated()
+{
+	mSignal->lock();
+	LLThread::terminated();
+	mSignal->broadcast();
+	mSignal->unlock();
+}
+
+void LLInventorySearch::QueryThread::submit(LLInventorySearchResultPtr query)
+{
+	LLMutexLock lock(mSignal);
+	mPendingQuery = query;
+	mSignal->signal();
+}
+
+bool LLInventorySearch::QueryThread::fetchCompleted(std::vector<LLInventorySearchResultPtr>& completed)
+{
+	LLMutexLock lock(mSignal);
+	if (mCompletedQueries.empty())
+	{
+		return false;
+	}
+	completed.swap(mCompletedQueries);
+	return true;
+}
+
+void LLInventorySearch::QueryThread::run()
+{
+	mSignal->lock();
+	while (!mQuitting)
+	{
+		if (mPendingQuery.isNull())
+		{
+			mSignal->wait();
+			continue;
+		}
+
+		LLInventorySearchResultPtr query = mPendingQuery;
+		mPendingQuery = NULL;
+		mSignal->unlock();
+
+		mSearch.runQuery(*query);
+
+		mSignal->lock();
+		mCompletedQueries.push_back(query);
+	}
+	mSignal->unlock();
+}
@@ -0,0 +1,205 @@
+/** 
+ * @file llinventorysearchindex.h
+ * @brief Inverted index over inventory labels used to speed up filter-as-you-type
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include <boost/unordered_map.hpp>
+
+#include "llinventoryobserver.h"
+#include "llpointer.h"
+#include "llsingleton.h"
+#include "llthread.h"
+#include "lluuid.h"
+
+class LLInventoryObject;
+
+// Search type bits, as in LLFolderView::getSearchType().
+enum EInventorySearchType
+{
+	INVENTORY_SEARCH_NAME = 1,
+	INVENTORY_SEARCH_DESCRIPTION = 2,
+	INVENTORY_SEARCH_CREATOR = 4
+};
+
+//-----------------------------------------------------------------------------
+// LLInventorySearchIndex
+//
+// Trigram index over the (upper case) label, description and creator name of
+// inventory objects. Not thread-safe by itself; LLInventorySearch below wraps
+// it for use from the main thread and its query thread.
+//-----------------------------------------------------------------------------
+class LLInventorySearchIndex
+{
+public:
+	LLInventorySearchIndex();
+
+	// Returns true if anything changed. Strings must already be upper case.
+	// The last few distinct labels are all kept, because inventory panels with
+	// and without label suffixes report different labels for the same object.
+	bool update(const LLUUID& id, const std::string& label,
+				const std::string& description, const std::string& creator);
+	bool remove(const LLUUID& id);
+	void clear();
+
+	// Collects every object whose searchable text, composed like
+	// LLFolderViewItem::updateSearchLabelType() does, contains substring.
+	void query(const std::string& substring, U32 search_type, uuid_set_t& matches);
+
+	size_t size() const { return mIndex.size(); }
+
+private:
+	struct Entry
+	{
+		LLUUID mID;
+		std::vector<std::string> mLabels;
+		std::string mDescription;
+		std::string mCreator;
+		bool mAlive;
+	};
+
+	void addPostings(U32 entry_index, const std::string& text);
+	void rebuildPostings();
+	bool matches(const Entry& entry, const std::string& substring, U32 search_type, std::string& buffer) const;
+	void queryLinear(const std::string& substring, U32 search_type, uuid_set_t& matches);
+
+	static U32 trigram(const char* p) { return ((U32)(U8)p[0] << 16) | ((U32)(U8)p[1] << 8) | (U32)(U8)p[2]; }
+
+	typedef boost::unordered_map<LLUUID, U32> index_map_t;
+	typedef boost::unordered_map<U32, std::vector<U32> > postings_t;
+
+	std::vector<Entry> mEntries;
+	std::vector<U32> mFreeEntries;
+	index_map_t mIndex;
+	// Posting lists are append-only; entries that no longer contain a trigram are
+	// weeded out when matching, and the lists are rebuilt once enough edits piled up.
+	postings_t mPostings;
+	size_t mStalePostings;
+	std::vector<U32> mQueryMarks;
+	U32 mQueryMark;
+};
+
+//-----------------------------------------------------------------------------
+// LLInventorySearchResult
+//-----------------------------------------------------------------------------
+class LLInventorySearchResult : public LLThreadSafeRefCount
+{
+public:
+	LLInventorySearchResult(const std::string& substring, U32 search_type)
+	:	mSubstring(substring), mSearchType(search_type), mGeneration(0) { }
+
+	// False only if folder_id is known to have no descendants matching mSubstring.
+	bool mayContainMatches(const LLUUID& folder_id) const;
+
+	// A result for a substring of the current filter string is still a superset of the real matches.
+	bool covers(const std::string& substring, U32 search_type) const
+	{
+		return search_type == mSearchType && substring.find(mSubstring) != std::string::npos;
+	}
+
+	const std::string mSubstring;
+	const U32 mSearchType;
+	U32 mGeneration;			// Index generation the matches are valid for, set by the query thread.
+	uuid_set_t mMatches;		// Filled by the query thread.
+	uuid_set_t mAncestors;		// Matches and all their ancestors, filled by the main thread.
+};
+typedef LLPointer<LLInventorySearchResult> LLInventorySearchResultPtr;
+
+//-----------------------------------------------------------------------------
+// LLInventorySearch
+//
+// Keeps an LLInventorySearchIndex up to date from LLInventoryModel changes and
+// folder view labels, and answers filter string queries on a worker thread.
+// LLFolderViewFolder::filter uses the answers to skip whole folders that
+// can't contain anything passing the filter string.
+//-----------------------------------------------------------------------------
+class LLInventorySearch : public LLSingleton<LLInventorySearch>, public LLInventoryObserver
+{
+	friend class LLSingleton<LLInventorySearch>;
+	LLInventorySearch();
+	~LLInventorySearch();
+
+public:
+	static void cleanupClass();
+
+	/*virtual*/ void changed(U32 mask);
+
+	// Called by folder view items whenever their searchable strings were recomputed.
+	void updateLabel(const LLUUID& id, const std::string& label,
+					 const std::string& description, const std::string& creator);
+
+	// Returns the best available result for the filter string, or NULL if there is none yet.
+	// Queues a query for the exact string if needed; call again on the next frame.
+	LLInventorySearchResultPtr getResult(const std::string& substring, U32 search_type);
+
+private:
+	class QueryThread : public LLThread
+	{
+	public:
+		QueryThread(LLInventorySearch& search);
+		~QueryThread();
+
+		/*virtual*/ void run();
+		/*virtual*/ void shutdown();
+		/*virtual*/ void terminated();
+
+		// Replaces any query that didn't start yet.
+		void submit(LLInventorySearchResultPtr query);
+		// Moves finished queries to completed; returns false if there were none.
+		bool fetchCompleted(std::vector<LLInventorySearchResultPtr>& completed);
+
+	private:
+		LLInventorySearch& mSearch;
+		LLCondition* mSignal;		// Protects the members below.
+		bool mQuitting;
+		LLInventorySearchResultPtr mPendingQuery;
+		std::vector<LLInventorySearchResultPtr> mCompletedQueries;
+	};
+
+	void indexObject(const LLInventoryObject* obj);
+	void indexModel();
+	void runQuery(LLInventorySearchResult& query);
+	void processCompleted();
+
+	LLMutex mIndexMutex;					// Protects mSearchIndex and mGeneration.
+	LLInventorySearchIndex mSearchIndex;
+	U32 mGeneration;						// Bumped on every change to the index.
+
+	QueryThread* mThread;
+
+	// Main thread only.
+	std::vector<LLInventorySearchResultPtr> mResults;
+	bool mModelIndexed;
+	std::string mRequestedSubstring;
+	U32 mRequestedSearchType;
+	U32 mRequestedGeneration;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
@@ -179,6 +179,8 @@ const S32 CIRCLE_STEPS = 100;
 
 const F64 COARSEUPDATE_MAX_Z = 1020.0f;
 
+const F32 OBJECT_LAYER_REFRESH_PERIOD = 0.1f;	// seconds
+
 std::map<LLUUID, LLVector3d>	LLNetMap::mClosestAgentsToCursor; // <exodus/>
 uuid_vec_t						LLNetMap::mClosestAgentsAtLastClick; // <exodus/>
 
@@ -277,6 +279,7 @@ void LLNetMap::setScale( F32 scale )
 		F32 num_pixels = (F32)mObjectImagep->getWidth();
 		mObjectMapTPM = num_pixels / meters;
 		mObjectMapPixels = diameter;
+		mObjectLayer.setRaster(mObjectRawImagep, mObjectMapTPM);
 	}
 
 	mPixelsPerMeter = mScale / REGION_WIDTH_METERS;
@@ -521,30 +524,18 @@ void LLNetMap::draw()
 		LLVector3d posCenterGlobal = viewPosToGlobal(llfloor(posCenter.mV[VX]), llfloor(posCenter.mV[VY]));
 
 		static LLCachedControl<bool> s_fShowObjects(gSavedSettings, "ShowMiniMapObjects") ;
-		if ( (s_fShowObjects) && ((mUpdateObjectImage) || ((map_timer.getElapsedTimeF32() > 0.5f))) )
+		if (s_fShowObjects)
 		{
-			mUpdateObjectImage = false;
-// [/SL:KB]
-
-//			// Locate the centre of the object layer, accounting for panning
-//			LLVector3 new_center = globalPosToView(gAgentCamera.getCameraPositionGlobal());
-//			new_center.mV[VX] -= mCurPan.mV[VX];
-//			new_center.mV[VY] -= mCurPan.mV[VY];
-//			new_center.mV[VZ] = 0.f;
-//			mObjectImageCenterGlobal = viewPosToGlobal(llfloor(new_center.mV[VX]), llfloor(new_center.mV[VY]));
-// [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3.0)
-			mObjectImageCenterGlobal = posCenterGlobal;
-// [/SL:KB]
-
-			// Create the base texture.
-			U8 *default_texture = mObjectRawImagep->getData();
-			memset( default_texture, 0, mObjectImagep->getWidth() * mObjectImagep->getHeight() * mObjectImagep->getComponents() );
-
-			// Draw objects
-			gObjectList.renderObjectsForMap(*this);
-
-			mObjectImagep->setSubImage(mObjectRawImagep, 0, 0, mObjectImagep->getWidth(), mObjectImagep->getHeight());
-			map_timer.reset();
+			// The object layer only redraws what changed, so it can keep up
+			// with moving objects and the camera much more often than the
+			// full redraw it replaced could.
+			bool refresh = mUpdateObjectImage || map_timer.getElapsedTimeF32() > OBJECT_LAYER_REFRESH_PERIOD;
+			if (refresh && !mObjectLayer.isUpdating())
+			{
+				mUpdateObjectImage = false;
+				map_timer.reset();
+			}
+			updateObjectImage(posCenterGlobal, refresh);
 		}
 
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3.0)
@@ -588,14 +579,16 @@ void LLNetMap::draw()
 		{
 			gGL.getTexUnit(0)->bind(mObjectImagep);
 // [/SL:KB]
+		// The object raster wraps around; start at the texel of its lower left corner.
+		const LLVector2& tex_origin = mObjectLayer.getTexCoordOrigin();
 		gGL.begin(LLRender::TRIANGLE_STRIP);
-			gGL.texCoord2f(0.f, 1.f);
+			gGL.texCoord2f(tex_origin.mV[VX], tex_origin.mV[VY] + 1.f);
 			gGL.vertex2f(map_center_agent.mV[VX] - image_half_width, image_half_height + map_center_agent.mV[VY]);
-			gGL.texCoord2f(0.f, 0.f);
+			gGL.texCoord2f(tex_origin.mV[VX], tex_origin.mV[VY]);
 			gGL.vertex2f(map_center_agent.mV[VX] - image_half_width, map_center_agent.mV[VY] - image_half_height);
-			gGL.texCoord2f(1.f, 1.f);
+			gGL.texCoord2f(tex_origin.mV[VX] + 1.f, tex_origin.mV[VY] + 1.f);
 			gGL.vertex2f(image_half_width + map_center_agent.mV[VX], image_half_height + map_center_agent.mV[VY]);
-			gGL.texCoord2f(1.f, 0.f);
+			gGL.texCoord2f(tex_origin.mV[VX] + 1.f, tex_origin.mV[VY]);
 			gGL.vertex2f(image_half_width + map_center_agent.mV[VX], map_center_agent.mV[VY] - image_half_height);
 		gGL.end();
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-07-26 (Catznip-3.3)
@@ -1081,102 +1074,26 @@ void LLNetMap::updateMinorDirections()
 	mSELabel->setVisible(show_minors);
 }
 
-void LLNetMap::renderScaledPointGlobal( const LLVector3d& pos, const LLColor4U &color, F32 radius_meters )
-{
-	LLVector3 local_pos;
-	local_pos.setVec( pos - mObjectImageCenterGlobal );
-
-	// DEV-17370 - megaprims of size > 4096 cause lag.  (go figger.)
-	const F32 MAX_RADIUS = 256.0f;
-	F32 radius_clamped = llmin(radius_meters, MAX_RADIUS);
-
-	S32 diameter_pixels = ll_round(2 * radius_clamped * mObjectMapTPM);
-	renderPoint( local_pos, color, diameter_pixels );
-}
-
-
-void LLNetMap::renderPoint(const LLVector3 &pos_local, const LLColor4U &color, 
-						   S32 diameter, S32 relative_height)
+void LLNetMap::updateObjectImage(const LLVector3d& center_global, bool refresh)
 {
-	if (diameter <= 0)
-	{
-		return;
-	}
-
-	const S32 image_width = (S32)mObjectImagep->getWidth();
-	const S32 image_height = (S32)mObjectImagep->getHeight();
-
-	S32 x_offset = ll_round(pos_local.mV[VX] * mObjectMapTPM + image_width / 2);
-	S32 y_offset = ll_round(pos_local.mV[VY] * mObjectMapTPM + image_height / 2);
-
-	if ((x_offset < 0) || (x_offset >= image_width))
-	{
-		return;
-	}
-	if ((y_offset < 0) || (y_offset >= image_height))
-	{
-		return;
-	}
-
-	U8 *datap = mObjectRawImagep->getData();
-
-	S32 neg_radius = diameter / 2;
-	S32 pos_radius = diameter - neg_radius;
-	S32 x, y;
-
-	if (relative_height > 0)
+	std::vector<LLRect> dirty_rects;
+	if (mObjectLayer.takeDirtyRects(dirty_rects))
 	{
-		// ...point above agent
-		S32 px, py;
-
-		// vertical line
-		px = x_offset;
-		for (y = -neg_radius; y < pos_radius; y++)
+		for (std::vector<LLRect>::const_iterator rect = dirty_rects.begin(); rect != dirty_rects.end(); ++rect)
 		{
-			py = y_offset + y;
-			if ((py < 0) || (py >= image_height))
-			{
-				continue;
-			}
-			S32 offset = px + py * image_width;
-			((U32*)datap)[offset] = color.mAll;
-		}
-
-		// top line
-		py = y_offset + pos_radius - 1;
-		for (x = -neg_radius; x < pos_radius; x++)
-		{
-			px = x_offset + x;
-			if ((px < 0) || (px >= image_width))
-			{
-				continue;
-			}
-			S32 offset = px + py * image_width;
-			((U32*)datap)[offset] = color.mAll;
+			mObjectImagep->setSubImage(mObjectRawImagep, rect->mLeft, rect->mBottom, rect->getWidth(), rect->getHeight());
 		}
+		mObjectImageCenterGlobal = mObjectLayer.getCenterGlobal();
 	}
-	else
+
+	if (refresh && !mObjectLayer.isUpdating())
 	{
-		// ...point level with agent
-		for (x = -neg_radius; x < pos_radius; x++)
-		{
-			S32 p_x = x_offset + x;
-			if ((p_x < 0) || (p_x >= image_width))
-			{
-				continue;
-			}
+		static const LLCachedControl<U32> delta("MiniMapPrimMaxAltitudeDelta");
+		static const LLCachedControl<U32> delta_own("MiniMapPrimMaxAltitudeDeltaOwn");
+		mObjectLayer.setAltitudeFilter(gAgent.getPositionGlobal().mdV[VZ], delta, delta_own);
 
-			for (y = -neg_radius; y < pos_radius; y++)
-			{
-				S32 p_y = y_offset + y;
-				if ((p_y < 0) || (p_y >= image_height))
-				{
-					continue;
-				}
-				S32 offset = p_x + p_y * image_width;
-				((U32*)datap)[offset] = color.mAll;
-			}
-		}
+		gObjectList.updateObjectsForMap(mObjectLayer);
+		mObjectLayer.update(center_global);
 	}
 }
 
@@ -1321,7 +1238,10 @@ bool LLNetMap::createImage(LLPointer<LLImageRaw>& rawimagep) const
 void LLNetMap::createObjectImage()
 {
 	if (createImage(mObjectRawImagep))
+	{
 		mObjectImagep = LLViewerTextureManager::getLocalTexture( mObjectRawImagep.get(), FALSE);
+		mObjectImagep->setAddressMode(LLTexUnit::TAM_WRAP);
+	}
 	setScale(mScale);
 	mUpdateObjectImage = true;
 }
@@ -34,6 +34,7 @@
 #define LL_LLNETMAP_H
 
 #include "lfidbearer.h"
+#include "llnetmapobjectlayer.h"
 #include "llpanel.h"
 
 
@@ -75,12 +76,10 @@ public:
 	void			refreshParcelOverlay() { mUpdateParcelImage = true; }
 // [/SL:KB]
 	void			setScale( F32 scale );
-	void			renderScaledPointGlobal( const LLVector3d& pos, const LLColor4U &color, F32 radius );
 
 private:
 	const LLVector3d& getObjectImageCenterGlobal()	{ return mObjectImageCenterGlobal; }
-	void renderPoint(const LLVector3 &pos, const LLColor4U &color, 
-					 S32 diameter, S32 relative_height = 0);
+	void			updateObjectImage(const LLVector3d& center_global, bool refresh);
 
 	LLVector3		globalPosToView(const LLVector3d& global_pos);
 	LLVector3d		viewPosToGlobal(S32 x,S32 y);
@@ -141,6 +140,7 @@ private:
 	LLVector3d		mObjectImageCenterGlobal;
 	LLPointer<LLImageRaw> mObjectRawImagep;
 	LLPointer<LLViewerTexture>	mObjectImagep;
+	LLNetMapObjectLayer mObjectLayer;
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3.0)
 	LLVector3d		mParcelImageCenterGlobal;
 	LLPointer<LLImageRaw> mParcelRawImagep;
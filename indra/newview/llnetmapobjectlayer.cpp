@@ -0,0 +1,606 @@
+/** 
+ * @file llnetmapobjectlayer.cpp
+ * @brief Incrementally maintained object layer of the mini map.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llnetmapobjectlayer.h"
+
+#include "lljobsystem.h"
+
+// Side of the square tiles the raster is redrawn and uploaded in.
+static const S32 TILE_SIZE = 32;
+// Megaprims bigger than this would blot out the map (DEV-17370).
+static const F32 MAX_DOT_RADIUS = 256.f;
+
+// Position of v in a raster of the given size that wraps around.
+static inline S32 wrap(S64 v, S32 size)
+{
+	S64 r = v % size;
+	return (S32)(r < 0 ? r + size : r);
+}
+
+//-----------------------------------------------------------------------------
+// LLNetMapObjectLayer::Raster
+//
+// Everything the worker thread touches. The main thread only writes the
+// inputs and reads the results while no update is running.
+//-----------------------------------------------------------------------------
+class LLNetMapObjectLayer::Raster : public LLThreadSafeRefCount
+{
+public:
+	Raster();
+
+	// WORKER THREAD
+	void run();
+
+	bool hasWindow() const { return mHasWindow; }
+
+	// Inputs
+	LLPointer<LLImageRaw> mImage;
+	F32 mTexelsPerMeter;
+	F64 mAltitude;
+	U32 mDelta;
+	U32 mDeltaOwn;
+	bool mRedrawAll;
+	bool mClear;
+	std::vector<Change> mChanges;
+	S64 mOriginX;				// window of world texels the raster holds
+	S64 mOriginY;
+	F64 mCenterZ;
+
+	// Results
+	std::vector<LLRect> mDirtyRects;
+	LLVector3d mCenterGlobal;
+	LLVector2 mTexCoordOrigin;
+
+	// MAIN THREAD
+	bool mBusy;
+
+private:
+	bool getFootprint(const Dot& dot, S64& x0, S64& y0, S64& x1, S64& y1) const;
+	bool clipToWindow(S64& x0, S64& y0, S64& x1, S64& y1) const;
+	bool isVisible(const Dot& dot) const;
+	void dirtyAll();
+	void dirtyRect(S64 x0, S64 y0, S64 x1, S64 y1);
+	void dirtyDot(const Dot& dot);
+	void scroll();
+	void drawDot(const Dot& dot, U32* pixels);
+	void redraw();
+	void collectDirtyRects();
+
+	absl::flat_hash_map<key_t, Dot> mDots;
+	S32 mWidth;
+	S32 mHeight;
+	S32 mTilesX;
+	S32 mTilesY;
+	std::vector<U8> mDirtyTiles;
+	S32 mDirtyTileCount;
+	bool mHasWindow;
+	S64 mWindowX;				// window the raster currently holds
+	S64 mWindowY;
+};
+
+LLNetMapObjectLayer::Raster::Raster()
+:	mTexelsPerMeter(1.f),
+	mAltitude(0.0),
+	mDelta(0),
+	mDeltaOwn(0),
+	mRedrawAll(true),
+	mClear(false),
+	mOriginX(0),
+	mOriginY(0),
+	mCenterZ(0.0),
+	mBusy(false),
+	mWidth(0),
+	mHeight(0),
+	mTilesX(0),
+	mTilesY(0),
+	mDirtyTileCount(0),
+	mHasWindow(false),
+	mWindowX(0),
+	mWindowY(0)
+{
+}
+
+void LLNetMapObjectLayer::Raster::run()
+{
+	if (mClear)
+	{
+		mDots.clear();
+		mClear = false;
+		mRedrawAll = true;
+	}
+
+	if (mImage.isNull())
+	{
+		// Nothing to draw into; just keep the dots up to date.
+		for (std::vector<Change>::const_iterator iter = mChanges.begin(); iter != mChanges.end(); ++iter)
+		{
+			if (iter->mRemove)
+			{
+				mDots.erase(iter->mKey);
+			}
+			else
+			{
+				mDots[iter->mKey] = iter->mDot;
+			}
+		}
+		mChanges.clear();
+		mHasWindow = false;
+		return;
+	}
+
+	if (mImage->getWidth() != mWidth || mImage->getHeight() != mHeight)
+	{
+		mWidth = mImage->getWidth();
+		mHeight = mImage->getHeight();
+		mTilesX = (mWidth + TILE_SIZE - 1) / TILE_SIZE;
+		mTilesY = (mHeight + TILE_SIZE - 1) / TILE_SIZE;
+		mDirtyTiles.assign(mTilesX * mTilesY, 0);
+		mDirtyTileCount = 0;
+		mRedrawAll = true;
+	}
+
+	if (mRedrawAll || !mHasWindow)
+	{
+		mWindowX = mOriginX;
+		mWindowY = mOriginY;
+		mHasWindow = true;
+		dirtyAll();
+		mRedrawAll = false;
+	}
+	else
+	{
+		scroll();
+	}
+
+	// Objects leave their old footprint and draw in their new one.
+	for (std::vector<Change>::const_iterator iter = mChanges.begin(); iter != mChanges.end(); ++iter)
+	{
+		absl::flat_hash_map<key_t, Dot>::iterator dot = mDots.find(iter->mKey);
+		if (dot != mDots.end())
+		{
+			dirtyDot(dot->second);
+			if (iter->mRemove)
+			{
+				mDots.erase(dot);
+				continue;
+			}
+			dot->second = iter->mDot;
+		}
+		else if (iter->mRemove)
+		{
+			continue;
+		}
+		else
+		{
+			mDots[iter->mKey] = iter->mDot;
+		}
+		dirtyDot(iter->mDot);
+	}
+	mChanges.clear();
+
+	if (mDirtyTileCount)
+	{
+		redraw();
+		collectDirtyRects();
+	}
+
+	mCenterGlobal.mdV[VX] = (mWindowX + mWidth / 2) / (F64)mTexelsPerMeter;
+	mCenterGlobal.mdV[VY] = (mWindowY + mHeight / 2) / (F64)mTexelsPerMeter;
+	mCenterGlobal.mdV[VZ] = mCenterZ;
+	mTexCoordOrigin.set((F32)wrap(mWindowX, mWidth) / mWidth, (F32)wrap(mWindowY, mHeight) / mHeight);
+}
+
+bool LLNetMapObjectLayer::Raster::getFootprint(const Dot& dot, S64& x0, S64& y0, S64& x1, S64& y1) const
+{
+	// Same square as LLNetMap used to draw, but in world texels.
+	S32 diameter = ll_round(2.f * llmin(dot.mRadius, MAX_DOT_RADIUS) * mTexelsPerMeter);
+	if (diameter <= 0)
+	{
+		return false;
+	}
+	x0 = (S64)floor(dot.mPosGlobal.mdV[VX] * mTexelsPerMeter + 0.5) - diameter / 2;
+	y0 = (S64)floor(dot.mPosGlobal.mdV[VY] * mTexelsPerMeter + 0.5) - diameter / 2;
+	x1 = x0 + diameter;
+	y1 = y0 + diameter;
+	return true;
+}
+
+bool LLNetMapObjectLayer::Raster::clipToWindow(S64& x0, S64& y0, S64& x1, S64& y1) const
+{
+	x0 = llmax(x0, mWindowX);
+	y0 = llmax(y0, mWindowY);
+	x1 = llmin(x1, mWindowX + mWidth);
+	y1 = llmin(y1, mWindowY + mHeight);
+	return x0 < x1 && y0 < y1;
+}
+
+bool LLNetMapObjectLayer::Raster::isVisible(const Dot& dot) const
+{
+	U32 delta = dot.mOwned ? mDeltaOwn : mDelta;
+	return !delta || static_cast<U32>(std::fabs(mAltitude - dot.mPosGlobal.mdV[VZ])) <= delta;
+}
+
+void LLNetMapObjectLayer::Raster::dirtyAll()
+{
+	std::fill(mDirtyTiles.begin(), mDirtyTiles.end(), 1);
+	mDirtyTileCount = mDirtyTiles.size();
+}
+
+void LLNetMapObjectLayer::Raster::dirtyRect(S64 x0, S64 y0, S64 x1, S64 y1)
+{
+	if (!clipToWindow(x0, y0, x1, y1))
+	{
+		return;
+	}
+	// The window is at most one raster wide, so a rectangle in it wraps at
+	// most once per axis; step from tile to tile in raster space.
+	for (S64 y = y0; y < y1; )
+	{
+		S32 ry = wrap(y, mHeight);
+		S32 tile_y = ry / TILE_SIZE;
+		for (S64 x = x0; x < x1; )
+		{
+			S32 rx = wrap(x, mWidth);
+			U8& dirty = mDirtyTiles[tile_y * mTilesX + rx / TILE_SIZE];
+			if (!dirty)
+			{
+				dirty = 1;
+				++mDirtyTileCount;
+			}
+			x += llmin(TILE_SIZE - rx % TILE_SIZE, mWidth - rx);
+		}
+		y += llmin(TILE_SIZE - ry % TILE_SIZE, mHeight - ry);
+	}
+}
+
+void LLNetMapObjectLayer::Raster::dirtyDot(const Dot& dot)
+{
+	S64 x0, y0, x1, y1;
+	if (getFootprint(dot, x0, y0, x1, y1))
+	{
+		dirtyRect(x0, y0, x1, y1);
+	}
+}
+
+void LLNetMapObjectLayer::Raster::scroll()
+{
+	S64 dx = mOriginX - mWindowX;
+	S64 dy = mOriginY - mWindowY;
+	if (!dx && !dy)
+	{
+		return;
+	}
+
+	mWindowX = mOriginX;
+	mWindowY = mOriginY;
+	if (llabs(dx) >= mWidth || llabs(dy) >= mHeight)
+	{
+		dirtyAll();
+		return;
+	}
+
+	// The texels that scrolled out of the window hold the ones that scrolled
+	// in; those strips are all that needs redrawing.
+	if (dx > 0)
+	{
+		dirtyRect(mWindowX + mWidth - dx, mWindowY, mWindowX + mWidth, mWindowY + mHeight);
+	}
+	else if (dx < 0)
+	{
+		dirtyRect(mWindowX, mWindowY, mWindowX - dx, mWindowY + mHeight);
+	}
+	if (dy > 0)
+	{
+		dirtyRect(mWindowX, mWindowY + mHeight - dy, mWindowX + mWidth, mWindowY + mHeight);
+	}
+	else if (dy < 0)
+	{
+		dirtyRect(mWindowX, mWindowY, mWindowX + mWidth, mWindowY - dy);
+	}
+}
+
+void LLNetMapObjectLayer::Raster::drawDot(const Dot& dot, U32* pixels)
+{
+	S64 x0, y0, x1, y1;
+	if (!getFootprint(dot, x0, y0, x1, y1) || !clipToWindow(x0, y0, x1, y1))
+	{
+		return;
+	}
+
+	const U32 color = dot.mColor.mAll;
+	for (S64 y = y0; y < y1; )
+	{
+		S32 ry = wrap(y, mHeight);
+		S32 rows = (S32)llmin(y1 - y, (S64)llmin(TILE_SIZE - ry % TILE_SIZE, mHeight - ry));
+		const U8* dirty_row = &mDirtyTiles[(ry / TILE_SIZE) * mTilesX];
+		for (S64 x = x0; x < x1; )
+		{
+			S32 rx = wrap(x, mWidth);
+			S32 cols = (S32)llmin(x1 - x, (S64)llmin(TILE_SIZE - rx % TILE_SIZE, mWidth - rx));
+			if (dirty_row[rx / TILE_SIZE])
+			{
+				for (S32 row = 0; row < rows; ++row)
+				{
+					U32* p = pixels + (ry + row) * mWidth + rx;
+					std::fill(p, p + cols, color);
+				}
+			}
+			x += cols;
+		}
+		y += rows;
+	}
+}
+
+void LLNetMapObjectLayer::Raster::redraw()
+{
+	U32* pixels = (U32*)mImage->getData();
+
+	for (S32 tile_y = 0; tile_y < mTilesY; ++tile_y)
+	{
+		for (S32 tile_x = 0; tile_x < mTilesX; ++tile_x)
+		{
+			if (!mDirtyTiles[tile_y * mTilesX + tile_x])
+			{
+				continue;
+			}
+			S32 left = tile_x * TILE_SIZE;
+			S32 cols = llmin(TILE_SIZE, mWidth - left);
+			S32 bottom = tile_y * TILE_SIZE;
+			S32 top = llmin(bottom + TILE_SIZE, mHeight);
+			for (S32 y = bottom; y < top; ++y)
+			{
+				memset(pixels + y * mWidth + left, 0, cols * sizeof(U32));
+			}
+		}
+	}
+
+	for (absl::flat_hash_map<key_t, Dot>::const_iterator iter = mDots.begin(); iter != mDots.end(); ++iter)
+	{
+		if (isVisible(iter->second))
+		{
+			drawDot(iter->second, pixels);
+		}
+	}
+}
+
+void LLNetMapObjectLayer::Raster::collectDirtyRects()
+{
+	if (mDirtyTileCount == (S32)mDirtyTiles.size())
+	{
+		mDirtyRects.push_back(LLRect(0, mHeight, mWidth, 0));
+	}
+	else
+	{
+		// One rectangle per run of dirty tiles in a row, merged with the
+		// rectangle right below it when they have the same columns.
+		for (S32 tile_y = 0; tile_y < mTilesY; ++tile_y)
+		{
+			const size_t this_row = mDirtyRects.size();
+			S32 bottom = tile_y * TILE_SIZE;
+			S32 top = llmin(bottom + TILE_SIZE, mHeight);
+			for (S32 tile_x = 0; tile_x < mTilesX; )
+			{
+				if (!mDirtyTiles[tile_y * mTilesX + tile_x])
+				{
+					++tile_x;
+					continue;
+				}
+				S32 first = tile_x;
+				while (tile_x < mTilesX && mDirtyTiles[tile_y * mTilesX + tile_x])
+				{
+					++tile_x;
+				}
+				S32 left = first * TILE_SIZE;
+				S32 right = llmin(tile_x * TILE_SIZE, mWidth);
+
+				bool merged = false;
+				for (size_t i = 0; i < this_row && !merged; ++i)
+				{
+					LLRect& below = mDirtyRects[i];
+					if (below.mTop == bottom && below.mLeft == left && below.mRight == right)
+					{
+						below.mTop = top;
+						merged = true;
+					}
+				}
+				if (!merged)
+				{
+					mDirtyRects.push_back(LLRect(left, top, right, bottom));
+				}
+			}
+		}
+	}
+
+	std::fill(mDirtyTiles.begin(), mDirtyTiles.end(), 0);
+	mDirtyTileCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+// LLNetMapObjectLayer::UpdateJob
+//-----------------------------------------------------------------------------
+class LLNetMapObjectLayer::UpdateJob : public LLJob
+{
+public:
+	UpdateJob(Raster* raster)
+	:	LLJob(PRIORITY_NORMAL, true),
+		mRaster(raster)
+	{
+	}
+
+protected:
+	/*virtual*/ void run()
+	{
+		mRaster->run();
+	}
+
+	/*virtual*/ void finish()
+	{
+		mRaster->mBusy = false;
+	}
+
+private:
+	LLPointer<Raster> mRaster;
+};
+
+//-----------------------------------------------------------------------------
+// LLNetMapObjectLayer
+//-----------------------------------------------------------------------------
+LLNetMapObjectLayer::LLNetMapObjectLayer()
+:	mRaster(new Raster),
+	mTexelsPerMeter(1.f),
+	mAltitude(0.0),
+	mDelta(0),
+	mDeltaOwn(0),
+	mRedrawAll(true),
+	mClear(false),
+	mNeedsAllDots(true)
+{
+}
+
+LLNetMapObjectLayer::~LLNetMapObjectLayer()
+{
+	// A running update keeps its raster alive until it is done.
+}
+
+void LLNetMapObjectLayer::setDot(key_t key, const Dot& dot)
+{
+	Change change;
+	change.mKey = key;
+	change.mRemove = false;
+	change.mDot = dot;
+	mChanges.push_back(change);
+}
+
+void LLNetMapObjectLayer::removeDot(key_t key)
+{
+	Change change;
+	change.mKey = key;
+	change.mRemove = true;
+	mChanges.push_back(change);
+}
+
+void LLNetMapObjectLayer::clearDots()
+{
+	mChanges.clear();
+	mClear = true;
+	mNeedsAllDots = false;
+}
+
+void LLNetMapObjectLayer::setRaster(LLImageRaw* raw, F32 texels_per_meter)
+{
+	llassert(!raw || raw->getComponents() == 4);
+	mImage = raw;
+	mTexelsPerMeter = texels_per_meter;
+	mRedrawAll = true;
+}
+
+void LLNetMapObjectLayer::setAltitudeFilter(F64 agent_altitude, U32 delta, U32 delta_own)
+{
+	// Dots only cross the filter limits when the agent moved a fair bit up or down.
+	if (delta != mDelta || delta_own != mDeltaOwn ||
+		((delta || delta_own) && std::fabs(agent_altitude - mAltitude) >= 0.5))
+	{
+		mAltitude = agent_altitude;
+		mDelta = delta;
+		mDeltaOwn = delta_own;
+		mRedrawAll = true;
+	}
+}
+
+bool LLNetMapObjectLayer::update(const LLVector3d& center_global)
+{
+	if (isUpdating())
+	{
+		return false;
+	}
+
+	Raster& raster = *mRaster;
+	raster.mImage = mImage;
+	raster.mTexelsPerMeter = mTexelsPerMeter;
+	raster.mAltitude = mAltitude;
+	raster.mDelta = mDelta;
+	raster.mDeltaOwn = mDeltaOwn;
+	raster.mRedrawAll |= mRedrawAll;
+	raster.mClear |= mClear;
+	raster.mChanges.swap(mChanges);
+	mRedrawAll = false;
+	mClear = false;
+
+	if (mImage.notNull())
+	{
+		raster.mOriginX = (S64)floor(center_global.mdV[VX] * mTexelsPerMeter + 0.5) - mImage->getWidth() / 2;
+		raster.mOriginY = (S64)floor(center_global.mdV[VY] * mTexelsPerMeter + 0.5) - mImage->getHeight() / 2;
+	}
+	raster.mCenterZ = center_global.mdV[VZ];
+
+	raster.mBusy = true;
+	LLJobSystem::instance().submit(new UpdateJob(mRaster));
+	return true;
+}
+
+bool LLNetMapObjectLayer::isUpdating() const
+{
+	return mRaster->mBusy;
+}
+
+void LLNetMapObjectLayer::flush()
+{
+	while (isUpdating())
+	{
+		if (!LLJobSystem::instance().updateMainThread(0.f) && isUpdating())
+		{
+			LLThread::yield();
+		}
+	}
+}
+
+bool LLNetMapObjectLayer::takeDirtyRects(std::vector<LLRect>& rects)
+{
+	rects.clear();
+	if (isUpdating())
+	{
+		return false;
+	}
+
+	// Rectangles of a raster that was replaced meanwhile are of no use; the
+	// new one gets redrawn completely anyway.
+	if (mImage.isNull() || mRaster->mImage != mImage || !mRaster->hasWindow())
+	{
+		mRaster->mDirtyRects.clear();
+		return false;
+	}
+
+	rects.swap(mRaster->mDirtyRects);
+	mCenterGlobal = mRaster->mCenterGlobal;
+	mTexCoordOrigin = mRaster->mTexCoordOrigin;
+	return true;
+}
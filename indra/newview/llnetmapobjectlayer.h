@@ -0,0 +1,128 @@
+/** 
+ * @file llnetmapobjectlayer.h
+ * @brief Incrementally maintained object layer of the mini map.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLNETMAPOBJECTLAYER_H
+#define LL_LLNETMAPOBJECTLAYER_H
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+#include "llimage.h"
+#include "llpointer.h"
+#include "llrect.h"
+#include "v2math.h"
+#include "v3dmath.h"
+#include "v4coloru.h"
+
+//-----------------------------------------------------------------------------
+// LLNetMapObjectLayer
+//
+// The object layer of the mini map: one dot per map object, drawn into a
+// raster that wraps around in both directions, so that following the camera
+// only redraws the strips that scrolled into view. Dots are added, moved and
+// removed by key; only the tiles they covered before and after are redrawn,
+// on a job system worker, and only those tiles need to be uploaded.
+//-----------------------------------------------------------------------------
+class LLNetMapObjectLayer
+{
+public:
+	struct Dot
+	{
+		LLVector3d mPosGlobal;
+		F32 mRadius;			// meters
+		LLColor4U mColor;
+		bool mOwned;			// filtered by the altitude delta of own objects
+	};
+
+	typedef const void* key_t;
+
+	LLNetMapObjectLayer();
+	~LLNetMapObjectLayer();
+
+	// Changes are queued and applied by the next update().
+	void setDot(key_t key, const Dot& dot);
+	void removeDot(key_t key);
+	void clearDots();
+	// True until the first clearDots(), i.e. until someone fed it every dot.
+	bool needsAllDots() const { return mNeedsAllDots; }
+
+	// Sets the raster to draw into and its resolution; redraws all of it.
+	void setRaster(LLImageRaw* raw, F32 texels_per_meter);
+	// Hides dots further than delta (delta_own for own objects) meters above
+	// or below agent_altitude; 0 disables the filter.
+	void setAltitudeFilter(F64 agent_altitude, U32 delta, U32 delta_own);
+
+	// Brings the raster up to date around center_global. Returns false and
+	// does nothing while the previous update is still running.
+	bool update(const LLVector3d& center_global);
+	bool isUpdating() const;
+	// Waits for the running update, if any.
+	void flush();
+
+	// Results of the last finished update: the raster rectangles that changed
+	// since the previous call, the global position of the raster center and
+	// the texture coordinates of its lower left corner (the raster wraps).
+	// Returns false, with no rectangles, while there is no finished update
+	// of the current raster.
+	bool takeDirtyRects(std::vector<LLRect>& rects);
+	const LLVector3d& getCenterGlobal() const { return mCenterGlobal; }
+	const LLVector2& getTexCoordOrigin() const { return mTexCoordOrigin; }
+
+private:
+	class Raster;
+	class UpdateJob;
+
+	struct Change
+	{
+		key_t mKey;
+		bool mRemove;
+		Dot mDot;
+	};
+
+	LLPointer<Raster> mRaster;
+
+	// Inputs of the next update().
+	LLPointer<LLImageRaw> mImage;
+	F32 mTexelsPerMeter;
+	F64 mAltitude;
+	U32 mDelta;
+	U32 mDeltaOwn;
+	bool mRedrawAll;
+	bool mClear;
+	std::vector<Change> mChanges;
+	bool mNeedsAllDots;
+
+	// Results of the last update taken.
+	LLVector3d mCenterGlobal;
+	LLVector2 mTexCoordOrigin;
+};
+
+#endif // LL_LLNETMAPOBJECTLAYER_H
@@ -205,6 +205,128 @@ void LLSkinningUtil::getPerVertexSkinMatrix(
 	llassert(valid_weights);
 }
 
+void LLSkinningUtil::initPositionPalette(LLMatrix4a* palette, S32 count, const LLMeshSkinInfo* skin, LLVOAvatar *avatar)
+{
+    initSkinningMatrixPalette(palette, count, skin, avatar, true);
+
+    LLMatrix4a bind_shape_matrix;
+    bind_shape_matrix.loadu(skin->mBindShapeMatrix);
+
+    for (S32 j = 0; j < count; ++j)
+    {
+        LLMatrix4a joint = palette[j];
+        palette[j].setMul(joint, bind_shape_matrix);
+    }
+}
+
+void LLSkinningUtil::skinPositions(
+    const LLMatrix4a* palette,
+    U32 palette_size,
+    const LLVector4a* weights,
+    const LLVector4a* positions,
+    U32 num_vertices,
+    const LLVector4a& offset,
+    LLVector4a* out,
+    LLVector4a* extents)
+{
+    if (!num_vertices || !palette_size)
+    {
+        return;
+    }
+
+    const S32 max_index = (S32) palette_size - 1;
+
+    LLVector4a min;
+    LLVector4a max;
+    min.splat(F32_MAX);
+    max.splat(-F32_MAX);
+
+    for (U32 j = 0; j < num_vertices; ++j)
+    {
+        // Each lane packs a joint index in its integer part and the
+        // unnormalized weight of that joint in its fraction.
+        const LLQuad w = weights[j];
+        const __m128i packed_idx = _mm_cvttps_epi32(w);
+
+        LLVector4a wght;
+        wght.setSub(LLVector4a(w), LLVector4a(_mm_cvtepi32_ps(packed_idx)));
+
+        S32 idx[4];
+        _mm_storeu_si128((__m128i*) idx, packed_idx);
+
+        const F32* f = wght.getF32ptr();
+        const F32 scale = f[0] + f[1] + f[2] + f[3];
+
+        const LLVector4a& v = positions[j];
+        LLVector4a pos;
+
+        if (scale <= 0.f)
+        {
+            // Weights are scrubbed on load, so this should not happen; fall
+            // back to the first influence rather than producing NaNs.
+            palette[llclamp(idx[0], 0, max_index)].affineTransform(v, pos);
+        }
+        else
+        {
+            wght.mul(1.f / scale);
+            const S32 used = _mm_movemask_ps(_mm_cmpgt_ps(wght, _mm_setzero_ps()));
+
+            pos.clear();
+            for (S32 k = 0; k < 4; ++k)
+            {
+                if (used & (1 << k))
+                {
+                    LLVector4a t;
+                    palette[llclamp(idx[k], 0, max_index)].affineTransform(v, t);
+
+                    LLVector4a s;
+                    s.splat(f[k]);
+                    t.mul(s);
+                    pos.add(t);
+                }
+            }
+        }
+
+        pos.add(offset);
+        out[j] = pos;
+
+        min.setMin(min, pos);
+        max.setMax(max, pos);
+    }
+
+    if (extents)
+    {
+        extents[0] = min;
+        extents[1] = max;
+    }
+}
+
+bool LLSkinningUtil::paletteDiffers(const LLMatrix4a* a, const LLMatrix4a* b, U32 count, F32 threshold)
+{
+    LLVector4a limit;
+    limit.splat(threshold);
+
+    for (U32 j = 0; j < count; ++j)
+    {
+        LLVector4a diff[4];
+        diff[0].setSub(a[j].getRow<0>(), b[j].getRow<0>());
+        diff[1].setSub(a[j].getRow<1>(), b[j].getRow<1>());
+        diff[2].setSub(a[j].getRow<2>(), b[j].getRow<2>());
+        diff[3].setSub(a[j].getRow<3>(), b[j].getRow<3>());
+
+        for (U32 r = 0; r < 4; ++r)
+        {
+            diff[r].setAbs(diff[r]);
+            if (diff[r].greaterThan(limit).getGatheredBits())
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 void LLSkinningUtil::initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar)
 {
     if (!skin->mJointNumsInitialized)
@@ -45,6 +45,18 @@ namespace LLSkinningUtil
     void initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar);
     void updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *avatar, LLVolumeFace& vol_face);
 	LLQuaternion getUnscaledQuaternion(const LLMatrix4& mat4);
+
+    // Position-only skinning, used for rigged volume picking and bounds.
+    // The position palette folds the bind shape matrix into each joint
+    // matrix so that a vertex costs one affine transform per influence.
+    void initPositionPalette(LLMatrix4a* palette, S32 count, const LLMeshSkinInfo* skin, LLVOAvatar *avatar);
+    // Skins num_vertices positions into out, adds offset to each of them and,
+    // when extents is not NULL, writes their bounding box to extents[0..1].
+    void skinPositions(const LLMatrix4a* palette, U32 palette_size, const LLVector4a* weights,
+                       const LLVector4a* positions, U32 num_vertices, const LLVector4a& offset,
+                       LLVector4a* out, LLVector4a* extents);
+    // True when any element of the two palettes differs by more than threshold.
+    bool paletteDiffers(const LLMatrix4a* a, const LLMatrix4a* b, U32 count, F32 threshold);
 };
 
 #endif
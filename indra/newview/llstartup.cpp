@@ -60,6 +60,7 @@
 
 #include "llares.h"
 #include "llavatarnamecache.h"
+#include "llavatarsnapshot.h"
 #include "llexperiencecache.h"
 #include "lllandmark.h"
 #include "llcachename.h"
@@ -1672,6 +1673,7 @@ bool idle_startup()
 
 		// init the shader managers
 
+		LLAvatarSnapshot::setEnabled(gSavedSettings.getBOOL("AvatarSnapshotEnabled"));
 		LLAvatarAppearance::initClass();
 		display_startup();
 
@@ -1478,6 +1478,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		// Will call callbackHttpGet when curl request completes
 		AIHTTPHeaders headers("Accept", "image/x-j2c");
 		// Call LLHTTPClient::request directly instead of LLHTTPClient::getByteRange, because we want to pass a NULL AIEngine.
+		// Textures are already compressed, and a Range applies to the encoded body, so don't accept a Content-Encoding.
 		if (mRequestedOffset > 0 || mRequestedSize > 0)
 		{
 			int const range_end = mRequestedOffset + mRequestedSize - 1;
@@ -1486,7 +1487,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		}
 		LLHTTPClient::request(mUrl, LLHTTPClient::HTTP_GET, NULL,
 			new HTTPGetResponder( mFTType, mFetcher, mID, LLTimer::getTotalTime(), mRequestedSize, mRequestedOffset),
-			headers, approved/*,*/ DEBUG_CURLIO_PARAM(debug_off), keep_alive, no_does_authentication, allow_compressed_reply, NULL, 0, NULL);
+			headers, approved/*,*/ DEBUG_CURLIO_PARAM(debug_off), keep_alive, no_does_authentication, no_allow_compressed_reply, NULL, 0, NULL);
 
 		mFetcher->addToHTTPQueue(mID);
 		recordTextureStart(true);
@@ -3282,10 +3283,10 @@ S32 LLTextureFetch::getFetchState(const LLUUID& id, F32& data_progress_p, F32& r
 void LLTextureFetch::dump()
 {
 	LL_INFOS(LOG_TXT) << "LLTextureFetch REQUESTS:" << LL_ENDL;
-	for (request_queue_t::iterator iter = mRequestQueue.begin();
-		 iter != mRequestQueue.end(); ++iter)
+	lockData();
+	for (LLQueuedThread::QueuedRequest* qreq = mRequestQueue.front();
+		 qreq; qreq = mRequestQueue.next(qreq))
 	{
-		LLQueuedThread::QueuedRequest* qreq = *iter;
 		LLWorkerThread::WorkRequest* wreq = (LLWorkerThread::WorkRequest*)qreq;
 		LLTextureFetchWorker* worker = (LLTextureFetchWorker*)wreq->getWorkerClass();
 		LL_INFOS(LOG_TXT) << " ID: " << worker->mID
@@ -3293,6 +3294,7 @@ void LLTextureFetch::dump()
 				<< " STATE: " << worker->sStateDescs[worker->mState]
 				<< LL_ENDL;
 	}
+	unlockData();
 
 	LL_INFOS(LOG_TXT) << "LLTextureFetch ACTIVE_HTTP:" << LL_ENDL;
 	for (queue_t::const_iterator iter(mHTTPTextureQueue.begin());
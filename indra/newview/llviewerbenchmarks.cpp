@@ -0,0 +1,2741 @@
+/** 
+ * @file llviewerbenchmarks.cpp
+ * @brief Timing runs for viewer subsystems, reachable from the Advanced menu
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llviewerbenchmarks.h"
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+
+#include "aistatemachine.h"
+#include "aithreadsafe.h"
+#include "llagent.h"
+#include "llalignedarray.h"
+#include "llavatarspatialindex.h"
+#include "llavatarsnapshot.h"
+#include "llbuffer.h"
+#include "llbufferstream.h"
+#include "lldatapacker.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "llerrorcontrol.h"
+#include "llfloater.h"
+#include "llinventorysearchindex.h"
+#include "lljobsystem.h"
+#include "llkeywords.h"
+#include "llmenugl.h"
+#include "llnetmapobjectlayer.h"
+#include "llpolymesh.h"
+#include "llqueuedthread.h"
+#include "llrand.h"
+#include "llregionhandle.h"
+#include "llscrolllistcolumn.h"
+#include "llscrolllistctrl.h"
+#include "llscrolllistitem.h"
+#include "llscrolllistrowmodel.h"
+#include "llsdserialize.h"
+#include "llskinningutil.h"
+#include "llstringtable.h"
+#include "lltexteditor.h"
+#include "llthread.h"
+#include "llthreadsafequeue.h"
+#include "lltimer.h"
+#include "lluictrlfactory.h"
+#include "lluixmlcache.h"
+#include "llviewercontrol.h"
+#include "llviewerobjectlist.h"
+#include "llviewerregion.h"
+#include "llvolume.h"
+#include "llvolumemgr.h"
+#include "llxmltree.h"
+#include "llurlregistry.h"
+
+void init_debug_benchmark_menu(LLMenuGL* menu)
+{
+	menu->addChild(new LLMenuItemCallGL("Floater Construction", handle_benchmark_floater_construction));
+	menu->addChild(new LLMenuItemCallGL("Inventory Search", handle_benchmark_inventory_search));
+	menu->addChild(new LLMenuItemCallGL("URL Matching", handle_benchmark_url_matching));
+	menu->addChild(new LLMenuItemCallGL("Script Highlighting", handle_benchmark_script_highlighting));
+	menu->addChild(new LLMenuItemCallGL("String Table", handle_benchmark_string_table));
+	menu->addChild(new LLMenuItemCallGL("Job System", handle_benchmark_job_system));
+	menu->addChild(new LLMenuItemCallGL("Request Queue", handle_benchmark_request_queue));
+	menu->addChild(new LLMenuItemCallGL("LLSD Response Decode", handle_benchmark_llsd_response));
+	menu->addChild(new LLMenuItemCallGL("Logging", handle_benchmark_logging));
+	menu->addChild(new LLMenuItemCallGL("Disabled Log Messages", handle_benchmark_disabled_logging));
+	menu->addChild(new LLMenuItemCallGL("Mutexes", handle_benchmark_mutexes));
+	menu->addChild(new LLMenuItemCallGL("Read-Mostly Access", handle_benchmark_read_mostly));
+	menu->addChild(new LLMenuItemCallGL("State Machine Engines", handle_benchmark_state_machines));
+	menu->addChild(new LLMenuItemCallGL("Thread-Safe Queue", handle_benchmark_thread_safe_queue));
+	menu->addChild(new LLMenuItemCallGL("Avatar Startup", handle_benchmark_avatar_startup));
+	menu->addChild(new LLMenuItemCallGL("Morph Targets", handle_benchmark_morph_targets));
+	menu->addChild(new LLMenuItemCallGL("Rigged Skinning", handle_benchmark_rigged_skinning));
+	menu->addChild(new LLMenuItemCallGL("Minimap Objects", handle_benchmark_minimap_objects));
+	menu->addChild(new LLMenuItemCallGL("Radar Updates", handle_benchmark_radar_updates));
+	menu->addChild(new LLMenuItemCallGL("Scroll List Rows", handle_benchmark_scroll_list_rows));
+	menu->addChild(new LLMenuItemCallGL("Object Updates", handle_benchmark_object_updates));
+	menu->addChild(new LLMenuItemCallGL("Volume Manager", handle_benchmark_volume_manager));
+	menu->addChild(new LLMenuItemCallGL("Volume Generation", handle_benchmark_volume_generation));
+
+	menu->createJumpKeys();
+}
+
+//-----------------------------------------------------------------------------
+// Floater construction
+//-----------------------------------------------------------------------------
+
+// Builds every floater description in the default skin three times: XUI
+// parsing with a cold cache, XUI parsing from the cache, and full floater
+// construction (parse + widgets + postBuild) from the cache.
+void handle_benchmark_floater_construction(void*)
+{
+	std::string xui_dir = gDirUtilp->add(gDirUtilp->add(gDirUtilp->getDefaultSkinDir(), "xui"), "en-us");
+	std::vector<std::string> filenames;
+	{
+		LLDirIterator iter(xui_dir, "floater_*.xml");
+		std::string filename;
+		while (iter.next(filename))
+		{
+			filenames.push_back(filename);
+		}
+	}
+	if (filenames.empty())
+	{
+		LL_WARNS("Benchmark") << "No floater descriptions found in " << xui_dir << LL_ENDL;
+		return;
+	}
+
+	LLUIXMLCache& xui_cache = LLUIXMLCache::instance();
+	LLTimer timer;
+	LLXMLNodePtr root;
+
+	xui_cache.clear(true);
+	timer.reset();
+	for (std::vector<std::string>::const_iterator iter = filenames.begin(); iter != filenames.end(); ++iter)
+	{
+		LLUICtrlFactory::getLayeredXMLNode(*iter, root);
+	}
+	F64 cold_parse = timer.getElapsedTimeF64();
+
+	timer.reset();
+	for (std::vector<std::string>::const_iterator iter = filenames.begin(); iter != filenames.end(); ++iter)
+	{
+		LLUICtrlFactory::getLayeredXMLNode(*iter, root);
+	}
+	F64 warm_parse = timer.getElapsedTimeF64();
+	root = NULL;
+
+	timer.reset();
+	for (std::vector<std::string>::const_iterator iter = filenames.begin(); iter != filenames.end(); ++iter)
+	{
+		LLFloater* floater = new LLFloater(std::string("benchmark_floater"));
+		LLUICtrlFactory::getInstance()->buildFloater(floater, *iter, NULL, FALSE);
+		delete floater;
+	}
+	F64 build = timer.getElapsedTimeF64();
+
+	LL_INFOS("Benchmark") << "Floater construction, " << filenames.size() << " files: "
+						  << "parse (cold cache) " << cold_parse * 1000.0 << " ms, "
+						  << "parse (cached) " << warm_parse * 1000.0 << " ms, "
+						  << "full construction (cached) " << build * 1000.0 << " ms. "
+						  << "Cache hits: " << xui_cache.getHits() << ", misses: " << xui_cache.getMisses() << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Inventory search
+//-----------------------------------------------------------------------------
+
+// Types a search string one character at a time against a synthetic inventory,
+// comparing LLInventorySearchIndex with the linear scan LLInventoryFilter does.
+void handle_benchmark_inventory_search(void*)
+{
+	static const char* const words[] = {
+		"BLUE", "RED", "LEATHER", "SHIRT", "JACKET", "BOOTS", "HAIR", "SKIN", "SHAPE", "EYES",
+		"TEXTURE", "SCRIPT", "HOUSE", "CHAIR", "TABLE", "LAMP", "TREE", "POSE", "ANIMATION", "GESTURE"
+	};
+	static const S32 num_words = LL_ARRAY_SIZE(words);
+	static const S32 num_entries = 150000;
+
+	std::vector<std::string> labels;
+	labels.reserve(num_entries);
+	for (S32 i = 0; i < num_entries; ++i)
+	{
+		labels.push_back(llformat("%s %s %d", words[ll_rand(num_words)], words[ll_rand(num_words)], ll_rand(1000)));
+	}
+
+	LLInventorySearchIndex index;
+	LLTimer timer;
+	for (S32 i = 0; i < num_entries; ++i)
+	{
+		LLUUID id;
+		id.generate();
+		index.update(id, labels[i], LLStringUtil::null, LLStringUtil::null);
+	}
+	F64 build = timer.getElapsedTimeF64();
+
+	const std::string typed("LEATHER JACKET 12");
+	F64 indexed = 0.0, linear = 0.0;
+	size_t indexed_matches = 0, linear_matches = 0;
+	for (size_t len = 1; len <= typed.size(); ++len)
+	{
+		const std::string substring(typed, 0, len);
+
+		uuid_set_t matches;
+		timer.reset();
+		index.query(substring, INVENTORY_SEARCH_NAME, matches);
+		indexed += timer.getElapsedTimeF64();
+		indexed_matches += matches.size();
+
+		timer.reset();
+		for (std::vector<std::string>::const_iterator iter = labels.begin(); iter != labels.end(); ++iter)
+		{
+			if (iter->find(substring) != std::string::npos)
+			{
+				++linear_matches;
+			}
+		}
+		linear += timer.getElapsedTimeF64();
+	}
+
+	LL_INFOS("Benchmark") << "Inventory search, " << num_entries << " items, " << typed.size() << " keystrokes: "
+						  << "index build " << build * 1000.0 << " ms, "
+						  << "indexed " << indexed * 1000.0 << " ms (" << indexed_matches << " matches), "
+						  << "linear " << linear * 1000.0 << " ms (" << linear_matches << " matches)." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// URL matching
+//-----------------------------------------------------------------------------
+
+// Finds all Urls in every line of the chat logs of the current account, the
+// way text widgets do, once with the LLUrlRegistry trigger prefilter and once
+// running every entry regex; also checks both give the same matches.
+void handle_benchmark_url_matching(void*)
+{
+	static const size_t max_lines = 200000;
+
+	std::vector<std::string> lines;
+	const std::string& log_dir = gDirUtilp->getPerAccountChatLogsDir();
+	if (!log_dir.empty())
+	{
+		LLDirIterator iter(log_dir, "*.txt");
+		std::string filename;
+		while (lines.size() < max_lines && iter.next(filename))
+		{
+			llifstream file(gDirUtilp->add(log_dir, filename).c_str());
+			std::string line;
+			while (lines.size() < max_lines && std::getline(file, line))
+			{
+				lines.push_back(line);
+			}
+		}
+	}
+	if (lines.empty())
+	{
+		LL_WARNS("Benchmark") << "No chat logs found in \"" << log_dir << "\"" << LL_ENDL;
+		return;
+	}
+
+	LLUrlRegistry& registry = LLUrlRegistry::instance();
+	std::vector<std::string> urls[2];
+	F64 elapsed[2];
+	for (S32 pass = 0; pass < 2; ++pass)
+	{
+		registry.setUseTriggers(pass == 0);
+		LLTimer timer;
+		for (std::vector<std::string>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
+		{
+			std::string text = *iter;
+			LLUrlMatch match;
+			while (registry.findUrl(text, match, &LLUrlRegistryNullCallback, true))
+			{
+				urls[pass].push_back(match.getUrl());
+				text.erase(0, match.getEnd() + 1);
+			}
+		}
+		elapsed[pass] = timer.getElapsedTimeF64();
+	}
+	registry.setUseTriggers(true);
+
+	LL_INFOS("Benchmark") << "URL matching, " << lines.size() << " chat log lines, " << urls[0].size() << " urls: "
+						  << "with triggers " << elapsed[0] * 1000.0 << " ms, "
+						  << "all regexes " << elapsed[1] * 1000.0 << " ms." << LL_ENDL;
+	if (urls[0] != urls[1])
+	{
+		LL_WARNS("Benchmark") << "URL matching: trigger prefilter found different urls (" << urls[0].size()
+							  << " versus " << urls[1].size() << ")!" << LL_ENDL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Script highlighting
+//-----------------------------------------------------------------------------
+
+// Types characters in the middle of a large script, recoloring it after each
+// keystroke the way the script editor does, once with the incremental
+// LLKeywords::updateSegments() and once with a full findSegments(); also
+// checks both give the same segments.
+void handle_benchmark_script_highlighting(void*)
+{
+	static const size_t script_size = 64 * 1024;
+	static const S32 keystrokes = 500;
+
+	LLKeywords keywords;
+	if (!keywords.loadFromFile(gDirUtilp->getExpandedFilename(LL_PATH_APP_SETTINGS, "keywords.ini")))
+	{
+		LL_WARNS("Benchmark") << "Could not load keywords.ini" << LL_ENDL;
+		return;
+	}
+
+	const std::string chunk =
+		"// Counts touches\n"
+		"integer gCount = 0;\n"
+		"default\n"
+		"{\n"
+		"    state_entry()\n"
+		"    {\n"
+		"        llSetText(\"Touched \" + (string)gCount + \" times\", <1.0, 1.0, 1.0>, 1.0);\n"
+		"    }\n"
+		"    /* Someone touched us:\n"
+		"       count it and say so. */\n"
+		"    touch_start(integer total_number)\n"
+		"    {\n"
+		"        gCount += total_number;\n"
+		"        llSay(PUBLIC_CHANNEL, \"Touched by \" + llDetectedName(0));\n"
+		"    }\n"
+		"}\n";
+	std::string script;
+	while (script.size() < script_size)
+	{
+		script += chunk;
+	}
+	const LLWString typed = utf8str_to_wstring("integer i = llFloor(ZERO_VECTOR.x); /* \"x\" */\n");
+	const LLColor4 default_color = LLColor4::black;
+
+	std::vector<LLTextSegmentPtr> segments[2];
+	F64 elapsed[2];
+	bool identical = true;
+	for (S32 pass = 0; pass < 2; ++pass)
+	{
+		LLWString text = utf8str_to_wstring(script);
+		keywords.findSegments(&segments[pass], text, default_color);
+		const S32 cursor = text.size() / 2;
+		LLTimer timer;
+		for (S32 i = 0; i < keystrokes; ++i)
+		{
+			text.insert(cursor + i, 1, typed[i % typed.size()]);
+			if (pass == 0)
+			{
+				keywords.updateSegments(&segments[pass], text, default_color);
+			}
+			else
+			{
+				keywords.findSegments(&segments[pass], text, default_color);
+			}
+		}
+		elapsed[pass] = timer.getElapsedTimeF64();
+	}
+
+	if (segments[0].size() != segments[1].size())
+	{
+		identical = false;
+	}
+	for (size_t i = 0; identical && i < segments[0].size(); ++i)
+	{
+		identical = segments[0][i]->getStart() == segments[1][i]->getStart() &&
+					segments[0][i]->getEnd() == segments[1][i]->getEnd() &&
+					segments[0][i]->getToken() == segments[1][i]->getToken();
+	}
+
+	LL_INFOS("Benchmark") << "Script highlighting, " << keystrokes << " keystrokes in a " << script.size() << " characters script: "
+						  << "incremental " << elapsed[0] * 1000.0 << " ms, "
+						  << "full " << elapsed[1] * 1000.0 << " ms." << LL_ENDL;
+	if (!identical)
+	{
+		LL_WARNS("Benchmark") << "Script highlighting: incremental update gave different segments ("
+							  << segments[0].size() << " versus " << segments[1].size() << ")!" << LL_ENDL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// String table
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Looks up (and every tenth time adds) names in a shared LLStringTable.
+	class StringTableBenchmarkThread : public LLThread
+	{
+	public:
+		StringTableBenchmarkThread(LLStringTable& table, const std::vector<std::string>& names, S32 first, S32 lookups)
+		:	LLThread("String table benchmark"),
+			mTable(table),
+			mNames(names),
+			mFirst(first),
+			mLookups(lookups)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			const S32 count = mNames.size();
+			for (S32 i = 0; i < mLookups; ++i)
+			{
+				const std::string& name = mNames[(mFirst + i * 7919) % count];
+				if (i % 10 == 0)
+				{
+					mTable.addStringEntry(name);
+				}
+				else
+				{
+					// Misses are expected for names no thread added yet.
+					mTable.checkStringEntry(name);
+				}
+			}
+		}
+
+	private:
+		LLStringTable& mTable;
+		const std::vector<std::string>& mNames;
+		const S32 mFirst;
+		const S32 mLookups;
+	};
+}
+
+// Measures LLStringTable lookups on the main thread, then the throughput of
+// 1 to 8 threads sharing a table, a tenth of their operations being insertions.
+void handle_benchmark_string_table(void*)
+{
+	static const S32 name_count = 20000;
+	static const S32 lookups = 2000000;
+	static const S32 max_threads = 8;
+
+	std::vector<std::string> names;
+	names.reserve(name_count);
+	for (S32 i = 0; i < name_count; ++i)
+	{
+		names.push_back(llformat("benchmark_name_%d", i));
+	}
+
+	{
+		LLStringTable table(name_count);
+		for (S32 i = 0; i < name_count; ++i)
+		{
+			table.addStringEntry(names[i]);
+		}
+		S32 misses = 0;
+		LLTimer timer;
+		for (S32 i = 0; i < lookups; ++i)
+		{
+			if (!table.checkStringEntry(names[(i * 7919) % name_count]))
+			{
+				++misses;
+			}
+		}
+		F64 elapsed = timer.getElapsedTimeF64();
+		LL_INFOS("Benchmark") << "String table, " << lookups << " lookups of " << name_count << " names: "
+							  << elapsed * 1.0e9 / lookups << " ns per lookup." << LL_ENDL;
+		if (misses)
+		{
+			LL_WARNS("Benchmark") << "String table: " << misses << " names not found!" << LL_ENDL;
+		}
+	}
+
+	for (S32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+	{
+		// Half of the names are added before starting, the threads add the rest.
+		LLStringTable table(name_count / 2);
+		for (S32 i = 0; i < name_count; i += 2)
+		{
+			table.addStringEntry(names[i]);
+		}
+
+		std::vector<StringTableBenchmarkThread*> threads;
+		LLTimer timer;
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			threads.push_back(new StringTableBenchmarkThread(table, names, i * name_count / thread_count, lookups / thread_count));
+			threads.back()->start();
+		}
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			while (!threads[i]->isStopped())
+			{
+				ms_sleep(1);
+			}
+		}
+		F64 elapsed = timer.getElapsedTimeF64();
+		for_each(threads.begin(), threads.end(), DeletePointer());
+
+		LL_INFOS("Benchmark") << "String table, " << thread_count << " threads, " << lookups << " operations: "
+							  << elapsed * 1000.0 << " ms, " << table.getUniqueEntries() << " unique names." << LL_ENDL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Job system
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Busy waits so that job run times don't depend on the scheduler.
+	void spin(F64 seconds)
+	{
+		F64 end = LLTimer::getTotalSeconds() + seconds;
+		while (LLTimer::getTotalSeconds() < end)
+		{
+		}
+	}
+
+	void wait_for(const LLAtomicS32& count, S32 target)
+	{
+		while (count < target)
+		{
+			ms_sleep(0);
+		}
+	}
+}
+
+// Measures LLJobSystem throughput with tiny jobs submitted from the main
+// thread and spawned by a job, the latency of high priority jobs while the
+// workers are busy with low priority ones, and the overhead of dependencies.
+void handle_benchmark_job_system(void*)
+{
+	static const S32 tiny_jobs = 200000;
+	static const S32 latency_samples = 2000;
+	static const S32 chain_length = 20000;
+
+	LLJobSystem& jobs = LLJobSystem::instance();
+	if (!jobs.getWorkerCount())
+	{
+		LL_WARNS("Benchmark") << "The job system isn't running." << LL_ENDL;
+		return;
+	}
+
+	// Throughput, jobs submitted by the main thread.
+	{
+		LLAtomicS32 done(0);
+		LLTimer timer;
+		for (S32 i = 0; i < tiny_jobs; ++i)
+		{
+			jobs.post([&done]() { done++; });
+		}
+		wait_for(done, tiny_jobs);
+		F64 elapsed = timer.getElapsedTimeF64();
+		LL_INFOS("Benchmark") << "Job system, " << jobs.getWorkerCount() << " workers, " << tiny_jobs
+							  << " jobs submitted by the main thread: " << elapsed * 1.0e9 / tiny_jobs << " ns per job." << LL_ENDL;
+	}
+
+	// Throughput, jobs spawned by one job (they all start on one worker, the others have to steal).
+	{
+		LLAtomicS32 done(0);
+		LLTimer timer;
+		jobs.post([&done, &jobs]()
+			{
+				for (S32 i = 0; i < tiny_jobs; ++i)
+				{
+					jobs.post([&done]() { done++; });
+				}
+			});
+		wait_for(done, tiny_jobs);
+		F64 elapsed = timer.getElapsedTimeF64();
+		LL_INFOS("Benchmark") << "Job system, " << tiny_jobs << " jobs spawned by a job: "
+							  << elapsed * 1.0e9 / tiny_jobs << " ns per job." << LL_ENDL;
+	}
+
+	// Latency of high priority jobs while every worker has 1 ms low priority jobs queued.
+	{
+		LLAtomicS32 background_done(0);
+		const S32 background_jobs = jobs.getWorkerCount() * latency_samples / 10;
+		for (S32 i = 0; i < background_jobs; ++i)
+		{
+			jobs.post([&background_done]() { spin(0.001); background_done++; }, LLJob::PRIORITY_LOW);
+		}
+
+		F64 total_latency = 0.0;
+		F64 max_latency = 0.0;
+		for (S32 i = 0; i < latency_samples; ++i)
+		{
+			LLAtomicS32 started(0);
+			F64 submitted = LLTimer::getTotalSeconds();
+			F64 latency = 0.0;
+			jobs.post([&started, &latency, submitted]() { latency = LLTimer::getTotalSeconds() - submitted; started++; }, LLJob::PRIORITY_HIGH);
+			wait_for(started, 1);
+			total_latency += latency;
+			max_latency = llmax(max_latency, latency);
+		}
+		S32 background_left = background_jobs - background_done;
+		wait_for(background_done, background_jobs);
+		LL_INFOS("Benchmark") << "Job system, high priority latency with " << background_jobs << " 1 ms low priority jobs ("
+							  << background_left << " left after sampling): average " << total_latency * 1.0e6 / latency_samples
+							  << " us, maximum " << max_latency * 1.0e6 << " us." << LL_ENDL;
+	}
+
+	// Dependencies: a chain where each job waits for the previous one, then a fan-in.
+	{
+		LLAtomicS32 done(0);
+		LLTimer timer;
+		std::vector<LLPointer<LLJob> > chain;
+		chain.reserve(chain_length);
+		for (S32 i = 0; i < chain_length; ++i)
+		{
+			chain.push_back(new LLFunctionJob([&done]() { done++; }));
+			if (i)
+			{
+				chain[i]->addDependency(chain[i - 1]);
+			}
+		}
+		for (S32 i = chain_length - 1; i >= 0; --i)
+		{
+			jobs.submit(chain[i]);
+		}
+		wait_for(done, chain_length);
+		F64 chain_elapsed = timer.getElapsedTimeF64();
+
+		done = 0;
+		timer.reset();
+		LLPointer<LLJob> last = new LLFunctionJob([&done]() { done++; });
+		std::vector<LLPointer<LLJob> > fan_in;
+		fan_in.reserve(chain_length);
+		for (S32 i = 0; i < chain_length; ++i)
+		{
+			fan_in.push_back(new LLFunctionJob([&done]() { done++; }));
+			last->addDependency(fan_in.back());
+		}
+		jobs.submit(last);
+		for (S32 i = 0; i < chain_length; ++i)
+		{
+			jobs.submit(fan_in[i]);
+		}
+		wait_for(done, chain_length + 1);
+		F64 fan_in_elapsed = timer.getElapsedTimeF64();
+
+		LL_INFOS("Benchmark") << "Job system, " << chain_length << " jobs: chain " << chain_elapsed * 1.0e9 / chain_length
+							  << " ns per job, fan-in " << fan_in_elapsed * 1.0e9 / chain_length << " ns per job." << LL_ENDL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Request queue
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Its own thread consumes the requests, which complete immediately.
+	class BenchmarkQueuedThread : public LLQueuedThread
+	{
+	public:
+		class Request : public QueuedRequest
+		{
+		public:
+			Request(handle_t handle, U32 priority, LLAtomicS32& processed)
+			:	QueuedRequest(handle, priority, FLAG_AUTO_COMPLETE),
+				mProcessed(processed)
+			{
+			}
+
+		protected:
+			/*virtual*/ bool processRequest() { return true; }
+			/*virtual*/ void finishRequest(bool completed) { mProcessed++; }
+
+		private:
+			LLAtomicS32& mProcessed;
+		};
+
+		BenchmarkQueuedThread() : LLQueuedThread("Request queue benchmark"), mProcessed(0) { }
+
+		handle_t add(U32 priority)
+		{
+			handle_t handle = generateHandle();
+			addRequest(new Request(handle, priority, mProcessed));
+			return handle;
+		}
+
+		LLAtomicS32 mProcessed;
+	};
+
+	// Adds requests, and like the texture fetcher keeps changing the priority
+	// of the ones it added recently and polling their status.
+	class RequestQueueBenchmarkThread : public LLThread
+	{
+	public:
+		RequestQueueBenchmarkThread(BenchmarkQueuedThread& queue, S32 requests)
+		:	LLThread("Request queue benchmark producer"),
+			mQueue(queue),
+			mRequests(requests)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			const S32 recent_count = 64;
+			LLQueuedThread::handle_t recent[recent_count] = { 0 };
+			U32 random = (U32)(size_t)this;		// ll_rand() isn't thread safe.
+			for (S32 i = 0; i < mRequests; ++i)
+			{
+				random = random * 1664525 + 1013904223;
+				recent[i % recent_count] = mQueue.add(LLQueuedThread::PRIORITY_LOW + (random & LLQueuedThread::PRIORITY_LOWBITS));
+				for (S32 j = 0; j < 4; ++j)
+				{
+					random = random * 1664525 + 1013904223;
+					LLQueuedThread::handle_t handle = recent[(random >> 24) % recent_count];
+					if (handle)
+					{
+						mQueue.setPriority(handle, LLQueuedThread::PRIORITY_LOW + (random & LLQueuedThread::PRIORITY_LOWBITS));
+						mQueue.getRequestStatus(handle);
+					}
+				}
+			}
+		}
+
+	private:
+		BenchmarkQueuedThread& mQueue;
+		const S32 mRequests;
+	};
+}
+
+// Measures how long 1 to 8 producer threads take to get requests through an
+// LLQueuedThread, each request also being reprioritized and polled 4 times
+// while it is likely still queued.
+void handle_benchmark_request_queue(void*)
+{
+	static const S32 requests = 200000;
+	static const S32 max_threads = 8;
+
+	for (S32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+	{
+		BenchmarkQueuedThread* queue = new BenchmarkQueuedThread;
+		std::vector<RequestQueueBenchmarkThread*> threads;
+		LLTimer timer;
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			threads.push_back(new RequestQueueBenchmarkThread(*queue, requests / thread_count));
+			threads.back()->start();
+		}
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			while (!threads[i]->isStopped())
+			{
+				ms_sleep(1);
+			}
+		}
+		F64 produced = timer.getElapsedTimeF64();
+		S32 pending = queue->getPending();
+		wait_for(queue->mProcessed, thread_count * (requests / thread_count));
+		F64 elapsed = timer.getElapsedTimeF64();
+		for_each(threads.begin(), threads.end(), DeletePointer());
+		delete queue;
+
+		LL_INFOS("Benchmark") << "Request queue, " << thread_count << " producer threads, " << requests << " requests: "
+							  << produced * 1000.0 << " ms to add, " << elapsed * 1000.0 << " ms to process, "
+							  << pending << " pending when done adding." << LL_ENDL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LLSD response decode
+//-----------------------------------------------------------------------------
+
+// Measures how long the main thread stalls on LLSD replies of 1 to 50 MB that
+// arrive in 16 kB chunks: when the whole body is parsed from the response
+// buffer after the transfer finished, versus when the curl thread parsed each
+// chunk as it arrived (LLHTTPClient::ResponderBase::decodeWhileReceiving()).
+void handle_benchmark_llsd_response(void*)
+{
+	static const S32 sizes_mb[] = { 1, 10, 50 };
+	static const S32 chunk_size = 16 * 1024;
+
+	for (U32 i = 0; i < LL_ARRAY_SIZE(sizes_mb); ++i)
+	{
+		// Something that looks like an inventory fetch reply. Serialize a
+		// thousand items first to find out how many are needed.
+		LLSD items = LLSD::emptyArray();
+		std::string xml;
+		for (S32 target = 1000; target > items.size(); )
+		{
+			while (items.size() < target)
+			{
+				LLSD item;
+				item["item_id"] = LLUUID::generateNewID();
+				item["parent_id"] = LLUUID::generateNewID();
+				item["name"] = llformat("Benchmark item %d", items.size());
+				item["desc"] = "A description of the item.";
+				item["type"] = 7;
+				item["flags"] = 0;
+				item["created_at"] = 1234567890 + items.size();
+				items.append(item);
+			}
+			std::ostringstream ostr;
+			LLSDSerialize::toXML(items, ostr);
+			xml = ostr.str();
+			target = (S32)((F64)sizes_mb[i] * 1024 * 1024 * items.size() / xml.size());
+		}
+
+		// Whole body, parsed by the main thread.
+		LLBufferArray buffer;
+		LLChannelDescriptors channels = buffer.nextChannel();
+		for (size_t offset = 0; offset < xml.size(); offset += chunk_size)
+		{
+			buffer.append(channels.in(), (U8 const*)xml.data() + offset, llmin((size_t)chunk_size, xml.size() - offset));
+		}
+		LLSD content;
+		LLTimer timer;
+		{
+			LLBufferStream istr(channels, &buffer);
+			LLSDSerialize::fromXML(content, istr);
+		}
+		F64 whole_body = timer.getElapsedTimeF64();
+
+		// Chunks parsed as they arrive, finished by the main thread.
+		LLPointer<LLSDXMLParser> parser = new LLSDXMLParser;
+		F64 slowest_chunk = 0.0;
+		timer.reset();
+		for (size_t offset = 0; offset < xml.size(); offset += chunk_size)
+		{
+			F64 start = timer.getElapsedTimeF64();
+			parser->parsePartial(xml.data() + offset, llmin((size_t)chunk_size, xml.size() - offset));
+			F64 elapsed = timer.getElapsedTimeF64() - start;
+			slowest_chunk = llmax(slowest_chunk, elapsed);
+		}
+		F64 chunks = timer.getElapsedTimeF64();
+		LLSD streamed_content;
+		timer.reset();
+		parser->finishParse(streamed_content);
+		F64 finish = timer.getElapsedTimeF64();
+
+		LL_INFOS("Benchmark") << "LLSD response of " << xml.size() / (1024 * 1024) << " MB (" << items.size() << " items): main thread stalls "
+							  << whole_body * 1000.0 << " ms parsing the whole body, or " << finish * 1000.0 << " ms finishing a streamed parse ("
+							  << chunks * 1000.0 << " ms spread over the chunks on the curl thread, at most " << slowest_chunk * 1000.0 << " ms each)." << LL_ENDL;
+		if (content.size() != items.size() || streamed_content.size() != items.size())
+		{
+			LL_WARNS("Benchmark") << "LLSD response: parsed " << content.size() << " and " << streamed_content.size() << " items instead of " << items.size() << "!" << LL_ENDL;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Logging
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Stands in for the log file, without the disk: formats and keeps the messages.
+	class BenchmarkRecorder : public LLError::Recorder
+	{
+	public:
+		BenchmarkRecorder() : mMessages(0)
+		{
+			mWantsTime = true;
+			mWantsTags = true;
+			mWantsLevel = true;
+			mWantsFunctionName = true;
+		}
+
+		/*virtual*/ void recordMessage(LLError::ELevel level, const std::string& message)
+		{
+			if (message.find("Logging benchmark message") != std::string::npos)
+			{
+				mBuffer.append(message).append(1, '\n');
+				if (mBuffer.size() > 1024 * 1024)
+				{
+					mBuffer.clear();
+				}
+				++mMessages;
+			}
+		}
+
+		S32 mMessages;	// Only accessed with the log lock held, or once logging finished.
+
+	private:
+		std::string mBuffer;
+	};
+
+	// Logs messages as fast as it can, timing each.
+	class LoggingBenchmarkThread : public LLThread
+	{
+	public:
+		LoggingBenchmarkThread(S32 messages)
+		:	LLThread("Logging benchmark"),
+			mMessages(messages),
+			mTotalLatency(0.0),
+			mMaxLatency(0.0)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			for (S32 i = 0; i < mMessages; ++i)
+			{
+				F64 start = LLTimer::getTotalSeconds();
+				LL_INFOS("Benchmark") << "Logging benchmark message " << i << " of " << mMessages << " from " << mName << LL_ENDL;
+				F64 latency = LLTimer::getTotalSeconds() - start;
+				mTotalLatency += latency;
+				mMaxLatency = llmax(mMaxLatency, latency);
+			}
+		}
+
+		const S32 mMessages;
+		F64 mTotalLatency;
+		F64 mMaxLatency;
+	};
+}
+
+// Measures the throughput of 1 to 8 threads logging at the same time, and how
+// long each LL_INFOS takes for the caller, with synchronous and with
+// asynchronous logging (LLError::setAsyncLogging()). The messages go to an
+// in-memory recorder instead of the log; so do the messages that other threads
+// happen to log meanwhile.
+void handle_benchmark_logging(void*)
+{
+	static const S32 messages = 200000;
+	static const S32 max_threads = 8;
+
+	// Write whatever is queued to the real log before replacing the recorders.
+	LLError::setAsyncLogging(false);
+	LLError::SettingsStoragePtr saved_settings = LLError::saveAndResetSettings();
+	LLError::setDefaultLevel(LLError::LEVEL_INFO);
+	LLError::setTimeFunction(LLError::utcTime);
+
+	std::ostringstream results;
+	for (S32 async = 0; async <= 1; ++async)
+	{
+		LLError::setAsyncLogging(async);
+		for (S32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+		{
+			boost::shared_ptr<BenchmarkRecorder> recorder(new BenchmarkRecorder);
+			LLError::addRecorder(recorder);
+			std::vector<LoggingBenchmarkThread*> threads;
+			LLTimer timer;
+			for (S32 i = 0; i < thread_count; ++i)
+			{
+				threads.push_back(new LoggingBenchmarkThread(messages / thread_count));
+				threads.back()->start();
+			}
+			F64 total_latency = 0.0;
+			F64 max_latency = 0.0;
+			for (S32 i = 0; i < thread_count; ++i)
+			{
+				while (!threads[i]->isStopped())
+				{
+					ms_sleep(1);
+				}
+				total_latency += threads[i]->mTotalLatency;
+				max_latency = llmax(max_latency, threads[i]->mMaxLatency);
+			}
+			F64 logged = timer.getElapsedTimeF64();
+			LLError::flushAsyncLog();
+			F64 written = timer.getElapsedTimeF64();
+			for_each(threads.begin(), threads.end(), DeletePointer());
+			LLError::removeRecorder(recorder);
+
+			S32 logged_count = thread_count * (messages / thread_count);
+			results << "\n  " << (async ? "Asynchronous" : "Synchronous") << ", " << thread_count << " threads: "
+					<< logged * 1000.0 << " ms to log, " << written * 1000.0 << " ms to write " << recorder->mMessages
+					<< " messages (" << logged_count - recorder->mMessages << " dropped); caller latency "
+					<< total_latency * 1.0e9 / logged_count << " ns average, " << max_latency * 1.0e6 << " us max.";
+		}
+	}
+
+	LLError::setAsyncLogging(false);
+	LLError::restoreSettings(saved_settings);
+	LLError::setAsyncLogging(gSavedSettings.getBOOL("AsyncLogging"));
+
+	LL_INFOS("Benchmark") << "Logging, " << messages << " messages:" << results.str() << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Disabled log messages
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// A log message in a hot loop that is filtered out by its tag.
+	void log_disabled(S32 i)
+	{
+		LL_INFOS("BenchmarkDisabled") << "Disabled log message " << i << LL_ENDL;
+	}
+
+	class DisabledLoggingBenchmarkThread : public LLThread
+	{
+	public:
+		DisabledLoggingBenchmarkThread(S32 iterations)
+		:	LLThread("Disabled logging benchmark"),
+			mIterations(iterations)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			for (S32 i = 0; i < mIterations; ++i)
+			{
+				log_disabled(i);
+			}
+		}
+
+	private:
+		const S32 mIterations;
+	};
+}
+
+// Measures what a log message that is filtered out costs in a tight loop, on
+// 1 to 8 threads, and on the main thread while the log settings change every
+// thousand iterations (each change makes every call site evaluate its level
+// again).
+void handle_benchmark_disabled_logging(void*)
+{
+	static const S32 iterations = 50000000;
+	static const S32 changing_iterations = 1000000;
+	static const S32 max_threads = 8;
+
+	LLError::setTagLevel("BenchmarkDisabled", LLError::LEVEL_NONE);
+
+	std::ostringstream results;
+	for (S32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+	{
+		std::vector<DisabledLoggingBenchmarkThread*> threads;
+		LLTimer timer;
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			threads.push_back(new DisabledLoggingBenchmarkThread(iterations));
+			threads.back()->start();
+		}
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			while (!threads[i]->isStopped())
+			{
+				ms_sleep(1);
+			}
+		}
+		F64 elapsed = timer.getElapsedTimeF64();
+		for_each(threads.begin(), threads.end(), DeletePointer());
+		results << "\n  " << thread_count << " threads: " << elapsed * 1.0e9 / iterations << " ns per message per thread.";
+	}
+
+	LLTimer timer;
+	for (S32 i = 0; i < changing_iterations; ++i)
+	{
+		if (i % 1000 == 0)
+		{
+			LLError::setTagLevel("BenchmarkDisabled", LLError::LEVEL_NONE);
+		}
+		log_disabled(i);
+	}
+	F64 elapsed = timer.getElapsedTimeF64();
+	results << "\n  Settings changing every 1000 messages: " << elapsed * 1.0e9 / changing_iterations << " ns per message.";
+
+	LL_INFOS("Benchmark") << "Disabled log messages, " << iterations << " per thread:" << results.str() << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Mutexes
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// What LLMutex and LLCondition were before: a boost recursive mutex, and
+	// a condition variable that works with any lock.
+	struct BoostCondition
+	{
+		boost::recursive_mutex mMutex;
+		boost::condition_variable_any mCondition;
+	};
+
+	// Like the objects the texture fetcher and the mesh repository create
+	// for every request: a worker with a mutex, and a condition.
+	struct WorkerLikeObject
+	{
+		LLMutexRootPool mMutex;
+		LLCondition mCondition;
+	};
+
+	struct BoostWorkerLikeObject
+	{
+		boost::recursive_mutex mMutex;
+		BoostCondition mCondition;
+	};
+
+	template<class MUTEX>
+	class MutexBenchmarkThread : public LLThread
+	{
+	public:
+		MutexBenchmarkThread(MUTEX& mutex, S32& counter, S32 iterations)
+		:	LLThread("Mutex benchmark"),
+			mMutex(mutex),
+			mCounter(counter),
+			mIterations(iterations)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			for (S32 i = 0; i < mIterations; ++i)
+			{
+				mMutex.lock();
+				++mCounter;
+				mMutex.unlock();
+			}
+		}
+
+	private:
+		MUTEX& mMutex;
+		S32& mCounter;
+		const S32 mIterations;
+	};
+
+	template<class MUTEX>
+	F64 time_lock_unlock(MUTEX& mutex, S32 iterations)
+	{
+		LLTimer timer;
+		for (S32 i = 0; i < iterations; ++i)
+		{
+			mutex.lock();
+			mutex.unlock();
+		}
+		return timer.getElapsedTimeF64() * 1.0e9 / iterations;
+	}
+
+	template<class OBJECT>
+	F64 time_construction(S32 iterations)
+	{
+		LLTimer timer;
+		for (S32 i = 0; i < iterations; ++i)
+		{
+			delete new OBJECT;
+		}
+		return timer.getElapsedTimeF64() * 1.0e9 / iterations;
+	}
+
+	template<class MUTEX>
+	F64 time_contended(S32 thread_count, S32 iterations)
+	{
+		MUTEX mutex;
+		S32 counter = 0;
+		std::vector<MutexBenchmarkThread<MUTEX>*> threads;
+		LLTimer timer;
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			threads.push_back(new MutexBenchmarkThread<MUTEX>(mutex, counter, iterations / thread_count));
+			threads.back()->start();
+		}
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			while (!threads[i]->isStopped())
+			{
+				ms_sleep(1);
+			}
+		}
+		F64 elapsed = timer.getElapsedTimeF64();
+		for_each(threads.begin(), threads.end(), DeletePointer());
+		if (counter != thread_count * (iterations / thread_count))
+		{
+			LL_WARNS("Benchmark") << "Mutexes: counted " << counter << " instead of " << thread_count * (iterations / thread_count) << "!" << LL_ENDL;
+		}
+		return elapsed * 1000.0;
+	}
+}
+
+// Compares LLMutex and LLCondition with the boost primitives they used to
+// wrap: locking and unlocking without contention, recursively, signalling
+// without waiters, constructing and destroying objects that have a mutex
+// and a condition, and 4 threads fighting over one mutex.
+void handle_benchmark_mutexes(void*)
+{
+	static const S32 iterations = 10000000;
+	static const S32 constructions = 1000000;
+	static const S32 contended_iterations = 2000000;
+
+	LLMutex mutex;
+	boost::recursive_mutex boost_mutex;
+	F64 ll_lock = time_lock_unlock(mutex, iterations);
+	F64 boost_lock = time_lock_unlock(boost_mutex, iterations);
+
+	mutex.lock();
+	boost_mutex.lock();
+	F64 ll_recursive = time_lock_unlock(mutex, iterations);
+	F64 boost_recursive = time_lock_unlock(boost_mutex, iterations);
+	mutex.unlock();
+	boost_mutex.unlock();
+
+	LLCondition condition;
+	BoostCondition boost_condition;
+	LLTimer timer;
+	for (S32 i = 0; i < iterations; ++i)
+	{
+		condition.lock();
+		condition.signal();
+		condition.unlock();
+	}
+	F64 ll_signal = timer.getElapsedTimeF64() * 1.0e9 / iterations;
+	timer.reset();
+	for (S32 i = 0; i < iterations; ++i)
+	{
+		boost_condition.mMutex.lock();
+		boost_condition.mCondition.notify_one();
+		boost_condition.mMutex.unlock();
+	}
+	F64 boost_signal = timer.getElapsedTimeF64() * 1.0e9 / iterations;
+
+	F64 ll_construction = time_construction<WorkerLikeObject>(constructions);
+	F64 boost_construction = time_construction<BoostWorkerLikeObject>(constructions);
+
+	F64 ll_contended = time_contended<LLMutex>(4, contended_iterations);
+	F64 boost_contended = time_contended<boost::recursive_mutex>(4, contended_iterations);
+
+	LL_INFOS("Benchmark") << "Mutexes (LLMutex vs. boost):"
+						  << "\n  Lock and unlock: " << ll_lock << " vs. " << boost_lock << " ns."
+						  << "\n  Recursive lock and unlock: " << ll_recursive << " vs. " << boost_recursive << " ns."
+						  << "\n  Signal without waiters: " << ll_signal << " vs. " << boost_signal << " ns."
+						  << "\n  Construct and destroy a mutex and a condition: " << ll_construction << " vs. " << boost_construction
+						  << " ns (" << sizeof(WorkerLikeObject) << " vs. " << sizeof(BoostWorkerLikeObject) << " bytes)."
+						  << "\n  4 threads, " << contended_iterations << " locks: " << ll_contended << " vs. " << boost_contended << " ms." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Read-mostly access
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	typedef std::map<std::string, S32> read_mostly_map_t;
+
+	// Reads one of the map's entries through LOCKED, until told to stop.
+	template<class LOCKED>
+	class ReadMostlyReaderThread : public LLThread
+	{
+	public:
+		ReadMostlyReaderThread(LOCKED& map, const std::vector<std::string>& keys, const LLAtomicS32& stop)
+		:	LLThread("Read-mostly benchmark reader"),
+			mReads(0),
+			mMap(map),
+			mKeys(keys),
+			mStop(stop)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			U32 random = (U32)(size_t)this;		// ll_rand() isn't thread safe.
+			while (!mStop)
+			{
+				random = random * 1664525 + 1013904223;
+				const std::string& key = mKeys[(random >> 16) % mKeys.size()];
+				mMap.read(key);
+				++mReads;
+			}
+		}
+
+		S32 mReads;
+
+	private:
+		LOCKED& mMap;
+		const std::vector<std::string>& mKeys;
+		const LLAtomicS32& mStop;
+	};
+
+	struct RWLockedMap
+	{
+		AIThreadSafeDC<read_mostly_map_t> mMap;
+
+		S32 read(const std::string& key)
+		{
+			AIReadAccess<read_mostly_map_t> map_r(mMap);
+			read_mostly_map_t::const_iterator it = map_r->find(key);
+			return it == map_r->end() ? 0 : it->second;
+		}
+		void write(const std::string& key)
+		{
+			++(*AIWriteAccess<read_mostly_map_t>(mMap))[key];
+		}
+	};
+
+	struct RCUMap
+	{
+		AIThreadSafeRCU<read_mostly_map_t> mMap;
+
+		S32 read(const std::string& key)
+		{
+			AIRCUReadAccess<read_mostly_map_t> map_r(mMap);
+			read_mostly_map_t::const_iterator it = map_r->find(key);
+			return it == map_r->end() ? 0 : it->second;
+		}
+		void write(const std::string& key)
+		{
+			++(*AIRCUWriteAccess<read_mostly_map_t>(mMap))[key];
+		}
+	};
+
+	// Runs reader_count readers for a while, the main thread changing the
+	// map every millisecond. Returns the reads per second, and the average
+	// time a write took in write_us.
+	template<class LOCKED>
+	F64 run_read_mostly(S32 reader_count, const std::vector<std::string>& keys, F64& write_us)
+	{
+		static const S32 writes = 200;
+
+		LOCKED map;
+		for (U32 i = 0; i < keys.size(); ++i)
+		{
+			map.write(keys[i]);
+		}
+
+		LLAtomicS32 stop(0);
+		std::vector<ReadMostlyReaderThread<LOCKED>*> threads;
+		for (S32 i = 0; i < reader_count; ++i)
+		{
+			threads.push_back(new ReadMostlyReaderThread<LOCKED>(map, keys, stop));
+			threads.back()->start();
+		}
+		LLTimer timer;
+		F64 writing = 0.0;
+		for (S32 i = 0; i < writes; ++i)
+		{
+			ms_sleep(1);
+			F64 start = timer.getElapsedTimeF64();
+			map.write(keys[i % keys.size()]);
+			writing += timer.getElapsedTimeF64() - start;
+		}
+		stop = 1;
+		F64 elapsed = timer.getElapsedTimeF64();
+		S32 reads = 0;
+		for (S32 i = 0; i < reader_count; ++i)
+		{
+			while (!threads[i]->isStopped())
+			{
+				ms_sleep(1);
+			}
+			reads += threads[i]->mReads;
+		}
+		for_each(threads.begin(), threads.end(), DeletePointer());
+		write_us = writing * 1.0e6 / writes;
+		return reads / elapsed;
+	}
+}
+
+// Compares the read throughput of 1 to 8 threads looking up entries in a
+// map that the main thread changes every millisecond, when the map is
+// protected by AIThreadSafe (a read/write lock) and by AIThreadSafeRCU
+// (readers never wait, writers copy the map), and what a write costs.
+void handle_benchmark_read_mostly(void*)
+{
+	static const S32 key_count = 200;
+	static const S32 max_threads = 8;
+
+	std::vector<std::string> keys;
+	for (S32 i = 0; i < key_count; ++i)
+	{
+		keys.push_back(llformat("https://sim%d.agni.lindenlab.com:12043", i));
+	}
+
+	std::ostringstream results;
+	for (S32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+	{
+		F64 rw_write_us;
+		F64 rcu_write_us;
+		F64 rw_reads = run_read_mostly<RWLockedMap>(thread_count, keys, rw_write_us);
+		F64 rcu_reads = run_read_mostly<RCUMap>(thread_count, keys, rcu_write_us);
+		results << "\n  " << thread_count << " readers: " << rw_reads / 1.0e6 << " vs. " << rcu_reads / 1.0e6
+				<< " million reads/s, writes " << rw_write_us << " vs. " << rcu_write_us << " us.";
+	}
+
+	LL_INFOS("Benchmark") << "Read-mostly access (AIThreadSafe vs. AIThreadSafeRCU), " << key_count << " entries:" << results.str() << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// State machine engines
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Does a little work in each of a few runs, yielding in between.
+	class BenchmarkStateMachine : public AIStateMachine
+	{
+	protected:
+		typedef AIStateMachine direct_base_type;
+
+		enum benchmark_state_type {
+			Benchmark_step = direct_base_type::max_state
+		};
+
+	public:
+		static state_type const max_state = Benchmark_step + 1;
+
+	public:
+		BenchmarkStateMachine(void) : AIStateMachine(CWD_ONLY(false)), mSteps(0), mResult(0) { }
+
+		/*virtual*/ const char* getName() const { return "BenchmarkStateMachine"; }
+
+	protected:
+		/*virtual*/ ~BenchmarkStateMachine() { }
+
+		/*virtual*/ void initialize_impl(void) { set_state(Benchmark_step); }
+		/*virtual*/ void multiplex_impl(state_type run_state)
+		{
+			static const S32 steps = 4;
+			for (U32 i = 0; i < 100; ++i)
+			{
+				mResult = mResult * 31 + i;
+			}
+			if (++mSteps < steps)
+			{
+				yield();
+			}
+			else
+			{
+				finish();
+			}
+		}
+		/*virtual*/ char const* state_str_impl(state_type run_state) const
+		{
+			switch(run_state)
+			{
+				AI_CASE_RETURN(Benchmark_step);
+			}
+			llassert(false);
+			return "UNKNOWN STATE";
+		}
+
+	private:
+		S32 mSteps;
+		U32 mResult;
+	};
+
+	// Runs an engine like the state machine thread(s) do.
+	class EngineBenchmarkThread : public LLThread
+	{
+	public:
+		EngineBenchmarkThread(AIEngine& engine, bool pool, const LLAtomicS32& stop)
+		:	LLThread("State machine benchmark engine"),
+			mEngine(engine),
+			mPool(pool),
+			mStop(stop)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			while (!mStop)
+			{
+				if (mPool)
+				{
+					mEngine.poolloop();
+				}
+				else
+				{
+					mEngine.threadloop();
+				}
+			}
+		}
+
+	private:
+		AIEngine& mEngine;
+		bool mPool;
+		const LLAtomicS32& mStop;
+	};
+
+	// Returns the time it takes to run machine_count state machines to the end.
+	F64 time_state_machines(S32 thread_count, bool pool, S32 machine_count)
+	{
+		AIEngine engine("Benchmark engine");
+		LLAtomicS32 stop(0);
+		std::vector<EngineBenchmarkThread*> threads;
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			threads.push_back(new EngineBenchmarkThread(engine, pool, stop));
+			threads.back()->start();
+		}
+
+		LLAtomicS32 done(0);
+		LLTimer timer;
+		for (S32 i = 0; i < machine_count; ++i)
+		{
+			(new BenchmarkStateMachine)->run([&done](bool) { done++; }, &engine);
+		}
+		wait_for(done, machine_count);
+		F64 elapsed = timer.getElapsedTimeF64();
+
+		stop = 1;
+		for (S32 i = 0; i < thread_count; ++i)
+		{
+			// The engine may still be waiting for work.
+			while (!threads[i]->isStopped())
+			{
+				engine.wake_up();
+				ms_sleep(1);
+			}
+		}
+		for_each(threads.begin(), threads.end(), DeletePointer());
+		return elapsed;
+	}
+}
+
+// Runs 100,000 small state machines, that each yield a few times, through
+// a single thread running AIEngine::threadloop (like the state machine
+// thread by default) and through pools of 1 to 8 threads running
+// AIEngine::poolloop (StateMachineThreads > 1).
+void handle_benchmark_state_machines(void*)
+{
+	static const S32 machine_count = 100000;
+	static const S32 max_threads = 8;
+
+	F64 elapsed = time_state_machines(1, false, machine_count);
+	LL_INFOS("Benchmark") << "State machines, " << machine_count << " through a single thread engine: "
+						  << elapsed * 1.0e6 / machine_count << " us per state machine." << LL_ENDL;
+	for (S32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+	{
+		elapsed = time_state_machines(thread_count, true, machine_count);
+		LL_INFOS("Benchmark") << "State machines, " << machine_count << " through a pool of " << thread_count << " threads: "
+							  << elapsed * 1.0e6 / machine_count << " us per state machine." << LL_ENDL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Thread-safe queue
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	class QueueProducerThread : public LLThread
+	{
+	public:
+		QueueProducerThread(LLThreadSafeQueue<U32>& queue, S32 count)
+		:	LLThread("Queue benchmark producer"),
+			mQueue(queue),
+			mCount(count)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			for (S32 i = 0; i < mCount; ++i)
+			{
+				mQueue.pushFront((U32)i);
+			}
+		}
+
+	private:
+		LLThreadSafeQueue<U32>& mQueue;
+		S32 mCount;
+	};
+
+	class QueueConsumerThread : public LLThread
+	{
+	public:
+		QueueConsumerThread(LLThreadSafeQueue<U32>& queue, S32 count)
+		:	LLThread("Queue benchmark consumer"),
+			mQueue(queue),
+			mCount(count),
+			mSum(0)
+		{
+		}
+
+		/*virtual*/ void run()
+		{
+			for (S32 i = 0; i < mCount; ++i)
+			{
+				mSum += mQueue.popBack();
+			}
+		}
+
+	private:
+		LLThreadSafeQueue<U32>& mQueue;
+		S32 mCount;
+		U32 mSum;
+	};
+
+	// Returns the time per element when producers push, and consumers pop,
+	// element_count elements through one queue, blocking when it's full or empty.
+	F64 time_queue(S32 producers, S32 consumers, S32 element_count)
+	{
+		LLThreadSafeQueue<U32> queue(1024);
+		std::vector<LLThread*> threads;
+		LLTimer timer;
+		for (S32 i = 0; i < consumers; ++i)
+		{
+			threads.push_back(new QueueConsumerThread(queue, element_count / consumers));
+			threads.back()->start();
+		}
+		for (S32 i = 0; i < producers; ++i)
+		{
+			threads.push_back(new QueueProducerThread(queue, element_count / producers));
+			threads.back()->start();
+		}
+		for (S32 i = 0; i < (S32)threads.size(); ++i)
+		{
+			while (!threads[i]->isStopped())
+			{
+				ms_sleep(1);
+			}
+		}
+		F64 elapsed = timer.getElapsedTimeF64();
+		for_each(threads.begin(), threads.end(), DeletePointer());
+		return elapsed * 1.0e9 / element_count;
+	}
+}
+
+// Measures LLThreadSafeQueue throughput with one producer and one consumer,
+// several producers and one consumer (like the main loop repeater), and
+// several of both.
+void handle_benchmark_thread_safe_queue(void*)
+{
+	static const S32 element_count = 1000000;	// Divisible by all thread counts below.
+
+	LL_INFOS("Benchmark") << "Thread-safe queue, " << element_count << " elements, 1:1: "
+						  << time_queue(1, 1, element_count) << " ns per element." << LL_ENDL;
+	LL_INFOS("Benchmark") << "Thread-safe queue, " << element_count << " elements, 4:1: "
+						  << time_queue(4, 1, element_count) << " ns per element." << LL_ENDL;
+	LL_INFOS("Benchmark") << "Thread-safe queue, " << element_count << " elements, 4:4: "
+						  << time_queue(4, 4, element_count) << " ns per element." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Avatar startup
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Returns the milliseconds per load of an avatar definition file.
+	F64 time_xml_tree(const std::string& filename, bool snapshot, S32 iterations)
+	{
+		LLTimer timer;
+		for (S32 i = 0; i < iterations; ++i)
+		{
+			LLXmlTree tree;
+			if (snapshot)
+			{
+				LLAvatarSnapshot::instance().loadXmlTree(filename, tree);
+			}
+			else
+			{
+				tree.parseFile(filename, FALSE);
+			}
+		}
+		return timer.getElapsedTimeF64() * 1000.0 / iterations;
+	}
+
+	// Returns the milliseconds it takes to load all the given meshes.
+	F64 time_meshes(const std::vector<std::string>& filenames)
+	{
+		LLTimer timer;
+		for (std::vector<std::string>::const_iterator iter = filenames.begin(); iter != filenames.end(); ++iter)
+		{
+			LLPolyMeshSharedData* mesh = new LLPolyMeshSharedData;
+			mesh->loadMesh(*iter);
+			delete mesh;
+		}
+		return timer.getElapsedTimeF64() * 1000.0;
+	}
+}
+
+// Compares parsing the avatar definition files and base meshes from their
+// source files with loading them from the avatar startup snapshot.
+void handle_benchmark_avatar_startup(void*)
+{
+	static const S32 iterations = 20;
+
+	bool was_enabled = LLAvatarSnapshot::enabled();
+	LLAvatarSnapshot& snapshot = LLAvatarSnapshot::instance();
+
+	const char* xml_files[] = { "avatar_lad.xml", "avatar_skeleton.xml" };
+	for (size_t i = 0; i < LL_ARRAY_SIZE(xml_files); ++i)
+	{
+		std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_CHARACTER, xml_files[i]);
+		LLXmlTree tree;
+		if (!tree.parseFile(filename, FALSE))
+		{
+			continue;
+		}
+		LLAvatarSnapshot::setEnabled(true);
+		snapshot.storeXmlTree(filename, tree);
+		LL_INFOS("Benchmark") << xml_files[i] << ": parse " << time_xml_tree(filename, false, iterations)
+							  << " ms, snapshot " << time_xml_tree(filename, true, iterations) << " ms." << LL_ENDL;
+	}
+
+	// LOD meshes are named like avatar_head_1.llm, and need their base mesh.
+	std::vector<std::string> meshes;
+	std::string dir = gDirUtilp->getExpandedFilename(LL_PATH_CHARACTER, "");
+	LLDirIterator iter(dir, "*.llm");
+	std::string name;
+	while (iter.next(name))
+	{
+		if (name.size() < 6 || name[name.size() - 6] != '_' || !isdigit((U8)name[name.size() - 5]))
+		{
+			meshes.push_back(gDirUtilp->add(dir, name));
+		}
+	}
+
+	LLAvatarSnapshot::setEnabled(false);
+	F64 parse_ms = time_meshes(meshes);
+	LLAvatarSnapshot::setEnabled(true);
+	time_meshes(meshes);		// Fill in missing sections.
+	F64 snapshot_ms = time_meshes(meshes);
+	LL_INFOS("Benchmark") << meshes.size() << " base meshes: parse " << parse_ms
+						  << " ms, snapshot " << snapshot_ms << " ms." << LL_ENDL;
+
+	snapshot.save();
+	LL_INFOS("Benchmark") << "Avatar snapshot hits: " << snapshot.getHits() << ", misses: " << snapshot.getMisses() << LL_ENDL;
+	LLAvatarSnapshot::setEnabled(was_enabled);
+}
+
+//-----------------------------------------------------------------------------
+// Morph targets
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	struct MorphedMesh
+	{
+		LLPolyMesh* mMesh;
+		std::vector<LLPolyMorphData*> mMorphs;
+	};
+
+	// Returns the milliseconds it takes to apply every morph of every mesh,
+	// like a full appearance update does, one morph at a time or in a batch.
+	F64 time_morphs(const std::vector<MorphedMesh>& meshes, bool batch, S32 rounds)
+	{
+		std::vector<LLPolyMesh*> batched;
+		LLTimer timer;
+		for (S32 round = 0; round < rounds; ++round)
+		{
+			// Alternate the sign so that the vertices don't drift away.
+			F32 delta_weight = (round & 1) ? -0.5f : 0.5f;
+			for (std::vector<MorphedMesh>::const_iterator iter = meshes.begin(); iter != meshes.end(); ++iter)
+			{
+				if (batch)
+				{
+					iter->mMesh->beginMorphBatch();
+					batched.push_back(iter->mMesh);
+				}
+				for (std::vector<LLPolyMorphData*>::const_iterator morph = iter->mMorphs.begin(); morph != iter->mMorphs.end(); ++morph)
+				{
+					(*morph)->applyTo(iter->mMesh, delta_weight, NULL, false);
+				}
+			}
+			if (batch)
+			{
+				LLPolyMesh::endMorphBatches(batched);
+				batched.clear();
+			}
+		}
+		return timer.getElapsedTimeF64() * 1000.0 / rounds;
+	}
+}
+
+// Applies all morph targets of the base avatar meshes, both one morph at a
+// time (renormalizing after each) and batched per mesh (renormalizing once,
+// spread over the job system workers).
+void handle_benchmark_morph_targets(void*)
+{
+	static const S32 rounds = 20;
+
+	std::vector<MorphedMesh> meshes;
+	std::string dir = gDirUtilp->getExpandedFilename(LL_PATH_CHARACTER, "");
+	LLDirIterator iter(dir, "*.llm");
+	std::string name;
+	U32 morph_count = 0;
+	while (iter.next(name))
+	{
+		// Skip LOD meshes, like avatar_head_1.llm.
+		if (name.size() >= 6 && name[name.size() - 6] == '_' && isdigit((U8)name[name.size() - 5]))
+		{
+			continue;
+		}
+		LLPolyMesh* mesh = LLPolyMesh::getMesh(name);
+		if (!mesh)
+		{
+			continue;
+		}
+		MorphedMesh morphed;
+		morphed.mMesh = mesh;
+		LLPolyMesh::morph_list_t morphs;
+		LLPolyMesh::getMorphList(name, &morphs);
+		for (LLPolyMesh::morph_list_t::iterator morph = morphs.begin(); morph != morphs.end(); ++morph)
+		{
+			morphed.mMorphs.push_back(morph->second);
+		}
+		morph_count += morphed.mMorphs.size();
+		meshes.push_back(morphed);
+	}
+
+	LL_INFOS("Benchmark") << "Morph targets, " << morph_count << " morphs on " << meshes.size() << " meshes: one at a time "
+						  << time_morphs(meshes, false, rounds) << " ms, batched " << time_morphs(meshes, true, rounds)
+						  << " ms with " << LLJobSystem::instance().getWorkerCount() << " workers." << LL_ENDL;
+
+	for (std::vector<MorphedMesh>::iterator mesh = meshes.begin(); mesh != meshes.end(); ++mesh)
+	{
+		delete mesh->mMesh;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Rigged skinning
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Fills mat with small random rotations and translations, like the joint
+	// matrices of an animated avatar.
+	void random_palette(LLMatrix4a* mat, U32 count)
+	{
+		for (U32 j = 0; j < count; ++j)
+		{
+			LLVector3 axis(ll_frand(), ll_frand(), 1.f);
+			axis.normVec();
+			LLMatrix4 m;
+			m.initRotTrans(ll_frand(), axis, LLVector3(ll_frand(), ll_frand(), ll_frand()));
+			mat[j].loadu(m);
+		}
+	}
+}
+
+// Skins the positions of a rigged mesh sized like a dense attachment, once
+// through the per-vertex matrix blend the picking path used to do and once
+// through the position kernel with the bind shape matrix folded into the
+// palette.
+void handle_benchmark_rigged_skinning(void*)
+{
+	static const U32 vertex_count = 65536;
+	static const U32 joint_count = 64;
+	static const S32 rounds = 20;
+
+	LLMatrix4a mat[joint_count];
+	random_palette(mat, joint_count);
+
+	LLMatrix4a bind_shape_matrix;
+	random_palette(&bind_shape_matrix, 1);
+
+	LLMatrix4a palette[joint_count];
+	for (U32 j = 0; j < joint_count; ++j)
+	{
+		palette[j].setMul(mat[j], bind_shape_matrix);
+	}
+
+	LLAlignedArray<LLVector4a, 64> positions;
+	LLAlignedArray<LLVector4a, 64> weights;
+	LLAlignedArray<LLVector4a, 64> blended;
+	LLAlignedArray<LLVector4a, 64> skinned;
+	positions.resize(vertex_count);
+	weights.resize(vertex_count);
+	blended.resize(vertex_count);
+	skinned.resize(vertex_count);
+	for (U32 i = 0; i < vertex_count; ++i)
+	{
+		positions[i].set(ll_frand(), ll_frand(), ll_frand(), 1.f);
+		// Two influences per vertex, the typical case.
+		F32 w = llclamp(ll_frand(), 0.01f, 0.99f);
+		weights[i].set(ll_rand(joint_count) + w, ll_rand(joint_count) + (1.f - w), 0.f, 0.f);
+	}
+
+	LLVector4a offset;
+	offset.set(128.f, 128.f, 24.f);
+
+	U32 max_joints = LLSkinningUtil::getMaxJointCount();
+	LLTimer timer;
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		for (U32 i = 0; i < vertex_count; ++i)
+		{
+			LLMatrix4a final_mat;
+			LLSkinningUtil::getPerVertexSkinMatrix(weights[i].getF32ptr(), mat, false, final_mat, max_joints);
+
+			LLVector4a t;
+			bind_shape_matrix.affineTransform(positions[i], t);
+			final_mat.affineTransform(t, blended[i]);
+			blended[i].add(offset);
+		}
+	}
+	F64 blend_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	LLVector4a extents[2];
+	timer.reset();
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		LLSkinningUtil::skinPositions(palette, joint_count, weights.mArray, positions.mArray, vertex_count,
+									  offset, skinned.mArray, extents);
+	}
+	F64 kernel_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	F32 max_error = 0.f;
+	for (U32 i = 0; i < vertex_count; ++i)
+	{
+		LLVector4a diff;
+		diff.setSub(blended[i], skinned[i]);
+		max_error = llmax(max_error, diff.getLength3().getF32());
+	}
+
+	LL_INFOS("Benchmark") << "Rigged skinning, " << vertex_count << " vertices: per-vertex matrices " << blend_ms
+						  << " ms, position kernel " << kernel_ms << " ms, largest difference " << max_error << " m." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Minimap objects
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Runs one object layer update and returns the number of texels it
+	// redrew (and that would be uploaded).
+	S32 update_object_layer(LLNetMapObjectLayer& layer, const LLVector3d& center)
+	{
+		layer.update(center);
+		layer.flush();
+
+		std::vector<LLRect> rects;
+		layer.takeDirtyRects(rects);
+		S32 texels = 0;
+		for (std::vector<LLRect>::const_iterator rect = rects.begin(); rect != rects.end(); ++rect)
+		{
+			texels += rect->getWidth() * rect->getHeight();
+		}
+		return texels;
+	}
+}
+
+// Draws a synthetic set of map objects into a mini map sized raster, redrawn
+// from scratch like the mini map used to every refresh, and then kept up to
+// date while a few objects move and the camera walks along.
+void handle_benchmark_minimap_objects(void*)
+{
+	static const S32 object_count = 15000;
+	static const S32 moving_count = 50;
+	static const S32 raster_size = 512;
+	static const F32 texels_per_meter = 1.f;
+	static const S32 rounds = 50;
+
+	LLPointer<LLImageRaw> raw = new LLImageRaw(raster_size, raster_size, 4);
+	LLNetMapObjectLayer layer;
+	layer.setRaster(raw, texels_per_meter);
+	layer.clearDots();
+
+	LLVector3d center(256000.0, 256000.0, 30.0);
+	std::vector<LLNetMapObjectLayer::Dot> dots(object_count);
+	for (S32 i = 0; i < object_count; ++i)
+	{
+		LLNetMapObjectLayer::Dot& dot = dots[i];
+		dot.mPosGlobal.setVec(center.mdV[VX] + (ll_frand() - 0.5f) * raster_size / texels_per_meter,
+							  center.mdV[VY] + (ll_frand() - 0.5f) * raster_size / texels_per_meter,
+							  ll_frand(100.f));
+		dot.mRadius = 0.5f + ll_frand(4.f);
+		dot.mColor = LLColor4U(ll_rand(256), ll_rand(256), ll_rand(256), 255);
+		dot.mOwned = false;
+		layer.setDot((LLNetMapObjectLayer::key_t)(intptr_t)(i + 1), dot);
+	}
+	update_object_layer(layer, center);
+
+	LLTimer timer;
+	S32 full_texels = 0;
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		layer.setRaster(raw, texels_per_meter);
+		full_texels += update_object_layer(layer, center);
+	}
+	F64 full_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	timer.reset();
+	S32 incremental_texels = 0;
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		for (S32 i = 0; i < moving_count; ++i)
+		{
+			S32 index = ll_rand(object_count);
+			dots[index].mPosGlobal.mdV[VX] += 1.0;
+			layer.setDot((LLNetMapObjectLayer::key_t)(intptr_t)(index + 1), dots[index]);
+		}
+		center.mdV[VX] += 0.5;
+		incremental_texels += update_object_layer(layer, center);
+	}
+	F64 incremental_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	LL_INFOS("Benchmark") << "Minimap objects, " << object_count << " objects on a " << raster_size << "x" << raster_size
+						  << " raster: full redraw " << full_ms << " ms (" << full_texels / rounds << " texels uploaded), "
+						  << moving_count << " moving with the camera walking " << incremental_ms << " ms ("
+						  << incremental_texels / rounds << " texels uploaded)." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Radar updates
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	const U32 RADAR_REGIONS_PER_SIDE = 2;
+
+	struct RadarAvatar
+	{
+		LLUUID		mID;
+		LLVector3d	mPosGlobal;
+	};
+
+	// Packs the avatars into per region coarse location lists, the way the
+	// CoarseLocationUpdate handlers fill LLViewerRegion::mMapAvatars.
+	void pack_coarse_locations(const std::vector<RadarAvatar>& avatars, const LLVector3d& origin,
+							   std::vector<std::vector<U32> >& locations, std::vector<uuid_vec_t>& ids)
+	{
+		for (U32 i = 0; i < RADAR_REGIONS_PER_SIDE * RADAR_REGIONS_PER_SIDE; ++i)
+		{
+			locations[i].clear();
+			ids[i].clear();
+		}
+		for (std::vector<RadarAvatar>::const_iterator it = avatars.begin(); it != avatars.end(); ++it)
+		{
+			LLVector3d local = it->mPosGlobal - origin;
+			U32 region_x = llclamp((U32)(local.mdV[VX] / REGION_WIDTH_METERS), 0U, RADAR_REGIONS_PER_SIDE - 1);
+			U32 region_y = llclamp((U32)(local.mdV[VY] / REGION_WIDTH_METERS), 0U, RADAR_REGIONS_PER_SIDE - 1);
+			U32 x = llclamp((U32)(local.mdV[VX] - region_x * REGION_WIDTH_METERS), 0U, 255U);
+			U32 y = llclamp((U32)(local.mdV[VY] - region_y * REGION_WIDTH_METERS), 0U, 255U);
+			U32 z = llclamp((U32)(local.mdV[VZ] / 4.0), 0U, 255U);
+			U32 region = region_y * RADAR_REGIONS_PER_SIDE + region_x;
+			locations[region].push_back((x << 16) | (y << 8) | z);
+			ids[region].push_back(it->mID);
+		}
+	}
+
+	void move_radar_avatars(std::vector<RadarAvatar>& avatars, S32 count, F64 extent)
+	{
+		for (S32 i = 0; i < count; ++i)
+		{
+			LLVector3d& pos = avatars[ll_rand((S32)avatars.size())].mPosGlobal;
+			pos.mdV[VX] = llclamp(pos.mdV[VX] + ll_frand(8.f) - 4.0, 0.0, extent - 1.0);
+			pos.mdV[VY] = llclamp(pos.mdV[VY] + ll_frand(8.f) - 4.0, 0.0, extent - 1.0);
+		}
+	}
+
+	void make_radar_row(LLScrollListItem::Params& row, const RadarAvatar& avatar, const LLVector3d& agent_pos)
+	{
+		row.value = avatar.mID;
+		row.columns.add(LLScrollListCell::Params().column("avatar_name").value(avatar.mID.asString()));
+		row.columns.add(LLScrollListCell::Params().column("distance").value(llformat("%.1f", dist_vec(avatar.mPosGlobal, agent_pos))));
+		row.columns.add(LLScrollListCell::Params().column("position").value(llformat("%d, %d", (S32)avatar.mPosGlobal.mdV[VX] % 256, (S32)avatar.mPosGlobal.mdV[VY] % 256)));
+	}
+}
+
+// Feeds coarse location updates for a crowd spread over four regions, a
+// fifth of them walking between updates, through the per region list
+// bookkeeping and linear entry lookups the radar used to do, then through
+// the avatar index. Then refreshes a radar like list by rebuilding all its
+// rows, and by diffing them in place.
+void handle_benchmark_radar_updates(void*)
+{
+	static const S32 avatar_count = 500;
+	static const S32 moving_count = 100;
+	static const S32 rounds = 50;
+	const U32 region_count = RADAR_REGIONS_PER_SIDE * RADAR_REGIONS_PER_SIDE;
+	const F64 extent = RADAR_REGIONS_PER_SIDE * REGION_WIDTH_METERS;
+
+	// Well away from any grid coordinates a session would be using
+	const LLVector3d origin(256.0 * 10000.0, 256.0 * 10000.0, 0.0);
+	std::vector<U64> handles(region_count);
+	for (U32 i = 0; i < region_count; ++i)
+	{
+		handles[i] = to_region_handle((U32)origin.mdV[VX] + (i % RADAR_REGIONS_PER_SIDE) * REGION_WIDTH_U32,
+									  (U32)origin.mdV[VY] + (i / RADAR_REGIONS_PER_SIDE) * REGION_WIDTH_U32);
+	}
+
+	std::vector<RadarAvatar> avatars(avatar_count);
+	for (S32 i = 0; i < avatar_count; ++i)
+	{
+		avatars[i].mID.generate();
+		avatars[i].mPosGlobal.setVec(origin.mdV[VX] + ll_frand(extent), origin.mdV[VY] + ll_frand(extent), 20.0 + ll_frand(40.f));
+	}
+	std::vector<RadarAvatar> start = avatars;
+
+	std::vector<std::vector<U32> > locations(region_count);
+	std::vector<uuid_vec_t> ids(region_count), previous_ids(region_count);
+	S32 found = 0;
+
+	// Old bookkeeping: a list of last update's ids trimmed one id at a time,
+	// a linear entry lookup per reported avatar, and a scan of the other
+	// regions' lists for every departure.
+	uuid_vec_t entries;
+	LLTimer timer;
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		move_radar_avatars(avatars, moving_count, extent);
+		pack_coarse_locations(avatars, origin, locations, ids);
+		for (U32 region = 0; region < region_count; ++region)
+		{
+			std::list<LLUUID> map_avids(previous_ids[region].begin(), previous_ids[region].end());
+			for (const LLUUID& id : ids[region])
+			{
+				map_avids.remove(id);
+				if (std::find(entries.begin(), entries.end(), id) == entries.end())
+				{
+					entries.push_back(id);
+				}
+				else
+				{
+					++found;
+				}
+			}
+			previous_ids[region] = ids[region];
+
+			if (map_avids.empty()) continue;
+			uuid_vec_t existing;
+			for (U32 other = 0; other < region_count; ++other)
+			{
+				existing.insert(existing.end(), previous_ids[other].begin(), previous_ids[other].end());
+			}
+			for (const LLUUID& id : map_avids)
+			{
+				if (std::find(existing.begin(), existing.end(), id) != existing.end()) continue;
+				entries.erase(std::find(entries.begin(), entries.end(), id));
+			}
+		}
+	}
+	F64 list_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	avatars = start;
+	found = 0;
+	S32 changes = 0;
+	LLAvatarSpatialIndex& index(LLAvatarSpatialIndex::instance());
+	boost::signals2::scoped_connection connection = index.setChangeCallback([&changes](const LLUUID&, LLAvatarSpatialIndex::EChange) { ++changes; });
+	timer.reset();
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		move_radar_avatars(avatars, moving_count, extent);
+		pack_coarse_locations(avatars, origin, locations, ids);
+		for (U32 region = 0; region < region_count; ++region)
+		{
+			LLVector3d region_origin = origin;
+			region_origin.mdV[VX] += (region % RADAR_REGIONS_PER_SIDE) * REGION_WIDTH_METERS;
+			region_origin.mdV[VY] += (region / RADAR_REGIONS_PER_SIDE) * REGION_WIDTH_METERS;
+			index.updateRegion(handles[region], region_origin, locations[region], ids[region]);
+			for (const LLUUID& id : ids[region])
+			{
+				found += index.find(id) != NULL;
+			}
+		}
+	}
+	F64 index_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+	connection.disconnect();
+
+	uuid_vec_t in_range;
+	index.getAvatarsInRange(origin + LLVector3d(extent / 2.0, extent / 2.0, 40.0), 96.f, in_range);
+
+	for (U32 region = 0; region < region_count; ++region)
+	{
+		index.removeRegion(handles[region]);
+	}
+
+	// Row refresh of a radar like list, sorted on distance
+	LLScrollListCtrl* list = new LLScrollListCtrl(std::string("benchmark_radar"), LLRect(0, 400, 400, 0), NULL, true);
+	const char* column_names[] = { "avatar_name", "distance", "position" };
+	for (const char* name : column_names)
+	{
+		LLScrollListColumn::Params column;
+		column.name = name;
+		column.width.pixel_width = 100;
+		list->addColumn(column);
+	}
+	list->sortByColumn("distance", TRUE);
+
+	const LLVector3d agent_pos = origin + LLVector3d(extent / 2.0, extent / 2.0, 30.0);
+	avatars = start;
+	timer.reset();
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		move_radar_avatars(avatars, moving_count, extent);
+		list->deleteAllItems();
+		for (const RadarAvatar& avatar : avatars)
+		{
+			LLScrollListItem::Params row;
+			make_radar_row(row, avatar, agent_pos);
+			list->addRow(row);
+		}
+		list->updateSort();
+	}
+	F64 rebuild_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	avatars = start;
+	timer.reset();
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		move_radar_avatars(avatars, moving_count, extent);
+		absl::flat_hash_map<LLUUID, LLScrollListItem*> rows;
+		for (LLScrollListItem* item : list->getAllData())
+		{
+			rows.emplace(item->getUUID(), item);
+		}
+		for (const RadarAvatar& avatar : avatars)
+		{
+			LLScrollListItem::Params row;
+			make_radar_row(row, avatar, agent_pos);
+			auto it = rows.find(avatar.mID);
+			if (it == rows.end())
+			{
+				list->addRow(row);
+			}
+			else
+			{
+				list->updateRow(it->second, row);
+			}
+		}
+		list->updateSort();
+	}
+	F64 diff_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+	delete list;
+
+	LL_INFOS("Benchmark") << "Radar updates, " << avatar_count << " avatars in " << region_count << " regions, "
+						  << moving_count << " moving per update: list bookkeeping " << list_ms << " ms, avatar index "
+						  << index_ms << " ms (" << changes / rounds << " changes per update, " << found << " lookups hit, "
+						  << in_range.size() << " within 96m of the center); rows rebuilt " << rebuild_ms
+						  << " ms, rows diffed " << diff_ms << " ms." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Scroll list rows
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	struct BenchmarkRow
+	{
+		std::string	mName;
+		std::string	mSize;
+		std::string	mOwner;
+	};
+
+	// Rows are indices into a table, the way a floater would back a large
+	// list with its own data.
+	class BenchmarkRowModel : public LLScrollListRowModel
+	{
+	public:
+		BenchmarkRowModel(const std::vector<BenchmarkRow>& rows) : mRows(rows) {}
+
+		/*virtual*/ void buildRow(const LLSD& value, LLScrollListItem::Params& row) const
+		{
+			const BenchmarkRow& data = mRows[value.asInteger()];
+			row.value = value;
+			row.columns.add(LLScrollListCell::Params().column("name").value(data.mName));
+			row.columns.add(LLScrollListCell::Params().column("size").value(data.mSize));
+			row.columns.add(LLScrollListCell::Params().column("owner").value(data.mOwner));
+		}
+
+		/*virtual*/ std::string getKey(const LLSD& value, const std::string& column) const
+		{
+			const BenchmarkRow& data = mRows[value.asInteger()];
+			return column == "name" ? data.mName : column == "size" ? data.mSize : data.mOwner;
+		}
+
+	private:
+		const std::vector<BenchmarkRow>& mRows;
+	};
+
+	LLScrollListCtrl* make_benchmark_list()
+	{
+		LLScrollListCtrl* list = new LLScrollListCtrl(std::string("benchmark_rows"), LLRect(0, 400, 400, 0), NULL, true);
+		list->setMaxItemCount(S32_MAX);
+		const char* column_names[] = { "name", "size", "owner" };
+		for (const char* name : column_names)
+		{
+			LLScrollListColumn::Params column;
+			column.name = name;
+			column.width.pixel_width = 100;
+			list->addColumn(column);
+		}
+		return list;
+	}
+
+	// Sorts on two columns, then narrows a filter one character at a time
+	void sort_and_filter_rows(LLScrollListCtrl* list, F64& sort_ms, F64& filter_ms)
+	{
+		LLTimer timer;
+		list->sortByColumn("owner", TRUE);
+		list->sortByColumn("size", FALSE);
+		list->updateSort();
+		sort_ms = timer.getElapsedTimeF64() * 1000.0;
+
+		timer.reset();
+		list->setFilter("7");
+		list->setFilter("7a");
+		list->setFilter("7ab");
+		list->setFilter(LLStringUtil::null);
+		filter_ms = timer.getElapsedTimeF64() * 1000.0;
+	}
+}
+
+// Populates, sorts and filters a large three column list without drawing
+// it, once with a cell per column built for every row and once with rows
+// backed by a row model, whose cells only get built when a row is drawn.
+void handle_benchmark_scroll_list_rows(void*)
+{
+	static const S32 row_count = 100000;
+
+	std::vector<BenchmarkRow> rows(row_count);
+	for (S32 i = 0; i < row_count; ++i)
+	{
+		rows[i].mName = llformat("Object %x", ll_rand());
+		rows[i].mSize = llformat("%d", ll_rand(1 << 20));
+		rows[i].mOwner = llformat("Resident %d", ll_rand(500));
+	}
+	BenchmarkRowModel model(rows);
+
+	LLScrollListCtrl* list = make_benchmark_list();
+	LLTimer timer;
+	for (S32 i = 0; i < row_count; ++i)
+	{
+		LLScrollListItem::Params row;
+		model.buildRow(LLSD(i), row);
+		list->addRow(row);
+	}
+	F64 cells_add_ms = timer.getElapsedTimeF64() * 1000.0;
+	F64 cells_sort_ms, cells_filter_ms;
+	sort_and_filter_rows(list, cells_sort_ms, cells_filter_ms);
+	delete list;
+
+	list = make_benchmark_list();
+	list->setRowModel(&model);
+	std::vector<LLSD> values;
+	values.reserve(row_count);
+	timer.reset();
+	for (S32 i = 0; i < row_count; ++i)
+	{
+		values.push_back(LLSD(i));
+	}
+	list->addVirtualRows(values);
+	F64 virtual_add_ms = timer.getElapsedTimeF64() * 1000.0;
+	F64 virtual_sort_ms, virtual_filter_ms;
+	sort_and_filter_rows(list, virtual_sort_ms, virtual_filter_ms);
+	delete list;
+
+	LL_INFOS("Benchmark") << "Scroll list rows, " << row_count << " rows of 3 columns: with cells add " << cells_add_ms
+						  << " ms, sort " << cells_sort_ms << " ms, filter " << cells_filter_ms << " ms; with a row model add "
+						  << virtual_add_ms << " ms, sort " << virtual_sort_ms << " ms, filter " << virtual_filter_ms
+						  << " ms." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Object updates
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	struct CapturedUpdate
+	{
+		LLPointer<LLViewerObject>	mObject;
+		std::vector<U8>				mData;
+		S32							mOffset;
+	};
+
+	// Takes the cached full update of each object of the agent's region, the
+	// data a cache hit replays, positioned after the header that
+	// processObjectUpdate() reads itself.
+	void capture_object_updates(std::vector<CapturedUpdate>& updates, size_t max_count)
+	{
+		LLViewerRegion* regionp = gAgent.getRegion();
+		if (!regionp) return;
+
+		for (LLViewerObject* objectp : gObjectList.mObjects)
+		{
+			if (updates.size() >= max_count) break;
+			if (objectp->isDead() || objectp->isAvatar() || objectp->getRegion() != regionp) continue;
+
+			LLDataPackerBinaryBuffer* dp = regionp->peekDP(objectp->getLocalID(), objectp->getCRC());
+			if (!dp) continue;
+
+			LLUUID id;
+			U32 local_id;
+			U8 pcode;
+			dp->reset();
+			dp->unpackUUID(id, "ID");
+			dp->unpackU32(local_id, "LocalID");
+			dp->unpackU8(pcode, "PCode");
+
+			CapturedUpdate update;
+			update.mObject = objectp;
+			update.mData.assign(dp->getBuffer(), dp->getBuffer() + dp->getBufferSize());
+			update.mOffset = dp->getCurrentSize();
+			updates.push_back(update);
+		}
+	}
+}
+
+// Replays the cached updates of up to 5000 objects around the agent, the
+// way a burst of ObjectUpdateCached hits lands on login: once applied inside
+// the handler, a message of 16 at a time, and once staged three times over
+// and applied in frame sized batches.
+void handle_benchmark_object_updates(void*)
+{
+	static const size_t max_updates = 5000;
+	static const S32 blocks_per_message = 16;
+	static const S32 resends = 3;
+
+	std::vector<CapturedUpdate> updates;
+	capture_object_updates(updates, max_updates);
+	if (updates.empty())
+	{
+		LL_INFOS("Benchmark") << "Object updates: no cached objects in the agent's region to replay." << LL_ENDL;
+		return;
+	}
+	// Leave whatever arrived for real out of the measurements
+	gObjectList.applyStagedUpdates(0.f);
+
+	LLTimer timer;
+	for (size_t i = 0; i < updates.size(); ++i)
+	{
+		CapturedUpdate& update = updates[i];
+		LLDataPackerBinaryBuffer dp(update.mData.data(), update.mData.size());
+		dp.shift(update.mOffset);
+		gObjectList.processUpdateCore(NULL, update.mObject, NULL, 0, OUT_FULL_CACHED, &dp, FALSE);
+		if ((i + 1) % blocks_per_message == 0)
+		{
+			LLVOAvatar::cullAvatarsByPixelArea();
+		}
+	}
+	F64 immediate_ms = timer.getElapsedTimeF64() * 1000.0;
+
+	for (S32 resend = 0; resend < resends; ++resend)
+	{
+		for (CapturedUpdate& update : updates)
+		{
+			LLDataPackerBinaryBuffer dp(update.mData.data(), update.mData.size());
+			dp.shift(update.mOffset);
+			// As current as what the object has, and without ping interpolation
+			LLViewerObject::StagedMessageInfo message;
+			message.mPacketID = update.mObject->getLatestRecvPacketID();
+			message.mPingDelay = -1.f;
+			gObjectList.stageUpdate(update.mObject, dp, OUT_FULL_CACHED, (U32)-1, 0, false, message);
+		}
+	}
+	const S32 staged = gObjectList.getNumStagedUpdates();
+
+	static const LLCachedControl<F32> update_budget("ObjectUpdateBudget");
+	const F32 budget_ms = llmax((F32)update_budget, 0.1f);
+	S32 frames = 0;
+	F64 longest_frame_ms = 0.0;
+	timer.reset();
+	while (gObjectList.getNumStagedUpdates())
+	{
+		LLTimer frame_timer;
+		gObjectList.applyStagedUpdates(budget_ms);
+		F64 frame_ms = frame_timer.getElapsedTimeF64() * 1000.0;
+		longest_frame_ms = llmax(longest_frame_ms, frame_ms);
+		++frames;
+	}
+	F64 batched_ms = timer.getElapsedTimeF64() * 1000.0;
+
+	LL_INFOS("Benchmark") << "Object updates, " << updates.size() << " objects: applied in the handler " << immediate_ms
+						  << " ms in one frame; " << updates.size() * resends << " updates staged as " << staged
+						  << ", applied in " << batched_ms << " ms over " << frames << " frames of " << budget_ms
+						  << " ms budget, longest " << longest_frame_ms << " ms." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Volume manager
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// Makes count shapes the way builds use them: the plain primitive types
+	// first, then cut, hollowed, twisted and tapered variations of them.
+	void make_volume_shapes(std::vector<LLVolumeParams>& shapes, size_t count)
+	{
+		static const U8 types[][2] = {
+			{ LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE },		// box
+			{ LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_LINE },		// cylinder
+			{ LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PATH_LINE },		// prism
+			{ LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE },	// sphere
+			{ LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE },		// torus
+			{ LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_CIRCLE },		// tube
+		};
+		static const size_t num_types = LL_ARRAY_SIZE(types);
+
+		for (size_t i = 0; shapes.size() < count; ++i)
+		{
+			LLVolumeParams params;
+			params.setType(types[i % num_types][0], types[i % num_types][1]);
+			size_t variation = i / num_types;
+			if (variation)
+			{
+				params.setHollow((variation % 10) * 0.05f);
+				params.setBeginAndEndS(0.f, 1.f - ((variation / 10) % 4) * 0.125f);
+				params.setTwistEnd(((variation / 40) % 5) * 0.1f);
+				params.setTaper(((variation / 200) % 5) * 0.1f, 0.f);
+			}
+			shapes.push_back(params);
+		}
+	}
+
+	void ref_volumes(LLVolumeMgr& mgr, const std::vector<const LLVolumeParams*>& prims, std::vector<LLVolume*>& volumes, S32 begin, S32 end)
+	{
+		for (S32 i = begin; i < end; ++i)
+		{
+			volumes[i] = mgr.refVolume(*prims[i], 0);
+		}
+		for (S32 i = begin; i < end; ++i)
+		{
+			mgr.unrefVolume(volumes[i]);
+		}
+	}
+
+	const S32 VOLUME_CHUNK = 1024;
+
+	void ref_volume_chunk(LLVolumeMgr* mgr, const std::vector<const LLVolumeParams*>* prims, std::vector<LLVolume*>* volumes, S32 c)
+	{
+		ref_volumes(*mgr, *prims, *volumes, c * VOLUME_CHUNK, llmin((c + 1) * VOLUME_CHUNK, (S32)prims->size()));
+	}
+}
+
+// References and releases the volumes of 100k prims drawn from 2000 shapes,
+// a few hundred of which account for most prims like on builder sims, on a
+// volume manager of its own. Compares a pass on the main thread with passes
+// spread over the job system workers, and with lookups in an ordered map
+// keyed on the full parameters, as the manager used to be.
+void handle_benchmark_volume_manager(void*)
+{
+	static const size_t num_shapes = 2000;
+	static const size_t num_prims = 100000;
+	static const S32 rounds = 5;
+
+	std::vector<LLVolumeParams> shapes;
+	make_volume_shapes(shapes, num_shapes);
+
+	// Zipf-like: shape k is picked with a weight of 1/(k+1).
+	std::vector<F32> weights(num_shapes);
+	F32 total_weight = 0.f;
+	for (size_t k = 0; k < num_shapes; ++k)
+	{
+		total_weight += 1.f / (F32)(k + 1);
+		weights[k] = total_weight;
+	}
+	std::vector<const LLVolumeParams*> prims(num_prims);
+	for (size_t i = 0; i < num_prims; ++i)
+	{
+		size_t k = std::lower_bound(weights.begin(), weights.end(), ll_frand(total_weight)) - weights.begin();
+		prims[i] = &shapes[llmin(k, num_shapes - 1)];
+	}
+
+	LLVolumeMgr mgr;
+	mgr.useMutex();
+
+	// Generating the volumes is not what is measured; keep one reference
+	// to each shape meanwhile.
+	LLTimer timer;
+	std::vector<LLVolume*> held;
+	for (std::vector<LLVolumeParams>::iterator iter = shapes.begin(); iter != shapes.end(); ++iter)
+	{
+		held.push_back(mgr.refVolume(*iter, 0));
+	}
+	F64 generate_ms = timer.getElapsedTimeF64() * 1000.0;
+
+	std::vector<LLVolume*> volumes(num_prims);
+	timer.reset();
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		ref_volumes(mgr, prims, volumes, 0, (S32)num_prims);
+	}
+	F64 serial_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	const S32 num_chunks = ((S32)num_prims + VOLUME_CHUNK - 1) / VOLUME_CHUNK;
+	timer.reset();
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		LLJobSystem::instance().parallelFor(num_chunks, boost::bind(&ref_volume_chunk, &mgr, &prims, &volumes, _1));
+	}
+	F64 parallel_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	typedef std::map<const LLVolumeParams*, S32, LLVolumeParams::compare> ordered_map_t;
+	ordered_map_t ordered;
+	for (size_t k = 0; k < num_shapes; ++k)
+	{
+		ordered[&shapes[k]] = (S32)k;
+	}
+	S32 found = 0;
+	timer.reset();
+	for (S32 round = 0; round < rounds; ++round)
+	{
+		for (size_t i = 0; i < num_prims; ++i)
+		{
+			found += ordered.find(prims[i]) != ordered.end();
+		}
+	}
+	F64 ordered_ms = timer.getElapsedTimeF64() * 1000.0 / rounds;
+
+	for (std::vector<LLVolume*>::iterator iter = held.begin(); iter != held.end(); ++iter)
+	{
+		mgr.unrefVolume(*iter);
+	}
+
+	LL_INFOS("Benchmark") << "Volume manager, " << num_prims << " prims of " << num_shapes << " shapes ("
+						  << generate_ms << " ms to generate): ref and unref " << serial_ms << " ms on the main thread, "
+						  << parallel_ms << " ms with " << LLJobSystem::instance().getWorkerCount()
+						  << " workers; ordered map lookups alone " << ordered_ms << " ms (" << found / rounds
+						  << " found)." << LL_ENDL;
+}
+
+//-----------------------------------------------------------------------------
+// Volume generation
+//-----------------------------------------------------------------------------
+
+namespace
+{
+	// A lumpy sphere, RGB only, so the map passes the sculpt area checks at
+	// every stitching type.
+	void make_sculpt_map(std::vector<U8>& data, U16 width, U16 height)
+	{
+		data.resize(width * height * 3);
+		for (U16 y = 0; y < height; ++y)
+		{
+			F32 phi = F_PI * y / (height - 1);
+			for (U16 x = 0; x < width; ++x)
+			{
+				F32 theta = F_TWO_PI * x / width;
+				F32 r = 0.85f + 0.15f * sinf(5.f * theta) * sinf(3.f * phi);
+				U8* rgb = &data[(x + y * width) * 3];
+				rgb[0] = (U8)(127.5f + 127.f * r * sinf(phi) * cosf(theta));
+				rgb[1] = (U8)(127.5f + 127.f * r * sinf(phi) * sinf(theta));
+				rgb[2] = (U8)(127.5f + 127.f * r * cosf(phi));
+			}
+		}
+	}
+
+	struct SculptMap
+	{
+		U16 mWidth;
+		U16 mHeight;
+		std::vector<U8> mData;
+	};
+
+	LLPointer<LLVolume> generate_volume(const LLVolumeParams& params, F32 detail, const SculptMap* map)
+	{
+		LLPointer<LLVolume> volume = new LLVolume(params, detail);
+		if (map)
+		{
+			volume->sculpt(map->mWidth, map->mHeight, 3, &map->mData[0], 0, false);
+		}
+		for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+		{
+			volume->genTangents(f);
+		}
+		return volume;
+	}
+
+	struct GenerationJob
+	{
+		const LLVolumeParams* mParams;
+		const SculptMap* mMap;
+	};
+
+	const S32 GENERATION_CHUNK = 16;
+
+	void generate_volume_chunk(const std::vector<GenerationJob>* jobs, F32 detail, S32 c)
+	{
+		S32 end = llmin((c + 1) * GENERATION_CHUNK, (S32)jobs->size());
+		for (S32 i = c * GENERATION_CHUNK; i < end; ++i)
+		{
+			generate_volume(*(*jobs)[i].mParams, detail, (*jobs)[i].mMap);
+		}
+	}
+
+	// Returns prims per second for generating all jobs at the given detail,
+	// on the main thread or spread over the job system workers.
+	F64 time_volume_generation(const std::vector<GenerationJob>& jobs, F32 detail, bool parallel)
+	{
+		LLTimer timer;
+		if (parallel)
+		{
+			const S32 num_chunks = ((S32)jobs.size() + GENERATION_CHUNK - 1) / GENERATION_CHUNK;
+			LLJobSystem::instance().parallelFor(num_chunks, boost::bind(&generate_volume_chunk, &jobs, detail, _1));
+		}
+		else
+		{
+			for (S32 c = 0; c * GENERATION_CHUNK < (S32)jobs.size(); ++c)
+			{
+				generate_volume_chunk(&jobs, detail, c);
+			}
+		}
+		F64 elapsed = timer.getElapsedTimeF64();
+		return jobs.size() / llmax(elapsed, 0.000001);
+	}
+}
+
+// Generates 2000 prim shapes and 48 sculpties (every stitching type, with
+// and without mirror and invert, on square and oblong maps) at the highest
+// LOD, faces and tangents included, and reports prims per second on the main
+// thread and spread over the job system workers. The generated geometry
+// itself is checked by the llvolume unit test.
+void handle_benchmark_volume_generation(void*)
+{
+	static const size_t num_shapes = 2000;
+	static const F32 detail = 4.f;
+
+	std::vector<LLVolumeParams> shapes;
+	make_volume_shapes(shapes, num_shapes);
+
+	static const U16 map_sizes[][2] = { { 64, 64 }, { 32, 128 }, { 128, 32 } };
+	std::vector<SculptMap> maps(LL_ARRAY_SIZE(map_sizes));
+	for (size_t m = 0; m < maps.size(); ++m)
+	{
+		maps[m].mWidth = map_sizes[m][0];
+		maps[m].mHeight = map_sizes[m][1];
+		make_sculpt_map(maps[m].mData, maps[m].mWidth, maps[m].mHeight);
+	}
+
+	std::vector<LLVolumeParams> sculpt_shapes;
+	std::vector<const SculptMap*> sculpt_maps;
+	static const U8 flags[] = { 0, LL_SCULPT_FLAG_MIRROR, LL_SCULPT_FLAG_INVERT, LL_SCULPT_FLAG_MIRROR | LL_SCULPT_FLAG_INVERT };
+	for (U8 stitching = LL_SCULPT_TYPE_SPHERE; stitching <= LL_SCULPT_TYPE_CYLINDER; ++stitching)
+	{
+		for (size_t f = 0; f < LL_ARRAY_SIZE(flags); ++f)
+		{
+			for (size_t m = 0; m < maps.size(); ++m)
+			{
+				LLVolumeParams params;
+				params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+				params.setSculptID(LLUUID::generateNewID(), stitching | flags[f]);
+				sculpt_shapes.push_back(params);
+				sculpt_maps.push_back(&maps[m]);
+			}
+		}
+	}
+
+	std::vector<GenerationJob> prims(shapes.size());
+	for (size_t i = 0; i < shapes.size(); ++i)
+	{
+		prims[i].mParams = &shapes[i];
+		prims[i].mMap = NULL;
+	}
+	std::vector<GenerationJob> sculpts(sculpt_shapes.size());
+	for (size_t i = 0; i < sculpt_shapes.size(); ++i)
+	{
+		sculpts[i].mParams = &sculpt_shapes[i];
+		sculpts[i].mMap = sculpt_maps[i];
+	}
+
+	F64 prims_serial = time_volume_generation(prims, detail, false);
+	F64 prims_parallel = time_volume_generation(prims, detail, true);
+	F64 sculpts_serial = time_volume_generation(sculpts, detail, false);
+	F64 sculpts_parallel = time_volume_generation(sculpts, detail, true);
+
+	LL_INFOS("Benchmark") << "Volume generation at the highest LOD, " << prims.size() << " prims at "
+						  << prims_serial << " prims/s on the main thread, " << prims_parallel << " prims/s with "
+						  << LLJobSystem::instance().getWorkerCount() << " workers; " << sculpts.size()
+						  << " sculpties at " << sculpts_serial << " prims/s on the main thread, "
+						  << sculpts_parallel << " prims/s with the workers." << LL_ENDL;
+}
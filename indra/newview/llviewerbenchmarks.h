@@ -0,0 +1,64 @@
+/** 
+ * @file llviewerbenchmarks.h
+ * @brief Timing runs for viewer subsystems, reachable from the Advanced menu
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVIEWERBENCHMARKS_H
+#define LL_LLVIEWERBENCHMARKS_H
+
+class LLMenuGL;
+
+// Each benchmark runs synchronously on the main thread and reports its
+// results to the log (grep for "Benchmark").
+void init_debug_benchmark_menu(LLMenuGL* menu);
+
+void handle_benchmark_floater_construction(void*);
+void handle_benchmark_inventory_search(void*);
+void handle_benchmark_url_matching(void*);
+void handle_benchmark_script_highlighting(void*);
+void handle_benchmark_string_table(void*);
+void handle_benchmark_job_system(void*);
+void handle_benchmark_request_queue(void*);
+void handle_benchmark_llsd_response(void*);
+void handle_benchmark_logging(void*);
+void handle_benchmark_disabled_logging(void*);
+void handle_benchmark_mutexes(void*);
+void handle_benchmark_read_mostly(void*);
+void handle_benchmark_state_machines(void*);
+void handle_benchmark_thread_safe_queue(void*);
+void handle_benchmark_avatar_startup(void*);
+void handle_benchmark_morph_targets(void*);
+void handle_benchmark_rigged_skinning(void*);
+void handle_benchmark_minimap_objects(void*);
+void handle_benchmark_radar_updates(void*);
+void handle_benchmark_scroll_list_rows(void*);
+void handle_benchmark_object_updates(void*);
+void handle_benchmark_volume_manager(void*);
+void handle_benchmark_volume_generation(void*);
+
+#endif // LL_LLVIEWERBENCHMARKS_H
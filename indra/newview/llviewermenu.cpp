@@ -123,6 +123,7 @@
 #include "lltrans.h"
 #include "lluictrlfactory.h"
 #include "llvelocitybar.h"
+#include "llviewerbenchmarks.h"
 #include "llviewercamera.h"
 #include "llviewergenericmessage.h"
 #include "llviewerjoystick.h"
@@ -958,6 +959,11 @@ void init_client_menu(LLMenuGL* menu)
 	init_debug_xui_menu(sub_menu);
 	menu->addChild(sub_menu);
 
+	sub_menu = new LLMenuGL("Benchmarks");
+	sub_menu->setCanTearOff(TRUE);
+	init_debug_benchmark_menu(sub_menu);
+	menu->addChild(sub_menu);
+
 	sub_menu = new LLMenuGL("Character");
 	sub_menu->setCanTearOff(TRUE);
 	init_debug_avatar_menu(sub_menu);
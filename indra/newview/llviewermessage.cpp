@@ -106,6 +106,7 @@
 #include "llviewerwindow.h"
 #include "llvlmanager.h"
 #include "llvoavatar.h"
+#include "llvocache.h"
 #include "llworld.h"
 #include "pipeline.h"
 #include "llfloaterworldmap.h"
@@ -2951,6 +2952,10 @@ void process_teleport_finish(LLMessageSystem* msg, void**)
 		LLWorld::getInstance()->setRegionSize(region_size_x, region_size_y);
 	}
 	LLViewerRegion* regionp =  LLWorld::getInstance()->addRegion(region_handle, sim_host);
+	if (LLVOCache::hasInstance())
+	{
+		LLVOCache::getInstance()->noteArrival();
+	}
 
 	M7WindlightInterface::getInstance()->receiveReset();
 
@@ -3280,6 +3285,10 @@ void process_crossed_region(LLMessageSystem* msg, void**)
 		LLWorld::getInstance()->setRegionSize(region_size_x, region_size_y);
 	}
 	LLViewerRegion* regionp = LLWorld::getInstance()->addRegion(region_handle, sim_host);
+	if (LLVOCache::hasInstance())
+	{
+		LLVOCache::getInstance()->noteArrival();
+	}
 
 	LL_DEBUGS("CrossingCaps") << "Calling setSeedCapability from process_crossed_region(). Seed cap == "
 		<< seedCap << LL_ENDL;
@@ -110,6 +110,7 @@
 
 BOOL		LLViewerObject::sVelocityInterpolate = TRUE;
 BOOL		LLViewerObject::sPingInterpolate = TRUE;
+const LLViewerObject::StagedMessageInfo* LLViewerObject::sStagedMessage = NULL;
 
 U32			LLViewerObject::sNumZombieObjects = 0;
 S32			LLViewerObject::sNumObjects = 0;
@@ -1137,6 +1138,18 @@ U32 LLViewerObject::extractSpatialExtents(LLDataPackerBinaryBuffer *dp, LLVector
 	return parent_id;
 }
 
+// static
+F32 LLViewerObject::getPingInterpolationDelay(LLMessageSystem* mesgsys, F32 time_dilation)
+{
+	LLCircuitData *cdp = gMessageSystem->mCircuitInfo.findCircuit(mesgsys->getSender());
+	if (!cdp)
+	{
+		LL_WARNS() << "findCircuit() returned NULL; skipping interpolation" << LL_ENDL;
+		return -1.f;
+	}
+	return 0.5f * time_dilation * ( ((F32)cdp->getPingDelay().valueInUnits<LLUnits::Seconds>()) + gFrameDTClamped);
+}
+
 U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 					 void **user_data,
 					 U32 block_num,
@@ -2028,19 +2041,14 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 
 	new_rot.normQuat();
 
-	if (sPingInterpolate && mesgsys != NULL)
+	if (sPingInterpolate && (mesgsys != NULL || sStagedMessage))
 	{
-		LLCircuitData *cdp = gMessageSystem->mCircuitInfo.findCircuit(mesgsys->getSender());
-		if (cdp)
+		F32 ping_delay = mesgsys ? getPingInterpolationDelay(mesgsys, time_dilation) : sStagedMessage->mPingDelay;
+		if (ping_delay >= 0.f)
 		{
-			F32 ping_delay = 0.5f * time_dilation * ( ((F32)cdp->getPingDelay().valueInUnits<LLUnits::Seconds>()) + gFrameDTClamped);
 			LLVector3 diff = getVelocity() * ping_delay;
 			new_pos_parent += diff;
 		}
-		else
-		{
-			LL_WARNS() << "findCircuit() returned NULL; skipping interpolation" << LL_ENDL;
-		}
 	}
 
 	//////////////////////////
@@ -2051,11 +2059,10 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 
 	// If we're going to skip this message, why are we
 	// doing all the parenting, etc above?
-	if(mesgsys != NULL)
+	if(mesgsys != NULL || sStagedMessage)
 	{
-		U32 packet_id = mesgsys->getCurrentRecvPacketID();
-		if (packet_id < mLatestRecvPacketID &&
-			mLatestRecvPacketID - packet_id < 65536)
+		U32 packet_id = mesgsys ? mesgsys->getCurrentRecvPacketID() : sStagedMessage->mPacketID;
+		if (isOlderPacket(packet_id, mLatestRecvPacketID))
 		{
 			//skip application of this message, it's old
 			return retval;
@@ -2438,8 +2445,15 @@ void LLViewerObject::loadFlags(U32 flags)
 	}
 
 	// keep local flags and overwrite remote-controlled flags
+	U32 old_flags = mFlags;
 	mFlags = (mFlags & FLAGS_LOCAL) | flags;
 
+	// The map dot colour follows the owner flags.
+	if ((old_flags ^ mFlags) & (FLAGS_OBJECT_YOU_OWNER | FLAGS_OBJECT_GROUP_OWNED))
+	{
+		dirtyMapPosition(true);
+	}
+
 	// ...new objects that should come in selected need to be added to the selected list
 	mCreateSelected = ((flags & FLAGS_CREATE_SELECTED) != 0);
 	return;
@@ -3667,6 +3681,11 @@ void LLViewerObject::setScale(const LLVector3 &scale, BOOL damped)
 				gObjectList.addToMap(this);
 				mOnMap = TRUE;
 			}
+			else
+			{
+				// The dot size follows the scale.
+				gObjectList.dirtyMapObject(this);
+			}
 		}
 		else
 		{
@@ -4360,7 +4379,8 @@ void LLViewerObject::setPositionAbsoluteGlobal( const LLVector3d &pos_global, BO
 
 void LLViewerObject::setPosition(const LLVector3 &pos, BOOL damped)
 {
-	if (getPosition() != pos)
+	bool moved = getPosition() != pos;
+	if (moved)
 	{
 		setChanged(TRANSLATED | SILHOUETTE);
 	}
@@ -4372,6 +4392,10 @@ void LLViewerObject::setPosition(const LLVector3 &pos, BOOL damped)
 		// position caches need to be up to date on root objects
 		updatePositionCaches();
 	}
+	if (moved)
+	{
+		dirtyMapPosition(true);
+	}
 }
 
 void LLViewerObject::setPositionGlobal(const LLVector3d &pos_global, BOOL damped)
@@ -5551,6 +5575,30 @@ BOOL LLViewerObject::isOnMap()
 	return mOnMap;
 }
 
+void LLViewerObject::dirtyMapPosition(bool include_self)
+{
+	// Dead objects are off the map already and may be gone by the time the
+	// map looks at its changes.
+	if (isDead())
+	{
+		return;
+	}
+	if (include_self && mOnMap)
+	{
+		gObjectList.dirtyMapObject(this);
+	}
+	if (isRoot())
+	{
+		for (child_list_t::const_iterator iter = mChildList.begin(); iter != mChildList.end(); ++iter)
+		{
+			if ((*iter)->mOnMap && !(*iter)->isDead())
+			{
+				gObjectList.dirtyMapObject(*iter);
+			}
+		}
+	}
+}
+
 
 void LLViewerObject::updateText()
 {
@@ -6470,6 +6518,10 @@ BOOL LLViewerObject::setFlagsWithoutUpdate(U32 flags, BOOL state)
 			setit = TRUE;
 		}
 	}
+	if (setit && (flags & (FLAGS_OBJECT_YOU_OWNER | FLAGS_OBJECT_GROUP_OWNED)))
+	{
+		dirtyMapPosition(true);
+	}
 	return setit;
 }
 
@@ -811,6 +811,9 @@ protected:
 	void doInventoryCallback();
 	
 	BOOL isOnMap();
+	// Tells the mini map that this object (if include_self) and the children
+	// on the map that move along with it are somewhere else now.
+	void dirtyMapPosition(bool include_self);
 
 	void unpackParticleSource(const S32 block_num, const LLUUID& owner_id);
 	void unpackParticleSource(LLDataPacker &dp, const LLUUID& owner_id, bool legacy);
@@ -914,6 +917,23 @@ protected:
 	static void	setVelocityInterpolate(BOOL value)		{ sVelocityInterpolate = value;	}
 	static void	setPingInterpolate(BOOL value)			{ sPingInterpolate = value;	}
 
+public:
+	// True if packet_id predates latest_packet_id, allowing for wrap around.
+	static bool isOlderPacket(U32 packet_id, U32 latest_packet_id) { return packet_id < latest_packet_id && latest_packet_id - packet_id < 65536; }
+	// Seconds to extrapolate an update from mesgsys by, or -1 without a circuit.
+	static F32	getPingInterpolationDelay(LLMessageSystem* mesgsys, F32 time_dilation);
+
+	// What processUpdateMessage() reads from the message for a full update,
+	// recorded when LLViewerObjectList stages one; only set while it applies
+	// the staged update, the message being long gone by then.
+	struct StagedMessageInfo
+	{
+		U32		mPacketID;
+		F32		mPingDelay;
+	};
+protected:
+	static const StagedMessageInfo* sStagedMessage;
+
 private:	
 	static S32 sNumObjects;
 
@@ -937,6 +957,7 @@ public:
 	void setLastUpdateType(EObjectUpdateType last_update_type);
 	BOOL getLastUpdateCached() const;
 	void setLastUpdateCached(BOOL last_update_cached);
+	U32 getLatestRecvPacketID() const					{ return mLatestRecvPacketID; }
 
     virtual void updateRiggingInfo() {}
 
@@ -959,6 +980,7 @@ inline void LLViewerObject::setRotation(const LLQuaternion& quat, BOOL damped)
 	LLPrimitive::setRotation(quat);
 	setChanged(ROTATED | SILHOUETTE);
 	updateDrawable(damped);
+	dirtyMapPosition(false);
 }
 
 inline void LLViewerObject::setRotation(const F32 x, const F32 y, const F32 z, BOOL damped)
@@ -966,6 +988,7 @@ inline void LLViewerObject::setRotation(const F32 x, const F32 y, const F32 z, B
 	LLPrimitive::setRotation(x, y, z);
 	setChanged(ROTATED | SILHOUETTE);
 	updateDrawable(damped);
+	dirtyMapPosition(false);
 }
 
 class LLViewerObjectMedia
@@ -46,7 +46,7 @@
 #include "llviewerobject.h"
 #include "llviewerwindow.h"
 #include "llwindow.h"
-#include "llnetmap.h"
+#include "llnetmapobjectlayer.h"
 #include "llagent.h"
 #include "llagentcamera.h"
 #include "pipeline.h"
@@ -124,6 +124,8 @@ U32						LLViewerObjectList::sSimulatorMachineIndex = 1; // Not zero deliberatel
 std::map<U64, U32>			LLViewerObjectList::sIPAndPortToIndex;
 std::map<U64, LLUUID>	LLViewerObjectList::sIndexAndLocalIDToUUID;
 LLStat					LLViewerObjectList::sCacheHitRate("object_cache_hits", 128);
+LLStat					LLViewerObjectList::sStagedUpdateCount("object_staged_updates", 32);
+LLStat					LLViewerObjectList::sStagedUpdateLatency("object_staged_update_latency", 128);
 
 LLViewerObjectList::LLViewerObjectList()
 {
@@ -135,6 +137,7 @@ LLViewerObjectList::LLViewerObjectList()
 	mMinNumDeadObjects = 20;
 	mNumOrphans = 0;
 	mNumNewObjects = 0;
+	mMapObjectsReset = false;
 	mWasPaused = FALSE;
 	mNumDeadObjectUpdates = 0;
 	mNumUnknownKills = 0;
@@ -154,6 +157,8 @@ void LLViewerObjectList::destroy()
 	mActiveObjects.clear();
 	mDeadObjects.clear();
 	mMapObjects.clear();
+	mMapChanges.clear();
+	mMapObjectsReset = true;
 	mUUIDObjectMap.clear();
 	mUUIDAvatarMap.clear();
 }
@@ -255,15 +260,14 @@ void LLViewerObjectList::setUUIDAndLocal(const LLUUID &id,
 S32 gFullObjectUpdates = 0;
 S32 gTerseObjectUpdates = 0;
 
-void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp, 
+void LLViewerObjectList::processUpdateCore(LLMessageSystem* msg,
+										   LLViewerObject* objectp, 
 										   void** user_data, 
 										   U32 i, 
 										   const EObjectUpdateType update_type, 
 										   LLDataPacker* dpp, 
 										   BOOL just_created)
 {
-	LLMessageSystem* msg = gMessageSystem;
-
 	// ignore returned flags
 	objectp->processUpdateMessage(msg, user_data, i, update_type, dpp);
 		
@@ -403,6 +407,24 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		return;
 	}
 
+	static const LLCachedControl<bool> batch_updates("ObjectUpdateBatching");
+	// Full updates that come with a data packer need nothing more from the
+	// message once decoded, so update() can apply them later.
+	const bool stage = batch_updates && (cached || (compressed && update_type != OUT_TERSE_IMPROVED));
+	if (stage)
+	{
+		// processUpdateMessage() reads this from the message otherwise
+		U16 time_dilation16;
+		mesgsys->getU16Fast(_PREHASH_RegionData, _PREHASH_TimeDilation, time_dilation16);
+		regionp->setTimeDilation((F32)time_dilation16 / 65535.f);
+	}
+	else if (update_type == OUT_FULL && !mStagedUpdates.empty())
+	{
+		// Uncompressed full updates can reparent objects, so whatever they
+		// refer to must be up to date first.
+		applyStagedUpdates(0.f);
+	}
+
 	U8 compressed_dpbuffer[2048];
 	LLDataPackerBinaryBuffer compressed_dp(compressed_dpbuffer, 2048);
 	LLDataPacker *cached_dpp = NULL;
@@ -597,6 +619,21 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			LL_WARNS() << "Dead object " << objectp->mID << " in UUID map 1!" << LL_ENDL;
 		}
 
+		if (stage)
+		{
+			objectp->mLocalID = local_id;
+			U32 flags = (U32)-1;
+			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+			U16 time_dilation16;
+			mesgsys->getU16Fast(_PREHASH_RegionData, _PREHASH_TimeDilation, time_dilation16);
+			LLViewerObject::StagedMessageInfo message;
+			message.mPacketID = mesgsys->getCurrentRecvPacketID();
+			message.mPingDelay = LLViewerObject::getPingInterpolationDelay(mesgsys, ((F32)time_dilation16) / 65535.f);
+			stageUpdate(objectp, compressed ? compressed_dp : *static_cast<LLDataPackerBinaryBuffer*>(cached_dpp), update_type, flags, msg_size, justCreated, message);
+			continue;
+		}
+		flushStagedUpdate(objectp);
+
 		bool bCached = false;
 		if (compressed)
 		{
@@ -604,7 +641,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			{
 				objectp->mLocalID = local_id;
 			}
-			processUpdateCore(objectp, user_data, i, update_type, &compressed_dp, justCreated);
+			processUpdateCore(mesgsys, objectp, user_data, i, update_type, &compressed_dp, justCreated);
 			if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
 			{
 				bCached = true;
@@ -615,7 +652,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		else if (cached)
 		{
 			objectp->mLocalID = local_id;
-			processUpdateCore(objectp, user_data, i, update_type, cached_dpp, justCreated);
+			processUpdateCore(mesgsys, objectp, user_data, i, update_type, cached_dpp, justCreated);
 		}
 		else
 		{
@@ -623,16 +660,138 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			{
 				objectp->mLocalID = local_id;
 			}
-			processUpdateCore(objectp, user_data, i, update_type, NULL, justCreated);
+			processUpdateCore(mesgsys, objectp, user_data, i, update_type, NULL, justCreated);
 		}
 		recorder.objectUpdateEvent(local_id, update_type, objectp, msg_size);
 		objectp->setLastUpdateType(update_type);
 		objectp->setLastUpdateCached(bCached);
 	}
 
-	recorder.log(0.2f);
+	if (!stage) // applyStagedUpdates() does this once per batch
+	{
+		recorder.log(0.2f);
+
+		LLVOAvatar::cullAvatarsByPixelArea();
+	}
+}
+
+void LLViewerObjectList::stageUpdate(LLViewerObject* objectp, const LLDataPackerBinaryBuffer& dp, EObjectUpdateType update_type,
+									 U32 flags, S32 msg_size, bool just_created, const LLViewerObject::StagedMessageInfo& message)
+{
+	auto inserted = mStagedUpdates.emplace(objectp, StagedUpdate());
+	StagedUpdate& update = inserted.first->second;
+	if (inserted.second)
+	{
+		mStagedOrder.push_back(objectp);
+		update.mStagedTime = LLTimer::getTotalSeconds();
+		update.mJustCreated = just_created;
+	}
+	else if (LLViewerObject::isOlderPacket(message.mPacketID, update.mMessage.mPacketID))
+	{
+		// Arrived out of order; the update already queued is newer.
+		return;
+	}
+	// else this replaces an update that never got applied, and keeps its
+	// place in the queue. The object still needs adding to the pipeline if
+	// that one created it.
+
+	update.mData.assign(dp.getBuffer(), dp.getBuffer() + dp.getBufferSize());
+	update.mOffset = dp.getCurrentSize();
+	update.mFlags = flags;
+	update.mMsgSize = msg_size;
+	update.mMessage = message;
+	update.mUpdateType = update_type;
+}
+
+static LLTrace::BlockTimerStatHandle FTM_APPLY_STAGED_UPDATES("Apply Staged Object Updates");
+
+S32 LLViewerObjectList::applyStagedUpdates(F32 budget_ms)
+{
+	if (mStagedOrder.empty())
+	{
+		return 0;
+	}
+	LL_RECORD_BLOCK_TIME(FTM_APPLY_STAGED_UPDATES);
+
+	LLTimer timer;
+	const F64 now = LLTimer::getTotalSeconds();
+	S32 applied = 0;
+	while (!mStagedOrder.empty())
+	{
+		if (budget_ms > 0.f && applied && timer.getElapsedTimeF32() * 1000.f >= budget_ms)
+		{
+			break;
+		}
+
+		LLPointer<LLViewerObject> objectp = mStagedOrder.front();
+		mStagedOrder.pop_front();
+		auto iter = mStagedUpdates.find(objectp.get());
+		if (iter == mStagedUpdates.end())
+		{
+			continue; // Applied early or killed
+		}
+		// Applying can kill other objects, which removes their updates
+		StagedUpdate update = std::move(iter->second);
+		mStagedUpdates.erase(iter);
 
+		sStagedUpdateLatency.addValue((F32)((now - update.mStagedTime) * 1000.0));
+		applyStagedUpdate(objectp, update);
+		++applied;
+	}
+	sStagedUpdateCount.addValue((F32)mStagedUpdates.size());
+
+	LLViewerStatsRecorder::instance().log(0.2f);
 	LLVOAvatar::cullAvatarsByPixelArea();
+
+	return applied;
+}
+
+void LLViewerObjectList::flushStagedUpdate(LLViewerObject* objectp)
+{
+	auto iter = mStagedUpdates.find(objectp);
+	if (iter != mStagedUpdates.end())
+	{
+		StagedUpdate update = std::move(iter->second);
+		mStagedUpdates.erase(iter);
+		applyStagedUpdate(objectp, update);
+	}
+}
+
+void LLViewerObjectList::applyStagedUpdate(LLViewerObject* objectp, StagedUpdate& update)
+{
+	if (objectp->isDead())
+	{
+		return;
+	}
+
+	LLDataPackerBinaryBuffer dp(update.mData.data(), update.mData.size());
+	dp.shift(update.mOffset);
+
+	// A newer packet was applied since; drop this one rather than cache it.
+	// A new object still needs setting up, processUpdateMessage() then skips
+	// the stale part as it does for live updates.
+	if (!update.mJustCreated && LLViewerObject::isOlderPacket(update.mMessage.mPacketID, objectp->mLatestRecvPacketID))
+	{
+		return;
+	}
+
+	// processUpdateMessage() takes these from the message, which is long gone
+	objectp->loadFlags(update.mFlags);
+	LLViewerObject::sStagedMessage = &update.mMessage;
+	processUpdateCore(NULL, objectp, NULL, 0, update.mUpdateType, &dp, update.mJustCreated);
+	LLViewerObject::sStagedMessage = NULL;
+
+	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
+	bool cached = false;
+	if (update.mUpdateType == OUT_FULL_COMPRESSED && objectp->mRegionp)
+	{
+		cached = true;
+		LLViewerRegion::eCacheUpdateResult result = objectp->mRegionp->cacheFullUpdate(objectp, dp);
+		recorder.cacheFullUpdate(objectp->mLocalID, update.mUpdateType, result, objectp, update.mMsgSize);
+	}
+	recorder.objectUpdateEvent(objectp->mLocalID, update.mUpdateType, objectp, update.mMsgSize);
+	objectp->setLastUpdateType(update.mUpdateType);
+	objectp->setLastUpdateCached(cached);
 }
 
 void LLViewerObjectList::processCompressedObjectUpdate(LLMessageSystem *mesgsys,
@@ -955,6 +1114,11 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 	//clear avatar LOD change counter
 	LLVOAvatar::sNumLODChangesThisFrame = 0;
 
+	// Apply the object updates received since the last frame, up to the budget
+	static const LLCachedControl<bool> batch_updates("ObjectUpdateBatching");
+	static const LLCachedControl<F32> update_budget("ObjectUpdateBudget");
+	applyStagedUpdates(batch_updates ? llmax((F32)update_budget, 0.1f) : 0.f);
+
 	const F64 frame_time = LLFrameTimer::getElapsedSeconds();
 	
 	LLViewerObject *objectp = NULL;	
@@ -1266,6 +1430,7 @@ void LLViewerObjectList::cleanupReferences(LLViewerObject *objectp)
 	// Remove from object map so noone can look it up.
 
 	mUUIDObjectMap.erase(objectp->mID);
+	mStagedUpdates.erase(objectp);
 	// <singu> Use the return value (number of erased elements) to determine if we were an avatar.
 	if (mUUIDAvatarMap.erase(objectp->mID)) //No need to be careful here.
 		if (LLFloaterIMPanel* im = find_im_floater(objectp->mID))
@@ -1389,6 +1554,10 @@ void LLViewerObjectList::killAllObjects()
 		llassert((objectp == gAgentAvatarp) || objectp->isDead() || (objectp->asAvatar() && objectp->asAvatar()->isFrozenDead()));
 	}
 
+	// Let go of the objects whose updates never got applied
+	mStagedUpdates.clear();
+	mStagedOrder.clear();
+
 	cleanDeadObjects(FALSE);
 
 	if(!mObjects.empty())
@@ -1407,6 +1576,8 @@ void LLViewerObjectList::killAllObjects()
 	{
 		LL_WARNS() << "Some objects still on map object list!" << LL_ENDL;
 		mMapObjects.clear();
+		mMapChanges.clear();
+		mMapObjectsReset = true;
 	}
 }
 
@@ -1717,97 +1888,109 @@ void LLViewerObjectList::clearAllMapObjectsInRegion(LLViewerRegion* regionp)
 		}
 	}
 }
-void LLViewerObjectList::renderObjectsForMap(LLNetMap &netmap)
+void LLViewerObjectList::noteMapChange(const LLViewerObject *objectp, bool on_map)
 {
-	LLColor4 above_water_color = gColors.getColor( "NetMapOtherOwnAboveWater" );
-	LLColor4 below_water_color = gColors.getColor( "NetMapOtherOwnBelowWater" );
-	LLColor4 you_own_above_water_color = 
-						gColors.getColor( "NetMapYouOwnAboveWater" );
-	LLColor4 you_own_below_water_color = 
-						gColors.getColor( "NetMapYouOwnBelowWater" );
-	LLColor4 group_own_above_water_color = 
-						gColors.getColor( "NetMapGroupOwnAboveWater" );
-	LLColor4 group_own_below_water_color = 
-						gColors.getColor( "NetMapGroupOwnBelowWater" );
-
-	F32 max_radius = gSavedSettings.getF32("MiniMapPrimMaxRadius");
-	
-	const F32 agent_altitude(gAgent.getPositionGlobal()[VZ]);
-	static const LLCachedControl<U32> delta("MiniMapPrimMaxAltitudeDelta");
+	// Nobody collects the changes while the mini map is closed; rather than
+	// piling up every object that ever left the map, start over.
+	if (mMapChanges.size() > 2 * mMapObjects.size() + 1024)
+	{
+		mMapChanges.clear();
+		mMapObjectsReset = true;
+	}
+	if (!mMapObjectsReset)
+	{
+		mMapChanges[objectp] = on_map;
+	}
+}
 
-	for (vobj_list_t::iterator iter = mMapObjects.begin(); iter != mMapObjects.end(); ++iter)
+// Returns false if objectp should not show on the map at all.
+static bool get_map_dot(LLViewerObject* objectp, LLNetMapObjectLayer::Dot& dot)
+{
+	static const LLCachedControl<LLColor4> above_water_color(gColors, "NetMapOtherOwnAboveWater");
+	static const LLCachedControl<LLColor4> below_water_color(gColors, "NetMapOtherOwnBelowWater");
+	static const LLCachedControl<LLColor4> you_own_above_water_color(gColors, "NetMapYouOwnAboveWater");
+	static const LLCachedControl<LLColor4> you_own_below_water_color(gColors, "NetMapYouOwnBelowWater");
+	static const LLCachedControl<LLColor4> group_own_above_water_color(gColors, "NetMapGroupOwnAboveWater");
+	static const LLCachedControl<LLColor4> group_own_below_water_color(gColors, "NetMapGroupOwnBelowWater");
+	static const LLCachedControl<F32> max_radius(gSavedSettings, "MiniMapPrimMaxRadius");
+
+	if (objectp->isDead() || !objectp->getRegion() || objectp->isOrphaned() || objectp->isAttachment())
 	{
-		LLViewerObject* objectp = *iter;
+		return false;
+	}
+	const LLVector3& scale = objectp->getScale();
+	const LLVector3d pos = objectp->getPositionGlobal();
+	const F64 water_height = F64( objectp->getRegion()->getWaterHeight() );
 
-		llassert_always(objectp);
-		llassert(!objectp->isDead());
-		
-		if (objectp->isDead() || !objectp->getRegion() || objectp->isOrphaned() || objectp->isAttachment())
+	F32 approx_radius = (scale.mV[VX] + scale.mV[VY]) * 0.5f * 0.5f * 1.3f;  // 1.3 is a fudge
+
+	// Limit the size of megaprims so they don't blot out everything on the minimap.
+	// Attempting to draw very large megaprims also causes client lag.
+	// See DEV-17370 and SNOW-79 for details.
+	approx_radius = llmin(approx_radius, (F32)max_radius);
+
+	LLColor4 color = above_water_color;
+	dot.mOwned = objectp->permYouOwner();
+	if (dot.mOwned)
+	{
+		const F32 MIN_RADIUS_FOR_OWNED_OBJECTS = 2.f;
+		if( approx_radius < MIN_RADIUS_FOR_OWNED_OBJECTS )
 		{
-			continue;
+			approx_radius = MIN_RADIUS_FOR_OWNED_OBJECTS;
 		}
-		const LLVector3& scale = objectp->getScale();
-		const LLVector3d pos = objectp->getPositionGlobal();
-		const F64 water_height = F64( objectp->getRegion()->getWaterHeight() );
-		// LLWorld::getInstance()->getWaterHeight();
-		
-		F32 approx_radius = (scale.mV[VX] + scale.mV[VY]) * 0.5f * 0.5f * 1.3f;  // 1.3 is a fudge
-
-		// Limit the size of megaprims so they don't blot out everything on the minimap.
-		// Attempting to draw very large megaprims also causes client lag.
-		// See DEV-17370 and SNOW-79 for details.
-		approx_radius = llmin(approx_radius, max_radius);
 
-		LLColor4U color = above_water_color;
-		if( objectp->permYouOwner() )
+		if( pos.mdV[VZ] >= water_height )
 		{
-			static const LLCachedControl<U32> delta("MiniMapPrimMaxAltitudeDeltaOwn");
-			if (delta && static_cast<U32>(std::fabs(agent_altitude - pos[VZ])) > delta)
-				continue;
+			color = objectp->permGroupOwner() ? group_own_above_water_color.get() : you_own_above_water_color.get();
+		}
+		else
+		{
+			color = objectp->permGroupOwner() ? group_own_below_water_color.get() : you_own_below_water_color.get();
+		}
+	}
+	else if ( pos.mdV[VZ] < water_height )
+	{
+		color = below_water_color;
+	}
 
-			const F32 MIN_RADIUS_FOR_OWNED_OBJECTS = 2.f;
-			if( approx_radius < MIN_RADIUS_FOR_OWNED_OBJECTS )
-			{
-				approx_radius = MIN_RADIUS_FOR_OWNED_OBJECTS;
-			}
-			
-			if( pos.mdV[VZ] >= water_height )
-			{
-				if ( objectp->permGroupOwner() )
-				{
-					color = group_own_above_water_color;
-				}
-				else
-				{
-					color = you_own_above_water_color;
-				}
-			}
-			else
+	dot.mPosGlobal = pos;
+	dot.mRadius = approx_radius;
+	dot.mColor = color;
+	return true;
+}
+
+void LLViewerObjectList::updateObjectsForMap(LLNetMapObjectLayer& layer)
+{
+	LLNetMapObjectLayer::Dot dot;
+
+	if (mMapObjectsReset || layer.needsAllDots())
+	{
+		layer.clearDots();
+		for (vobj_list_t::iterator iter = mMapObjects.begin(); iter != mMapObjects.end(); ++iter)
+		{
+			LLViewerObject* objectp = *iter;
+			if (get_map_dot(objectp, dot))
 			{
-				if ( objectp->permGroupOwner() )
-				{
-					color = group_own_below_water_color;
-				}
-				else
-				{
-					color = you_own_below_water_color;
-				}
+				layer.setDot(objectp, dot);
 			}
 		}
-		else if (delta && static_cast<U32>(std::fabs(agent_altitude - pos[VZ])) > delta)
+		mMapChanges.clear();
+		mMapObjectsReset = false;
+		return;
+	}
+
+	for (absl::flat_hash_map<const LLViewerObject*, bool>::iterator iter = mMapChanges.begin(); iter != mMapChanges.end(); ++iter)
+	{
+		if (iter->second && get_map_dot(const_cast<LLViewerObject*>(iter->first), dot))
 		{
-			continue;
+			layer.setDot(iter->first, dot);
 		}
-		else if ( pos.mdV[VZ] < water_height )
+		else
 		{
-			color = below_water_color;
+			layer.removeDot(iter->first);
 		}
-
-		netmap.renderScaledPointGlobal( 
-			pos, 
-			color,
-			approx_radius );
 	}
+	mMapChanges.clear();
 }
 
 void LLViewerObjectList::renderObjectBounds(const LLVector3 &center)
@@ -2211,6 +2394,8 @@ void LLViewerObjectList::findOrphans(LLViewerObject* objectp, U32 ip, U32 port)
 			childp->hideExtraDisplayItems( FALSE );
 
 			objectp->addChild(childp);
+			// Its map dot was dropped, or placed region relative, while orphaned.
+			childp->dirtyMapPosition(true);
 			orphans_found = TRUE;
 			++iter;
 		}
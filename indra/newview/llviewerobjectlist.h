@@ -33,6 +33,7 @@
 #ifndef LL_LLVIEWEROBJECTLIST_H
 #define LL_LLVIEWEROBJECTLIST_H
 
+#include <deque>
 #include <map>
 #include <set>
 
@@ -47,7 +48,8 @@
 #include "llvoavatar.h"
 
 class LLCamera;
-class LLNetMap;
+class LLDataPackerBinaryBuffer;
+class LLNetMapObjectLayer;
 class LLDebugBeacon;
 
 constexpr U32 CLOSE_BIN_SIZE = 10;
@@ -90,10 +92,24 @@ public:
 	void cleanDeadObjects(const BOOL use_timer = TRUE);	// Clean up the dead object list.
 
 	// Simulator and viewer side object updates...
-	void processUpdateCore(LLViewerObject* objectp, void** data, U32 block, const EObjectUpdateType update_type, LLDataPacker* dpp, BOOL justCreated);
+	void processUpdateCore(LLMessageSystem* mesgsys, LLViewerObject* objectp, void** data, U32 block, const EObjectUpdateType update_type, LLDataPacker* dpp, BOOL justCreated);
 	void processObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type, bool cached=false, bool compressed=false);
 	void processCompressedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
 	void processCachedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
+
+	// Full updates that carry all of their data in a data packer (cache hits
+	// and compressed full updates) are staged by processObjectUpdate() and
+	// applied from update() within a per frame time budget. A newer update to
+	// an object replaces the one still waiting for it.
+	void stageUpdate(LLViewerObject* objectp, const LLDataPackerBinaryBuffer& dp, EObjectUpdateType update_type, U32 flags, S32 msg_size, bool just_created,
+					 const LLViewerObject::StagedMessageInfo& message);
+	// Applies staged updates, oldest first, until budget_ms is used up, or all
+	// of them when budget_ms is zero. Returns how many were applied.
+	S32 applyStagedUpdates(F32 budget_ms);
+	// Applies the update staged for objectp, if any, so that an update that
+	// could not be staged lands after it.
+	void flushStagedUpdate(LLViewerObject* objectp);
+	S32 getNumStagedUpdates() const { return (S32)mStagedUpdates.size(); }
 	void updateApparentAngles(LLAgent &agent);
 	void update(LLAgent &agent, LLWorld &world);
 
@@ -120,7 +136,9 @@ public:
 
 	bool hasMapObjectInRegion(LLViewerRegion* regionp) ;
 	void clearAllMapObjectsInRegion(LLViewerRegion* regionp) ;
-	void renderObjectsForMap(LLNetMap &netmap);
+	// Hands the map objects that were added, moved or removed since the last
+	// call (all of them the first time) to the mini map object layer.
+	void updateObjectsForMap(LLNetMapObjectLayer& layer);
 	void renderObjectBounds(const LLVector3 &center);
 
 	void addDebugBeacon(const LLVector3 &pos_agent, const std::string &string,
@@ -147,6 +165,8 @@ public:
 
 	void addToMap(LLViewerObject *objectp);
 	void removeFromMap(LLViewerObject *objectp);
+	void dirtyMapObject(LLViewerObject *objectp) { noteMapChange(objectp, true); }
+	void noteMapChange(const LLViewerObject *objectp, bool on_map);
 
 	void clearDebugText();
 
@@ -211,6 +231,8 @@ public:
 	S32 mNumOrphans;
 
 	static LLStat sCacheHitRate;
+	static LLStat sStagedUpdateCount;	// staged updates left after each frame
+	static LLStat sStagedUpdateLatency;	// msec from staging to applying
 
 	typedef std::vector<LLPointer<LLViewerObject> > vobj_list_t;
 
@@ -219,6 +241,11 @@ public:
 
 	vobj_list_t mMapObjects;
 
+	// Map objects changed since the last updateObjectsForMap(), and whether
+	// they are still on the map. Objects that left are never dereferenced.
+	absl::flat_hash_map<const LLViewerObject*, bool> mMapChanges;
+	bool mMapObjectsReset;
+
 	uuid_set_t mDeadObjects;	
 
 	absl::flat_hash_map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
@@ -243,6 +270,23 @@ public:
 
 	std::set<LLViewerObject *> mSelectPickList;
 
+	struct StagedUpdate
+	{
+		std::vector<U8>		mData;
+		S32					mOffset;		// where processUpdateMessage() starts reading
+		U32					mFlags;
+		S32					mMsgSize;
+		LLViewerObject::StagedMessageInfo mMessage;	// packet id and ping delay
+		F64					mStagedTime;
+		EObjectUpdateType	mUpdateType;
+		bool				mJustCreated;
+	};
+	void applyStagedUpdate(LLViewerObject* objectp, StagedUpdate& update);
+
+	absl::flat_hash_map<const LLViewerObject*, StagedUpdate> mStagedUpdates;
+	// Staging order; objects whose update was already applied or dropped are skipped.
+	std::deque<LLPointer<LLViewerObject> > mStagedOrder;
+
 	friend class LLViewerObject;
 };
 
@@ -306,6 +350,7 @@ inline LLViewerObject *LLViewerObjectList::getObject(const S32 index)
 inline void LLViewerObjectList::addToMap(LLViewerObject *objectp)
 {
 	mMapObjects.push_back(objectp);
+	noteMapChange(objectp, true);
 }
 
 inline void LLViewerObjectList::removeFromMap(LLViewerObject *objectp)
@@ -315,6 +360,7 @@ inline void LLViewerObjectList::removeFromMap(LLViewerObject *objectp)
 	{
 		mMapObjects.erase(iter);
 	}
+	noteMapChange(objectp, false);
 }
 
 
@@ -54,6 +54,7 @@
 #include "llagentcamera.h"
 
 #include "llavatarrenderinfoaccountant.h"
+#include "llavatarspatialindex.h"
 #include "llcallingcard.h"
 #include "llcaphttpsender.h"
 #include "llcapabilitylistener.h"
@@ -479,6 +480,14 @@ LLViewerRegion::LLViewerRegion(const U64 &handle,
 	// Create the object lists
 	initStats();
 	initPartitions();
+
+	// Start loading the object cache now; it is only needed once the
+	// region handshake came in.
+	if (LLVOCache::hasInstance())
+	{
+		LLVOCache::getInstance()->prefetch(handle);
+	}
+
 	// If the newly entered region is using server bakes, and our
 	// current appearance is non-baked, request appearance update from
 	// server.
@@ -1310,7 +1319,6 @@ public:
 
 		std::vector<U32>& avatar_locs = region->mMapAvatars;
 		uuid_vec_t& avatar_ids = region->mMapAvatarIDs;
-		std::list<LLUUID> map_avids(avatar_ids.begin(), avatar_ids.end());
 		avatar_locs.clear();
 		avatar_ids.clear();
 
@@ -1359,7 +1367,6 @@ public:
 					LLUUID agent_id(agents_it->get("AgentID").asUUID());
 					//LL_INFOS() << "next agent: " << agent_id.asString() << LL_ENDL;
 					avatar_ids.push_back(agent_id);
-					map_avids.remove(agent_id);
 				}
 			}
 			if (has_agent_data)
@@ -1367,11 +1374,12 @@ public:
 				agents_it++;
 			}
 		}
+		LLAvatarSpatialIndex::instance().updateRegion(region);
 		if (LLFloaterAvatarList::instanceExists())
 		{
 			LLFloaterAvatarList& inst(LLFloaterAvatarList::instance());
 			inst.updateAvatarList(region);
-			inst.expireAvatarList(map_avids);
+			inst.expireAvatarList();
 		}
 	}
 };
@@ -1386,7 +1394,6 @@ LLHTTPRegistration<CoarseLocationUpdate>
 void LLViewerRegion::updateCoarseLocations(LLMessageSystem* msg)
 {
 	//LL_INFOS() << "CoarseLocationUpdate" << LL_ENDL;
-	std::list<LLUUID> map_avids(mMapAvatarIDs.begin(), mMapAvatarIDs.end());
 	mMapAvatars.clear();
 	mMapAvatarIDs.clear(); // only matters in a rare case but it's good to be safe.
 
@@ -1441,15 +1448,15 @@ void LLViewerRegion::updateCoarseLocations(LLMessageSystem* msg)
 			if(has_agent_data)
 			{
 				mMapAvatarIDs.push_back(agent_id);
-				map_avids.remove(agent_id);
 			}
 		}
 	}
+	LLAvatarSpatialIndex::instance().updateRegion(this);
 	if (LLFloaterAvatarList::instanceExists())
 	{
 		LLFloaterAvatarList& inst(LLFloaterAvatarList::instance());
 		inst.updateAvatarList(this);
-		inst.expireAvatarList(map_avids);
+		inst.expireAvatarList();
 	}
 }
 
@@ -1690,6 +1697,12 @@ LLDataPacker *LLViewerRegion::getDP(U32 local_id, U32 crc, U8 &cache_miss_type)
 	return NULL;
 }
 
+LLDataPackerBinaryBuffer *LLViewerRegion::peekDP(U32 local_id, U32 crc)
+{
+	LLVOCacheEntry* entry = get_if_there(mImpl->mCacheMap, local_id, (LLVOCacheEntry*)NULL);
+	return entry ? entry->getDP(crc) : NULL;
+}
+
 void LLViewerRegion::addCacheMissFull(const U32 local_id)
 {
 	mCacheMissFull.push_back(local_id);
@@ -361,6 +361,8 @@ public:
 	// handle a full update message
 	eCacheUpdateResult cacheFullUpdate(LLViewerObject* objectp, LLDataPackerBinaryBuffer &dp);
 	LLDataPacker *getDP(U32 local_id, U32 crc, U8 &cache_miss_type);
+	// Like getDP(), but a miss is not queued for a request to the simulator
+	LLDataPackerBinaryBuffer *peekDP(U32 local_id, U32 crc);
 	void requestCacheMisses();
 	void addCacheMissFull(const U32 local_id);
 
@@ -3135,7 +3135,7 @@ void LLVOAvatar::idleUpdateVoiceVisualizer(bool voice_enabled)
 					if( mAahMorph ) mAahMorph->setWeight(mAahMorph->getMinWeight(), FALSE);
 					
 					mLipSyncActive = false;
-					LLCharacter::updateVisualParams();
+					LLAvatarAppearance::updateVisualParams();
 					dirtyMesh();
 				}
 			}
@@ -3338,12 +3338,14 @@ void LLVOAvatar::idleUpdateAppearanceAnimation()
 			}
 
 			// apply all params
+			beginMorphBatch();
 			for (param = getFirstVisualParam();
 				 param;
 				 param = getNextVisualParam())
 			{
 				param->apply(avatar_sex);
 			}
+			endMorphBatch();
 
 			mLastAppearanceBlendTime = appearance_anim_time;
 		}
@@ -3397,7 +3399,7 @@ void LLVOAvatar::idleUpdateLipSync(bool voice_enabled)
 		}
 
 		mLipSyncActive = true;
-		LLCharacter::updateVisualParams();
+		LLAvatarAppearance::updateVisualParams();
 		dirtyMesh();
 		mIdleTimer.reset();
 	}
@@ -7405,7 +7407,7 @@ void LLVOAvatar::updateVisualParams()
 		}
 	}
 
-	LLCharacter::updateVisualParams();
+	LLAvatarAppearance::updateVisualParams();
 
 	if (mLastSkeletonSerialNum != mSkeletonSerialNum)
 	{
@@ -35,8 +35,21 @@
 #include "llvocache.h"
 
 #include "llerror.h"
+#include "lljobsystem.h"
+#include "llpartdata.h"
+#include "llprimitive.h"
 #include "llregionhandle.h"
 #include "llviewercontrol.h"
+#include "llvolume.h"
+#include "llvolumemessage.h"
+#include "llvolumemgr.h"
+#include "llvovolume.h"
+#include "pipeline.h"
+
+// How long prefetched data waits for its region before being dropped.
+const F64 PREFETCH_TIMEOUT = 60.0;
+// How long prefetched volumes are held for the objects using them to be created.
+const F64 PREFETCHED_VOLUME_HOLD_TIME = 30.0;
 
 BOOL check_read(LLAPRFile* apr_file, void* src, S32 n_bytes) 
 {
@@ -227,6 +240,337 @@ BOOL LLVOCacheEntry::writeToFile(LLAPRFile* apr_file) const
 	return success ;
 }
 
+//---------------------------------------------------------------------------
+// LLVOCache::Prefetch
+//---------------------------------------------------------------------------
+
+namespace
+{
+	// Reads a cached full object update up to its volume parameters, the
+	// way LLViewerObject and LLVOVolume::processUpdateMessage() do. Returns
+	// false for anything but a plain prim: sculpts and meshes need assets to
+	// be generated, and flexible prims get volumes of their own.
+	bool unpack_prim_volume(LLDataPackerBinaryBuffer& dp, LLVolumeParams& volume_params,
+							LLVector3& scale, LLVector3& pos, U32& parent_id)
+	{
+		LLUUID id;
+		U32 local_id;
+		U8 pcode;
+		dp.reset();
+		dp.unpackUUID(id, "ID");
+		dp.unpackU32(local_id, "LocalID");
+		dp.unpackU8(pcode, "PCode");
+		if (pcode != LL_PCODE_VOLUME)
+		{
+			return false;
+		}
+
+		U8 state, material, click_action;
+		U32 crc, value;
+		LLVector3 vec;
+		dp.unpackU8(state, "State");
+		dp.unpackU32(crc, "CRC");
+		dp.unpackU8(material, "Material");
+		dp.unpackU8(click_action, "ClickAction");
+		dp.unpackVector3(scale, "Scale");
+		dp.unpackVector3(pos, "Pos");
+		dp.unpackVector3(vec, "Rot");
+		dp.unpackU32(value, "SpecialCode");
+		dp.unpackUUID(id, "Owner");
+
+		if (value & 0x80)
+		{
+			dp.unpackVector3(vec, "Omega");
+		}
+		parent_id = 0;
+		if (value & 0x20)
+		{
+			dp.unpackU32(parent_id, "ParentID");
+		}
+		if (value & 0x2)
+		{
+			U8 tree_data;
+			dp.unpackU8(tree_data, "TreeData");
+		}
+		else if (value & 0x1)
+		{
+			U32 size;
+			dp.unpackU32(size, "ScratchPadSize");
+			std::vector<U8> scratch_pad(llmax(size, (U32)1));
+			S32 sp_size;
+			dp.unpackBinaryData(&scratch_pad[0], sp_size, "PartData");
+		}
+		if (value & 0x4)
+		{
+			std::string text;
+			U8 color[4];
+			dp.unpackString(text, "Text");
+			dp.unpackBinaryDataFixed(color, 4, "Color");
+		}
+		if (value & 0x200)
+		{
+			std::string media_url;
+			dp.unpackString(media_url, "MediaURL");
+		}
+		if (value & 0x8)
+		{
+			LLPartSysData part_sys_data;
+			if (!part_sys_data.unpackLegacy(dp))
+			{
+				return false;
+			}
+		}
+
+		U8 num_parameters;
+		dp.unpackU8(num_parameters, "num_params");
+		U8 param_block[MAX_OBJECT_PARAMS_SIZE];
+		for (U8 param = 0; param < num_parameters; ++param)
+		{
+			U16 param_type;
+			S32 param_size;
+			dp.unpackU16(param_type, "param_type");
+			dp.unpackBinaryData(param_block, param_size, "param_data");
+			if (param_type == LLNetworkData::PARAMS_SCULPT ||
+				param_type == LLNetworkData::PARAMS_MESH ||
+				param_type == LLNetworkData::PARAMS_EXTENDED_MESH ||
+				param_type == LLNetworkData::PARAMS_FLEXIBLE)
+			{
+				return false;
+			}
+		}
+
+		if (value & 0x10)
+		{
+			F32 gain, cutoff;
+			U8 sound_flags;
+			dp.unpackUUID(id, "SoundUUID");
+			dp.unpackF32(gain, "SoundGain");
+			dp.unpackU8(sound_flags, "SoundFlags");
+			dp.unpackF32(cutoff, "SoundRadius");
+		}
+		if (value & 0x100)
+		{
+			std::string name_value_list;
+			dp.unpackString(name_value_list, "NV");
+		}
+
+		if (!LLVolumeMessage::unpackVolumeParams(&volume_params, dp))
+		{
+			return false;
+		}
+		volume_params.setSculptID(LLUUID::null, 0);
+		return true;
+	}
+}
+
+class LLVOCache::Prefetch : public LLThreadSafeRefCount
+{
+public:
+	typedef std::map<std::pair<LLVolumeParams, S32>, LLPointer<LLVolume> > volume_map_t;
+
+	Prefetch(U64 handle)
+	:	mHandle(handle),
+		mHasArrivalPos(false),
+		mLODFactor(1.f),
+		mDistanceFactor(1.f),
+		mDynamicLOD(true),
+		mStartTime(0.0),
+		mFailed(false),
+		mDone(false),
+		mCancelled(false)
+	{
+	}
+
+	void run();
+
+protected:
+	~Prefetch()
+	{
+		for (LLVOCacheEntry::vocache_entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+		{
+			delete iter->second;
+		}
+	}
+
+	void generateVolumes();
+
+public:
+	// Set up on the main thread before the job is submitted.
+	const U64 mHandle;
+	std::string mFilename;
+	LLVector3 mArrivalPos;
+	bool mHasArrivalPos;
+	F32 mLODFactor;
+	F32 mDistanceFactor;
+	bool mDynamicLOD;
+	F64 mStartTime;
+
+	// Filled in by the job.
+	LLUUID mCacheID;
+	LLVOCacheEntry::vocache_entry_map_t mEntries;
+	volume_map_t mVolumes;
+	bool mFailed;
+
+	// Held by the job while it reads mFilename, so that the main thread can
+	// wait for the read before rewriting or removing the file.
+	LLMutex mFileMutex;
+
+	// Main thread only.
+	bool mDone;
+	// Set on the main thread; the job reads it under mFileMutex.
+	bool mCancelled;
+};
+
+void LLVOCache::Prefetch::run()
+{
+	{
+		LLMutexLock lock(mFileMutex);
+		if (mCancelled)
+		{
+			mFailed = true;
+			return;
+		}
+		LLAPRFile apr_file(mFilename, APR_READ|APR_BINARY);
+		S32 num_entries = 0;
+		mFailed = !check_read(&apr_file, mCacheID.mData, UUID_BYTES) ||
+				  !check_read(&apr_file, &num_entries, sizeof(S32));
+		for (S32 i = 0; !mFailed && i < num_entries; i++)
+		{
+			LLVOCacheEntry* entry = new LLVOCacheEntry(&apr_file);
+			if (!entry->getLocalID())
+			{
+				delete entry;
+				mFailed = true;
+				break;
+			}
+			mEntries[entry->getLocalID()] = entry;
+		}
+	}
+
+	// readFromCache() reads the file again and deals with the corruption.
+	if (!mFailed)
+	{
+		generateVolumes();
+	}
+}
+
+void LLVOCache::Prefetch::generateVolumes()
+{
+	struct Prim
+	{
+		LLVolumeParams mParams;
+		LLVector3 mScale;
+		LLVector3 mPos;
+		U32 mParentID;
+	};
+	std::vector<Prim> prims;
+	prims.reserve(mEntries.size());
+	std::map<U32, LLVector3> root_positions;
+
+	for (LLVOCacheEntry::vocache_entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		LLDataPackerBinaryBuffer* dp = iter->second->peekDP();
+		Prim prim;
+		if (dp && unpack_prim_volume(*dp, prim.mParams, prim.mScale, prim.mPos, prim.mParentID))
+		{
+			if (!prim.mParentID)
+			{
+				root_positions[iter->first] = prim.mPos;
+			}
+			prims.push_back(prim);
+		}
+	}
+
+	for (std::vector<Prim>::iterator iter = prims.begin(); iter != prims.end(); ++iter)
+	{
+		// Objects get created at the lowest detail, so that is always wanted.
+		LLPointer<LLVolume>& lowest = mVolumes[std::make_pair(iter->mParams, 0)];
+		if (lowest.isNull())
+		{
+			lowest = new LLVolume(iter->mParams, LLVolumeLODGroup::getVolumeScaleFromDetail(0));
+		}
+
+		if (!mHasArrivalPos)
+		{
+			continue;
+		}
+
+		// Guess the detail the prim will switch to right away when seen from
+		// the arrival point, as LLVOVolume::calcLOD() would.
+		LLVector3 pos = iter->mPos;
+		if (iter->mParentID)
+		{
+			std::map<U32, LLVector3>::const_iterator root = root_positions.find(iter->mParentID);
+			if (root == root_positions.end())
+			{
+				continue;
+			}
+			pos = root->second;
+		}
+
+		F32 distance = dist_vec(pos, mArrivalPos) * mDistanceFactor;
+		F32 radius = lowest->mLODScaleBias.scaledVec(iter->mScale).length();
+		if (distance <= 0.f || radius <= 0.f)
+		{
+			continue;
+		}
+		F32 ramp_dist = mLODFactor * 2.f;
+		if (distance < ramp_dist)
+		{
+			distance *= distance / ramp_dist;
+		}
+		distance *= F_PI / 3.f;
+		distance = ll_round(distance, 0.01f);
+		radius = ll_round(radius, 0.01f);
+
+		S32 detail;
+		if (mDynamicLOD)
+		{
+			detail = LLVolumeLODGroup::getDetailFromTan(ll_round(mLODFactor * radius / distance, 0.01f));
+		}
+		else
+		{
+			detail = llclamp((S32)(sqrtf(radius) * mLODFactor * 4.f), 0, 3);
+		}
+		if (detail > 0)
+		{
+			LLPointer<LLVolume>& volume = mVolumes[std::make_pair(iter->mParams, detail)];
+			if (volume.isNull())
+			{
+				volume = new LLVolume(iter->mParams, LLVolumeLODGroup::getVolumeScaleFromDetail(detail));
+			}
+		}
+	}
+}
+
+class LLVOCache::PrefetchJob : public LLJob
+{
+public:
+	PrefetchJob(Prefetch* prefetch)
+	:	LLJob(PRIORITY_HIGH, true),
+		mPrefetch(prefetch)
+	{
+	}
+
+protected:
+	/*virtual*/ void run()
+	{
+		mPrefetch->run();
+	}
+
+	/*virtual*/ void finish()
+	{
+		mPrefetch->mDone = true;
+		if (!mPrefetch->mCancelled && LLVOCache::hasInstance())
+		{
+			LLVOCache::getInstance()->onPrefetchDone(mPrefetch);
+		}
+	}
+
+private:
+	LLPointer<Prefetch> mPrefetch;
+};
+
 //-------------------------------------------------------------------
 //LLVOCache
 //-------------------------------------------------------------------
@@ -240,6 +584,8 @@ const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
 
 LLVOCache* LLVOCache::sInstance = NULL;
+LLStat LLVOCache::sPrefetchHitRate("object_cache_prefetch_hits", 32);
+LLStat LLVOCache::sArrivalTime("arrival_time", 16);
 
 //static 
 LLVOCache* LLVOCache::getInstance() 
@@ -271,13 +617,17 @@ LLVOCache::LLVOCache():
 	mInitialized(FALSE),
 	mReadOnly(TRUE),
 	mNumEntries(0),
-	mCacheSize(1)
+	mCacheSize(1),
+	mArrivalPending(false),
+	mArrivalSawObjects(false)
 {
 	mEnabled = gSavedSettings.getBOOL("ObjectCacheEnabled");
 }
 
 LLVOCache::~LLVOCache()
 {
+	cancelPrefetches();
+	releasePrefetchedVolumes(true);
 	if(mEnabled)
 	{
 		writeCacheHeader();
@@ -342,6 +692,7 @@ void LLVOCache::removeCache(ELLPath location)
 	std::string mask = "*";
 	std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
 	LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
+	cancelPrefetches();
 	gDirUtilp->deleteFilesInDir(cache_dir, mask); //delete all files
 	LLFile::rmdir(cache_dir);
 
@@ -362,6 +713,7 @@ void LLVOCache::removeCache()
 
 	std::string mask = "*";
 	LL_INFOS() << "Removing cache at " << mObjectCacheDirName << LL_ENDL;
+	cancelPrefetches();
 	gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask); 
 
 	clearCacheInMemory() ;
@@ -405,6 +757,7 @@ void LLVOCache::removeEntry(U64 handle)
 
 void LLVOCache::clearCacheInMemory()
 {
+	cancelPrefetches();
 	if(!mHeaderEntryQueue.empty()) 
 	{
 		for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin(); iter != mHeaderEntryQueue.end(); ++iter)
@@ -437,6 +790,8 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 		return ;
 	}
 
+	cancelPrefetch(entry->mHandle);
+
 	std::string filename;
 	getObjectCacheFilename(entry->mHandle, filename);
 	LLAPRFile::remove(filename);
@@ -603,6 +958,23 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 		return ;
 	}
 
+	prefetch_map_t::iterator prefetch_iter = mPrefetches.find(handle);
+	if (prefetch_iter != mPrefetches.end())
+	{
+		// A prefetch still running is of no use for the entries anymore, but
+		// it still hands over its volumes when done.
+		LLPointer<Prefetch> prefetch = prefetch_iter->second;
+		mPrefetches.erase(prefetch_iter);
+		if (prefetch->mDone && !prefetch->mFailed && prefetch->mCacheID == id)
+		{
+			llassert(cache_entry_map.empty());
+			cache_entry_map.swap(prefetch->mEntries);
+			sPrefetchHitRate.addValue(100.f);
+			return;
+		}
+	}
+	sPrefetchHitRate.addValue(0.f);
+
 	bool success = true ;
 	{
 		std::string filename;
@@ -725,6 +1097,9 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 		return ; //nothing changed, no need to update.
 	}
 
+	// Whatever was prefetched for the region is outdated now.
+	cancelPrefetch(handle);
+
 	//write to cache file
 	bool success = true ;
 	{
@@ -756,3 +1131,134 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 	return ;
 }
 
+
+//---------------------------------------------------------------------------
+// Prefetching
+//---------------------------------------------------------------------------
+
+void LLVOCache::prefetch(U64 handle, const LLVector3* arrival_pos_region)
+{
+	if (!mEnabled || !mInitialized || !gSavedSettings.getBOOL("ObjectCachePrefetch"))
+	{
+		return;
+	}
+	if (mHandleEntryMap.find(handle) == mHandleEntryMap.end() || mPrefetches.find(handle) != mPrefetches.end())
+	{
+		return;
+	}
+
+	LLPointer<Prefetch> prefetch = new Prefetch(handle);
+	getObjectCacheFilename(handle, prefetch->mFilename);
+	if (arrival_pos_region)
+	{
+		prefetch->mArrivalPos = *arrival_pos_region;
+		prefetch->mHasArrivalPos = true;
+	}
+	prefetch->mLODFactor = LLVOVolume::sLODFactor;
+	prefetch->mDistanceFactor = LLVOVolume::sDistanceFactor;
+	prefetch->mDynamicLOD = LLPipeline::sDynamicLOD;
+	prefetch->mStartTime = mPrefetchTimer.getElapsedTimeF64();
+	mPrefetches[handle] = prefetch;
+
+	LLJobSystem::instance().submit(new PrefetchJob(prefetch));
+}
+
+void LLVOCache::onPrefetchDone(Prefetch* prefetch)
+{
+	LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+	if (!volume_mgr)
+	{
+		return;
+	}
+
+	// Hand the volumes over to the manager, which keeps its own when it
+	// already has them.
+	F64 now = mPrefetchTimer.getElapsedTimeF64();
+	for (Prefetch::volume_map_t::iterator iter = prefetch->mVolumes.begin(); iter != prefetch->mVolumes.end(); ++iter)
+	{
+		LLVolume* volumep = volume_mgr->refVolume(iter->first.first, iter->first.second, iter->second);
+		mPrefetchedVolumes.push_back(volume_ref_t(volumep, now));
+	}
+
+	LL_DEBUGS("ObjectCache") << "Prefetched " << prefetch->mEntries.size() << " objects and "
+							 << prefetch->mVolumes.size() << " volumes for region " << prefetch->mHandle
+							 << " in " << (now - prefetch->mStartTime) * 1000.0 << " ms" << LL_ENDL;
+	prefetch->mVolumes.clear();
+}
+
+// Returns once no job reads the region's cache file anymore, so that the
+// caller can rewrite or remove it.
+void LLVOCache::cancelPrefetch(U64 handle)
+{
+	prefetch_map_t::iterator iter = mPrefetches.find(handle);
+	if (iter != mPrefetches.end())
+	{
+		LLPointer<Prefetch> prefetch = iter->second;
+		mPrefetches.erase(iter);
+		LLMutexLock lock(prefetch->mFileMutex);
+		prefetch->mCancelled = true;
+	}
+}
+
+void LLVOCache::cancelPrefetches()
+{
+	for (prefetch_map_t::iterator iter = mPrefetches.begin(); iter != mPrefetches.end(); ++iter)
+	{
+		LLMutexLock lock(iter->second->mFileMutex);
+		iter->second->mCancelled = true;
+	}
+	mPrefetches.clear();
+}
+
+void LLVOCache::releasePrefetchedVolumes(bool all)
+{
+	LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+	F64 expired = mPrefetchTimer.getElapsedTimeF64() - PREFETCHED_VOLUME_HOLD_TIME;
+	while (!mPrefetchedVolumes.empty() && (all || mPrefetchedVolumes.front().second < expired))
+	{
+		if (volume_mgr)
+		{
+			volume_mgr->unrefVolume(mPrefetchedVolumes.front().first);
+		}
+		mPrefetchedVolumes.pop_front();
+	}
+}
+
+void LLVOCache::noteArrival()
+{
+	mArrivalTimer.reset();
+	mArrivalPending = true;
+	mArrivalSawObjects = false;
+}
+
+void LLVOCache::updatePrefetches(S32 new_objects, S32 pending_updates)
+{
+	// Drop prefetches for regions that never connected.
+	F64 expired = mPrefetchTimer.getElapsedTimeF64() - PREFETCH_TIMEOUT;
+	for (prefetch_map_t::iterator iter = mPrefetches.begin(); iter != mPrefetches.end(); )
+	{
+		prefetch_map_t::iterator cur = iter++;
+		if (cur->second->mDone && cur->second->mStartTime < expired)
+		{
+			mPrefetches.erase(cur);
+		}
+	}
+	releasePrefetchedVolumes(false);
+
+	// The scene is considered complete on the first frame after objects
+	// started arriving where none is created and no update is left pending.
+	if (mArrivalPending)
+	{
+		if (new_objects > 0)
+		{
+			mArrivalSawObjects = true;
+		}
+		else if (mArrivalSawObjects && pending_updates == 0)
+		{
+			F64 arrival_ms = mArrivalTimer.getElapsedTimeF64() * 1000.0;
+			sArrivalTime.addValue((F32)arrival_ms);
+			LL_INFOS("ObjectCache") << "Arrival to full frame: " << arrival_ms << " ms" << LL_ENDL;
+			mArrivalPending = false;
+		}
+	}
+}
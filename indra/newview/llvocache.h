@@ -36,6 +36,14 @@
 #include "lluuid.h"
 #include "lldatapacker.h"
 #include "lldir.h"
+#include "llpointer.h"
+#include "llstat.h"
+#include "lltimer.h"
+#include "v3math.h"
+
+#include <deque>
+
+class LLVolume;
 
 
 //---------------------------------------------------------------------------
@@ -59,6 +67,8 @@ public:
 	BOOL writeToFile(LLAPRFile* apr_file) const;
 	void assignCRC(U32 crc, LLDataPackerBinaryBuffer &dp);
 	LLDataPackerBinaryBuffer *getDP(U32 crc);
+	// Like getDP() for the current CRC, without counting a hit.
+	LLDataPackerBinaryBuffer *peekDP()	{ return mDP.getBufferSize() ? &mDP : NULL; }
 	void recordHit();
 	void recordDupe() { mDupeCount++; }
 
@@ -125,6 +135,20 @@ public:
 
 	void setReadOnly(BOOL read_only) {mReadOnly = read_only;} 
 
+	// Starts loading the cache file of the region at handle on a worker, and
+	// generating the volumes of the prims in it, so that readFromCache() finds
+	// them ready when the region connects. arrival_pos_region, if known, is
+	// where the agent will land; prims close to it get their likely LOD too.
+	void prefetch(U64 handle, const LLVector3* arrival_pos_region = NULL);
+	// Call when the agent arrives in a region after a teleport or crossing.
+	void noteArrival();
+	// Called once per frame with the number of objects created this frame
+	// and the object updates still waiting to be applied.
+	void updatePrefetches(S32 new_objects, S32 pending_updates);
+
+	static LLStat sPrefetchHitRate;	// % of cache reads served by a prefetch
+	static LLStat sArrivalTime;		// ms from arrival until all object updates were applied
+
 private:
 	void setDirNames(ELLPath location);	
 	// determine the cache filename for the region from the region handle	
@@ -137,7 +161,15 @@ private:
 	void removeEntry(HeaderEntryInfo* entry) ;
 	void purgeEntries(U32 size);
 	BOOL updateEntry(const HeaderEntryInfo* entry);
-	
+	void cancelPrefetch(U64 handle);
+	void cancelPrefetches();
+	void releasePrefetchedVolumes(bool all);
+
+	class Prefetch;
+	class PrefetchJob;
+	friend class PrefetchJob;
+	void onPrefetchDone(Prefetch* prefetch);
+
 private:
 	BOOL                 mEnabled;
 	BOOL                 mInitialized ;
@@ -150,6 +182,17 @@ private:
 	header_entry_queue_t mHeaderEntryQueue;
 	handle_entry_map_t   mHandleEntryMap;	
 
+	typedef std::map<U64, LLPointer<Prefetch> > prefetch_map_t;
+	prefetch_map_t       mPrefetches;
+	// Volume manager references keeping prefetched volumes alive until the
+	// objects using them are created.
+	typedef std::pair<LLVolume*, F64> volume_ref_t;
+	std::deque<volume_ref_t> mPrefetchedVolumes;
+	LLTimer              mPrefetchTimer;
+	LLTimer              mArrivalTimer;
+	bool                 mArrivalPending;
+	bool                 mArrivalSawObjects;
+
 	static LLVOCache* sInstance ;
 public:
 	static LLVOCache* getInstance() ;
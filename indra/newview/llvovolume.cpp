@@ -88,6 +88,9 @@
 #include "llvocache.h"
 #include "llmaterialmgr.h"
 #include "llsculptidsize.h"
+#include "lljobsystem.h"
+
+#include <boost/bind.hpp>
 
 // [RLVa:KB] - Checked: 2010-04-04 (RLVa-1.2.0d)
 #include "rlvhandler.h"
@@ -4576,9 +4579,13 @@ void LLVOVolume::updateRiggedVolume(bool force_update)
 static LLTrace::BlockTimerStatHandle FTM_SKIN_RIGGED("Skin");
 static LLTrace::BlockTimerStatHandle FTM_RIGGED_OCTREE("Octree");
 
+// Below this many vertices the faces of a rigged volume are skinned on the
+// calling thread; handing them to the job system would cost more than it saves.
+static const U32 MIN_PARALLEL_SKINNED_VERTICES = 4096;
+
 void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, const LLVolume* volume)
 {
-	bool copy = false;
+	bool copy = volume != mSkinnedVolume;
 	if (volume->getNumVolumeFaces() != getNumVolumeFaces())
 	{ 
 		copy = true;
@@ -4616,82 +4623,100 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 
 	LLMatrix4a mat[kMaxJoints];
 	U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
-	LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar, true);
+	LLSkinningUtil::initPositionPalette(mat, maxJoints, skin, avatar);
 
-	
-	LLMatrix4a bind_shape_matrix;
-	bind_shape_matrix.loadu(skin->mBindShapeMatrix);
+	const LLVector3& avatar_pos = avatar->getPosition();
+
+	// Idle and barely moving avatars keep the last skinned positions and
+	// octrees; picking does not need sub-millimeter accuracy.
+	static LLCachedControl<F32> skin_threshold(gSavedSettings, "RiggedVolumeSkinThreshold", 0.001f);
+	if (!copy && skin == mSkinnedSkin && mPalette.size() == maxJoints &&
+		dist_vec_squared(avatar_pos, mSkinnedAvatarPos) <= skin_threshold * skin_threshold &&
+		!LLSkinningUtil::paletteDiffers(mat, mPalette.mArray, maxJoints, skin_threshold))
+	{
+		return;
+	}
+
+	mPalette.resize(maxJoints);
+	for (U32 j = 0; j < maxJoints; ++j)
+	{
+		mPalette[j] = mat[j];
+	}
+	mSkinnedAvatarPos = avatar_pos;
+	mSkinnedVolume = volume;
+	mSkinnedSkin = skin;
 
 	LLVector4a av_pos;
-	av_pos.load3(avatar->getPosition().mV);
+	av_pos.load3(avatar_pos.mV);
 
+	U32 total_vertices = 0;
 	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
 	{
 		const LLVolumeFace& vol_face = volume->getVolumeFace(i);
-		
-		LLVolumeFace& dst_face = mVolumeFaces[i];
-		
-		LLVector4a* weight = vol_face.mWeights;
-
-		if(!weight)
+		if (vol_face.mWeights)
 		{
-			continue;
+			LLSkinningUtil::checkSkinWeights(vol_face.mWeights, mVolumeFaces[i].mNumVertices, skin);
+			total_vertices += mVolumeFaces[i].mNumVertices;
 		}
-		LLSkinningUtil::checkSkinWeights(weight, dst_face.mNumVertices, skin);
+	}
 
-		LLVector4a* pos = dst_face.mPositions;
+	{
+		LL_RECORD_BLOCK_TIME(FTM_SKIN_RIGGED);
 
-		if( pos && dst_face.mExtents )
+		LLJobSystem& jobs = LLJobSystem::instance();
+		if (total_vertices >= MIN_PARALLEL_SKINNED_VERTICES && volume->getNumVolumeFaces() > 1 &&
+			jobs.getWorkerCount() > 0)
 		{
-			LL_RECORD_BLOCK_TIME(FTM_SKIN_RIGGED);
-
-			U32 max_joints = LLSkinningUtil::getMaxJointCount();
-			for (U32 j = 0; j < (U32)dst_face.mNumVertices; ++j)
-			{
-				LLMatrix4a final_mat;
-				LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
-				
-				LLVector4a& v = vol_face.mPositions[j];
-
-				LLVector4a t;
-				bind_shape_matrix.affineTransform(v, t);
-				final_mat.affineTransform(t, pos[j]);
-
-				pos[j].add(av_pos); // Algorithm tweaked to stop hosing up normals.
-			}
-
-			//update bounding box
-			LLVector4a& min = dst_face.mExtents[0];
-			LLVector4a& max = dst_face.mExtents[1];
-
-			min = pos[0];
-			max = pos[1];
-
-			for (U32 j = 1; j < (U32)dst_face.mNumVertices; ++j)
+			jobs.parallelFor(volume->getNumVolumeFaces(),
+							 boost::bind(&LLRiggedVolume::skinFace, this, volume, &av_pos, _1));
+		}
+		else
+		{
+			for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
 			{
-				min.setMin(min, pos[j]);
-				max.setMax(max, pos[j]);
+				skinFace(volume, &av_pos, i);
 			}
+		}
+	}
 
-			dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
-			dst_face.mCenter->mul(0.5f);
-
+	// The octree node pool is not thread safe, so the octrees are rebuilt here.
+	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+	{
+		if (!volume->getVolumeFace(i).mWeights)
+		{
+			continue;
 		}
 
+		LLVolumeFace& dst_face = mVolumeFaces[i];
+
 		{
 			LL_RECORD_BLOCK_TIME(FTM_RIGGED_OCTREE);
 			delete dst_face.mOctree;
 			dst_face.mOctree = NULL;
 
-			LLVector4a size;
-			size.setSub(dst_face.mExtents[1], dst_face.mExtents[0]);
-			size.splat(size.getLength3().getF32()*0.5f);
-			
 			dst_face.createOctree(1.f);
 		}
 	}
 }
 
+void LLRiggedVolume::skinFace(const LLVolume* volume, const LLVector4a* offset, S32 face)
+{
+	const LLVolumeFace& vol_face = volume->getVolumeFace(face);
+	LLVolumeFace& dst_face = mVolumeFaces[face];
+
+	if (!vol_face.mWeights || !dst_face.mPositions || !dst_face.mExtents || !dst_face.mNumVertices)
+	{
+		return;
+	}
+
+	LLSkinningUtil::skinPositions(mPalette.mArray, mPalette.size(), vol_face.mWeights,
+								  vol_face.mPositions, dst_face.mNumVertices, *offset,
+								  dst_face.mPositions, dst_face.mExtents);
+
+	dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
+	dst_face.mCenter->mul(0.5f);
+}
+
 U32 LLVOVolume::getPartitionType() const
 {
 	if (isHUDAttachment())
@@ -40,6 +40,8 @@
 #include "llapr.h"
 #include "m3math.h"		// LLMatrix3
 #include "m4math.h"		// LLMatrix4
+#include "llalignedarray.h"
+#include "llmatrix4a.h"
 #include <map>
 
 class LLViewerTextureAnim;
@@ -62,13 +64,25 @@ enum LLVolumeInterfaceType
 class LLRiggedVolume : public LLVolume
 {
 	U64 mFrame;
+
+	// Pose of the last skinning pass, so that update() can skip re-skinning
+	// (and rebuilding the face octrees) while the avatar holds still.
+	LLAlignedArray<LLMatrix4a, 64> mPalette;
+	LLVector3 mSkinnedAvatarPos;
+	const LLVolume* mSkinnedVolume;
+	const LLMeshSkinInfo* mSkinnedSkin;
+
 public:
 	LLRiggedVolume(const LLVolumeParams& params)
-		: LLVolume(params, 0.f), mFrame(-1)
+		: LLVolume(params, 0.f), mFrame(-1), mSkinnedVolume(NULL), mSkinnedSkin(NULL)
 	{
 	}
 
 	void update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, const LLVolume* src_volume);
+
+private:
+	// Skins one face of src_volume with mPalette; safe to run on any thread.
+	void skinFace(const LLVolume* src_volume, const LLVector4a* offset, S32 face);
 };
 
 // Base class for implementations of the volume - Primitive, Flexible Object, etc.
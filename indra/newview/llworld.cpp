@@ -39,6 +39,7 @@
 #include "llstl.h"
 
 #include "llagent.h"
+#include "llavatarspatialindex.h"
 #include "llviewercontrol.h"
 #include "lldrawpool.h"
 #include "llglheaders.h"
@@ -364,6 +365,8 @@ void LLWorld::removeRegion(const LLHost &host)
 
 	mRegionRemovedSignal(regionp);
 
+	LLAvatarSpatialIndex::instance().removeRegion(regionp->getHandle());
+
 	updateWaterObjects();
 
 	//double check all objects of this region are removed.
@@ -1605,26 +1608,24 @@ void LLWorld::getAvatars(uuid_vec_t* avatar_ids, std::vector<LLVector3d>* positi
 		}
 	}
 	// region avatars added for situations where radius is greater than RenderFarClip
-	for (LLWorld::region_list_t::const_iterator iter = getRegionList().begin();
-		iter != getRegionList().end(); ++iter)
+	if (avatar_ids != NULL)
 	{
-		LLViewerRegion* regionp = *iter;
-		const LLVector3d& origin_global = regionp->getOriginGlobal();
-		S32 count = regionp->mMapAvatars.size();
-		for (S32 i = 0; i < count; i++)
+		uuid_vec_t coarse_ids;
+		std::vector<LLVector3d> coarse_positions;
+		LLAvatarSpatialIndex::instance().getAvatarsInRange(relative_to, radius, coarse_ids, &coarse_positions);
+		if (!coarse_ids.empty())
 		{
-			LLVector3d pos_global = unpackLocalToGlobalPosition(regionp->mMapAvatars.at(i), origin_global);
-			if(dist_vec_squared(pos_global, relative_to) <= radius_squared)
+			uuid_set_t found(avatar_ids->begin(), avatar_ids->end());
+			for (size_t i = 0; i < coarse_ids.size(); ++i)
 			{
-				LLUUID uuid = regionp->mMapAvatarIDs.at(i);
 				// if this avatar doesn't already exist in the list, add it
-				if(uuid.notNull() && avatar_ids != NULL && std::find(avatar_ids->begin(), avatar_ids->end(), uuid) == avatar_ids->end())
+				if (found.insert(coarse_ids[i]).second)
 				{
 					if(positions != NULL)
 					{
-						positions->push_back(pos_global);
+						positions->push_back(coarse_positions[i]);
 					}
-					avatar_ids->push_back(uuid);
+					avatar_ids->push_back(coarse_ids[i]);
 				}
 			}
 		}
@@ -1659,25 +1660,13 @@ void LLWorld::getAvatars(pos_map_t* umap, const LLVector3d& relative_to, F32 rad
 		}
 	}
 	// region avatars added for situations where radius is greater than RenderFarClip
-	for (LLWorld::region_list_t::const_iterator iter = getRegionList().begin();
-		 iter != getRegionList().end(); ++iter)
+	uuid_vec_t coarse_ids;
+	std::vector<LLVector3d> coarse_positions;
+	LLAvatarSpatialIndex::instance().getAvatarsInRange(relative_to, radius, coarse_ids, &coarse_positions);
+	for (size_t i = 0; i < coarse_ids.size(); ++i)
 	{
-		LLViewerRegion* regionp = *iter;
-		const LLVector3d& origin_global = regionp->getOriginGlobal();
-		S32 count = regionp->mMapAvatars.size();
-		for (S32 i = 0; i < count; i++)
-		{
-			LLVector3d pos_global = unpackLocalToGlobalPosition(regionp->mMapAvatars.at(i), origin_global);
-			if(dist_vec_squared(pos_global, relative_to) <= radius_squared)
-			{
-				LLUUID uuid = regionp->mMapAvatarIDs.at(i);
-				// if this avatar doesn't already exist in the list, add it
-				if(uuid.notNull())
-				{
-					umap->emplace(uuid, pos_global);
-				}
-			}
-		}
+		// if this avatar doesn't already exist in the list, add it
+		umap->emplace(coarse_ids[i], coarse_positions[i]);
 	}
 }
 